@@ -55,6 +55,7 @@ const float DEFAULT_GRAVITY			= 1066.0f;
 const idVec3 DEFAULT_GRAVITY_VEC3( 0, 0, -DEFAULT_GRAVITY );
 
 const int	CINEMATIC_SKIP_DELAY	= SEC2MS( 2.0f );
+const int	MODEL_READ_AHEAD		= 16;		// map entities whose model files are prefetched ahead of the spawning
 
 #ifdef GAME_DLL
 
@@ -3487,6 +3488,7 @@ void idGameLocal::SpawnMapEntities( void ) {
 	int			inhibit;
 	idMapEntity	*mapEnt;
 	int			numEntities;
+	int			prefetched;
 	idDict		args;
 
 	Printf( "Spawning entities\n" );
@@ -3514,8 +3516,14 @@ void idGameLocal::SpawnMapEntities( void ) {
 
 	num = 1;
 	inhibit = 0;
+	prefetched = 1;
 
 	for ( i = 1 ; i < numEntities ; i++ ) {
+		// the model files of the next entities are read on the job threads while this one spawns
+		for ( ; prefetched < numEntities && prefetched <= i + MODEL_READ_AHEAD; prefetched++ ) {
+			renderModelManager->PrefetchModel( mapFile->GetEntity( prefetched )->epairs.GetString( "model" ) );
+		}
+
 		mapEnt = mapFile->GetEntity( i );
 		args = mapEnt->epairs;
 
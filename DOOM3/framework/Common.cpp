@@ -114,6 +114,9 @@ idCVar com_timestampPrints("com_timestampPrints", "0", CVAR_SYSTEM,
 idCVar com_timescale("timescale", "1", CVAR_SYSTEM | CVAR_FLOAT, "scales the time", 0.1f, 10.0f);
 idCVar com_updateLoadSize("com_updateLoadSize", "0", CVAR_BOOL | CVAR_SYSTEM | CVAR_NOCHEAT,
                           "update the load size after loading a map");
+idCVar com_jobThreads("com_jobThreads", "-1", CVAR_INTEGER | CVAR_SYSTEM | CVAR_INIT,
+                      "number of job threads used for level loading, -1 = one less than the number of cores, 0 = run jobs on the main thread",
+                      -1, MAX_JOB_THREADS);
 
 idCVar com_product_lang_ext("com_product_lang_ext", "1", CVAR_INTEGER | CVAR_SYSTEM | CVAR_ARCHIVE,
                             "Extension to use when creating language files.");
@@ -274,6 +277,8 @@ private:
 
   void DumpWarnings(void);
 
+  void PrintJobMessages(void);
+
   void SingleAsyncTic(void);
 
   void LoadGameDLL(void);
@@ -301,6 +306,8 @@ private:
   idStrList warningList;
   idStrList errorList;
 
+  idStrList jobMessages;        // printed on job threads, echoed by the main thread, under CRITICAL_SECTION_THREE
+
   uintptr_t gameDLL;
 
   idLangDict languageDict;
@@ -425,6 +432,19 @@ void idCommonLocal::VPrintf(const char* fmt, va_list args) {
     Sys_Printf("idCommon::VPrintf: truncated to %zd characters\n", strlen(msg) - 1);
   }
 
+  // the console and the screen updates belong to the main thread, the
+  // job threads queue their messages until it prints the next time
+  if ( Mem_IsThreadSafe() && !Sys_IsMainThread()) {
+    Sys_EnterCriticalSection(CRITICAL_SECTION_THREE);
+    jobMessages.Append(msg + timeLength);
+    Sys_LeaveCriticalSection(CRITICAL_SECTION_THREE);
+    return;
+  }
+
+  if ( jobMessages.Num() && Sys_IsMainThread()) {
+    PrintJobMessages();
+  }
+
   if ( rd_buffer ) {
     if ((int) ( strlen(msg) + strlen(rd_buffer)) > ( rd_buffersize - 1 )) {
       rd_flush(rd_buffer);
@@ -551,9 +571,31 @@ void idCommonLocal::Warning(const char* fmt, ...) {
   S_COLOR_RED
   "%s\n", msg );
 
+  // warnings can come from the job threads
+  Sys_EnterCriticalSection(CRITICAL_SECTION_THREE);
   if ( warningList.Num() < MAX_WARNING_LIST ) {
     warningList.AddUnique(msg);
   }
+  Sys_LeaveCriticalSection(CRITICAL_SECTION_THREE);
+}
+
+/*
+==================
+idCommonLocal::PrintJobMessages
+
+echoes the messages the job threads printed since the last call
+==================
+*/
+void idCommonLocal::PrintJobMessages(void) {
+  idStrList messages;
+
+  Sys_EnterCriticalSection(CRITICAL_SECTION_THREE);
+  messages.Swap(jobMessages);
+  Sys_LeaveCriticalSection(CRITICAL_SECTION_THREE);
+
+  for ( int i = 0; i < messages.Num(); i++ ) {
+    Printf("%s", messages[i].c_str());
+  }
 }
 
 /*
@@ -2054,6 +2096,10 @@ void idCommonLocal::InitCommands(void) {
                         "lists all keys used by dictionaries");
   cmdSystem->AddCommand("listDictValues", idDict::ListValues_f, CMD_FL_SYSTEM | CMD_FL_CHEAT,
                         "lists all values used by dictionaries");
+  cmdSystem->AddCommand("benchMapFile", idMapFile::Benchmark_f, CMD_FL_SYSTEM,
+                        "compares loading a map from text and binary", idCmdSystem::ArgCompletion_MapName);
+  cmdSystem->AddCommand("benchLexer", idLexer::Benchmark_f, CMD_FL_SYSTEM,
+                        "times the token copies and punctuation lookups of reading a file");
 #ifdef __EMSCRIPTEN__
   // SIMD code not supported on emscripten for now
 #else
@@ -2130,6 +2176,10 @@ void idCommonLocal::Frame(void) {
   // pump all the events
   Sys_GenerateEvents();
 
+  if ( jobMessages.Num()) {
+    PrintJobMessages();
+  }
+
   // write config file if anything changed
   WriteConfiguration();
 
@@ -2144,6 +2194,9 @@ void idCommonLocal::Frame(void) {
 
   eventLoop->RunEventLoop();               // EMTERPRETIFY function (might yields)
 
+  // hand the finished asynchronous file reads to their callbacks
+  fileSystem->FinishAsyncReads( false );
+
 #ifdef NOMT
     // In single threaded mode, manually call the async timer update code at each frame
     common->Async();
@@ -2593,6 +2646,9 @@ void idCommonLocal::Init(int argc, char** argv) {
     // initialize processor specific SIMD implementation
     InitSIMD();
 
+    // start the job threads, only after the heap is up
+    Sys_StartJobThreads(com_jobThreads.GetInteger());
+
     // init commands
     InitCommands();
 
@@ -2660,6 +2716,9 @@ void idCommonLocal::Shutdown(void) {
   // game specific shut down
   ShutdownGame(false);
 
+  // stop the job threads before the heap goes away
+  Sys_ShutdownJobThreads();
+
   // shut down non-portable system services
   Sys_Shutdown();
 
@@ -73,6 +73,7 @@ extern idCVar		com_showAsyncStats;
 extern idCVar		com_showSoundDecoders;
 extern idCVar		com_makingBuild;
 extern idCVar		com_updateLoadSize;
+extern idCVar		com_jobThreads;
 
 extern int			time_gameFrame;			// game logic time
 extern int			time_gameDraw;			// game present time
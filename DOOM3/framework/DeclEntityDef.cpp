@@ -92,6 +92,20 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength ) {
 	// we always automatically set a "classname" key to our name
 	dict.Set( "classname", GetName() );
 
+	// a parse on a job thread leaves the inherited entityDefs and the media to ResolveReferences()
+	if ( !ParsingOnJob() ) {
+		ResolveReferences();
+	}
+
+	return true;
+}
+
+/*
+================
+idDeclEntityDef::ResolveReferences
+================
+*/
+void idDeclEntityDef::ResolveReferences( void ) {
 	// "inherit" keys will cause all values from another entityDef to be copied into this one
 	// if they don't conflict.  We can't have circular recursions, because each entityDef will
 	// never be parsed mroe than once
@@ -108,7 +122,7 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength ) {
 
 		const idDeclEntityDef *copy = static_cast<const idDeclEntityDef *>( declManager->FindType( DECL_ENTITYDEF, kv->GetValue(), false ) );
 		if ( !copy ) {
-			src.Warning( "Unknown entityDef '%s' inherited by '%s'", kv->GetValue().c_str(), GetName() );
+			common->Warning( "file %s, line %d: Unknown entityDef '%s' inherited by '%s'", GetFileName(), GetLineNum(), kv->GetValue().c_str(), GetName() );
 		} else {
 			defList.Append( copy );
 		}
@@ -127,8 +141,6 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength ) {
 	if ( !( com_editors & (EDITOR_RADIANT|EDITOR_AAS) ) ) {
 		game->CacheDictionaryMedia( &dict );
 	}
-
-	return true;
 }
 
 /*
@@ -47,6 +47,7 @@ public:
 	virtual size_t			Size( void ) const;
 	virtual const char *	DefaultDefinition() const;
 	virtual bool			Parse( const char *text, const int textLength );
+	virtual void			ResolveReferences( void );
 	virtual void			FreeData( void );
 	virtual void			Print( void ) const;
 };
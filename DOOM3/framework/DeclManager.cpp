@@ -80,11 +80,27 @@ missing reload over a previously explicit definition
 #define USE_COMPRESSED_DECLS
 //#define GET_HUFFMAN_FREQUENCIES
 
+#define DECL_CACHE_FILE			"decls.cache"
+#define DECL_CACHE_MAGIC		( ( 'D' << 24 ) | ( 'C' << 16 ) | ( 'C' << 8 ) | 'H' )
+#define DECL_CACHE_VERSION		1
+
+#define DECL_EXPAND_RUN			64		// decls per job when expanding decl text ahead of the parse
+#define DECL_PARSE_RUN			16		// decls per job when parsing decls at the start of a level load
+
+// the expand state of a decl changes under CRITICAL_SECTION_TWO once the expand jobs are submitted
+typedef enum {
+	EXPAND_NONE,			// no expanded text, only the main thread moves a decl out of this state
+	EXPAND_QUEUED,			// a job will expand the text unless a parse claims the decl first
+	EXPAND_RUNNING,			// a job reads textSource and writes expandedText
+	EXPAND_DONE				// expandedText is ready to be claimed
+} declExpandState_t;
+
 class idDeclType {
 public:
 	idStr						typeName;
 	declType_t					type;
 	idDecl *					(*allocator)( void );
+	bool						parseOnJobs;			// the Parse() supports idDecl::ParsingOnJob()
 };
 
 class idDeclFolder {
@@ -96,6 +112,25 @@ public:
 
 class idDeclFile;
 
+// where a decl starts in the text of its file, as found by the last scan of the file
+typedef struct {
+	idStr						typeName;
+	idStr						name;
+	int							offset;
+	int							size;
+	int							line;
+} declCacheEntry_t;
+
+// the decls of a file, valid as long as the file's size and checksum match
+class idDeclCacheFile {
+public:
+	idStr						fileName;
+	int							fileSize;
+	int							checksum;
+	int							numLines;
+	idList<declCacheEntry_t>	entries;
+};
+
 class idDeclLocal : public idDeclBase {
 	friend class idDeclFile;
 	friend class idDeclManagerLocal;
@@ -122,11 +157,13 @@ public:
 	virtual bool				SourceFileChanged( void ) const;
 	virtual void				MakeDefault( void );
 	virtual bool				EverReferenced( void ) const;
+	virtual bool				ParsingOnJob( void ) const;
 
 protected:
 	virtual bool				SetDefaultText( void );
 	virtual const char *		DefaultDefinition( void ) const;
 	virtual bool				Parse( const char *text, const int textLength );
+	virtual void				ResolveReferences( void );
 	virtual void				FreeData( void );
 	virtual void				List( void ) const;
 	virtual void				Print( void ) const;
@@ -138,6 +175,11 @@ protected:
 								// After calling parse, a decl will be guaranteed usable.
 	void						ParseLocal( void );
 
+								// Parses the decl definition on a job thread, the decl stays
+								// unparsed until ParseLocal() resolves the references.
+	void						ParseOnJob( void );
+	void						ResolveLocal( void );
+
 								// Does a MakeDefualt, but flags the decl so that it
 								// will Parse() the next time the decl is found.
 	void						Purge( void );
@@ -150,6 +192,8 @@ private:
 
 	idStr						name;					// name of the decl
 	char *						textSource;				// decl text definition
+	char *						expandedText;			// decompressed text prepared on a job at the start of a level load
+	declExpandState_t			expandState;			// who owns expandedText
 	int							textLength;				// length of textSource
 	int							compressedLength;		// compressed length
 	idDeclFile *				sourceFile;				// source file in which the decl was defined
@@ -159,6 +203,7 @@ private:
 	int							checksum;				// checksum of the decl text
 	declType_t					type;					// decl type
 	declState_t					declState;				// decl state
+	declState_t					jobState;				// state the parse on a job ended in
 	int							index;					// index in the per-type list
 
 	bool						parsedOutsideLevelLoad;	// these decls will never be purged
@@ -166,6 +211,8 @@ private:
 	bool						referencedThisLevel;	// set to true when the decl is used for the current level
 	bool						redefinedInReload;		// used during file reloading to make sure a decl that has
 														// its source removed will be defaulted
+	bool						parsingOnJob;			// Parse() is running on a job thread
+	bool						resolvePending;			// parsed on a job, ResolveReferences() wasn't called yet
 	idDeclLocal *				nextInFile;				// next decl in the decl file
 };
 
@@ -177,6 +224,9 @@ public:
 	void						Reload( bool force );
 	int							LoadAndParse();
 
+private:
+	bool						DefineDecl( declType_t type, const char *name, const char *buffer, int offset, int size, int line );
+
 public:
 	idStr						fileName;
 	declType_t					defaultType;
@@ -237,6 +287,14 @@ public:
 	idDeclType *				GetDeclType( int type ) const { return declTypes[type]; }
 	const idDeclFile *			GetImplicitDeclFile( void ) const { return &implicitDecls; }
 
+								// takes the expanded text of the decl, waiting only if its job is running right now,
+								// returns NULL if there is none, the caller frees the text
+	char *						ClaimExpandedText( idDeclLocal *decl );
+
+	const idDeclCacheFile *		FindCacheFile( const char *fileName ) const;
+								// takes over the cache file and replaces the one for the same file if any
+	void						UpdateCacheFile( idDeclCacheFile *cacheFile );
+
 private:
 	idList<idDeclType *>		declTypes;
 	idList<idDeclFolder *>		declFolders;
@@ -251,14 +309,41 @@ private:
 	int							indent;			// for MediaPrint
 	bool						insideLevelLoad;
 
+	idList<idDeclLocal *>		expandDecls;	// decls referenced by the last level, their text is expanded ahead of the parse
+	idJobList					expandJobs;
+	bool						expanding;
+
+	idList<idDeclLocal *>		jobParseDecls;	// decls referenced by the last level that were parsed on the job threads
+	idJobList					parseJobs;
+	bool						parsingOnJobs;	// FindDeclWithoutParsing() is called from the job threads
+
+	int							parseTime[DECL_MAX_TYPES];	// microseconds spent parsing, without the decls parsed from inside
+	int							parseCount[DECL_MAX_TYPES];
+	int							jobParseCount[DECL_MAX_TYPES];	// parses that ran on the job threads
+	int							childParseTime;			// time of the decls parsed from inside the current parse
+
+	idList<idDeclCacheFile *>	cacheFiles;		// decl positions from the last scan of every decl file
+	idHashIndex					cacheHash;
+	bool						cacheDirty;
+
 	static idCVar				decl_show;
+	static idCVar				decl_cache;
 
 private:
+	void						LoadDeclCache( void );
+	void						WriteDeclCache( void );
+	void						FinishExpanding( void );
+	void						DropExpandedText( void );
+	static void					ExpandTextJob( void *data );
+	void						PurgeUnresolvedDecls( void );
+	static void					ParseDeclsJob( void *data );
+
 	static void					ListDecls_f( const idCmdArgs &args );
 	static void					ReloadDecls_f( const idCmdArgs &args );
 	static void					TouchDecl_f( const idCmdArgs &args );
 };
 
+idCVar idDeclManagerLocal::decl_cache( "decl_cache", "1", CVAR_SYSTEM | CVAR_BOOL, "keep the positions of the decls in their files in " DECL_CACHE_FILE " so unchanged files don't need to be scanned at startup" );
 idCVar idDeclManagerLocal::decl_show( "decl_show", "0", CVAR_SYSTEM, "set to 1 to print parses, 2 to also print references", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
 
 idDeclManagerLocal	declManagerLocal;
@@ -606,6 +691,61 @@ void idDeclFile::Reload( bool force ) {
 	LoadAndParse();
 }
 
+/*
+================
+idDeclFile::DefineDecl
+
+defines the decl with the text at offset in the file buffer, returns false if it's a redefinition
+================
+*/
+bool idDeclFile::DefineDecl( declType_t type, const char *name, const char *buffer, int offset, int size, int line ) {
+	idDeclLocal *newDecl;
+	bool		reparse;
+
+	// look it up, possibly getting a newly created default decl
+	reparse = false;
+	newDecl = declManagerLocal.FindTypeWithoutParsing( type, name, false );
+	if ( newDecl ) {
+		// update the existing copy
+		if ( newDecl->sourceFile != this || newDecl->redefinedInReload ) {
+			common->Warning( "file %s, line %d: %s '%s' previously defined at %s:%i", fileName.c_str(), line,
+							declManagerLocal.GetDeclNameFromType( type ), name, newDecl->sourceFile->fileName.c_str(), newDecl->sourceLine );
+			return false;
+		}
+		if ( newDecl->declState != DS_UNPARSED ) {
+			reparse = true;
+		}
+	} else {
+		// allow it to be created as a default, then add it to the per-file list
+		newDecl = declManagerLocal.FindTypeWithoutParsing( type, name, true );
+		newDecl->nextInFile = this->decls;
+		this->decls = newDecl;
+	}
+
+	newDecl->redefinedInReload = true;
+
+	// a job may be expanding the old text
+	Mem_Free( declManagerLocal.ClaimExpandedText( newDecl ) );
+
+	if ( newDecl->textSource ) {
+		Mem_Free( newDecl->textSource );
+		newDecl->textSource = NULL;
+	}
+
+	newDecl->SetTextLocal( buffer + offset, size );
+	newDecl->sourceFile = this;
+	newDecl->sourceTextOffset = offset;
+	newDecl->sourceTextLength = size;
+	newDecl->sourceLine = line;
+	newDecl->declState = DS_UNPARSED;
+
+	// if it is currently in use, reparse it immedaitely
+	if ( reparse ) {
+		newDecl->ParseLocal();
+	}
+	return true;
+}
+
 /*
 ================
 idDeclFile::LoadAndParse
@@ -624,8 +764,8 @@ int idDeclFile::LoadAndParse() {
 	int			length, size;
 	int			sourceLine;
 	idStr		name;
-	idDeclLocal *newDecl;
-	bool		reparse;
+	const idDeclCacheFile *cacheFile;
+	idDeclCacheFile *newCacheFile;
 
 	// load the text
 	common->DPrintf( "...loading '%s'\n", fileName.c_str() );
@@ -635,145 +775,145 @@ int idDeclFile::LoadAndParse() {
 		return 0;
 	}
 
-	if ( !src.LoadMemory( buffer, length, fileName ) ) {
-		common->Error( "Couldn't parse %s", fileName.c_str() );
-		Mem_Free( buffer );
-		return 0;
-	}
-
 	// mark all the defs that were from the last reload of this file
 	for ( idDeclLocal *decl = decls; decl; decl = decl->nextInFile ) {
 		decl->redefinedInReload = false;
 	}
 
-	src.SetFlags( DECL_LEXER_FLAGS );
-
 	checksum = MD5_BlockChecksum( buffer, length );
 
 	fileSize = length;
 
-	// scan through, identifying each individual declaration
-	while( 1 ) {
-
-		startMarker = src.GetFileOffset();
-		sourceLine = src.GetLineNum();
+	// if the file didn't change since it was last scanned the decls are where they were then
+	cacheFile = declManagerLocal.FindCacheFile( fileName );
+	if ( cacheFile && ( cacheFile->fileSize != length || cacheFile->checksum != checksum ) ) {
+		cacheFile = NULL;
+	}
+	if ( cacheFile ) {
+		for ( i = 0; i < cacheFile->entries.Num(); i++ ) {
+			if ( declManagerLocal.GetDeclTypeFromName( cacheFile->entries[i].typeName ) == DECL_MAX_TYPES ) {
+				cacheFile = NULL;
+				break;
+			}
+		}
+	}
 
-		// parse the decl type name
-		if ( !src.ReadToken( &token ) ) {
-			break;
+	if ( cacheFile ) {
+		for ( i = 0; i < cacheFile->entries.Num(); i++ ) {
+			const declCacheEntry_t &entry = cacheFile->entries[i];
+			DefineDecl( declManagerLocal.GetDeclTypeFromName( entry.typeName ), entry.name, buffer, entry.offset, entry.size, entry.line );
 		}
+		numLines = cacheFile->numLines;
+	} else {
+		if ( !src.LoadMemory( buffer, length, fileName ) ) {
+			common->Error( "Couldn't parse %s", fileName.c_str() );
+			Mem_Free( buffer );
+			return 0;
+		}
+
+		src.SetFlags( DECL_LEXER_FLAGS );
+
+		newCacheFile = new idDeclCacheFile;
+		newCacheFile->fileName = fileName;
+		newCacheFile->fileSize = length;
+		newCacheFile->checksum = checksum;
+
+		// scan through, identifying each individual declaration
+		while( 1 ) {
 
-		declType_t identifiedType = DECL_MAX_TYPES;
+			startMarker = src.GetFileOffset();
+			sourceLine = src.GetLineNum();
 
-		// get the decl type from the type name
-		numTypes = declManagerLocal.GetNumDeclTypes();
-		for ( i = 0; i < numTypes; i++ ) {
-			idDeclType *typeInfo = declManagerLocal.GetDeclType( i );
-			if ( typeInfo && typeInfo->typeName.Icmp( token ) == 0 ) {
-				identifiedType = (declType_t) typeInfo->type;
+			// parse the decl type name
+			if ( !src.ReadToken( &token ) ) {
 				break;
 			}
-		}
 
-		if ( i >= numTypes ) {
+			declType_t identifiedType = DECL_MAX_TYPES;
 
-			if ( token.Icmp( "{" ) == 0 ) {
+			// get the decl type from the type name
+			numTypes = declManagerLocal.GetNumDeclTypes();
+			for ( i = 0; i < numTypes; i++ ) {
+				idDeclType *typeInfo = declManagerLocal.GetDeclType( i );
+				if ( typeInfo && typeInfo->typeName.Icmp( token ) == 0 ) {
+					identifiedType = (declType_t) typeInfo->type;
+					break;
+				}
+			}
 
-				// if we ever see an open brace, we somehow missed the [type] <name> prefix
-				src.Warning( "Missing decl name" );
-				src.SkipBracedSection( false );
-				continue;
+			if ( i >= numTypes ) {
 
-			} else {
+				if ( token.Icmp( "{" ) == 0 ) {
 
-				if ( defaultType == DECL_MAX_TYPES ) {
-					src.Warning( "No type" );
+					// if we ever see an open brace, we somehow missed the [type] <name> prefix
+					src.Warning( "Missing decl name" );
+					src.SkipBracedSection( false );
 					continue;
+
+				} else {
+
+					if ( defaultType == DECL_MAX_TYPES ) {
+						src.Warning( "No type" );
+						continue;
+					}
+					src.UnreadToken( &token );
+					// use the default type
+					identifiedType = defaultType;
 				}
-				src.UnreadToken( &token );
-				// use the default type
-				identifiedType = defaultType;
 			}
-		}
 
-		// now parse the name
-		if ( !src.ReadToken( &token ) ) {
-			src.Warning( "Type without definition at end of file" );
-			break;
-		}
+			// now parse the name
+			if ( !src.ReadToken( &token ) ) {
+				src.Warning( "Type without definition at end of file" );
+				break;
+			}
 
-		if ( !token.Icmp( "{" ) ) {
-			// if we ever see an open brace, we somehow missed the [type] <name> prefix
-			src.Warning( "Missing decl name" );
-			src.SkipBracedSection( false );
-			continue;
-		}
+			if ( !token.Icmp( "{" ) ) {
+				// if we ever see an open brace, we somehow missed the [type] <name> prefix
+				src.Warning( "Missing decl name" );
+				src.SkipBracedSection( false );
+				continue;
+			}
 
-		// FIXME: export decls are only used by the model exporter, they are skipped here for now
-		if ( identifiedType == DECL_MODELEXPORT ) {
-			src.SkipBracedSection();
-			continue;
-		}
+			// FIXME: export decls are only used by the model exporter, they are skipped here for now
+			if ( identifiedType == DECL_MODELEXPORT ) {
+				src.SkipBracedSection();
+				continue;
+			}
 
-		name = token;
+			name = token;
 
-		// make sure there's a '{'
-		if ( !src.ReadToken( &token ) ) {
-			src.Warning( "Type without definition at end of file" );
-			break;
-		}
-		if ( token != "{" ) {
-			src.Warning( "Expecting '{' but found '%s'", token.c_str() );
-			continue;
-		}
-		src.UnreadToken( &token );
-
-		// now take everything until a matched closing brace
-		src.SkipBracedSection();
-		size = src.GetFileOffset() - startMarker;
-
-		// look it up, possibly getting a newly created default decl
-		reparse = false;
-		newDecl = declManagerLocal.FindTypeWithoutParsing( identifiedType, name, false );
-		if ( newDecl ) {
-			// update the existing copy
-			if ( newDecl->sourceFile != this || newDecl->redefinedInReload ) {
-				src.Warning( "%s '%s' previously defined at %s:%i", declManagerLocal.GetDeclNameFromType( identifiedType ),
-								name.c_str(), newDecl->sourceFile->fileName.c_str(), newDecl->sourceLine );
-				continue;
+			// make sure there's a '{'
+			if ( !src.ReadToken( &token ) ) {
+				src.Warning( "Type without definition at end of file" );
+				break;
 			}
-			if ( newDecl->declState != DS_UNPARSED ) {
-				reparse = true;
+			if ( token != "{" ) {
+				src.Warning( "Expecting '{' but found '%s'", token.c_str() );
+				continue;
 			}
-		} else {
-			// allow it to be created as a default, then add it to the per-file list
-			newDecl = declManagerLocal.FindTypeWithoutParsing( identifiedType, name, true );
-			newDecl->nextInFile = this->decls;
-			this->decls = newDecl;
-		}
+			src.UnreadToken( &token );
+
+			// now take everything until a matched closing brace
+			src.SkipBracedSection();
+			size = src.GetFileOffset() - startMarker;
 
-		newDecl->redefinedInReload = true;
+			declCacheEntry_t &entry = newCacheFile->entries.Alloc();
+			entry.typeName = declManagerLocal.GetDeclNameFromType( identifiedType );
+			entry.name = name;
+			entry.offset = startMarker;
+			entry.size = size;
+			entry.line = sourceLine;
 
-		if ( newDecl->textSource ) {
-			Mem_Free( newDecl->textSource );
-			newDecl->textSource = NULL;
+			DefineDecl( identifiedType, name, buffer, startMarker, size, sourceLine );
 		}
 
-		newDecl->SetTextLocal( buffer + startMarker, size );
-		newDecl->sourceFile = this;
-		newDecl->sourceTextOffset = startMarker;
-		newDecl->sourceTextLength = size;
-		newDecl->sourceLine = sourceLine;
-		newDecl->declState = DS_UNPARSED;
+		numLines = src.GetLineNum();
 
-		// if it is currently in use, reparse it immedaitely
-		if ( reparse ) {
-			newDecl->ParseLocal();
-		}
+		newCacheFile->numLines = numLines;
+		declManagerLocal.UpdateCacheFile( newCacheFile );
 	}
 
-	numLines = src.GetLineNum();
-
 	Mem_Free( buffer );
 
 	// any defs that weren't redefinedInReload should now be defaulted
@@ -814,6 +954,15 @@ void idDeclManagerLocal::Init( void ) {
 	SetupHuffman();
 #endif
 
+	LoadDeclCache();
+
+	memset( parseTime, 0, sizeof( parseTime ) );
+	memset( parseCount, 0, sizeof( parseCount ) );
+	memset( jobParseCount, 0, sizeof( jobParseCount ) );
+	childParseTime = 0;
+	expanding = false;
+	parsingOnJobs = false;
+
 #ifdef GET_HUFFMAN_FREQUENCIES
 	ClearHuffmanFrequencies();
 #endif
@@ -834,6 +983,12 @@ void idDeclManagerLocal::Init( void ) {
 	RegisterDeclType( "video",				DECL_VIDEO,			idDeclAllocator<idDeclVideo> );
 	RegisterDeclType( "audio",				DECL_AUDIO,			idDeclAllocator<idDeclAudio> );
 
+	// these types only look up other decls and media in ResolveReferences() when they are parsed on a job,
+	// materials aren't among them because their parse reads back the images it finds
+	declTypes[DECL_SOUND]->parseOnJobs = true;
+	declTypes[DECL_ENTITYDEF]->parseOnJobs = true;
+	declTypes[DECL_PARTICLE]->parseOnJobs = true;
+
 	RegisterDeclFolder( "materials",		".mtr",				DECL_MATERIAL );
 	RegisterDeclFolder( "skins",			".skin",			DECL_SKIN );
 	RegisterDeclFolder( "sound",			".sndshd",			DECL_SOUND );
@@ -886,6 +1041,9 @@ void idDeclManagerLocal::Shutdown( void ) {
 	int			i, j;
 	idDeclLocal *decl;
 
+	DropExpandedText();
+	jobParseDecls.Clear();
+
 	// free decls
 	for ( i = 0; i < DECL_MAX_TYPES; i++ ) {
 		for ( j = 0; j < linearLists[i].Num(); j++ ) {
@@ -907,6 +1065,11 @@ void idDeclManagerLocal::Shutdown( void ) {
 	// free decl files
 	loadedFiles.DeleteContents( true );
 
+	// keep what was scanned for the next startup
+	WriteDeclCache();
+	cacheFiles.DeleteContents( true );
+	cacheHash.Free();
+
 	// free the decl types and folders
 	declTypes.DeleteContents( true );
 	declFolders.DeleteContents( true );
@@ -922,6 +1085,9 @@ idDeclManagerLocal::Reload
 ===================
 */
 void idDeclManagerLocal::Reload( bool force ) {
+	// the text may change under the jobs
+	DropExpandedText();
+
 	for ( int i = 0; i < loadedFiles.Num(); i++ ) {
 		loadedFiles[i]->Reload( force );
 	}
@@ -935,6 +1101,30 @@ idDeclManagerLocal::BeginLevelLoad
 void idDeclManagerLocal::BeginLevelLoad() {
 	insideLevelLoad = true;
 
+	DropExpandedText();
+
+	jobParseDecls.Clear();
+
+	// most decls of the last level are referenced again by the next one, the job threads
+	// parse the types that support it and decompress the text of the others while the
+	// level loads so the reparse doesn't have to
+	if ( Sys_NumJobThreads() > 0 ) {
+		for ( int i = 0; i < DECL_MAX_TYPES; i++ ) {
+			int	num = linearLists[i].Num();
+			for ( int j = 0 ; j < num ; j++ ) {
+				idDeclLocal *decl = linearLists[i][j];
+				if ( decl->referencedThisLevel && !decl->parsedOutsideLevelLoad && decl->textSource ) {
+					if ( declTypes[i]->parseOnJobs ) {
+						jobParseDecls.Append( decl );
+					} else {
+						decl->expandState = EXPAND_QUEUED;
+						expandDecls.Append( decl );
+					}
+				}
+			}
+		}
+	}
+
 	// clear all the referencedThisLevel flags and purge all the data
 	// so the next reference will cause a reparse
 	for ( int i = 0; i < DECL_MAX_TYPES; i++ ) {
@@ -944,6 +1134,164 @@ void idDeclManagerLocal::BeginLevelLoad() {
 			decl->Purge();
 		}
 	}
+
+	// the purge doesn't touch the text, so the jobs can start now. The parses look up
+	// and add decls, so they are done before the level load goes on
+	if ( jobParseDecls.Num() ) {
+		int start = Sys_Milliseconds();
+
+		for ( int i = 0; i < jobParseDecls.Num(); i += DECL_PARSE_RUN ) {
+			parseJobs.AddJob( ParseDeclsJob, &jobParseDecls[i] );
+		}
+		parsingOnJobs = true;
+		parseJobs.Submit();
+
+		// Wait() would run parses on this thread, where a warning can update the
+		// loading screen and look up decls while the jobs add to the lists
+		while ( !parseJobs.IsDone() ) {
+			Sys_Sleep( 1 );
+		}
+		parseJobs.Wait();
+		parseJobs.Clear();
+		parsingOnJobs = false;
+
+		common->DPrintf( "%i decls parsed on the job threads in %i msec\n", jobParseDecls.Num(), Sys_Milliseconds() - start );
+	}
+
+	if ( expandDecls.Num() ) {
+		for ( int i = 0; i < expandDecls.Num(); i += DECL_EXPAND_RUN ) {
+			expandJobs.AddJob( ExpandTextJob, &expandDecls[i] );
+		}
+		expandJobs.Submit();
+		expanding = true;
+	}
+}
+
+/*
+===================
+idDeclManagerLocal::ExpandTextJob
+
+decompresses the text of a run of decls, the last run may be shorter
+===================
+*/
+void idDeclManagerLocal::ExpandTextJob( void *data ) {
+	idDeclLocal **decls = (idDeclLocal **)data;
+	int first = decls - declManagerLocal.expandDecls.Ptr();
+	int num = Min( DECL_EXPAND_RUN, declManagerLocal.expandDecls.Num() - first );
+
+	for ( int i = 0; i < num; i++ ) {
+		idDeclLocal *decl = decls[i];
+
+		// the decl may have been parsed or given new text already
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+		if ( decl->expandState != EXPAND_QUEUED ) {
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+			continue;
+		}
+		decl->expandState = EXPAND_RUNNING;
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+
+		char *text = (char *)Mem_Alloc( decl->textLength + 1 );
+		decl->GetText( text );
+
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+		decl->expandedText = text;
+		decl->expandState = EXPAND_DONE;
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+	}
+}
+
+/*
+===================
+idDeclManagerLocal::ParseDeclsJob
+
+parses a run of decls, the last run may be shorter
+===================
+*/
+void idDeclManagerLocal::ParseDeclsJob( void *data ) {
+	idDeclLocal **decls = (idDeclLocal **)data;
+	int first = decls - declManagerLocal.jobParseDecls.Ptr();
+	int num = Min( DECL_PARSE_RUN, declManagerLocal.jobParseDecls.Num() - first );
+
+	for ( int i = 0; i < num; i++ ) {
+		decls[i]->ParseOnJob();
+	}
+}
+
+/*
+===================
+idDeclManagerLocal::PurgeUnresolvedDecls
+
+purges the decls parsed on the job threads that the level didn't reference
+===================
+*/
+void idDeclManagerLocal::PurgeUnresolvedDecls( void ) {
+	for ( int i = 0; i < jobParseDecls.Num(); i++ ) {
+		if ( jobParseDecls[i]->resolvePending ) {
+			jobParseDecls[i]->Purge();
+		}
+	}
+	jobParseDecls.Clear();
+}
+
+/*
+===================
+idDeclManagerLocal::ClaimExpandedText
+===================
+*/
+char *idDeclManagerLocal::ClaimExpandedText( idDeclLocal *decl ) {
+	char *text;
+
+	// only the main thread queues decls, so this needs no lock
+	if ( decl->expandState == EXPAND_NONE ) {
+		return NULL;
+	}
+
+	Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+	while ( decl->expandState == EXPAND_RUNNING ) {
+		// a single decl doesn't take long to expand
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+		Sys_Sleep( 0 );
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+	}
+	text = decl->expandedText;
+	decl->expandedText = NULL;
+	decl->expandState = EXPAND_NONE;
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+
+	return text;
+}
+
+/*
+===================
+idDeclManagerLocal::FinishExpanding
+===================
+*/
+void idDeclManagerLocal::FinishExpanding( void ) {
+	if ( expanding ) {
+		expandJobs.Wait();
+		expandJobs.Clear();
+		expanding = false;
+	}
+}
+
+/*
+===================
+idDeclManagerLocal::DropExpandedText
+
+frees the expanded text that wasn't used by a parse
+===================
+*/
+void idDeclManagerLocal::DropExpandedText( void ) {
+	FinishExpanding();
+	for ( int i = 0; i < expandDecls.Num(); i++ ) {
+		if ( expandDecls[i]->expandedText ) {
+			Mem_Free( expandDecls[i]->expandedText );
+			expandDecls[i]->expandedText = NULL;
+		}
+		expandDecls[i]->expandState = EXPAND_NONE;
+	}
+	expandDecls.Clear();
 }
 
 /*
@@ -954,10 +1302,170 @@ idDeclManagerLocal::EndLevelLoad
 void idDeclManagerLocal::EndLevelLoad() {
 	insideLevelLoad = false;
 
+	DropExpandedText();
+	PurgeUnresolvedDecls();
+
+	// all decl folders are registered by now, save the scanned files
+	WriteDeclCache();
+
 	// we don't need to do anything here, but the image manager, model manager,
 	// and sound sample manager will need to free media that was not referenced
 }
 
+/*
+===================
+idDeclManagerLocal::FindCacheFile
+===================
+*/
+const idDeclCacheFile *idDeclManagerLocal::FindCacheFile( const char *fileName ) const {
+	int hash = cacheHash.GenerateKey( fileName, false );
+	for ( int i = cacheHash.First( hash ); i != -1; i = cacheHash.Next( i ) ) {
+		if ( cacheFiles[i]->fileName.Icmp( fileName ) == 0 ) {
+			return cacheFiles[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+===================
+idDeclManagerLocal::UpdateCacheFile
+===================
+*/
+void idDeclManagerLocal::UpdateCacheFile( idDeclCacheFile *cacheFile ) {
+	int hash = cacheHash.GenerateKey( cacheFile->fileName, false );
+	for ( int i = cacheHash.First( hash ); i != -1; i = cacheHash.Next( i ) ) {
+		if ( cacheFiles[i]->fileName.Icmp( cacheFile->fileName ) == 0 ) {
+			delete cacheFiles[i];
+			cacheFiles[i] = cacheFile;
+			cacheDirty = true;
+			return;
+		}
+	}
+	cacheHash.Add( hash, cacheFiles.Append( cacheFile ) );
+	cacheDirty = true;
+}
+
+/*
+===================
+idDeclManagerLocal::LoadDeclCache
+===================
+*/
+void idDeclManagerLocal::LoadDeclCache( void ) {
+	idFile *		f;
+	int				magic, version, size, numFiles, numEntries;
+	int				i, j;
+
+	cacheFiles.DeleteContents( true );
+	cacheHash.Free();
+	cacheDirty = false;
+
+	if ( !decl_cache.GetBool() ) {
+		return;
+	}
+
+	f = fileSystem->OpenExplicitFileRead( fileSystem->RelativePathToOSPath( DECL_CACHE_FILE, "fs_savepath" ) );
+	if ( !f ) {
+		return;
+	}
+
+	// a cache cut short by a crash or kill has a size that doesn't match
+	magic = version = size = numFiles = 0;
+	f->ReadInt( magic );
+	f->ReadInt( version );
+	f->ReadInt( size );
+	if ( magic != DECL_CACHE_MAGIC || version != DECL_CACHE_VERSION || size != f->Length() - f->Tell() ) {
+		fileSystem->CloseFile( f );
+		return;
+	}
+
+	f->ReadInt( numFiles );
+
+	for ( i = 0; i < numFiles; i++ ) {
+		idDeclCacheFile *cacheFile = new idDeclCacheFile;
+		f->ReadString( cacheFile->fileName );
+		f->ReadInt( cacheFile->fileSize );
+		f->ReadInt( cacheFile->checksum );
+		f->ReadInt( cacheFile->numLines );
+		f->ReadInt( numEntries );
+		cacheHash.Add( cacheHash.GenerateKey( cacheFile->fileName, false ), cacheFiles.Append( cacheFile ) );
+		if ( cacheFile->fileSize < 0 || numEntries < 0 || numEntries > size ) {
+			break;
+		}
+		cacheFile->entries.SetNum( numEntries );
+		for ( j = 0; j < numEntries; j++ ) {
+			declCacheEntry_t &entry = cacheFile->entries[j];
+			f->ReadString( entry.typeName );
+			f->ReadString( entry.name );
+			f->ReadInt( entry.offset );
+			f->ReadInt( entry.size );
+			f->ReadInt( entry.line );
+			// the text of every decl has to lie inside the file it was scanned from
+			if ( entry.offset < 0 || entry.size < 0 || entry.offset > cacheFile->fileSize - entry.size ) {
+				break;
+			}
+		}
+		if ( j < numEntries ) {
+			break;
+		}
+	}
+
+	if ( numFiles < 0 || i < numFiles ) {
+		common->Warning( "%s is corrupt, rescanning decl files", DECL_CACHE_FILE );
+		cacheFiles.DeleteContents( true );
+		cacheHash.Free();
+		cacheDirty = true;
+	}
+
+	fileSystem->CloseFile( f );
+}
+
+/*
+===================
+idDeclManagerLocal::WriteDeclCache
+===================
+*/
+void idDeclManagerLocal::WriteDeclCache( void ) {
+	idFile_Memory	body( DECL_CACHE_FILE );
+	idFile *		f;
+	int				i, j;
+
+	if ( !cacheDirty || !decl_cache.GetBool() ) {
+		return;
+	}
+	cacheDirty = false;
+
+	f = &body;
+	f->WriteInt( cacheFiles.Num() );
+	for ( i = 0; i < cacheFiles.Num(); i++ ) {
+		const idDeclCacheFile *cacheFile = cacheFiles[i];
+		f->WriteString( cacheFile->fileName );
+		f->WriteInt( cacheFile->fileSize );
+		f->WriteInt( cacheFile->checksum );
+		f->WriteInt( cacheFile->numLines );
+		f->WriteInt( cacheFile->entries.Num() );
+		for ( j = 0; j < cacheFile->entries.Num(); j++ ) {
+			const declCacheEntry_t &entry = cacheFile->entries[j];
+			f->WriteString( entry.typeName );
+			f->WriteString( entry.name );
+			f->WriteInt( entry.offset );
+			f->WriteInt( entry.size );
+			f->WriteInt( entry.line );
+		}
+	}
+
+	f = fileSystem->OpenFileWrite( DECL_CACHE_FILE );
+	if ( !f ) {
+		common->Warning( "couldn't write %s", DECL_CACHE_FILE );
+		return;
+	}
+	f->WriteInt( DECL_CACHE_MAGIC );
+	f->WriteInt( DECL_CACHE_VERSION );
+	f->WriteInt( body.Length() );
+	f->Write( body.GetDataPtr(), body.Length() );
+	fileSystem->CloseFile( f );
+}
+
 /*
 ===================
 idDeclManagerLocal::RegisterDeclType
@@ -975,6 +1483,7 @@ void idDeclManagerLocal::RegisterDeclType( const char *typeName, declType_t type
 	declType->typeName = typeName;
 	declType->type = type;
 	declType->allocator = allocator;
+	declType->parseOnJobs = false;
 
 	if ( (int)type + 1 > declTypes.Num() ) {
 		declTypes.AssureSize( (int)type + 1, NULL );
@@ -1133,6 +1642,9 @@ const idDecl *idDeclManagerLocal::FindType( declType_t type, const char *name, b
 		//common->Warning( "idDeclManager::FindType: empty %s name", GetDeclType( (int)type )->typeName.c_str() );
 	}
 
+	// a parse on a job thread must use FindDeclWithoutParsing()
+	assert( !parsingOnJobs );
+
 	decl = FindTypeWithoutParsing( type, name, makeDefault );
 	if ( !decl ) {
 		return NULL;
@@ -1162,7 +1674,23 @@ idDeclManagerLocal::FindDeclWithoutParsing
 */
 const idDecl* idDeclManagerLocal::FindDeclWithoutParsing( declType_t type, const char *name, bool makeDefault) {
 	idDeclLocal* decl;
+
+	if ( !name || !name[0] ) {
+		name = "_emptyName";
+	}
+
+	// the parses on the job threads look up and create decls at the same time
+	if ( parsingOnJobs ) {
+		Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
+	}
 	decl = FindTypeWithoutParsing(type, name, makeDefault);
+	if(decl) {
+		decl->AllocateSelf();
+	}
+	if ( parsingOnJobs ) {
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
+	}
+
 	if(decl) {
 		return decl->self;
 	}
@@ -1600,6 +2128,8 @@ void idDeclManagerLocal::ListDecls_f( const idCmdArgs &args ) {
 	int		totalDecls = 0;
 	int		totalText = 0;
 	int		totalStructs = 0;
+	int		totalParses = 0;
+	int		totalParseTime = 0;
 
 	for ( i = 0; i < declManagerLocal.declTypes.Num(); i++ ) {
 		int size, num;
@@ -1620,7 +2150,10 @@ void idDeclManagerLocal::ListDecls_f( const idCmdArgs &args ) {
 		}
 		totalStructs += size;
 
-		common->Printf( "%4ik %4i %s\n", size >> 10, num, declManagerLocal.declTypes[i]->typeName.c_str() );
+		common->Printf( "%4ik %4i %5i parses %5i on jobs %6.1f msec %s\n", size >> 10, num, declManagerLocal.parseCount[i],
+						declManagerLocal.jobParseCount[i], declManagerLocal.parseTime[i] * 0.001f, declManagerLocal.declTypes[i]->typeName.c_str() );
+		totalParses += declManagerLocal.parseCount[i];
+		totalParseTime += declManagerLocal.parseTime[i];
 	}
 
 	for ( i = 0 ; i < declManagerLocal.loadedFiles.Num() ; i++ ) {
@@ -1630,6 +2163,7 @@ void idDeclManagerLocal::ListDecls_f( const idCmdArgs &args ) {
 
 	common->Printf( "%i total decls is %i decl files\n", totalDecls, declManagerLocal.loadedFiles.Num() );
 	common->Printf( "%iKB in text, %iKB in structures\n", totalText >> 10, totalStructs >> 10 );
+	common->Printf( "%i parses in %i msec\n", totalParses, totalParseTime / 1000 );
 }
 
 /*
@@ -1767,6 +2301,8 @@ idDeclLocal::idDeclLocal
 idDeclLocal::idDeclLocal( void ) {
 	name = "unnamed";
 	textSource = NULL;
+	expandedText = NULL;
+	expandState = EXPAND_NONE;
 	textLength = 0;
 	compressedLength = 0;
 	sourceFile = NULL;
@@ -1777,10 +2313,13 @@ idDeclLocal::idDeclLocal( void ) {
 	type = DECL_ENTITYDEF;
 	index = 0;
 	declState = DS_UNPARSED;
+	jobState = DS_UNPARSED;
 	parsedOutsideLevelLoad = false;
 	referencedThisLevel = false;
 	everReferenced = false;
 	redefinedInReload = false;
+	parsingOnJob = false;
+	resolvePending = false;
 	nextInFile = NULL;
 }
 
@@ -1836,6 +2375,7 @@ idDeclLocal::Invalidate
 */
 void idDeclLocal::Invalidate( void ) {
 	declState = DS_UNPARSED;
+	resolvePending = false;
 }
 
 /*
@@ -1923,6 +2463,12 @@ idDeclLocal::SetTextLocal
 */
 void idDeclLocal::SetTextLocal( const char *text, const int length ) {
 
+	// a job may be expanding the old text
+	Mem_Free( declManagerLocal.ClaimExpandedText( this ) );
+
+	// the data parsed from the old text is freed by the next parse
+	resolvePending = false;
+
 	Mem_Free( textSource );
 
 	checksum = MD5_BlockChecksum( text, length );
@@ -2066,6 +2612,7 @@ void idDeclLocal::MakeDefault() {
 
 	declManagerLocal.MediaPrint( "DEFAULTED\n" );
 	declState = DS_DEFAULTED;
+	resolvePending = false;
 
 	AllocateSelf();
 
@@ -2075,7 +2622,8 @@ void idDeclLocal::MakeDefault() {
 	// cause an infinite loop, but normal default definitions could
 	// still reference other default definitions, so we can't
 	// just dump out on the first recursion
-	if ( ++recursionLevel > 100 ) {
+	// the parses on the job threads can get here at the same time
+	if ( Sys_InterlockedAdd( recursionLevel, 1 ) > 100 ) {
 		common->FatalError( "idDecl::MakeDefault: bad DefaultDefinition(): %s", defaultText );
 	}
 
@@ -2086,7 +2634,7 @@ void idDeclLocal::MakeDefault() {
 	self->Parse( defaultText, strlen( defaultText ) );
 
 	// we could still eventually hit the recursion if we have enough Error() calls inside Parse...
-	--recursionLevel;
+	Sys_InterlockedAdd( recursionLevel, -1 );
 }
 
 /*
@@ -2122,6 +2670,14 @@ bool idDeclLocal::Parse( const char *text, const int textLength ) {
 	return true;
 }
 
+/*
+=================
+idDeclLocal::ResolveReferences
+=================
+*/
+void idDeclLocal::ResolveReferences( void ) {
+}
+
 /*
 =================
 idDeclLocal::FreeData
@@ -2178,6 +2734,12 @@ void idDeclLocal::ParseLocal( void ) {
 
 	AllocateSelf();
 
+	// the text was parsed on a job at the start of the level load, only the references are left
+	if ( resolvePending ) {
+		ResolveLocal();
+		return;
+	}
+
 	// always free data before parsing
 	self->FreeData();
 
@@ -2200,10 +2762,26 @@ void idDeclLocal::ParseLocal( void ) {
 
 	declState = DS_PARSED;
 
-	// parse
-	char *declText = (char *) _alloca( ( GetTextLength() + 1 ) * sizeof( char ) );
-	GetText( declText );
-	self->Parse( declText, GetTextLength() );
+	unsigned int parseStart = Sys_Microseconds();
+	int outerChildTime = declManagerLocal.childParseTime;
+	declManagerLocal.childParseTime = 0;
+
+	// parse, from the text expanded at the start of the level load if there is any
+	char *expanded = declManagerLocal.ClaimExpandedText( this );
+	if ( expanded ) {
+		char *declText = expanded;
+		self->Parse( declText, GetTextLength() );
+		Mem_Free( declText );
+	} else {
+		char *declText = (char *) _alloca( ( GetTextLength() + 1 ) * sizeof( char ) );
+		GetText( declText );
+		self->Parse( declText, GetTextLength() );
+	}
+
+	int parseTime = Sys_Microseconds() - parseStart;
+	declManagerLocal.parseTime[type] += parseTime - declManagerLocal.childParseTime;
+	declManagerLocal.parseCount[type]++;
+	declManagerLocal.childParseTime = outerChildTime + parseTime;
 
 	// free generated text
 	if ( generatedDefaultText ) {
@@ -2215,6 +2793,62 @@ void idDeclLocal::ParseLocal( void ) {
 	declManagerLocal.indent--;
 }
 
+/*
+=================
+idDeclLocal::ParseOnJob
+=================
+*/
+void idDeclLocal::ParseOnJob( void ) {
+	char *declText = (char *)Mem_Alloc( GetTextLength() + 1 );
+	GetText( declText );
+
+	unsigned int parseStart = Sys_Microseconds();
+
+	// always free data before parsing
+	parsingOnJob = true;
+	self->FreeData();
+	declState = DS_PARSED;
+	self->Parse( declText, GetTextLength() );
+	parsingOnJob = false;
+
+	Sys_InterlockedAdd( declManagerLocal.parseTime[type], Sys_Microseconds() - parseStart );
+	Sys_InterlockedAdd( declManagerLocal.parseCount[type], 1 );
+	Sys_InterlockedAdd( declManagerLocal.jobParseCount[type], 1 );
+
+	Mem_Free( declText );
+
+	// keep it from being used before ParseLocal() resolved the references
+	jobState = declState;
+	declState = DS_UNPARSED;
+	resolvePending = true;
+}
+
+/*
+=================
+idDeclLocal::ResolveLocal
+=================
+*/
+void idDeclLocal::ResolveLocal( void ) {
+	declManagerLocal.MediaPrint( "parsing %s %s\n", declManagerLocal.declTypes[type]->typeName.c_str(), name.c_str() );
+
+	declManagerLocal.indent++;
+
+	resolvePending = false;
+	declState = jobState;
+
+	unsigned int resolveStart = Sys_Microseconds();
+	int outerChildTime = declManagerLocal.childParseTime;
+	declManagerLocal.childParseTime = 0;
+
+	self->ResolveReferences();
+
+	int resolveTime = Sys_Microseconds() - resolveStart;
+	declManagerLocal.parseTime[type] += resolveTime - declManagerLocal.childParseTime;
+	declManagerLocal.childParseTime = outerChildTime + resolveTime;
+
+	declManagerLocal.indent--;
+}
+
 /*
 =================
 idDeclLocal::Purge
@@ -2242,3 +2876,12 @@ idDeclLocal::EverReferenced
 bool idDeclLocal::EverReferenced( void ) const {
 	return everReferenced;
 }
+
+/*
+=================
+idDeclLocal::ParsingOnJob
+=================
+*/
+bool idDeclLocal::ParsingOnJob( void ) const {
+	return parsingOnJob;
+}
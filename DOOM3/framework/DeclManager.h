@@ -123,9 +123,11 @@ public:
 	virtual bool			SourceFileChanged( void ) const = 0;
 	virtual void			MakeDefault( void ) = 0;
 	virtual bool			EverReferenced( void ) const = 0;
+	virtual bool			ParsingOnJob( void ) const = 0;
 	virtual bool			SetDefaultText( void ) = 0;
 	virtual const char *	DefaultDefinition( void ) const = 0;
 	virtual bool			Parse( const char *text, const int textLength ) = 0;
+	virtual void			ResolveReferences( void ) = 0;
 	virtual void			FreeData( void ) = 0;
 	virtual size_t			Size( void ) const = 0;
 	virtual void			List( void ) const = 0;
@@ -196,6 +198,11 @@ public:
 							// Returns true if the decl was ever referenced.
 	bool					EverReferenced( void ) const { return base->EverReferenced(); }
 
+							// Returns true while Parse() runs on a job thread at the start of a level load.
+							// The parse must not cause other decls to be parsed or media to be loaded then,
+							// it keeps the unparsed decls and the media names for ResolveReferences().
+	bool					ParsingOnJob( void ) const { return base->ParsingOnJob(); }
+
 public:
 							// Sets textSource to a default text if necessary.
 							// This may be overridden to provide a default definition based on the
@@ -217,6 +224,10 @@ public:
 							// there are parse errors.
 	virtual bool			Parse( const char *text, const int textLength ) { return base->Parse( text, textLength ); }
 
+							// Called on the main thread when a decl that was parsed on a job thread is first
+							// found, to parse the decls and touch the media the Parse() left for later.
+	virtual void			ResolveReferences( void ) { base->ResolveReferences(); }
+
 							// Frees any pointers held by the subclass. This may be called before
 							// any Parse(), so the constructor must have set sane values. The decl will be
 							// invalid after issuing this call, but it will always be immediately followed
@@ -285,6 +296,8 @@ public:
 							// if the decl wasn't explcitly defined.
 	virtual const idDecl *	FindType( declType_t type, const char *name, bool makeDefault = true ) = 0;
 
+							// Like FindType() but the decl isn't parsed or marked as referenced.
+							// This is the lookup a Parse() on a job thread has to use.
 	virtual const idDecl*	FindDeclWithoutParsing( declType_t type, const char *name, bool makeDefault = true ) = 0;
 
 	virtual void			ReloadFile( const char* filename, bool force ) = 0;
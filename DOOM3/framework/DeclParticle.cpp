@@ -28,6 +28,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "sys/platform.h"
 #include "idlib/geometry/DrawVert.h"
+#include "idlib/math/Simd.h"
 #include "framework/File.h"
 #include "renderer/RenderWorld.h"
 
@@ -207,7 +208,7 @@ void idDeclParticle::ParseParametric( idLexer &src, idParticleParm *parm ) {
 		}
 	} else {
 		// table
-		parm->table = static_cast<const idDeclTable *>( declManager->FindType( DECL_TABLE, token, false ) );
+		parm->table = LookupTable( token );
 	}
 
 }
@@ -221,7 +222,7 @@ idParticleStage *idDeclParticle::ParseParticleStage( idLexer &src ) {
 	idToken token;
 
 	idParticleStage *stage = new idParticleStage;
-	stage->Default();
+	stage->Default( LookupMaterial( "_default" ) );
 
 	while (1) {
 		if ( src.HadError() ) {
@@ -235,7 +236,7 @@ idParticleStage *idDeclParticle::ParseParticleStage( idLexer &src ) {
 		}
 		if ( !token.Icmp( "material" ) ) {
 			src.ReadToken( &token );
-			stage->material = declManager->FindMaterial( token.c_str() );
+			stage->material = LookupMaterial( token.c_str() );
 			continue;
 		}
 		if ( !token.Icmp( "count" ) ) {
@@ -464,9 +465,17 @@ bool idDeclParticle::Parse( const char *text, const int textLength ) {
 		return false;
 	}
 
-	//
-	// calculate the bounds
-	//
+	CalculateBounds();
+
+	return true;
+}
+
+/*
+================
+idDeclParticle::CalculateBounds
+================
+*/
+void idDeclParticle::CalculateBounds( void ) {
 	bounds.Clear();
 	for( int i = 0; i < stages.Num(); i++ ) {
 		GetStageBounds( stages[i] );
@@ -476,10 +485,74 @@ bool idDeclParticle::Parse( const char *text, const int textLength ) {
 	if ( bounds.GetVolume() <= 0.1f ) {
 		bounds = idBounds( vec3_origin ).Expand( 8.0f );
 	}
+}
+
+/*
+================
+idDeclParticle::LookupMaterial
+
+a parse on a job thread leaves the parse of the material to ResolveReferences()
+================
+*/
+const idMaterial *idDeclParticle::LookupMaterial( const char *name ) const {
+	if ( ParsingOnJob() ) {
+		return static_cast<const idMaterial *>( declManager->FindDeclWithoutParsing( DECL_MATERIAL, name ) );
+	}
+	return declManager->FindMaterial( name );
+}
+
+/*
+================
+idDeclParticle::LookupTable
+================
+*/
+const idDeclTable *idDeclParticle::LookupTable( const char *name ) const {
+	if ( ParsingOnJob() ) {
+		return static_cast<const idDeclTable *>( declManager->FindDeclWithoutParsing( DECL_TABLE, name, false ) );
+	}
+	return static_cast<const idDeclTable *>( declManager->FindType( DECL_TABLE, name, false ) );
+}
+
+/*
+================
+idDeclParticle::ResolveTable
 
+returns true if the parm uses a table
+================
+*/
+bool idDeclParticle::ResolveTable( idParticleParm *parm ) {
+	if ( !parm->table ) {
+		return false;
+	}
+	parm->table = static_cast<const idDeclTable *>( declManager->FindType( DECL_TABLE, parm->table->GetName(), false ) );
 	return true;
 }
 
+/*
+================
+idDeclParticle::ResolveReferences
+================
+*/
+void idDeclParticle::ResolveReferences( void ) {
+	bool usesTables = false;
+
+	for ( int i = 0; i < stages.Num(); i++ ) {
+		idParticleStage *stage = stages[i];
+
+		stage->material = declManager->FindMaterial( stage->material->GetName() );
+
+		usesTables |= ResolveTable( &stage->speed );
+		usesTables |= ResolveTable( &stage->rotationSpeed );
+		usesTables |= ResolveTable( &stage->size );
+		usesTables |= ResolveTable( &stage->aspect );
+	}
+
+	// the tables weren't parsed yet when the job calculated the bounds
+	if ( usesTables ) {
+		CalculateBounds();
+	}
+}
+
 /*
 ================
 idDeclParticle::FreeData
@@ -739,11 +812,11 @@ idParticleStage::idParticleStage( void ) {
 ================
 idParticleStage::Default
 
-Sets the stage to a default state
+Sets the stage to a default state, defaultMaterial is the _default material if the caller already found it
 ================
 */
-void idParticleStage::Default() {
-	material = declManager->FindMaterial( "_default" );
+void idParticleStage::Default( const idMaterial *defaultMaterial ) {
+	material = defaultMaterial ? defaultMaterial : declManager->FindMaterial( "_default" );
 	totalParticles = 100;
 	spawnBunching = 1.0f;
 	particleLife = 1.5f;
@@ -1334,6 +1407,361 @@ int idParticleStage::CreateParticle( particleGen_t *g, idDrawVert *verts ) const
 	return numVerts * 2;
 }
 
+/*
+================
+idParticleStage::CreateParticleBatch
+
+Creates the same verts as calling CreateParticle for each particle of the
+batch, but evaluates them one step at a time for all the particles, so the
+loops run over arrays and the quads are built by the SIMD processor.  Custom
+paths, aimed particles and integrated tables still go one particle at a time.
+The verts stay on the CPU like those of every other dynamic surface, they go
+through the frame vertex cache and the deforms and bounds read them.
+================
+*/
+int idParticleStage::CreateParticleBatch( particleGen_t *g, particleBatch_t *batch, idDrawVert *verts ) const {
+	int			i, j, num, numVerts;
+	int			slot[MAX_PARTICLE_BATCH];
+	int			index[MAX_PARTICLE_BATCH];
+	float		frac[MAX_PARTICLE_BATCH];
+	float		age[MAX_PARTICLE_BATCH];
+	idRandom	random[MAX_PARTICLE_BATCH];
+	byte		colors[MAX_PARTICLE_BATCH][4];
+	float		x[MAX_PARTICLE_BATCH], y[MAX_PARTICLE_BATCH], z[MAX_PARTICLE_BATCH];
+	float		width[MAX_PARTICLE_BATCH], height[MAX_PARTICLE_BATCH];
+	float		cosAngle[MAX_PARTICLE_BATCH], sinAngle[MAX_PARTICLE_BATCH];
+	float		frameFrac[MAX_PARTICLE_BATCH];
+
+	num = batch->numParticles;
+	batch->numParticles = 0;
+
+	if ( customPathType != PPATH_STANDARD || orientation == POR_AIMED || ( directionType != PDIR_CONE && directionType != PDIR_OUTWARD ) ||
+			speed.table != NULL || rotationSpeed.table != NULL ) {
+		numVerts = 0;
+		for ( i = 0; i < num; i++ ) {
+			g->index = batch->index[i];
+			g->frac = batch->frac[i];
+			g->random = batch->random[i];
+			g->originalRandom = batch->random[i];
+			g->age = g->frac * particleLife;
+			if ( batch->localOrigins ) {
+				g->origin = batch->origin[i];
+				g->axis = batch->axis[i];
+			}
+			numVerts += CreateParticle( g, verts + numVerts );
+		}
+		return numVerts;
+	}
+
+	//
+	// colors, dropping the particles that are completely faded out
+	//
+	const float *baseColor = ( entityColor ) ? g->renderEnt->shaderParms : color.ToFloatPtr();
+
+	for ( i = 0, j = 0; i < num; i++ ) {
+		float fadeFraction = 1.0f;
+
+		// same as ParticleColors
+		if ( batch->frac[i] < fadeInFraction ) {
+			fadeFraction *= ( batch->frac[i] / fadeInFraction );
+		}
+		if ( 1.0f - batch->frac[i] < fadeOutFraction ) {
+			fadeFraction *= ( ( 1.0f - batch->frac[i] ) / fadeOutFraction );
+		}
+		if ( fadeIndexFraction ) {
+			float indexFrac = ( totalParticles - batch->index[i] ) / (float)totalParticles;
+			if ( indexFrac < fadeIndexFraction ) {
+				fadeFraction *= indexFrac / fadeIndexFraction;
+			}
+		}
+
+		int visible = 0;
+		for ( int k = 0; k < 4; k++ ) {
+			float fcolor = baseColor[k] * fadeFraction + fadeColor[k] * ( 1.0f - fadeFraction );
+			int icolor = idMath::FtoiFast( fcolor * 255.0f );
+			if ( icolor < 0 ) {
+				icolor = 0;
+			} else if ( icolor > 255 ) {
+				icolor = 255;
+			}
+			colors[j][k] = icolor;
+			visible |= icolor;
+		}
+
+		// always write, only advance for visible particles
+		slot[j] = i;
+		index[j] = batch->index[i];
+		frac[j] = batch->frac[i];
+		age[j] = batch->frac[i] * particleLife;
+		random[j] = batch->random[i];
+		j += ( visible != 0 );
+	}
+	num = j;
+
+	if ( num == 0 ) {
+		return 0;
+	}
+
+	//
+	// initial origin distribution, same as ParticleOrigin
+	//
+	float radiusSqr, angle1, angle2;
+
+	switch( distributionType ) {
+		case PDIST_RECT: {
+			for ( i = 0; i < num; i++ ) {
+				x[i] = ( ( randomDistribution ) ? random[i].CRandomFloat() : 1.0f ) * distributionParms[0];
+				y[i] = ( ( randomDistribution ) ? random[i].CRandomFloat() : 1.0f ) * distributionParms[1];
+				z[i] = ( ( randomDistribution ) ? random[i].CRandomFloat() : 1.0f ) * distributionParms[2];
+			}
+			break;
+		}
+		case PDIST_CYLINDER: {
+			for ( i = 0; i < num; i++ ) {
+				angle1 = ( ( randomDistribution ) ? random[i].CRandomFloat() : 1.0f ) * idMath::TWO_PI;
+
+				idMath::SinCos16( angle1, x[i], y[i] );
+				z[i] = ( ( randomDistribution ) ? random[i].CRandomFloat() : 1.0f );
+
+				if ( distributionParms[3] > 0.0f ) {
+					radiusSqr = x[i] * x[i] + y[i] * y[i];
+					if ( radiusSqr < distributionParms[3] * distributionParms[3] ) {
+						float f = sqrt( radiusSqr ) / distributionParms[3];
+						float invf = 1.0f / f;
+						float newRadius = distributionParms[3] + f * ( 1.0f - distributionParms[3] );
+						float rescale = invf * newRadius;
+
+						x[i] *= rescale;
+						y[i] *= rescale;
+					}
+				}
+				x[i] *= distributionParms[0];
+				y[i] *= distributionParms[1];
+				z[i] *= distributionParms[2];
+			}
+			break;
+		}
+		case PDIST_SPHERE: {
+			for ( i = 0; i < num; i++ ) {
+				if ( randomDistribution ) {
+					do {
+						x[i] = random[i].CRandomFloat();
+						y[i] = random[i].CRandomFloat();
+						z[i] = random[i].CRandomFloat();
+						radiusSqr = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+					} while( radiusSqr > 1.0f );
+				} else {
+					x[i] = y[i] = z[i] = 1.0f;
+					radiusSqr = 3.0f;
+				}
+
+				if ( distributionParms[3] > 0.0f ) {
+					if ( radiusSqr < distributionParms[3] * distributionParms[3] ) {
+						float f = sqrt( radiusSqr ) / distributionParms[3];
+						float invf = 1.0f / f;
+						float newRadius = distributionParms[3] + f * ( 1.0f - distributionParms[3] );
+						float rescale = invf * newRadius;
+
+						x[i] *= rescale;
+						y[i] *= rescale;
+						z[i] *= rescale;
+					}
+				}
+				x[i] *= distributionParms[0];
+				y[i] *= distributionParms[1];
+				z[i] *= distributionParms[2];
+			}
+			break;
+		}
+	}
+
+	for ( i = 0; i < num; i++ ) {
+		x[i] += offset[0];
+		y[i] += offset[1];
+		z[i] += offset[2];
+	}
+
+	//
+	// add the velocity over time
+	//
+	if ( directionType == PDIR_CONE ) {
+		for ( i = 0; i < num; i++ ) {
+			angle1 = random[i].CRandomFloat() * directionParms[0] * idMath::M_DEG2RAD;
+			angle2 = random[i].CRandomFloat() * idMath::PI;
+
+			float s1, c1, s2, c2;
+			idMath::SinCos16( angle1, s1, c1 );
+			idMath::SinCos16( angle2, s2, c2 );
+
+			float iSpeed = speed.Integrate( frac[i], random[i] );
+			x[i] += s1 * c2 * iSpeed * particleLife;
+			y[i] += s1 * s2 * iSpeed * particleLife;
+			z[i] += c1 * iSpeed * particleLife;
+		}
+	} else {
+		for ( i = 0; i < num; i++ ) {
+			idVec3 dir( x[i], y[i], z[i] );
+			dir.Normalize();
+			dir[2] += directionParms[0];
+
+			float iSpeed = speed.Integrate( frac[i], random[i] );
+			x[i] += dir[0] * iSpeed * particleLife;
+			y[i] += dir[1] * iSpeed * particleLife;
+			z[i] += dir[2] * iSpeed * particleLife;
+		}
+	}
+
+	// adjust for the per-particle smoke offset
+	for ( i = 0; i < num; i++ ) {
+		const idMat3 &axis = ( batch->localOrigins ) ? batch->axis[slot[i]] : g->axis;
+		const idVec3 &origin = ( batch->localOrigins ) ? batch->origin[slot[i]] : g->origin;
+		idVec3 v( x[i], y[i], z[i] );
+
+		v *= axis;
+		v += origin;
+
+		x[i] = v[0];
+		y[i] = v[1];
+		z[i] = v[2];
+	}
+
+	// add gravity after adjusting for axis
+	if ( worldGravity ) {
+		idVec3 gra( 0, 0, -gravity );
+		gra *= g->renderEnt->axis.Transpose();
+		for ( i = 0; i < num; i++ ) {
+			x[i] += gra[0] * age[i] * age[i];
+			y[i] += gra[1] * age[i] * age[i];
+			z[i] += gra[2] * age[i] * age[i];
+		}
+	} else {
+		for ( i = 0; i < num; i++ ) {
+			z[i] -= gravity * age[i] * age[i];
+		}
+	}
+
+	//
+	// size and constant rotation, same as ParticleVerts
+	//
+	for ( i = 0; i < num; i++ ) {
+		float psize = size.Eval( frac[i], random[i] );
+		float paspect = aspect.Eval( frac[i], random[i] );
+
+		width[i] = psize;
+		height[i] = psize * paspect;
+
+		float angle = ( initialAngle ) ? initialAngle : 360 * random[i].RandomFloat();
+		float angleMove = rotationSpeed.Integrate( frac[i], random[i] ) * particleLife;
+		if ( index[i] & 1 ) {
+			angle += angleMove;
+		} else {
+			angle -= angleMove;
+		}
+
+		angle = angle / 180 * idMath::PI;
+		cosAngle[i] = idMath::Cos16( angle );
+		sinAngle[i] = idMath::Sin16( angle );
+	}
+
+	// the quads are rotated in the plane of these
+	idVec3 left, up;
+
+	if ( orientation == POR_Z ) {
+		left.Set( 0.0f, 1.0f, 0.0f );
+		up.Set( 1.0f, 0.0f, 0.0f );
+	} else if ( orientation == POR_X ) {
+		left.Set( 0.0f, 1.0f, 0.0f );
+		up.Set( 0.0f, 0.0f, 1.0f );
+	} else if ( orientation == POR_Y ) {
+		left.Set( 1.0f, 0.0f, 0.0f );
+		up.Set( 0.0f, 0.0f, 1.0f );
+	} else {
+		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[1], left );
+		g->renderEnt->axis.ProjectVector( g->renderView->viewaxis[2], up );
+	}
+
+	//
+	// texture coordinates and colors, same as ParticleTexCoords
+	//
+	float s, sWidth;
+
+	sWidth = 1.0f;
+	if ( animationFrames > 1 ) {
+		sWidth = 1.0f / animationFrames;
+	}
+
+	for ( i = 0; i < num; i++ ) {
+		idDrawVert *v = verts + i * 4;
+
+		s = 0.0f;
+		if ( animationFrames > 1 ) {
+			float floatFrame;
+			if ( animationRate ) {
+				floatFrame = age[i] * animationRate;
+			} else {
+				floatFrame = frac[i] * animationFrames;
+			}
+			int	intFrame = (int)floatFrame;
+			frameFrac[i] = floatFrame - intFrame;
+			s = sWidth * intFrame;
+		}
+
+		for ( j = 0; j < 4; j++ ) {
+			v[j].Clear();
+			v[j].color[0] = colors[i][0];
+			v[j].color[1] = colors[i][1];
+			v[j].color[2] = colors[i][2];
+			v[j].color[3] = colors[i][3];
+		}
+
+		v[0].st[0] = s;
+		v[0].st[1] = 0.0f;
+		v[1].st[0] = s + sWidth;
+		v[1].st[1] = 0.0f;
+		v[2].st[0] = s;
+		v[2].st[1] = 1.0f;
+		v[3].st[0] = s + sWidth;
+		v[3].st[1] = 1.0f;
+	}
+
+	SIMDProcessor->CreateParticleQuads( verts, x, y, z, width, height, cosAngle, sinAngle, left, up, num );
+
+	if ( animationFrames <= 1 ) {
+		return num * 4;
+	}
+
+	// spread the quads out from the back and cross fade each one with a copy, same as CreateParticle
+	for ( i = num - 1; i >= 0; i-- ) {
+		idDrawVert quad[4];
+		float iFrac = 1.0f - frameFrac[i];
+
+		for ( j = 0; j < 4; j++ ) {
+			quad[j] = verts[i * 4 + j];
+		}
+		for ( j = 0; j < 4; j++ ) {
+			idDrawVert &v0 = verts[i * 8 + j];
+			idDrawVert &v1 = verts[i * 8 + 4 + j];
+
+			v0 = quad[j];
+			v1 = quad[j];
+
+			v1.st[0] += sWidth;
+
+			v1.color[0] *= frameFrac[i];
+			v1.color[1] *= frameFrac[i];
+			v1.color[2] *= frameFrac[i];
+			v1.color[3] *= frameFrac[i];
+
+			v0.color[0] *= iFrac;
+			v0.color[1] *= iFrac;
+			v0.color[2] *= iFrac;
+			v0.color[3] *= iFrac;
+		}
+	}
+
+	return num * 8;
+}
+
 /*
 ==================
 idParticleStage::GetCustomPathName
@@ -105,6 +105,19 @@ typedef struct {
 	float					animationFrameFrac;	// set by ParticleTexCoords, used to make the cross faded version
 } particleGen_t;
 
+const int MAX_PARTICLE_BATCH =	64;
+
+// particles that passed the age tests, collected to be created together
+typedef struct {
+	int						numParticles;
+	bool					localOrigins;		// use the origins and axis below instead of the ones in particleGen_t
+	int						index[MAX_PARTICLE_BATCH];
+	float					frac[MAX_PARTICLE_BATCH];
+	idRandom				random[MAX_PARTICLE_BATCH];
+	idVec3					origin[MAX_PARTICLE_BATCH];
+	idMat3					axis[MAX_PARTICLE_BATCH];
+} particleBatch_t;
+
 
 //
 // single particle stage
@@ -114,10 +127,12 @@ public:
 							idParticleStage( void );
 	virtual					~idParticleStage( void ) {}
 
-	void					Default();
+	void					Default( const idMaterial *defaultMaterial = NULL );
 	virtual int				NumQuadsPerParticle() const;	// includes trails and cross faded animations
 	// returns the number of verts created, which will range from 0 to 4*NumQuadsPerParticle()
 	virtual int				CreateParticle( particleGen_t *g, idDrawVert *verts ) const;
+	// creates all the particles of the batch and empties it, returns the number of verts created
+	int						CreateParticleBatch( particleGen_t *g, particleBatch_t *batch, idDrawVert *verts ) const;
 
 	void					ParticleOrigin( particleGen_t *g, idVec3 &origin ) const;
 	int						ParticleVerts( particleGen_t *g, const idVec3 origin, idDrawVert *verts ) const;
@@ -205,6 +220,7 @@ public:
 	virtual size_t			Size( void ) const;
 	virtual const char *	DefaultDefinition( void ) const;
 	virtual bool			Parse( const char *text, const int textLength );
+	virtual void			ResolveReferences( void );
 	virtual void			FreeData( void );
 
 	bool					Save( const char *fileName = NULL );
@@ -216,6 +232,10 @@ public:
 private:
 	bool					RebuildTextSource( void );
 	void					GetStageBounds( idParticleStage *stage );
+	void					CalculateBounds( void );
+	const idMaterial *		LookupMaterial( const char *name ) const;
+	const idDeclTable *		LookupTable( const char *name ) const;
+	bool					ResolveTable( idParticleParm *parm );
 	idParticleStage *		ParseParticleStage( idLexer &src );
 	void					ParseParms( idLexer &src, float *parms, int maxParms );
 	void					ParseParametric( idLexer &src, idParticleParm *parm );
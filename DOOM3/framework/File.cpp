@@ -1363,3 +1363,123 @@ int idFile_InZip::Seek( long offset, fsOrigin_t origin ) {
 	}
 	return -1;
 }
+
+/*
+=================================================================================
+
+idFile_InZipMapped
+
+=================================================================================
+*/
+
+/*
+=================
+idFile_InZipMapped::idFile_InZipMapped
+=================
+*/
+idFile_InZipMapped::idFile_InZipMapped( const char *name, const char *fullPath, const byte *data, int compressedSize, int length, bool deflated ) :
+	idFile_Memory( name, deflated ? (const char *)NULL : (const char *)data, deflated ? 0 : length ) {
+	this->fullPath = fullPath;
+	this->source = deflated ? data : NULL;
+	this->compressedSize = compressedSize;
+	this->length = length;
+	inflated = NULL;
+	failed = false;
+}
+
+/*
+=================
+idFile_InZipMapped::~idFile_InZipMapped
+=================
+*/
+idFile_InZipMapped::~idFile_InZipMapped( void ) {
+	Mem_Free( inflated );
+}
+
+/*
+=================
+idFile_InZipMapped::Inflate
+=================
+*/
+bool idFile_InZipMapped::Inflate( void ) {
+	z_stream	stream;
+	int			err;
+
+	if ( !source ) {
+		return !failed;
+	}
+
+	inflated = (char *)Mem_Alloc( length + 1 );
+
+	memset( &stream, 0, sizeof( stream ) );
+	stream.next_in = (Bytef *)source;
+	stream.avail_in = compressedSize;
+	stream.next_out = (Bytef *)inflated;
+	stream.avail_out = length;
+
+	// zip entries are raw deflate streams without a zlib header
+	err = inflateInit2( &stream, -MAX_WBITS );
+	if ( err == Z_OK ) {
+		err = inflate( &stream, Z_FINISH );
+		inflateEnd( &stream );
+	}
+	if ( ( err != Z_STREAM_END && err != Z_OK ) || (int)stream.total_out != length ) {
+		failed = true;
+		Mem_Free( inflated );
+		inflated = NULL;
+		source = NULL;
+		return false;
+	}
+	inflated[length] = '\0';
+
+	source = NULL;
+	SetData( inflated, length );
+	return true;
+}
+
+/*
+=================
+idFile_InZipMapped::ReleaseData
+=================
+*/
+char *idFile_InZipMapped::ReleaseData( void ) {
+	char *data;
+
+	if ( !Inflate() || !inflated ) {
+		return NULL;
+	}
+	data = inflated;
+	inflated = NULL;
+	SetData( NULL, 0 );
+	length = 0;
+	return data;
+}
+
+/*
+=================
+idFile_InZipMapped::Read
+=================
+*/
+int idFile_InZipMapped::Read( void *buffer, int len ) {
+	int l;
+
+	if ( !Inflate() ) {
+		common->Warning( "idFile_InZipMapped::Read: couldn't inflate %s", fullPath.c_str() );
+		return 0;
+	}
+	l = idFile_Memory::Read( buffer, len );
+	fileSystem->AddToReadCount( l );
+	return l;
+}
+
+/*
+=================
+idFile_InZipMapped::Seek
+=================
+*/
+int idFile_InZipMapped::Seek( long offset, fsOrigin_t origin ) {
+	if ( !Inflate() ) {
+		return -1;
+	}
+	return idFile_Memory::Seek( offset, origin );
+}
@@ -245,4 +245,35 @@ private:
 	void *					z;				// unzip info
 };
 
+
+// a file in a memory mapped pak, stored files are read straight from the mapping,
+// deflated files are inflated into memory on the first read
+class idFile_InZipMapped : public idFile_Memory {
+	friend class			idFileSystemLocal;
+
+public:
+							idFile_InZipMapped( const char *name, const char *fullPath, const byte *data, int compressedSize, int length, bool deflated );
+	virtual					~idFile_InZipMapped( void );
+
+	virtual const char *	GetFullPath( void ) { return fullPath.c_str(); }
+	virtual int				Read( void *buffer, int len );
+	virtual int				Length( void ) { return length; }
+	virtual int				Seek( long offset, fsOrigin_t origin );
+
+							// inflates a deflated file, only touches the file itself so it can run on a job thread
+	bool					Inflate( void );
+	bool					NeedsInflate( void ) const { return source != NULL; }
+							// hands the inflated data, 0 terminated, over to the caller who frees it with Mem_Free,
+							// NULL for stored files or if inflating failed
+	char *					ReleaseData( void );
+
+private:
+	idStr					fullPath;		// full file path including pak file name
+	const byte *			source;			// deflated data in the mapping, NULL once inflated
+	int						compressedSize;
+	int						length;			// uncompressed size
+	char *					inflated;		// owned buffer with the inflated data
+	bool					failed;
+};
+
 #endif /* !__FILE_H__ */
@@ -255,10 +255,18 @@ static idInitExclusions	initExclusions;
 
 #define MAX_ZIPPED_FILE_NAME	2048
 #define FILE_HASH_SIZE			1024
+#define MAX_PREFETCHED_FILES	64
+#define MANIFEST_READ_AHEAD		16			// files of the level load manifest prefetched ahead of the load
+#define FILE_INDEX_NAME			"fileindex.dat"	// the file index of the last set of paks, in the save path
+#define FILE_INDEX_VERSION		1
 
 typedef struct fileInPack_s {
 	idStr				name;						// name of the file
 	ZPOS64_T			pos;						// file info position in zip
+	unsigned int		size;						// uncompressed size
+	unsigned int		compressedSize;				// size of the data in the zip
+	int					method;						// 0 = stored, Z_DEFLATED = deflated
+	unsigned int		localOffset;				// offset of the local file header, only valid for mapped paks
 	struct fileInPack_s * next;						// next file in the hash
 } fileInPack_t;
 
@@ -288,8 +296,30 @@ typedef struct {
 	bool				isNew;						// for downloaded paks
 	fileInPack_t		*hashTable[FILE_HASH_SIZE];
 	fileInPack_t		*buildBuffer;
+	const byte *		mapped;						// whole pak mapped read only, NULL if read through minizip
+	int					mappedLength;
+	int					mappedBias;					// bytes prepended before the zip data, same as minizip's byte_before_the_zipfile
+	int					searchOrder;				// position in searchPaths followed by addonPaks, set by BuildFileIndex
 } pack_t;
 
+// a ReadFileAsync or PrefetchFile in flight
+typedef struct {
+	idStr				relativePath;
+	idFile *			file;						// NULL if the file wasn't found
+	fileReadCallback_t	callback;					// NULL for prefetched files
+	void *				data;
+	idJobList			jobs;						// inflates the file if it's deflated in a mapped pak
+	bool				inflating;					// jobs were submitted and not waited for yet
+} asyncRead_t;
+
+// one slot of the flat index over the files of all paks
+typedef struct {
+	unsigned int		hash;						// full hash of the name, 0 for an empty slot
+	pack_t *			pack;
+	fileInPack_t *		file;
+	int					next;						// slot of the same name in the next pak in search order, -1 for none
+} fileIndexEntry_t;
+
 typedef struct {
 	idStr				path;						// c:\doom
 	idStr				gamedir;					// base
@@ -356,6 +386,11 @@ public:
 	virtual	void			ClearPureChecksums( void );
 	virtual int				ReadFile( const char *relativePath, void **buffer, ID_TIME_T *timestamp );
 	virtual void			FreeFile( void *buffer );
+	virtual void			ReadFileAsync( const char *relativePath, fileReadCallback_t callback, void *data );
+	virtual void			FinishAsyncReads( bool wait );
+	virtual void			PrefetchFile( const char *relativePath );
+	virtual void			BeginLevelLoad( const char *mapName );
+	virtual void			EndLevelLoad( void );
 	virtual int				WriteFile( const char *relativePath, const void *buffer, int size, const char *basePath = "fs_savepath" );
 	virtual void			RemoveFile( const char *relativePath );
 	virtual idFile *		OpenFileReadFlags( const char *relativePath, int searchFlags, pack_t **foundInPak = NULL, bool allowCopyFiles = true, const char* gamedir = NULL );
@@ -415,6 +450,8 @@ private:
 	static idCVar			fs_game_base;
 	static idCVar			fs_caseSensitiveOS;
 	static idCVar			fs_searchAddons;
+	static idCVar			fs_mapPaks;
+	static idCVar			fs_loadManifest;
 
 	backgroundDownload_t *	backgroundDownloads;
 	backgroundDownload_t	defaultBackgroundDownload;
@@ -432,9 +469,39 @@ private:
 
 	int						d3xp;	// 0: didn't check, -1: not installed, 1: installed
 
+							// open addressing table over the files of all paks in searchPaths and addonPaks, each name
+							// has one slot per pak it is in, chained from the first pak in search order to the last
+	fileIndexEntry_t *		fileIndex;
+	int						fileIndexSize;			// power of two, at least twice the number of files
+	bool					fileIndexDirty;
+
+	idList<asyncRead_t *>	asyncReads;				// in the order they were started
+
+	idStr					manifestName;			// manifest of the level being loaded, empty outside of level loads
+	idStrList				manifestFiles;			// files read by the last load of the level, in order
+	idHashIndex				manifestHash;
+	int						manifestPrefetched;		// manifestFiles handed to PrefetchFile so far
+	idStrList				recordedFiles;			// files read by this load, in order
+	idList<int>				recordedBytes;
+	idHashIndex				recordedHash;
+
 private:
 	void					ReplaceSeparators( idStr &path, char sep = PATHSEPERATOR_CHAR );
 	int						HashFileName( const char *fname ) const;
+	unsigned int			FullHashFileName( const char *fname ) const;
+	void					BuildFileIndex( void );
+	bool					LoadFileIndex( const idList<pack_t *> &paks );
+	void					WriteFileIndex( const idList<pack_t *> &paks );
+	const fileIndexEntry_t *FindFileInPaks( const char *relativePath, unsigned int fullHash );
+	fileInPack_t *			FileInPak( const fileIndexEntry_t *&entry, const pack_t *pak ) const;
+	bool					ParseMappedZip( pack_t *pack, int *headerLongs, int &numHeaderLongs );
+	const byte *			MappedFileData( pack_t *pak, fileInPack_t *pakFile );
+	int						ReadWholeFile( idFile *f, void **buffer );
+	void					StartInflate( asyncRead_t *read );
+	void					FreeAsyncRead( asyncRead_t *read );
+	void					RecordFileRead( const char *relativePath, idFile *f );
+	void					PrefetchManifest( int count );
+	void					ClearManifest( void );
 	int						ListOSFiles( const char *directory, const char *extension, idStrList &list );
 	FILE *					OpenOSFile( const char *name, const char *mode, idStr *caseSensitiveName = NULL );
 	FILE *					OpenOSFileCorrectName( idStr &path, const char *mode );
@@ -455,7 +522,7 @@ private:
 	pack_t *				GetPackForChecksum( int checksum, bool searchAddons = false );
 							// searches all the paks, no pure check
 	pack_t *				FindPakForFileChecksum( const char *relativePath, int fileChecksum, bool bReference );
-	idFile_InZip *			ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath );
+	idFile *				ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath );
 	int						GetFileChecksum( idFile *file );
 	pureStatus_t			GetPackStatus( pack_t *pak );
 	addonInfo_t *			ParseAddonDef( const char *buf, const int len );
@@ -482,6 +549,8 @@ idCVar	idFileSystemLocal::fs_caseSensitiveOS( "fs_caseSensitiveOS", "0", CVAR_SY
 idCVar	idFileSystemLocal::fs_caseSensitiveOS( "fs_caseSensitiveOS", "1", CVAR_SYSTEM | CVAR_BOOL, "" );
 #endif
 idCVar	idFileSystemLocal::fs_searchAddons( "fs_searchAddons", "0", CVAR_SYSTEM | CVAR_BOOL, "search all addon pk4s ( disables addon functionality )" );
+idCVar	idFileSystemLocal::fs_loadManifest( "fs_loadManifest", "1", CVAR_SYSTEM | CVAR_BOOL, "record the files read by a level load and prefetch them in the same order the next time the level loads" );
+idCVar	idFileSystemLocal::fs_mapPaks( "fs_mapPaks", "1", CVAR_SYSTEM | CVAR_INIT | CVAR_BOOL, "memory map pk4s, read the zip directory from the mapping and serve uncompressed files without copying" );
 
 idFileSystemLocal	fileSystemLocal;
 idFileSystem *		fileSystem = &fileSystemLocal;
@@ -503,6 +572,10 @@ idFileSystemLocal::idFileSystemLocal( void ) {
 	memset( &backgroundThread, 0, sizeof( backgroundThread ) );
 	backgroundThread_exit = false;
 	addonPaks = NULL;
+	fileIndex = NULL;
+	fileIndexSize = 0;
+	fileIndexDirty = true;
+	manifestPrefetched = 0;
 }
 
 /*
@@ -534,6 +607,261 @@ int idFileSystemLocal::HashFileName( const char *fname ) const {
 	return hash;
 }
 
+/*
+================
+idFileSystemLocal::FullHashFileName
+
+hash of the whole name for the file index that ignores the same case and separator
+distinctions as FilenameCompare, never 0
+================
+*/
+unsigned int idFileSystemLocal::FullHashFileName( const char *fname ) const {
+	unsigned int	hash;
+	char			letter;
+
+	hash = 2166136261u;
+	for ( int i = 0; fname[i] != '\0'; i++ ) {
+		letter = idStr::ToLower( fname[i] );
+		if ( letter == '\\' || letter == ':' ) {
+			letter = '/';
+		}
+		hash = ( hash ^ (byte)letter ) * 16777619u;
+	}
+	return hash ? hash : 1;
+}
+
+/*
+================
+idFileSystemLocal::BuildFileIndex
+
+rebuilt lazily on the first lookup after the set of paks changed, or read back
+from the save path when the paks are the same as the last time it was built
+================
+*/
+void idFileSystemLocal::BuildFileIndex( void ) {
+	searchpath_t		*search, *loop;
+	idList<pack_t *>	paks;
+	int					i, j, numFiles, size, slot, last;
+	unsigned int		hash;
+
+	numFiles = 0;
+	for ( loop = searchPaths; loop; loop == searchPaths ? loop = addonPaks : loop = NULL ) {
+		for ( search = loop; search; search = search->next ) {
+			if ( search->pack ) {
+				search->pack->searchOrder = paks.Append( search->pack );
+				numFiles += search->pack->numfiles;
+			}
+		}
+	}
+
+	size = FILE_HASH_SIZE;
+	while ( size < numFiles * 2 ) {
+		size <<= 1;
+	}
+	if ( size != fileIndexSize ) {
+		Mem_Free( fileIndex );
+		fileIndex = (fileIndexEntry_t *)Mem_Alloc( size * sizeof( fileIndex[0] ) );
+		fileIndexSize = size;
+	}
+	memset( fileIndex, 0, fileIndexSize * sizeof( fileIndex[0] ) );
+
+	fileIndexDirty = false;
+
+	if ( LoadFileIndex( paks ) ) {
+		return;
+	}
+
+	for ( i = 0; i < paks.Num(); i++ ) {
+		pack_t *pak = paks[i];
+		for ( j = 0; j < pak->numfiles; j++ ) {
+			fileInPack_t *file = &pak->buildBuffer[j];
+			if ( file->name.Length() == 0 ) {
+				continue;
+			}
+			hash = FullHashFileName( file->name );
+
+			// the paks are added in search order and a later slot of a probe sequence was
+			// always filled later, so the last slot with the name ends its chain
+			last = -1;
+			for ( slot = hash & ( fileIndexSize - 1 ); fileIndex[slot].hash; slot = ( slot + 1 ) & ( fileIndexSize - 1 ) ) {
+				if ( fileIndex[slot].hash == hash && !FilenameCompare( fileIndex[slot].file->name, file->name ) ) {
+					last = slot;
+				}
+			}
+
+			// the first of the same name in one pak is the one that is read
+			if ( last >= 0 && fileIndex[last].pack == pak ) {
+				continue;
+			}
+
+			fileIndex[slot].hash = hash;
+			fileIndex[slot].pack = pak;
+			fileIndex[slot].file = file;
+			fileIndex[slot].next = -1;
+			if ( last >= 0 ) {
+				fileIndex[last].next = slot;
+			}
+		}
+	}
+
+	WriteFileIndex( paks );
+}
+
+/*
+================
+idFileSystemLocal::LoadFileIndex
+
+the index file starts with the checksum, number of files and length of each pak in
+search order, if they all match the slots are read instead of hashing every name
+================
+*/
+bool idFileSystemLocal::LoadFileIndex( const idList<pack_t *> &paks ) {
+	idFile *	f;
+	int *		data;
+	int			i, len, numInts, numSlots, slot, pakNum, fileNum, next;
+	bool		valid;
+
+	if ( !fs_savepath.GetString()[0] ) {
+		return false;
+	}
+
+	f = OpenExplicitFileRead( BuildOSPath( fs_savepath.GetString(), gameFolder, FILE_INDEX_NAME ) );
+	if ( !f ) {
+		return false;
+	}
+	len = f->Length();
+	data = (int *)Mem_Alloc( len + 4 );
+	f->Read( data, len );
+	CloseFile( f );
+
+	numInts = len / 4;
+	for ( i = 0; i < numInts; i++ ) {
+		data[i] = LittleInt( data[i] );
+	}
+
+	// version, number of paks, paks, size of the table, number of slots, slots
+	valid = ( numInts >= 4 + paks.Num() * 3 && data[0] == FILE_INDEX_VERSION && data[1] == paks.Num() );
+	for ( i = 0; valid && i < paks.Num(); i++ ) {
+		const int *p = data + 2 + i * 3;
+		valid = ( p[0] == paks[i]->checksum && p[1] == paks[i]->numfiles && p[2] == paks[i]->length );
+	}
+
+	if ( valid ) {
+		const int *p = data + 2 + paks.Num() * 3;
+		numSlots = p[1];
+		valid = ( p[0] == fileIndexSize && numSlots >= 0 && numSlots <= fileIndexSize && numInts == ( p + 2 - data ) + numSlots * 5 );
+		for ( p += 2, i = 0; valid && i < numSlots; i++, p += 5 ) {
+			slot = p[0];
+			pakNum = p[2];
+			fileNum = p[3];
+			next = p[4];
+			valid = ( slot >= 0 && slot < fileIndexSize && !fileIndex[slot].hash && p[1] != 0 &&
+						pakNum >= 0 && pakNum < paks.Num() && fileNum >= 0 && fileNum < paks[pakNum]->numfiles &&
+						next >= -1 && next < fileIndexSize );
+			if ( valid ) {
+				fileIndex[slot].hash = (unsigned int)p[1];
+				fileIndex[slot].pack = paks[pakNum];
+				fileIndex[slot].file = &paks[pakNum]->buildBuffer[fileNum];
+				fileIndex[slot].next = next;
+			}
+		}
+		// the chains have to step to later paks or FileInPak could walk off them
+		for ( i = 0; valid && i < fileIndexSize; i++ ) {
+			next = fileIndex[i].next;
+			if ( fileIndex[i].hash && next >= 0 ) {
+				valid = ( fileIndex[next].hash && fileIndex[next].pack->searchOrder > fileIndex[i].pack->searchOrder );
+			}
+		}
+		if ( !valid ) {
+			memset( fileIndex, 0, fileIndexSize * sizeof( fileIndex[0] ) );
+		}
+	}
+
+	Mem_Free( data );
+
+	return valid;
+}
+
+/*
+================
+idFileSystemLocal::WriteFileIndex
+================
+*/
+void idFileSystemLocal::WriteFileIndex( const idList<pack_t *> &paks ) {
+	idList<int>	data;
+	int			i;
+
+	if ( !fs_savepath.GetString()[0] ) {
+		return;
+	}
+
+	data.SetGranularity( 1024 );
+	data.Append( FILE_INDEX_VERSION );
+	data.Append( paks.Num() );
+	for ( i = 0; i < paks.Num(); i++ ) {
+		data.Append( paks[i]->checksum );
+		data.Append( paks[i]->numfiles );
+		data.Append( paks[i]->length );
+	}
+	data.Append( fileIndexSize );
+	data.Append( 0 );
+	int countIndex = data.Num() - 1;
+	for ( i = 0; i < fileIndexSize; i++ ) {
+		if ( fileIndex[i].hash ) {
+			data.Append( i );
+			data.Append( (int)fileIndex[i].hash );
+			data.Append( fileIndex[i].pack->searchOrder );
+			data.Append( (int)( fileIndex[i].file - fileIndex[i].pack->buildBuffer ) );
+			data.Append( fileIndex[i].next );
+			data[countIndex]++;
+		}
+	}
+
+	for ( i = 0; i < data.Num(); i++ ) {
+		data[i] = LittleInt( data[i] );
+	}
+	WriteFile( FILE_INDEX_NAME, data.Ptr(), data.Num() * sizeof( data[0] ) );
+}
+
+/*
+================
+idFileSystemLocal::FindFileInPaks
+
+slot of the name in the first pak of the search order that has it, NULL if no pak has it
+================
+*/
+const fileIndexEntry_t *idFileSystemLocal::FindFileInPaks( const char *relativePath, unsigned int fullHash ) {
+	int slot;
+
+	if ( fileIndexDirty ) {
+		BuildFileIndex();
+	}
+	for ( slot = fullHash & ( fileIndexSize - 1 ); fileIndex[slot].hash; slot = ( slot + 1 ) & ( fileIndexSize - 1 ) ) {
+		if ( fileIndex[slot].hash == fullHash ) {
+			// case and separator insensitive comparisons
+			if ( !FilenameCompare( fileIndex[slot].file->name, relativePath ) ) {
+				return &fileIndex[slot];
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+================
+idFileSystemLocal::FileInPak
+
+steps the slot from FindFileInPaks along its chain up to pak, so the paks have to be
+asked for in search order, returns NULL if the file isn't in pak
+================
+*/
+fileInPack_t *idFileSystemLocal::FileInPak( const fileIndexEntry_t *&entry, const pack_t *pak ) const {
+	while ( entry && entry->pack->searchOrder < pak->searchOrder ) {
+		entry = ( entry->next >= 0 ) ? &fileIndex[entry->next] : NULL;
+	}
+	return ( entry && entry->pack == pak ) ? entry->file : NULL;
+}
+
 /*
 ===========
 idFileSystemLocal::FilenameCompare
@@ -948,7 +1276,7 @@ bool idFileSystemLocal::FileIsInPAK( const char *relativePath ) {
 	searchpath_t	*search;
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
-	int				hash;
+	const fileIndexEntry_t *entry;
 
 	if ( !searchPaths ) {
 		common->FatalError( "Filesystem call made without initialization\n" );
@@ -974,11 +1302,14 @@ bool idFileSystemLocal::FileIsInPAK( const char *relativePath ) {
 	// search through the path, one element at a time
 	//
 
-	hash = HashFileName( relativePath );
+	entry = FindFileInPaks( relativePath, FullHashFileName( relativePath ) );
+	if ( !entry ) {
+		return false;
+	}
 
 	for ( search = searchPaths; search; search = search->next ) {
 		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[hash] ) {
+		if ( search->pack ) {
 
 			// disregard if it doesn't match one of the allowed pure pak files - or is a localization file
 			if ( serverPaks.Num() ) {
@@ -988,16 +1319,11 @@ bool idFileSystemLocal::FileIsInPAK( const char *relativePath ) {
 				}
 			}
 
-			// look through all the pak file elements
 			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FilenameCompare( pakFile->name, relativePath ) ) {
-					return true;
-				}
-				pakFile = pakFile->next;
-			} while( pakFile != NULL );
+			pakFile = FileInPak( entry, pak );
+			if ( pakFile ) {
+				return true;
+			}
 		}
 	}
 	return false;
@@ -1069,6 +1395,22 @@ int idFileSystemLocal::ReadFile( const char *relativePath, void **buffer, ID_TIM
 		isConfig = false;
 	}
 
+	// only asking for the length and time shouldn't use up a prefetch of the file
+	if ( !buffer ) {
+		for ( int i = 0; i < asyncReads.Num(); i++ ) {
+			if ( !asyncReads[i]->callback && !asyncReads[i]->relativePath.Icmp( relativePath ) ) {
+				f = asyncReads[i]->file;
+				if ( manifestName.Length() ) {
+					RecordFileRead( relativePath, f );
+				}
+				if ( timestamp ) {
+					*timestamp = f->Timestamp();
+				}
+				return f->Length();
+			}
+		}
+	}
+
 	// look for it in the filesystem or pack files
 	f = OpenFileRead( relativePath, ( buffer != NULL ) );
 	if ( f == NULL ) {
@@ -1088,17 +1430,12 @@ int idFileSystemLocal::ReadFile( const char *relativePath, void **buffer, ID_TIM
 		return len;
 	}
 
-	loadCount++;
-	loadStack++;
-
-	buf = (byte *)Mem_ClearedAlloc(len+1);
-	*buffer = buf;
-
-	f->Read( buf, len );
-
-	// guarantee that it will have a trailing 0 for string operations
-	buf[len] = 0;
+	len = ReadWholeFile( f, buffer );
+	buf = (byte *)*buffer;
 	CloseFile( f );
+	if ( len < 0 ) {
+		return -1;
+	}
 
 	// if we are journalling and it is a config file, write it to the journal file
 	if ( isConfig && eventLoop && eventLoop->JournalLevel() == 1 ) {
@@ -1128,6 +1465,355 @@ void idFileSystemLocal::FreeFile( void *buffer ) {
 	Mem_Free( buffer );
 }
 
+/*
+============
+idFileSystemLocal::BeginLevelLoad
+============
+*/
+void idFileSystemLocal::BeginLevelLoad( const char *mapName ) {
+	idLexer		src( LEXFL_NOSTRINGCONCAT | LEXFL_NOFATALERRORS );
+	idToken		token;
+	idFile *	f;
+	char *		buf;
+	int			len;
+
+	ClearManifest();
+
+	if ( !fs_loadManifest.GetBool() ) {
+		return;
+	}
+
+	manifestName = "manifests/";
+	manifestName += mapName;
+	manifestName.SetFileExtension( ".manifest" );
+
+	// the manifest is written to the save path, don't pick one up from the paks
+	f = OpenExplicitFileRead( BuildOSPath( fs_savepath.GetString(), gameFolder, manifestName ) );
+	if ( !f ) {
+		return;
+	}
+	len = f->Length();
+	buf = (char *)Mem_Alloc( len + 1 );
+	f->Read( buf, len );
+	buf[len] = '\0';
+	CloseFile( f );
+
+	// "relativePath" bytes per line
+	src.LoadMemory( buf, len, manifestName );
+	while ( src.ReadToken( &token ) ) {
+		if ( token.type != TT_STRING ) {
+			break;
+		}
+		manifestHash.Add( manifestHash.GenerateKey( token, false ), manifestFiles.Append( token ) );
+		src.ParseInt();
+	}
+	src.FreeSource();
+	Mem_Free( buf );
+
+	PrefetchManifest( MANIFEST_READ_AHEAD );
+}
+
+/*
+============
+idFileSystemLocal::EndLevelLoad
+============
+*/
+void idFileSystemLocal::EndLevelLoad( void ) {
+	idStr	text;
+	int		i, bytes;
+
+	// read ahead hints that weren't picked up by now won't be
+	FinishAsyncReads( true );
+
+	if ( manifestName.Length() && recordedFiles.Num() ) {
+		bytes = 0;
+		text = "// files read by the last load of this level in order, with their sizes\n";
+		for ( i = 0; i < recordedFiles.Num(); i++ ) {
+			text += va( "\"%s\" %d\n", recordedFiles[i].c_str(), recordedBytes[i] );
+			bytes += recordedBytes[i];
+		}
+		WriteFile( manifestName, text.c_str(), text.Length() );
+		common->Printf( "%s: %d files, %d kB, %d files prefetched\n", manifestName.c_str(), recordedFiles.Num(), bytes >> 10, manifestPrefetched );
+	}
+
+	ClearManifest();
+}
+
+/*
+============
+idFileSystemLocal::ClearManifest
+============
+*/
+void idFileSystemLocal::ClearManifest( void ) {
+	manifestName.Clear();
+	manifestFiles.Clear();
+	manifestHash.Clear();
+	manifestPrefetched = 0;
+	recordedFiles.Clear();
+	recordedBytes.Clear();
+	recordedHash.Clear();
+}
+
+/*
+============
+idFileSystemLocal::PrefetchManifest
+
+prefetches the manifest files up to count
+============
+*/
+void idFileSystemLocal::PrefetchManifest( int count ) {
+	count = Min( count, manifestFiles.Num() );
+	while ( manifestPrefetched < count ) {
+		PrefetchFile( manifestFiles[manifestPrefetched++] );
+	}
+}
+
+/*
+============
+idFileSystemLocal::RecordFileRead
+============
+*/
+void idFileSystemLocal::RecordFileRead( const char *relativePath, idFile *f ) {
+	int key, i;
+
+	key = recordedHash.GenerateKey( relativePath, false );
+	for ( i = recordedHash.First( key ); i != -1; i = recordedHash.Next( i ) ) {
+		if ( !recordedFiles[i].Icmp( relativePath ) ) {
+			return;
+		}
+	}
+	recordedHash.Add( key, recordedFiles.Append( relativePath ) );
+	recordedBytes.Append( f->Length() );
+
+	// keep the prefetches a few files ahead of where the load is in the last manifest
+	key = manifestHash.GenerateKey( relativePath, false );
+	for ( i = manifestHash.First( key ); i != -1; i = manifestHash.Next( i ) ) {
+		if ( !manifestFiles[i].Icmp( relativePath ) ) {
+			PrefetchManifest( i + 1 + MANIFEST_READ_AHEAD );
+			break;
+		}
+	}
+}
+
+/*
+============
+idFileSystemLocal::ReadWholeFile
+
+reads an open file into a buffer for FreeFile, the inflated data of mapped pak files is taken over instead of copied
+============
+*/
+int idFileSystemLocal::ReadWholeFile( idFile *f, void **buffer ) {
+	idFile_InZipMapped *mapped;
+	byte *	buf;
+	int		len;
+
+	*buffer = NULL;
+	buf = NULL;
+	len = f->Length();
+
+	mapped = dynamic_cast<idFile_InZipMapped *>( f );
+	if ( mapped ) {
+		if ( !mapped->Inflate() ) {
+			common->Warning( "couldn't inflate %s", f->GetFullPath() );
+			return -1;
+		}
+		buf = (byte *)mapped->ReleaseData();
+		if ( buf ) {
+			AddToReadCount( len );
+		}
+	}
+
+	if ( !buf ) {
+		buf = (byte *)Mem_ClearedAlloc( len + 1 );
+		f->Read( buf, len );
+		// guarantee that it will have a trailing 0 for string operations
+		buf[len] = 0;
+	}
+
+	loadCount++;
+	loadStack++;
+
+	*buffer = buf;
+	return len;
+}
+
+/*
+============
+idFileSystemLocal::StartInflate
+============
+*/
+static void InflateFileJob( void *data ) {
+	( (idFile_InZipMapped *)data )->Inflate();
+}
+
+void idFileSystemLocal::StartInflate( asyncRead_t *read ) {
+	idFile_InZipMapped *mapped = dynamic_cast<idFile_InZipMapped *>( read->file );
+
+	if ( mapped && mapped->NeedsInflate() ) {
+		read->jobs.AddJob( InflateFileJob, mapped );
+		read->jobs.Submit();
+		read->inflating = true;
+	}
+}
+
+/*
+============
+idFileSystemLocal::FreeAsyncRead
+============
+*/
+void idFileSystemLocal::FreeAsyncRead( asyncRead_t *read ) {
+	if ( read->inflating ) {
+		read->jobs.Wait();
+	}
+	if ( read->file ) {
+		CloseFile( read->file );
+	}
+	delete read;
+}
+
+/*
+============
+idFileSystemLocal::ReadFileAsync
+============
+*/
+void idFileSystemLocal::ReadFileAsync( const char *relativePath, fileReadCallback_t callback, void *data ) {
+	asyncRead_t *read;
+	int i;
+
+	if ( !searchPaths ) {
+		common->FatalError( "Filesystem call made without initialization\n" );
+	}
+
+	// a prefetch of the file keeps inflating and becomes the read
+	for ( i = 0; i < asyncReads.Num(); i++ ) {
+		read = asyncReads[i];
+		if ( !read->callback && !read->relativePath.Icmp( relativePath ) ) {
+			asyncReads.RemoveIndex( i );
+			read->callback = callback;
+			read->data = data;
+			asyncReads.Append( read );
+			return;
+		}
+	}
+
+	read = new asyncRead_t;
+	read->relativePath = relativePath;
+	read->callback = callback;
+	read->data = data;
+	read->inflating = false;
+	read->file = OpenFileRead( relativePath );
+	StartInflate( read );
+	asyncReads.Append( read );
+}
+
+/*
+============
+idFileSystemLocal::FinishAsyncReads
+============
+*/
+void idFileSystemLocal::FinishAsyncReads( bool wait ) {
+	asyncRead_t *read;
+	void *	buffer;
+	int		length;
+	int		i;
+
+	for ( i = 0; i < asyncReads.Num(); i++ ) {
+		read = asyncReads[i];
+
+		if ( !read->callback ) {
+			if ( wait ) {
+				asyncReads.RemoveIndex( i-- );
+				FreeAsyncRead( read );
+			}
+			continue;
+		}
+
+		// without job threads the inflate only runs when waited for
+		if ( read->inflating && !wait && Sys_NumJobThreads() > 0 && !read->jobs.IsDone() ) {
+			continue;
+		}
+
+		asyncReads.RemoveIndex( i-- );
+
+		if ( read->inflating ) {
+			read->jobs.Wait();
+			read->inflating = false;
+		}
+
+		buffer = NULL;
+		length = -1;
+		if ( read->file ) {
+			length = ReadWholeFile( read->file, &buffer );
+		}
+
+		// the callback may start new reads
+		read->callback( read->relativePath, buffer, length, read->data );
+		FreeAsyncRead( read );
+	}
+}
+
+/*
+============
+idFileSystemLocal::PrefetchFile
+============
+*/
+void idFileSystemLocal::PrefetchFile( const char *relativePath ) {
+	idFile_InZipMapped *mapped;
+	asyncRead_t *read;
+	idFile *f;
+	int i, numPrefetched;
+
+	if ( !searchPaths ) {
+		common->FatalError( "Filesystem call made without initialization\n" );
+	}
+
+	// without job threads nothing could run ahead
+	if ( Sys_NumJobThreads() == 0 ) {
+		return;
+	}
+
+	numPrefetched = 0;
+	for ( i = 0; i < asyncReads.Num(); i++ ) {
+		if ( !asyncReads[i]->relativePath.Icmp( relativePath ) ) {
+			return;
+		}
+		if ( !asyncReads[i]->callback ) {
+			numPrefetched++;
+		}
+	}
+
+	// only deflated files have work that can be done ahead, the rest is read in place or straight from disk
+	f = OpenFileReadFlags( relativePath, FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS );
+	mapped = dynamic_cast<idFile_InZipMapped *>( f );
+	if ( !mapped || !mapped->NeedsInflate() ) {
+		if ( f ) {
+			CloseFile( f );
+		}
+		return;
+	}
+
+	// drop the oldest hint nobody asked for
+	if ( numPrefetched >= MAX_PREFETCHED_FILES ) {
+		for ( i = 0; i < asyncReads.Num(); i++ ) {
+			if ( !asyncReads[i]->callback ) {
+				read = asyncReads[i];
+				asyncReads.RemoveIndex( i );
+				FreeAsyncRead( read );
+				break;
+			}
+		}
+	}
+
+	read = new asyncRead_t;
+	read->relativePath = relativePath;
+	read->callback = NULL;
+	read->data = NULL;
+	read->inflating = false;
+	read->file = f;
+	StartInflate( read );
+	asyncReads.Append( read );
+}
+
 /*
 ============
 idFileSystemLocal::WriteFile
@@ -1271,6 +1957,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	unz_file_info64	file_info;
 	int				i;
 	int				hash;
+	int				numEntries;
 	int				fs_numHeaderLongs;
 	int *			fs_headerLongs;
 	FILE			*f;
@@ -1311,30 +1998,59 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	pack->addon_info = NULL;
 	pack->pureStatus = PURE_UNKNOWN;
 	pack->isNew = false;
+	pack->mapped = NULL;
+	pack->mappedLength = 0;
+	pack->mappedBias = 0;
+	pack->searchOrder = -1;
 
 	pack->length = len;
 
-	unzGoToFirstFile(uf);
 	fs_headerLongs = (int *)Mem_ClearedAlloc( gi.number_entry * sizeof(int) );
-	for ( i = 0; i < (int)gi.number_entry; i++ ) {
-		err = unzGetCurrentFileInfo64( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
-		if ( err != UNZ_OK ) {
-			break;
+
+	// read the directory straight from a mapping of the pak if possible, that avoids
+	// minizip's seek and read per entry and lets uncompressed files be served in place
+	if ( fs_mapPaks.GetBool() ) {
+		pack->mapped = (const byte *)Sys_MapFile( zipfile, &pack->mappedLength );
+		if ( pack->mapped && !ParseMappedZip( pack, fs_headerLongs, fs_numHeaderLongs ) ) {
+			Sys_UnmapFile( pack->mapped, pack->mappedLength );
+			pack->mapped = NULL;
+			pack->mappedLength = 0;
+			fs_numHeaderLongs = 0;
 		}
-		if ( file_info.uncompressed_size > 0 ) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleInt( file_info.crc );
+	}
+
+	if ( !pack->mapped ) {
+		unzGoToFirstFile(uf);
+		for ( i = 0; i < (int)gi.number_entry; i++ ) {
+			err = unzGetCurrentFileInfo64( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
+			if ( err != UNZ_OK ) {
+				break;
+			}
+			if ( file_info.uncompressed_size > 0 ) {
+				fs_headerLongs[fs_numHeaderLongs++] = LittleInt( file_info.crc );
+			}
+			buildBuffer[i].name = filename_inzip;
+			buildBuffer[i].name.ToLower();
+			buildBuffer[i].name.BackSlashesToSlashes();
+			// store the file position in the zip
+			buildBuffer[i].pos = unzGetOffset64( uf );
+			buildBuffer[i].size = (unsigned int)file_info.uncompressed_size;
+			buildBuffer[i].compressedSize = (unsigned int)file_info.compressed_size;
+			buildBuffer[i].method = file_info.compression_method;
+			buildBuffer[i].localOffset = 0;
+			// go to the next file in the zip
+			unzGoToNextFile(uf);
 		}
-		hash = HashFileName( filename_inzip );
-		buildBuffer[i].name = filename_inzip;
-		buildBuffer[i].name.ToLower();
-		buildBuffer[i].name.BackSlashesToSlashes();
-		// store the file position in the zip
-		buildBuffer[i].pos = unzGetOffset64( uf );
-		// add the file to the hash
+		numEntries = i;
+	} else {
+		numEntries = gi.number_entry;
+	}
+
+	// add the files to the hash
+	for ( i = 0; i < numEntries; i++ ) {
+		hash = HashFileName( buildBuffer[i].name );
 		buildBuffer[i].next = pack->hashTable[hash];
 		pack->hashTable[hash] = &buildBuffer[i];
-		// go to the next file in the zip
-		unzGoToNextFile(uf);
 	}
 
 	// ignore all binary paks
@@ -1342,6 +2058,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	for (pakFile = pack->hashTable[confHash]; pakFile; pakFile = pakFile->next) {
 		if (!FilenameCompare(pakFile->name, BINARY_CONFIG)) {
 			unzClose(uf);
+			Sys_UnmapFile( pack->mapped, pack->mappedLength );
 			delete[] buildBuffer;
 			delete pack;
 			Mem_Free( fs_headerLongs );
@@ -1355,7 +2072,7 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	for ( pakFile = pack->hashTable[confHash]; pakFile; pakFile = pakFile->next ) {
 		if ( !FilenameCompare( pakFile->name, ADDON_CONFIG ) ) {
 			pack->addon = true;
-			idFile_InZip *file = ReadFileFromZip( pack, pakFile, ADDON_CONFIG );
+			idFile *file = ReadFileFromZip( pack, pakFile, ADDON_CONFIG );
 			// may be just an empty file if you don't bother about the mapDef
 			if ( file && file->Length() ) {
 				char *buf;
@@ -1377,9 +2094,119 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 
 	Mem_Free( fs_headerLongs );
 
+	// the file index picks the new pak up on the next lookup
+	fileIndexDirty = true;
+
 	return pack;
 }
 
+// little endian fields of the zip directory records
+static ID_INLINE unsigned int ReadZipShort( const byte *p ) {
+	return p[0] | ( p[1] << 8 );
+}
+
+static ID_INLINE unsigned int ReadZipLong( const byte *p ) {
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (unsigned int)p[3] << 24 );
+}
+
+/*
+=================
+idFileSystemLocal::ParseMappedZip
+
+fills the pack's build buffer from the central directory in the mapping,
+returns false for anything unexpected so the caller can fall back to minizip
+=================
+*/
+bool idFileSystemLocal::ParseMappedZip( pack_t *pack, int *headerLongs, int &numHeaderLongs ) {
+	const byte *	base = pack->mapped;
+	int				length = pack->mappedLength;
+	int				eocd, minPos, i;
+	unsigned int	numEntries, centralSize, centralOffset, pos;
+	unsigned int	nameLen, extraLen, commentLen;
+
+	if ( length < 22 ) {
+		return false;
+	}
+
+	// the end of central directory record is followed by a comment of at most 64k
+	eocd = -1;
+	minPos = Max( 0, length - 22 - 0xffff );
+	for ( i = length - 22; i >= minPos; i-- ) {
+		if ( ReadZipLong( base + i ) == 0x06054b50 ) {
+			eocd = i;
+			break;
+		}
+	}
+	if ( eocd < 0 ) {
+		return false;
+	}
+
+	numEntries = ReadZipShort( base + eocd + 10 );
+	centralSize = ReadZipLong( base + eocd + 12 );
+	centralOffset = ReadZipLong( base + eocd + 16 );
+	if ( numEntries == 0xffff || centralOffset == 0xffffffff ) {
+		return false;		// zip64, leave it to minizip
+	}
+	if ( (int)numEntries != pack->numfiles || (ZPOS64_T)centralOffset + centralSize > (ZPOS64_T)eocd ) {
+		return false;
+	}
+	pack->mappedBias = eocd - ( centralOffset + centralSize );
+
+	pos = centralOffset;
+	for ( i = 0; i < (int)numEntries; i++ ) {
+		const byte *rec = base + pack->mappedBias + pos;
+		if ( pack->mappedBias + pos + 46 > (unsigned int)eocd || ReadZipLong( rec ) != 0x02014b50 ) {
+			return false;
+		}
+		nameLen = ReadZipShort( rec + 28 );
+		extraLen = ReadZipShort( rec + 30 );
+		commentLen = ReadZipShort( rec + 32 );
+		if ( nameLen >= MAX_ZIPPED_FILE_NAME || pack->mappedBias + pos + 46 + nameLen > (unsigned int)eocd ) {
+			return false;
+		}
+
+		fileInPack_t &file = pack->buildBuffer[i];
+		file.name.Empty();
+		file.name.Append( (const char *)rec + 46, nameLen );
+		file.name.ToLower();
+		file.name.BackSlashesToSlashes();
+		// same position minizip's unzGetOffset64 would give, so ReadFileFromZip can use either
+		file.pos = pos;
+		file.method = ReadZipShort( rec + 10 );
+		file.compressedSize = ReadZipLong( rec + 20 );
+		file.size = ReadZipLong( rec + 24 );
+		file.localOffset = ReadZipLong( rec + 42 );
+		if ( file.size > 0 ) {
+			headerLongs[numHeaderLongs++] = LittleInt( (int)ReadZipLong( rec + 16 ) );
+		}
+
+		pos += 46 + nameLen + extraLen + commentLen;
+	}
+
+	return true;
+}
+
+/*
+=================
+idFileSystemLocal::MappedFileData
+
+start of the file's data in the mapping, NULL if the local header doesn't check out
+=================
+*/
+const byte *idFileSystemLocal::MappedFileData( pack_t *pak, fileInPack_t *pakFile ) {
+	ZPOS64_T	local, data;
+
+	local = (ZPOS64_T)pak->mappedBias + pakFile->localOffset;
+	if ( local + 30 > (ZPOS64_T)pak->mappedLength || ReadZipLong( pak->mapped + local ) != 0x04034b50 ) {
+		return NULL;
+	}
+	data = local + 30 + ReadZipShort( pak->mapped + local + 26 ) + ReadZipShort( pak->mapped + local + 28 );
+	if ( data + pakFile->compressedSize > (ZPOS64_T)pak->mappedLength ) {
+		return NULL;
+	}
+	return pak->mapped + data;
+}
+
 /*
 ===============
 idFileSystemLocal::AddZipFile
@@ -2350,6 +3177,9 @@ void idFileSystemLocal::Startup( void ) {
 		}
 	}
 
+	// the addon and pure passes moved paks around, the file index chains them in search order
+	fileIndexDirty = true;
+
 	// add our commands
 	cmdSystem->AddCommand( "dir", Dir_f, CMD_FL_SYSTEM, "lists a folder", idCmdSystem::ArgCompletion_FileName );
 	cmdSystem->AddCommand( "dirtree", DirTree_f, CMD_FL_SYSTEM, "lists a folder with subfolders" );
@@ -2730,6 +3560,10 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 	Sys_DestroyThread(backgroundThread);
 	backgroundThread_exit = false;
 
+	// nothing may read from the mappings once the paks are gone
+	FinishAsyncReads( true );
+	ClearManifest();
+
 	gameFolder.Clear();
 
 	serverPaks.Clear();
@@ -2748,6 +3582,7 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 
 			if ( sp->pack ) {
 				unzClose( sp->pack->handle );
+				Sys_UnmapFile( sp->pack->mapped, sp->pack->mappedLength );
 				delete [] sp->pack->buildBuffer;
 				if ( sp->pack->addon_info ) {
 					sp->pack->addon_info->mapDecls.DeleteContents( true );
@@ -2766,6 +3601,11 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 	searchPaths = NULL;
 	addonPaks = NULL;
 
+	Mem_Free( fileIndex );
+	fileIndex = NULL;
+	fileIndexSize = 0;
+	fileIndexDirty = true;
+
 	cmdSystem->RemoveCommand( "path" );
 	cmdSystem->RemoveCommand( "dir" );
 	cmdSystem->RemoveCommand( "dirtree" );
@@ -2900,10 +3740,19 @@ pureStatus_t idFileSystemLocal::GetPackStatus( pack_t *pak ) {
 idFileSystemLocal::ReadFileFromZip
 ===========
 */
-idFile_InZip * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath ) {
+idFile * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath ) {
 	// relativePath == pakFile->name according to FilenameCompare()
 	// pakFile->Pos is position of that file within the zip
 
+	// files in a mapped pak are read from the mapping without a minizip handle,
+	// stored ones in place and deflated ones inflated in one go on first read
+	if ( pak->mapped && ( ( pakFile->method == 0 && pakFile->size == pakFile->compressedSize ) || pakFile->method == Z_DEFLATED ) ) {
+		const byte *data = MappedFileData( pak, pakFile );
+		if ( data ) {
+			return new idFile_InZipMapped( relativePath, pak->pakFilename + "/" + relativePath, data, pakFile->compressedSize, pakFile->size, pakFile->method == Z_DEFLATED );
+		}
+	}
+
 	// set position in pk4 file to the file (in the zip/pk4) we want a handle on
 	unzSetOffset64( pak->handle, pakFile->pos );
 
@@ -2948,7 +3797,7 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 	pack_t *		pak;
 	fileInPack_t *	pakFile;
 	directory_t *	dir;
-	int				hash;
+	const fileIndexEntry_t *entry;
 	FILE *			fp;
 
 	if ( !searchPaths ) {
@@ -2990,7 +3839,8 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 	// search through the path, one element at a time
 	//
 
-	hash = HashFileName( relativePath );
+	// the paks that have the file are chained in search order, so they're found without probing each of them
+	entry = FindFileInPaks( relativePath, FullHashFileName( relativePath ) );
 
 	for ( search = searchPaths; search; search = search->next ) {
 		if ( search->dir && ( searchFlags & FSFLAG_SEARCH_DIRS ) ) {
@@ -3096,7 +3946,10 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 			return file;
 		} else if ( search->pack && ( searchFlags & FSFLAG_SEARCH_PAKS ) ) {
 
-			if ( !search->pack->hashTable[hash] ) {
+			// look through all the pak file elements
+			pak = search->pack;
+			pakFile = FileInPak( entry, pak );
+			if ( !pakFile ) {
 				continue;
 			}
 
@@ -3108,51 +3961,42 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 				}
 			}
 
-			// look through all the pak file elements
-			pak = search->pack;
-			for ( pakFile = pak->hashTable[hash]; pakFile; pakFile = pakFile->next ) {
-				// case and separator insensitive comparisons
-				if ( !FilenameCompare( pakFile->name, relativePath ) ) {
-					idFile_InZip *file = ReadFileFromZip( pak, pakFile, relativePath );
+			idFile *file = ReadFileFromZip( pak, pakFile, relativePath );
 
-					if ( foundInPak ) {
-						*foundInPak = pak;
-					}
-
-					if ( !pak->referenced && !( searchFlags & FSFLAG_PURE_NOREF ) ) {
-						// mark this pak referenced
-						if ( fs_debug.GetInteger( ) ) {
-							common->Printf( "idFileSystem::OpenFileRead: %s -> adding %s to referenced paks\n", relativePath, pak->pakFilename.c_str() );
-						}
-						pak->referenced = true;
-					}
+			if ( foundInPak ) {
+				*foundInPak = pak;
+			}
 
-					if ( fs_debug.GetInteger( ) ) {
-						common->Printf( "idFileSystem::OpenFileRead: %s (found in '%s')\n", relativePath, pak->pakFilename.c_str() );
-					}
-					return file;
+			if ( !pak->referenced && !( searchFlags & FSFLAG_PURE_NOREF ) ) {
+				// mark this pak referenced
+				if ( fs_debug.GetInteger( ) ) {
+					common->Printf( "idFileSystem::OpenFileRead: %s -> adding %s to referenced paks\n", relativePath, pak->pakFilename.c_str() );
 				}
+				pak->referenced = true;
 			}
+
+			if ( fs_debug.GetInteger( ) ) {
+				common->Printf( "idFileSystem::OpenFileRead: %s (found in '%s')\n", relativePath, pak->pakFilename.c_str() );
+			}
+			return file;
 		}
 	}
 
 	if ( searchFlags & FSFLAG_SEARCH_ADDONS ) {
 		for ( search = addonPaks; search; search = search->next ) {
 			assert( search->pack );
-			fileInPack_t	*pakFile;
 			pak = search->pack;
-			for ( pakFile = pak->hashTable[hash]; pakFile; pakFile = pakFile->next ) {
-				if ( !FilenameCompare( pakFile->name, relativePath ) ) {
-					idFile_InZip *file = ReadFileFromZip( pak, pakFile, relativePath );
-					if ( foundInPak ) {
-						*foundInPak = pak;
-					}
-					// we don't toggle pure on paks found in addons - they can't be used without a reloadEngine anyway
-					if ( fs_debug.GetInteger( ) ) {
-						common->Printf( "idFileSystem::OpenFileRead: %s (found in addon pk4 '%s')\n", relativePath, search->pack->pakFilename.c_str() );
-					}
-					return file;
+			pakFile = FileInPak( entry, pak );
+			if ( pakFile ) {
+				idFile *file = ReadFileFromZip( pak, pakFile, relativePath );
+				if ( foundInPak ) {
+					*foundInPak = pak;
 				}
+				// we don't toggle pure on paks found in addons - they can't be used without a reloadEngine anyway
+				if ( fs_debug.GetInteger( ) ) {
+					common->Printf( "idFileSystem::OpenFileRead: %s (found in addon pk4 '%s')\n", relativePath, search->pack->pakFilename.c_str() );
+				}
+				return file;
 			}
 		}
 	}
@@ -3170,7 +4014,28 @@ idFileSystemLocal::OpenFileRead
 ===========
 */
 idFile *idFileSystemLocal::OpenFileRead( const char *relativePath, bool allowCopyFiles, const char* gamedir ) {
-	return OpenFileReadFlags( relativePath, FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS, NULL, allowCopyFiles, gamedir );
+	idFile *f = NULL;
+
+	// a prefetched file is already open and inflated or being inflated
+	if ( !gamedir ) {
+		for ( int i = 0; i < asyncReads.Num(); i++ ) {
+			asyncRead_t *read = asyncReads[i];
+			if ( !read->callback && !read->relativePath.Icmp( relativePath ) ) {
+				f = read->file;
+				asyncReads.RemoveIndex( i );
+				read->file = NULL;
+				FreeAsyncRead( read );
+				break;
+			}
+		}
+	}
+	if ( !f ) {
+		f = OpenFileReadFlags( relativePath, FSFLAG_SEARCH_DIRS | FSFLAG_SEARCH_PAKS, NULL, allowCopyFiles, gamedir );
+	}
+	if ( f && manifestName.Length() ) {
+		RecordFileRead( relativePath, f );
+	}
+	return f;
 }
 
 /*
@@ -3593,7 +4458,7 @@ pack_t *idFileSystemLocal::FindPakForFileChecksum( const char *relativePath, int
 			pak = search->pack;
 			for ( pakFile = pak->hashTable[ hash ]; pakFile; pakFile = pakFile->next ) {
 				if ( !FilenameCompare( pakFile->name, relativePath ) ) {
-					idFile_InZip *file = ReadFileFromZip( pak, pakFile, relativePath );
+					idFile *file = ReadFileFromZip( pak, pakFile, relativePath );
 					if ( findChecksum == GetFileChecksum( file ) ) {
 						if ( fs_debug.GetBool() ) {
 							common->Printf( "found '%s' with checksum 0x%x in pak '%s'\n", relativePath, findChecksum, pak->pakFilename.c_str() );
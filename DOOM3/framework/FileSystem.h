@@ -122,6 +122,10 @@ struct backgroundDownload_t {
 	volatile bool		completed;
 };
 
+// called on the main thread when an asynchronous read is finished
+// buffer is 0 terminated and must be freed with FreeFile, it's NULL with a length of -1 if the file couldn't be read
+typedef void (*fileReadCallback_t)( const char *relativePath, void *buffer, int length, void *data );
+
 // file list for directory listings
 class idFileList {
 	friend class idFileSystemLocal;
@@ -220,6 +224,21 @@ public:
 	virtual int				ReadFile( const char *relativePath, void **buffer, ID_TIME_T *timestamp = NULL ) = 0;
 							// Frees the memory allocated by ReadFile.
 	virtual void			FreeFile( void *buffer ) = 0;
+							// Starts reading a complete file. The file is looked up right away, compressed files
+							// in memory mapped paks are inflated on the job threads, everything else is read
+							// when the read finishes. The callback is called from FinishAsyncReads.
+	virtual void			ReadFileAsync( const char *relativePath, fileReadCallback_t callback, void *data ) = 0;
+							// Calls the callbacks of the asynchronous reads that are done, or of all of them if wait is set.
+							// Waiting also drops prefetched files which weren't read.
+	virtual void			FinishAsyncReads( bool wait ) = 0;
+							// Read ahead hint, starts inflating a compressed file in the background
+							// so the next ReadFile or OpenFileRead of it finds the data ready.
+	virtual void			PrefetchFile( const char *relativePath ) = 0;
+							// Records the files read until EndLevelLoad into a manifest for the level
+							// and prefetches the files of the last recorded load ahead of the reads.
+	virtual void			BeginLevelLoad( const char *mapName ) = 0;
+							// Writes the manifest and drops prefetched files that weren't read.
+	virtual void			EndLevelLoad( void ) = 0;
 							// Writes a complete file, will create any needed subdirectories.
 							// Returns the length of the file, or -1 on failure.
 	virtual int				WriteFile( const char *relativePath, const void *buffer, int size, const char *basePath = "fs_savepath" ) = 0;
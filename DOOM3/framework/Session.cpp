@@ -338,9 +338,13 @@ void idSessionLocal::Clear() {
 	mapSpawned = false;
 	guiActive = NULL;
 	aviCaptureMode = false;
+	waveCaptureMode = false;
 	timeDemo = TD_NO;
 	waitingOnBind = false;
 	lastPacifierTime = 0;
+	numLoadStages = 0;
+	loadStageProgress = 0.0f;
+	loadProgress = 0.0f;
 
 	msgRunning = false;
 	guiMsgRestore = NULL;
@@ -704,6 +708,19 @@ static void Session_AVIDemo_f( const idCmdArgs &args ) {
 	sessLocal.AVIRenderDemo( va( "demos/%s", args.Argv(1) ) );
 }
 
+/*
+================
+Session_WaveDemo_f
+================
+*/
+static void Session_WaveDemo_f( const idCmdArgs &args ) {
+	if ( args.Argc() < 2 ) {
+		common->Printf( "usage: waveDemo <demoname>\n" );
+		return;
+	}
+	sessLocal.WaveRenderDemo( va( "demos/%s", args.Argv(1) ) );
+}
+
 /*
 ================
 Session_AVIGame_f
@@ -860,6 +877,7 @@ void idSessionLocal::StopPlayingRenderDemo() {
 	int timeDemoStopTime = Sys_Milliseconds();
 
 	EndAVICapture();
+	EndWaveCapture();
 
 	readDemo->Close();
 
@@ -1059,6 +1077,43 @@ void idSessionLocal::AVIRenderDemo( const char *_demoName ) {
 	UpdateScreen();
 }
 
+/*
+================
+idSessionLocal::WaveRenderDemo
+
+Plays the demo like a timedemo with 3D rendering skipped and
+mixes its sound in the foreground to demos/<name>.wav
+================
+*/
+void idSessionLocal::WaveRenderDemo( const char *_demoName ) {
+	idStr	demoName = _demoName;	// copy off from va() buffer
+	idStr	shortName;
+
+	TimeRenderDemo( demoName );
+	if ( !readDemo ) {
+		return;
+	}
+
+	demoName.ExtractFileBase( shortName );
+	sw->StartWritingWave( va( "demos/%s.wav", shortName.c_str() ) );
+	waveCaptureMode = true;
+}
+
+/*
+================
+idSessionLocal::EndWaveCapture
+================
+*/
+void idSessionLocal::EndWaveCapture() {
+	if ( !waveCaptureMode ) {
+		return;
+	}
+
+	sw->StopWritingWave();
+
+	waveCaptureMode = false;
+}
+
 /*
 ================
 idSessionLocal::AVICmdDemo
@@ -1575,6 +1630,7 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 
 	// note which media we are going to need to load
 	if ( !reloadingSameMap ) {
+		fileSystem->BeginLevelLoad( fullMapName );
 		declManager->BeginLevelLoad();
 		renderSystem->BeginLevelLoad();
 		soundSystem->BeginLevelLoad();
@@ -1618,10 +1674,15 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 
 	int start = Sys_Milliseconds();
 
+	numLoadStages = 0;
+	loadStageProgress = 0.0f;
+	loadProgress = 0.0f;
+
 	common->Printf( "----- Map Initialization -----\n" );
 	common->Printf( "Map: %s\n", mapString.c_str() );
 
 	// let the renderSystem load all the geometry
+	BeginLoadStage( "render world", 0.0f );
 	if ( !rw->InitFromMap( fullMapName ) ) {
 		common->Error( "couldn't load %s", fullMapName.c_str() );
 	}
@@ -1638,6 +1699,7 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 	}
 
 	// load and spawn all other entities ( from a savegame possibly )
+	BeginLoadStage( "game", 0.1f );
 	if ( loadingSaveGame && savegameFile ) {
 		if ( game->InitFromSaveGame( fullMapName + ".map", rw, sw, savegameFile ) == false ) {
 			// If the loadgame failed, restart the map with the player persistent data
@@ -1655,6 +1717,7 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 
 	if ( !idAsyncNetwork::IsActive() && !loadingSaveGame ) {
 		// spawn players
+		BeginLoadStage( "players", 0.5f );
 		for ( i = 0; i < numClients; i++ ) {
 			game->SpawnPlayer( i );
 		}
@@ -1662,15 +1725,20 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 
 	// actually purge/load the media
 	if ( !reloadingSameMap ) {
+		BeginLoadStage( "renderer media", 0.55f );
 		renderSystem->EndLevelLoad();
+		BeginLoadStage( "sounds", 0.8f );
 		soundSystem->EndLevelLoad( mapString.c_str() );
+		BeginLoadStage( "decls", 0.85f );
 		declManager->EndLevelLoad();
 		SetBytesNeededForMapLoad( mapString.c_str(), fileSystem->GetReadCount() );
 	}
+	BeginLoadStage( "guis", 0.9f );
 	uiManager->EndLevelLoad();
 
 	if ( !idAsyncNetwork::IsActive() && !loadingSaveGame ) {
 		// run a few frames to allow everything to settle
+		BeginLoadStage( "settle frames", 0.95f );
 		for ( i = 0; i < 10; i++ ) {
 			game->RunFrame( mapSpawnData.mapSpawnUsercmd );
 		}
@@ -1680,7 +1748,14 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 	common->Printf( "%6d msec to load %s\n", msec, mapString.c_str() );
 
 	// let the renderSystem generate interactions now that everything is spawned
+	BeginLoadStage( "interactions", 0.98f );
 	rw->GenerateAllInteractions();
+	EndLoadStages();
+
+	// write the load manifest and drop the prefetches nothing asked for
+	fileSystem->EndLevelLoad();
+
+	PrintLoadStages( mapString.c_str(), Sys_Milliseconds() - start );
 
 	common->PrintWarnings();
 
@@ -2333,6 +2408,67 @@ void idSessionLocal::DrawCmdGraph() {
 	}
 }
 
+/*
+===============
+idSessionLocal::BeginLoadStage
+
+Closes the timing of the previous stage of the map load and
+pushes the loading bar at least up to progress
+===============
+*/
+void idSessionLocal::BeginLoadStage( const char *name, float progress ) {
+	EndLoadStages();
+
+	if ( numLoadStages < MAX_LOAD_STAGES ) {
+		loadStage_t &stage = loadStages[numLoadStages++];
+		stage.name = name;
+		stage.startTime = Sys_Milliseconds();
+		stage.msec = -1;
+		stage.bytesRead = fileSystem->GetReadCount();
+	}
+
+	loadStageProgress = progress;
+
+	if ( guiLoading ) {
+		guiLoading->SetStateString( "map_loading_stage", name );
+	}
+
+	// update the screen right away instead of waiting for the next print
+	lastPacifierTime = 0;
+	PacifierUpdate();
+}
+
+/*
+===============
+idSessionLocal::EndLoadStages
+
+Closes the timing of the stage that is running
+===============
+*/
+void idSessionLocal::EndLoadStages( void ) {
+	if ( numLoadStages > 0 ) {
+		loadStage_t &stage = loadStages[numLoadStages - 1];
+		if ( stage.msec < 0 ) {
+			stage.msec = Sys_Milliseconds() - stage.startTime;
+			stage.bytesRead = fileSystem->GetReadCount() - stage.bytesRead;
+		}
+	}
+}
+
+/*
+===============
+idSessionLocal::PrintLoadStages
+===============
+*/
+void idSessionLocal::PrintLoadStages( const char *mapName, int msec ) const {
+	common->Printf( "----- Load Report: %s -----\n", mapName );
+	for ( int i = 0; i < numLoadStages; i++ ) {
+		const loadStage_t &stage = loadStages[i];
+		common->Printf( "%6d msec %5.1f%% %7dk read  %s\n", stage.msec, msec ? stage.msec * 100.0f / msec : 0.0f, stage.bytesRead >> 10, stage.name );
+	}
+	common->Printf( "%6d msec total, %d job threads\n", msec, Sys_NumJobThreads() );
+}
+
 /*
 ===============
 idSessionLocal::PacifierUpdate
@@ -2360,6 +2496,11 @@ void idSessionLocal::PacifierUpdate() {
 		float n = fileSystem->GetReadCount();
 		float pct = ( n / bytesNeededForMapLoad );
 		// pct = idMath::ClampFloat( 0.0f, 100.0f, pct );
+		// the read count is only an estimate, never let the bar fall behind
+		// the stage the load is in or move backwards
+		pct = Max( pct, loadStageProgress );
+		pct = Max( pct, loadProgress );
+		loadProgress = pct;
 		guiLoading->SetStateFloat( "map_loading", pct );
 		guiLoading->StateChanged( com_frameTime );
 	}
@@ -2408,7 +2549,10 @@ void idSessionLocal::Draw() {
 
 		guiActive->Redraw( com_frameTime );
 	} else if ( readDemo ) {
-		rw->RenderScene( &currentDemoRenderView );
+		// only the sound matters when mixing a demo to a wave file
+		if ( !waveCaptureMode ) {
+			rw->RenderScene( &currentDemoRenderView );
+		}
 		renderSystem->DrawDemoPics();
 	} else if ( mapSpawned ) {
 		bool gameDraw = false;
@@ -2861,6 +3005,7 @@ void idSessionLocal::Init() {
 	cmdSystem->AddCommand( "timeDemo", Session_TimeDemo_f, CMD_FL_SYSTEM, "times a demo", idCmdSystem::ArgCompletion_DemoName );
 	cmdSystem->AddCommand( "timeDemoQuit", Session_TimeDemoQuit_f, CMD_FL_SYSTEM, "times a demo and quits", idCmdSystem::ArgCompletion_DemoName );
 	cmdSystem->AddCommand( "aviDemo", Session_AVIDemo_f, CMD_FL_SYSTEM, "writes AVIs for a demo", idCmdSystem::ArgCompletion_DemoName );
+	cmdSystem->AddCommand( "waveDemo", Session_WaveDemo_f, CMD_FL_SYSTEM, "mixes the sound of a demo to a wave file as fast as possible", idCmdSystem::ArgCompletion_DemoName );
 	cmdSystem->AddCommand( "compressDemo", Session_CompressDemo_f, CMD_FL_SYSTEM, "compresses a demo file", idCmdSystem::ArgCompletion_DemoName );
 #endif
 
@@ -80,6 +80,13 @@ typedef struct {
 	usercmd_t		mapSpawnUsercmd[MAX_ASYNC_CLIENTS];		// needed for tracking delta angles
 } mapSpawnData_t;
 
+typedef struct {
+	const char *	name;
+	int				startTime;
+	int				msec;
+	int				bytesRead;
+} loadStage_t;
+
 typedef enum {
 	TD_NO,
 	TD_YES,
@@ -89,6 +96,7 @@ typedef enum {
 const int USERCMD_PER_DEMO_FRAME	= 2;
 const int CONNECT_TRANSMIT_TIME		= 1000;
 const int MAX_LOGGED_USERCMDS		= 60*60*60;	// one hour of single player, 15 minutes of four player
+const int MAX_LOAD_STAGES			= 16;
 
 class idSessionLocal : public idSession {
 public:
@@ -197,6 +205,12 @@ public:
 	// console print that happens
 	int					lastPacifierTime;
 
+	// timing of the steps of ExecuteMapChange, for the load report
+	loadStage_t			loadStages[MAX_LOAD_STAGES];
+	int					numLoadStages;
+	float				loadStageProgress;		// the loading bar doesn't fall below this
+	float				loadProgress;			// last value sent to the loading gui
+
 	// this is the information required to be set before ExecuteMapChange() is called,
 	// which can be saved off at any time with the following commands so it can all be played back
 	mapSpawnData_t		mapSpawnData;
@@ -231,6 +245,8 @@ public:
 	float				aviDemoFrameCount;
 	int					aviTicStart;
 
+	bool				waveCaptureMode;	// if true, the demo sound is mixed to a wave file and nothing is rendered
+
 	timeDemo_t			timeDemo;
 	int					timeDemoStartTime;
 	int					numDemoFrames;		// for timeDemo and demoShot
@@ -296,6 +312,9 @@ public:
 	void				BeginAVICapture( const char *name );
 	void				EndAVICapture();
 
+	void				WaveRenderDemo( const char *name );
+	void				EndWaveCapture();
+
 	void				AdvanceRenderDemo( bool singleFrameOnly );
 	void				RunGameTic();
 
@@ -312,6 +331,10 @@ public:
 	void				ExecuteMapChange( bool noFadeWipe = false );
 	void				UnloadMap();
 
+	void				BeginLoadStage( const char *name, float progress );
+	void				EndLoadStages( void );
+	void				PrintLoadStages( const char *mapName, int msec ) const;
+
 	// return true if we actually waiting on an auth reply
 	bool				MaybeWaitOnCDKey( void );
 
@@ -27,8 +27,10 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/CRC32.h"
 #include "idlib/geometry/JointTransform.h"
 #include "idlib/math/Quat.h"
+#include "framework/FileSystem.h"
 
 #include "Game_local.h"
 
@@ -164,8 +166,29 @@ bool idMD5Anim::LoadAnim( const char *filename ) {
 	idToken	token;
 	int		i, j;
 	int		num;
+	void	*buffer;
+	int		length;
+	unsigned int crc;
+
+	buffer = NULL;
+	length = 0;
+	crc = 0;
+
+	if ( cvarSystem->GetCVarBool( "r_binaryMD5" ) ) {
+		// read the text ourselves so it can be checked against the binary version
+		length = fileSystem->ReadFile( filename, &buffer, NULL );
+		if ( !buffer ) {
+			return false;
+		}
+
+		crc = CRC32_BlockChecksum( buffer, length );
+		if ( LoadBinary( filename, crc, length ) ) {
+			fileSystem->FreeFile( buffer );
+			return true;
+		}
 
-	if ( !parser.LoadFile( filename ) ) {
+		parser.LoadMemory( (const char *)buffer, length, filename );
+	} else if ( !parser.LoadFile( filename ) ) {
 		return false;
 	}
 
@@ -326,10 +349,158 @@ bool idMD5Anim::LoadAnim( const char *filename ) {
 	// we don't count last frame because it would cause a 1 frame pause at the end
 	animLength = ( ( numFrames - 1 ) * 1000 + frameRate - 1 ) / frameRate;
 
+	if ( buffer ) {
+		WriteBinary( crc, length );
+		parser.FreeSource();
+		fileSystem->FreeFile( buffer );
+	}
+
 	// done
 	return true;
 }
 
+/*
+====================
+MD5_BinaryAnimLayout
+
+Changes whenever the size of one of the arrays stored in their runtime layout changes.
+====================
+*/
+static int MD5_BinaryAnimLayout( void ) {
+	return sizeof( idBounds ) | ( sizeof( idJointQuat ) << 8 ) | ( sizeof( float ) << 16 );
+}
+
+/*
+====================
+idMD5Anim::LoadBinary
+
+Loads the animation from the binary file written by WriteBinary if it was made from the current text file,
+pak files have no timestamps so the text is identified by its checksum and length.
+====================
+*/
+bool idMD5Anim::LoadBinary( const char *filename, unsigned int sourceCRC, int sourceLength ) {
+	idStr		binaryName;
+	idStr		jointName;
+	idFile *	file;
+	int			ident, version, layout, binaryLength;
+	unsigned int binaryCRC;
+	int			i;
+
+	binaryName = filename;
+	binaryName.SetFileExtension( MD5_ANIM_BINARY_EXT );
+	file = fileSystem->OpenFileRead( binaryName );
+	if ( !file ) {
+		return false;
+	}
+
+	file->ReadInt( ident );
+	file->ReadInt( version );
+	file->ReadInt( layout );
+	file->ReadInt( binaryLength );
+	binaryCRC = 0;
+	file->ReadUnsignedInt( binaryCRC );
+	if ( ident != MD5_BINARY_ID || version != MD5_BINARY_VERSION || layout != MD5_BinaryAnimLayout() ||
+			binaryLength != sourceLength || binaryCRC != sourceCRC ) {
+		fileSystem->CloseFile( file );
+		return false;
+	}
+
+	Free();
+
+	name = filename;
+
+	file->ReadInt( numFrames );
+	file->ReadInt( numJoints );
+	file->ReadInt( frameRate );
+	file->ReadInt( numAnimatedComponents );
+	file->ReadInt( animLength );
+	file->ReadVec3( totaldelta );
+
+	if ( numFrames <= 0 || numJoints <= 0 || numAnimatedComponents < 0 || numAnimatedComponents > numJoints * 6 ||
+			numFrames * numAnimatedComponents * (int)sizeof( float ) > file->Length() - file->Tell() ) {
+		common->Warning( "%s is corrupt", binaryName.c_str() );
+		fileSystem->CloseFile( file );
+		Free();
+		return false;
+	}
+
+	jointInfo.SetGranularity( 1 );
+	jointInfo.SetNum( numJoints );
+	for( i = 0; i < numJoints; i++ ) {
+		file->ReadString( jointName );
+		jointInfo[ i ].nameIndex = animationLib.JointIndex( jointName );
+		file->ReadInt( jointInfo[ i ].parentNum );
+		file->ReadInt( jointInfo[ i ].animBits );
+		file->ReadInt( jointInfo[ i ].firstComponent );
+	}
+
+	bounds.SetGranularity( 1 );
+	bounds.SetNum( numFrames );
+	file->Read( bounds.Ptr(), numFrames * sizeof( bounds[ 0 ] ) );
+
+	baseFrame.SetGranularity( 1 );
+	baseFrame.SetNum( numJoints );
+	file->Read( baseFrame.Ptr(), numJoints * sizeof( baseFrame[ 0 ] ) );
+
+	componentFrames.SetGranularity( 1 );
+	componentFrames.SetNum( numAnimatedComponents * numFrames );
+	file->Read( componentFrames.Ptr(), componentFrames.Num() * sizeof( componentFrames[ 0 ] ) );
+
+	if ( file->Tell() != file->Length() ) {
+		common->Warning( "%s is corrupt", binaryName.c_str() );
+		fileSystem->CloseFile( file );
+		Free();
+		return false;
+	}
+
+	fileSystem->CloseFile( file );
+	return true;
+}
+
+/*
+====================
+idMD5Anim::WriteBinary
+====================
+*/
+void idMD5Anim::WriteBinary( unsigned int sourceCRC, int sourceLength ) const {
+	idStr		binaryName;
+	idFile *	file;
+	int			i;
+
+	binaryName = name;
+	binaryName.SetFileExtension( MD5_ANIM_BINARY_EXT );
+	file = fileSystem->OpenFileWrite( binaryName );
+	if ( !file ) {
+		return;
+	}
+
+	file->WriteInt( MD5_BINARY_ID );
+	file->WriteInt( MD5_BINARY_VERSION );
+	file->WriteInt( MD5_BinaryAnimLayout() );
+	file->WriteInt( sourceLength );
+	file->WriteUnsignedInt( sourceCRC );
+
+	file->WriteInt( numFrames );
+	file->WriteInt( numJoints );
+	file->WriteInt( frameRate );
+	file->WriteInt( numAnimatedComponents );
+	file->WriteInt( animLength );
+	file->WriteVec3( totaldelta );
+
+	for( i = 0; i < numJoints; i++ ) {
+		file->WriteString( animationLib.JointName( jointInfo[ i ].nameIndex ) );
+		file->WriteInt( jointInfo[ i ].parentNum );
+		file->WriteInt( jointInfo[ i ].animBits );
+		file->WriteInt( jointInfo[ i ].firstComponent );
+	}
+
+	file->Write( bounds.Ptr(), bounds.Num() * sizeof( bounds[ 0 ] ) );
+	file->Write( baseFrame.Ptr(), baseFrame.Num() * sizeof( baseFrame[ 0 ] ) );
+	file->Write( componentFrames.Ptr(), componentFrames.Num() * sizeof( componentFrames[ 0 ] ) );
+
+	fileSystem->CloseFile( file );
+}
+
 /*
 ====================
 idMD5Anim::IncreaseRefs
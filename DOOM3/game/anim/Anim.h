@@ -239,6 +239,9 @@ private:
 	idVec3					totaldelta;
 	mutable int				ref_count;
 
+	bool					LoadBinary( const char *filename, unsigned int sourceCRC, int sourceLength );
+	void					WriteBinary( unsigned int sourceCRC, int sourceLength ) const;
+
 public:
 							idMD5Anim();
 							~idMD5Anim();
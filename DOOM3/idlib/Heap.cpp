@@ -1058,6 +1058,56 @@ void Mem_UpdateFreeStats( int size ) {
 	mem_total_allocs.totalSize -= size;
 }
 
+static bool			mem_threadSafe = false;
+
+/*
+==================
+Mem_EnableThreadSafety
+
+turned on while a job list is handed to the job threads and off again once
+the last such list was waited on, so allocations between job batches don't
+take the heap lock
+==================
+*/
+void Mem_EnableThreadSafety( bool enable ) {
+	mem_threadSafe = enable;
+}
+
+/*
+==================
+Mem_IsThreadSafe
+==================
+*/
+bool Mem_IsThreadSafe( void ) {
+	return mem_threadSafe;
+}
+
+/*
+==================
+Mem_Lock
+==================
+*/
+static ID_INLINE bool Mem_Lock( void ) {
+	if ( mem_threadSafe ) {
+		Sys_EnterCriticalSection( CRITICAL_SECTION_HEAP );
+		return true;
+	}
+	return false;
+}
+
+/*
+==================
+Mem_Unlock
+
+takes the result of Mem_Lock, the lock may be turned on or off in between
+==================
+*/
+static ID_INLINE void Mem_Unlock( bool locked ) {
+	if ( locked ) {
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_HEAP );
+	}
+}
+
 
 #ifndef ID_DEBUG_MEMORY
 
@@ -1076,8 +1126,10 @@ void *Mem_Alloc( const int size ) {
 #endif
 		return malloc( size );
 	}
+	bool locked = Mem_Lock();
 	void *mem = mem_heap->Allocate( size );
 	Mem_UpdateAllocStats( mem_heap->Msize( mem ) );
+	Mem_Unlock( locked );
 	return mem;
 }
 
@@ -1097,8 +1149,10 @@ void Mem_Free( void *ptr ) {
 		free( ptr );
 		return;
 	}
+	bool locked = Mem_Lock();
 	Mem_UpdateFreeStats( mem_heap->Msize( ptr ) );
 	mem_heap->Free( ptr );
+	Mem_Unlock( locked );
 }
 
 /*
@@ -1116,7 +1170,9 @@ void *Mem_Alloc16( const int size ) {
 #endif
 		return malloc( size );
 	}
+	bool locked = Mem_Lock();
 	void *mem = mem_heap->Allocate16( size );
+	Mem_Unlock( locked );
 	// make sure the memory is 16 byte aligned
 	assert( ( ((intptr_t)mem) & 15) == 0 );
 	return mem;
@@ -1140,7 +1196,9 @@ void Mem_Free16( void *ptr ) {
 	}
 	// make sure the memory is 16 byte aligned
 	assert( ( ((intptr_t)ptr) & 15) == 0 );
+	bool locked = Mem_Lock();
 	mem_heap->Free16( ptr );
+	Mem_Unlock( locked );
 }
 
 /*
@@ -1542,6 +1600,8 @@ void *Mem_AllocDebugMemory( const int size, const char *fileName, const int line
 		return malloc( size );
 	}
 
+	bool locked = Mem_Lock();
+
 	if ( align16 ) {
 		p = mem_heap->Allocate16( size + sizeof( debugMemory_t ) );
 	}
@@ -1563,6 +1623,8 @@ void *Mem_AllocDebugMemory( const int size, const char *fileName, const int line
 	}
 	mem_debugMemory = m;
 
+	Mem_Unlock( locked );
+
 	return ( ( (byte *) p ) + sizeof( debugMemory_t ) );
 }
 
@@ -1589,6 +1651,8 @@ void Mem_FreeDebugMemory( void *p, const char *fileName, const int lineNumber, c
 
 	m = (debugMemory_t *) ( ( (byte *) p ) - sizeof( debugMemory_t ) );
 
+	bool locked = Mem_Lock();
+
 	if ( m->size < 0 ) {
 		idLib::common->FatalError( "memory freed twice" );
 	}
@@ -1616,6 +1680,8 @@ void Mem_FreeDebugMemory( void *p, const char *fileName, const int lineNumber, c
 	else {
 		mem_heap->Free( m );
 	}
+
+	Mem_Unlock( locked );
 }
 
 /*
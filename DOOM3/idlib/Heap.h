@@ -62,6 +62,9 @@ void		Mem_GetStats( memoryStats_t &stats );
 void		Mem_Dump_f( const class idCmdArgs &args );
 void		Mem_DumpCompressed_f( const class idCmdArgs &args );
 void		Mem_AllocDefragBlock( void );
+// lock the heap and the string allocator while job threads are running
+void		Mem_EnableThreadSafety( bool enable );
+bool		Mem_IsThreadSafe( void );
 
 
 #ifndef ID_DEBUG_MEMORY
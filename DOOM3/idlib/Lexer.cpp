@@ -30,6 +30,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "idlib/Heap.h"
 #include "framework/Common.h"
 #include "framework/FileSystem.h"
+#include "idlib/CmdArgs.h"
 
 #include "idlib/Lexer.h"
 
@@ -116,6 +117,48 @@ int default_setup;
 
 char idLexer::baseFolder[ 256 ];
 
+// character classes used by the tokenizer to find the end of names and strings
+#define LEXCC_NAME			BIT(0)		// letters, digits and '_'
+#define LEXCC_NAMESTART		BIT(1)		// letters and '_'
+#define LEXCC_DIGIT			BIT(2)		// '0' to '9'
+#define LEXCC_PATH			BIT(3)		// extra name characters with LEXFL_ALLOWPATHNAMES
+#define LEXCC_DASH			BIT(4)		// extra name character with LEXFL_ONLYSTRINGS
+#define LEXCC_STRING		BIT(5)		// characters that end a plain run inside a string
+
+// constant initialized, so it is ready before any static constructor runs
+#define L	( LEXCC_NAME | LEXCC_NAMESTART )
+#define D	( LEXCC_NAME | LEXCC_DIGIT )
+#define P	LEXCC_PATH
+#define PS	( LEXCC_PATH | LEXCC_STRING )
+#define M	LEXCC_DASH
+#define S	LEXCC_STRING
+
+static const byte lexCharClass[256] = {
+	S,  0,  0,  0,  0,  0,  0,  0,  0,  0,  S,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  S,  0,  0,  0,  0,  S,  0,  0,  0,  0,  0,  M,  P,  P,
+	D,  D,  D,  D,  D,  D,  D,  D,  D,  D,  P,  0,  0,  0,  0,  0,
+	0,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,
+	L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  0,  PS, 0,  0,  L,
+	0,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,
+	L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  L,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+#undef L
+#undef D
+#undef P
+#undef PS
+#undef M
+#undef S
+
 /*
 ================
 idLexer::CreatePunctuationTable
@@ -438,8 +481,8 @@ Reads two strings with only a white space between them as one string.
 ================
 */
 int idLexer::ReadString( idToken *token, int quote ) {
-	int tmpline;
-	const char *tmpscript_p;
+	int tmpline, l;
+	const char *tmpscript_p, *start;
 	char ch;
 
 	if ( quote == '\"' ) {
@@ -510,7 +553,15 @@ int idLexer::ReadString( idToken *token, int quote ) {
 				idLexer::Error( "newline inside string" );
 				return 0;
 			}
-			token->AppendDirty( *idLexer::script_p++ );
+			// copy the whole run of plain characters up to the next one that needs a closer look
+			start = idLexer::script_p;
+			do {
+				idLexer::script_p++;
+			} while ( !( lexCharClass[(byte)*idLexer::script_p] & LEXCC_STRING ) );
+			l = idLexer::script_p - start;
+			token->EnsureAlloced( token->len + l + 1, true );
+			memcpy( token->data + token->len, start, l );
+			token->len += l;
 		}
 	}
 	token->data[token->len] = '\0';
@@ -536,20 +587,29 @@ idLexer::ReadName
 ================
 */
 int idLexer::ReadName( idToken *token ) {
-	char c;
+	const char *start;
+	int mask, l;
+
+	mask = LEXCC_NAME;
+	// if treating all tokens as strings, don't parse '-' as a seperate token
+	if ( idLexer::flags & LEXFL_ONLYSTRINGS ) {
+		mask |= LEXCC_DASH;
+	}
+	// if special path name characters are allowed
+	if ( idLexer::flags & LEXFL_ALLOWPATHNAMES ) {
+		mask |= LEXCC_PATH;
+	}
 
 	token->type = TT_NAME;
+	// the first character is always taken, find the end of the name and copy it at once
+	start = idLexer::script_p;
 	do {
-		token->AppendDirty( *idLexer::script_p++ );
-		c = *idLexer::script_p;
-	} while ((c >= 'a' && c <= 'z') ||
-				(c >= 'A' && c <= 'Z') ||
-				(c >= '0' && c <= '9') ||
-				c == '_' ||
-				// if treating all tokens as strings, don't parse '-' as a seperate token
-				((idLexer::flags & LEXFL_ONLYSTRINGS) && (c == '-')) ||
-				// if special path name characters are allowed
-				((idLexer::flags & LEXFL_ALLOWPATHNAMES) && (c == '/' || c == '\\' || c == ':' || c == '.')) );
+		idLexer::script_p++;
+	} while ( lexCharClass[(byte)*idLexer::script_p] & mask );
+	l = idLexer::script_p - start;
+	token->EnsureAlloced( token->len + l + 1, true );
+	memcpy( token->data + token->len, start, l );
+	token->len += l;
 	token->data[token->len] = '\0';
 	//the sub type is the length of the name
 	token->subtype = token->Length();
@@ -873,15 +933,15 @@ int idLexer::ReadToken( idToken *token ) {
 		}
 	}
 	// if there is a number
-	else if ( (c >= '0' && c <= '9') ||
-			(c == '.' && (*(idLexer::script_p + 1) >= '0' && *(idLexer::script_p + 1) <= '9')) ) {
+	else if ( ( lexCharClass[(byte)c] & LEXCC_DIGIT ) ||
+			( c == '.' && ( lexCharClass[(byte)*(idLexer::script_p + 1)] & LEXCC_DIGIT ) ) ) {
 		if ( !idLexer::ReadNumber( token ) ) {
 			return 0;
 		}
 		// if names are allowed to start with a number
 		if ( idLexer::flags & LEXFL_ALLOWNUMBERNAMES ) {
 			c = *idLexer::script_p;
-			if ( (c >= 'a' && c <= 'z') ||	(c >= 'A' && c <= 'Z') || c == '_' ) {
+			if ( lexCharClass[(byte)c] & LEXCC_NAMESTART ) {
 				if ( !idLexer::ReadName( token ) ) {
 					return 0;
 				}
@@ -895,7 +955,7 @@ int idLexer::ReadToken( idToken *token ) {
 		}
 	}
 	// if there is a name
-	else if ( (c >= 'a' && c <= 'z') ||	(c >= 'A' && c <= 'Z') || c == '_' ) {
+	else if ( lexCharClass[(byte)c] & LEXCC_NAMESTART ) {
 		if ( !idLexer::ReadName( token ) ) {
 			return 0;
 		}
@@ -1127,20 +1187,123 @@ int idLexer::SkipRestOfLine( void ) {
 	return 0;
 }
 
+/*
+=================
+idLexer::SkipToken
+
+Steps over the next token without building it.
+Returns 0 at the end of the script and -1 with the script pointer at the
+start of the token when the token needs the full tokenizer.
+=================
+*/
+int idLexer::SkipToken( int *brace ) {
+	const char *start, *p;
+	int c, mask, l, n;
+
+	*brace = 0;
+	lastScript_p = script_p;
+	lastline = line;
+	whiteSpaceStart_p = script_p;
+	if ( !ReadWhiteSpace() ) {
+		return 0;
+	}
+	whiteSpaceEnd_p = script_p;
+
+	start = script_p;
+	c = (byte)*script_p;
+
+	// braces are the only tokens the caller cares about
+	if ( c == '{' || c == '}' ) {
+		*brace = c;
+		script_p++;
+		return 1;
+	}
+
+	// numbers
+	if ( ( lexCharClass[c] & LEXCC_DIGIT ) || ( c == '.' && ( lexCharClass[(byte)script_p[1]] & LEXCC_DIGIT ) ) ) {
+		do {
+			script_p++;
+		} while ( ( lexCharClass[(byte)*script_p] & LEXCC_NAME ) || *script_p == '.' );
+		return 1;
+	}
+
+	// names
+	mask = LEXCC_NAME;
+	if ( flags & LEXFL_ALLOWPATHNAMES ) {
+		mask |= LEXCC_PATH;
+	}
+	if ( ( lexCharClass[c] & LEXCC_NAMESTART ) || ( ( flags & LEXFL_ALLOWPATHNAMES ) && ( c == '/' || c == '\\' || c == '.' ) ) ) {
+		do {
+			script_p++;
+		} while ( lexCharClass[(byte)*script_p] & mask );
+		return 1;
+	}
+
+	// strings, anything with escapes or errors goes through the tokenizer
+	if ( c == '\"' || c == '\'' ) {
+		for ( p = script_p + 1; *p != c; p++ ) {
+			if ( lexCharClass[(byte)*p] & LEXCC_STRING ) {
+				if ( *p == '\"' || *p == '\'' ) {
+					continue;
+				}
+				script_p = start;
+				return -1;
+			}
+		}
+		script_p = p + 1;
+		return 1;
+	}
+
+	// punctuation, longest match first
+	for ( n = punctuationtable[c]; n >= 0; n = nextpunctuation[n] ) {
+		p = punctuations[n].p;
+		for ( l = 0; p[l] && script_p[l]; l++ ) {
+			if ( script_p[l] != p[l] ) {
+				break;
+			}
+		}
+		if ( !p[l] ) {
+			script_p += l;
+			return 1;
+		}
+	}
+
+	script_p = start;
+	return -1;
+}
+
 /*
 =================
 idLexer::SkipBracedSection
 
 Skips until a matching close brace is found.
 Internal brace depths are properly skipped.
+Plain text is stepped over without building tokens.
 =================
 */
 int idLexer::SkipBracedSection( bool parseFirstBrace ) {
 	idToken token;
-	int depth;
+	int depth, brace, skipped;
+	bool fast;
+
+	fast = loaded && !tokenavailable && !( flags & LEXFL_ONLYSTRINGS );
 
 	depth = parseFirstBrace ? 0 : 1;
 	do {
+		if ( fast ) {
+			skipped = SkipToken( &brace );
+			if ( !skipped ) {
+				return false;
+			}
+			if ( skipped > 0 ) {
+				if ( brace == '{' ) {
+					depth++;
+				} else if ( brace == '}' ) {
+					depth--;
+				}
+				continue;
+			}
+		}
 		if ( !ReadToken( &token ) ) {
 			return false;
 		}
@@ -1798,3 +1961,102 @@ idLexer::HadError
 bool idLexer::HadError( void ) const {
 	return hadError;
 }
+
+/*
+================
+idLexer::Benchmark_f
+
+Times reading all the tokens of a file, and the two parts of it that are
+left as they are: copying the text into the token, which a token referencing
+the script buffer would skip, and walking the punctuation chains, which a
+perfect hash would replace.
+================
+*/
+void idLexer::Benchmark_f( const idCmdArgs &args ) {
+	idList<idToken>	tokens;
+	idToken			token, copy;
+	char *			buffer;
+	int				i, j, n, l, count, length, numPunctuations, check;
+	int				start, readTime, copyTime, lookupTime;
+
+	if ( args.Argc() < 2 ) {
+		idLib::common->Printf( "usage: benchLexer <filename> [count]\n" );
+		return;
+	}
+
+	count = ( args.Argc() > 2 ) ? atoi( args.Argv( 2 ) ) : 10;
+	if ( count < 1 ) {
+		count = 1;
+	}
+
+	length = idLib::fileSystem->ReadFile( args.Argv( 1 ), (void **)&buffer, NULL );
+	if ( !buffer ) {
+		idLib::common->Printf( "couldn't load %s\n", args.Argv( 1 ) );
+		return;
+	}
+
+	// the flags decls are read with
+	const int benchFlags = LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES | LEXFL_ALLOWMULTICHARLITERALS | LEXFL_ALLOWBACKSLASHSTRINGCONCAT | LEXFL_NOFATALERRORS;
+
+	numPunctuations = 0;
+	{
+		idLexer src( buffer, length, args.Argv( 1 ), benchFlags );
+		while ( src.ReadToken( &token ) ) {
+			tokens.Append( token );
+			if ( token.type == TT_PUNCTUATION ) {
+				numPunctuations++;
+			}
+		}
+	}
+
+	start = idLib::sys->GetMilliseconds();
+	for ( i = 0; i < count; i++ ) {
+		idLexer src( buffer, length, args.Argv( 1 ), benchFlags );
+		while ( src.ReadToken( &token ) ) {
+		}
+	}
+	readTime = idLib::sys->GetMilliseconds() - start;
+
+	// ReadToken builds every token once, the same as this assignment
+	start = idLib::sys->GetMilliseconds();
+	for ( i = 0; i < count; i++ ) {
+		for ( j = 0; j < tokens.Num(); j++ ) {
+			copy = tokens[j];
+		}
+	}
+	copyTime = idLib::sys->GetMilliseconds() - start;
+
+	// the same chain walk as ReadPunctuation, without building the token
+	idLexer lexer;
+	check = 0;
+	start = idLib::sys->GetMilliseconds();
+	for ( i = 0; i < count; i++ ) {
+		for ( j = 0; j < tokens.Num(); j++ ) {
+			if ( tokens[j].type != TT_PUNCTUATION ) {
+				continue;
+			}
+			const char *text = tokens[j].c_str();
+			for ( n = lexer.punctuationtable[(unsigned int)text[0]]; n >= 0; n = lexer.nextpunctuation[n] ) {
+				const char *p = lexer.punctuations[n].p;
+				for ( l = 0; p[l] && text[l]; l++ ) {
+					if ( text[l] != p[l] ) {
+						break;
+					}
+				}
+				if ( !p[l] ) {
+					check += lexer.punctuations[n].n;
+					break;
+				}
+			}
+		}
+	}
+	lookupTime = idLib::sys->GetMilliseconds() - start;
+
+	idLib::fileSystem->FreeFile( buffer );
+
+	float scale = 1.0f / count;
+	float percent = readTime > 0 ? 100.0f / readTime : 0.0f;
+	idLib::common->Printf( "%s: %d tokens read in %.2f msec\n", args.Argv( 1 ), tokens.Num(), readTime * scale );
+	idLib::common->Printf( "  copying the token text: %.2f msec (%.0f%%)\n", copyTime * scale, copyTime * percent );
+	idLib::common->Printf( "  %d punctuation lookups: %.2f msec (%.0f%%, %d)\n", numPunctuations, lookupTime * scale, lookupTime * percent, check );
+}
@@ -242,6 +242,8 @@ public:
 
 					// set the base folder to load files from
 	static void		SetBaseFolder( const char *path );
+					// times the parts of ReadToken a zero copy token or a perfect hashed punctuation lookup would speed up
+	static void		Benchmark_f( const class idCmdArgs &args );
 
 private:
 	int				loaded;					// set when a script file is loaded from file or memory
@@ -277,6 +279,7 @@ private:
 	int				ReadNumber( idToken *token );
 	int				ReadPunctuation( idToken *token );
 	int				ReadPrimitive( idToken *token );
+	int				SkipToken( int *brace );
 	int				CheckString( const char *str ) const;
 	int				NumLinesCrossed( void );
 };
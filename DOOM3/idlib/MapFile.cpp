@@ -27,11 +27,14 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/CRC32.h"
 #include "framework/File.h"
 #include "framework/FileSystem.h"
 
 #include "idlib/MapFile.h"
 
+idCVar map_binary( "map_binary", "1", CVAR_SYSTEM | CVAR_BOOL, "load maps from binary .mapb files generated from the .map text" );
+
 /*
 ===============
 FloatCRC
@@ -245,6 +248,63 @@ bool idMapPatch::Write( idFile *fp, int primitiveNum, const idVec3 &origin ) con
 	return true;
 }
 
+/*
+============
+idMapPatch::ParseBinary
+============
+*/
+idMapPatch *idMapPatch::ParseBinary( idFile *fp ) {
+	idStr material;
+	int i, width, height, horzSubdivisions, vertSubdivisions;
+	bool explicitSubdivisions;
+
+	fp->ReadString( material );
+	fp->ReadInt( width );
+	fp->ReadInt( height );
+	fp->ReadInt( horzSubdivisions );
+	fp->ReadInt( vertSubdivisions );
+	fp->ReadBool( explicitSubdivisions );
+
+	if ( width < 0 || height < 0 || width * height * 20 > fp->Length() - fp->Tell() ) {
+		return NULL;
+	}
+
+	idMapPatch *patch = new idMapPatch( width, height );
+	patch->SetSize( width, height );
+	patch->SetMaterial( material );
+	patch->SetHorzSubdivisions( horzSubdivisions );
+	patch->SetVertSubdivisions( vertSubdivisions );
+	patch->SetExplicitlySubdivided( explicitSubdivisions );
+	for ( i = 0; i < width * height; i++ ) {
+		fp->ReadVec3( patch->verts[i].xyz );
+		fp->ReadVec2( patch->verts[i].st );
+	}
+	patch->epairs.ReadFromFileHandle( fp );
+
+	return patch;
+}
+
+/*
+============
+idMapPatch::WriteBinary
+============
+*/
+void idMapPatch::WriteBinary( idFile *fp ) const {
+	int i;
+
+	fp->WriteString( GetMaterial() );
+	fp->WriteInt( GetWidth() );
+	fp->WriteInt( GetHeight() );
+	fp->WriteInt( GetHorzSubdivisions() );
+	fp->WriteInt( GetVertSubdivisions() );
+	fp->WriteBool( GetExplicitlySubdivided() );
+	for ( i = 0; i < GetWidth() * GetHeight(); i++ ) {
+		fp->WriteVec3( verts[i].xyz );
+		fp->WriteVec2( verts[i].st );
+	}
+	epairs.WriteToFileHandle( fp );
+}
+
 /*
 ===============
 idMapPatch::GetGeometryCRC
@@ -507,6 +567,57 @@ bool idMapBrush::Write( idFile *fp, int primitiveNum, const idVec3 &origin ) con
 	return true;
 }
 
+/*
+============
+idMapBrush::ParseBinary
+============
+*/
+idMapBrush *idMapBrush::ParseBinary( idFile *fp ) {
+	int i, numSides;
+	idMapBrushSide *side;
+
+	fp->ReadInt( numSides );
+	if ( numSides < 0 || numSides > fp->Length() - fp->Tell() ) {
+		return NULL;
+	}
+
+	idMapBrush *brush = new idMapBrush();
+	brush->sides.Resize( numSides );
+	for ( i = 0; i < numSides; i++ ) {
+		side = new idMapBrushSide();
+		fp->ReadString( side->material );
+		fp->ReadVec4( side->plane.ToVec4() );
+		fp->ReadVec3( side->texMat[0] );
+		fp->ReadVec3( side->texMat[1] );
+		fp->ReadVec3( side->origin );
+		brush->AddSide( side );
+	}
+	brush->epairs.ReadFromFileHandle( fp );
+
+	return brush;
+}
+
+/*
+============
+idMapBrush::WriteBinary
+============
+*/
+void idMapBrush::WriteBinary( idFile *fp ) const {
+	int i;
+	idMapBrushSide *side;
+
+	fp->WriteInt( GetNumSides() );
+	for ( i = 0; i < GetNumSides(); i++ ) {
+		side = GetSide( i );
+		fp->WriteString( side->material );
+		fp->WriteVec4( side->plane.ToVec4() );
+		fp->WriteVec3( side->texMat[0] );
+		fp->WriteVec3( side->texMat[1] );
+		fp->WriteVec3( side->origin );
+	}
+	epairs.WriteToFileHandle( fp );
+}
+
 /*
 ===============
 idMapBrush::GetGeometryCRC
@@ -675,6 +786,74 @@ bool idMapEntity::Write( idFile *fp, int entityNum ) const {
 	return true;
 }
 
+/*
+============
+idMapEntity::ParseBinary
+============
+*/
+idMapEntity *idMapEntity::ParseBinary( idFile *fp ) {
+	int i, numPrimitives, type;
+	idMapPrimitive *mapPrim;
+
+	idMapEntity *mapEnt = new idMapEntity();
+	mapEnt->epairs.ReadFromFileHandle( fp );
+
+	fp->ReadInt( numPrimitives );
+	if ( numPrimitives < 0 || numPrimitives > fp->Length() - fp->Tell() ) {
+		delete mapEnt;
+		return NULL;
+	}
+	mapEnt->primitives.Resize( numPrimitives );
+
+	for ( i = 0; i < numPrimitives; i++ ) {
+		fp->ReadInt( type );
+		switch( type ) {
+			case idMapPrimitive::TYPE_BRUSH:
+				mapPrim = idMapBrush::ParseBinary( fp );
+				break;
+			case idMapPrimitive::TYPE_PATCH:
+				mapPrim = idMapPatch::ParseBinary( fp );
+				break;
+			default:
+				mapPrim = NULL;
+				break;
+		}
+		if ( !mapPrim ) {
+			delete mapEnt;
+			return NULL;
+		}
+		mapEnt->AddPrimitive( mapPrim );
+	}
+
+	return mapEnt;
+}
+
+/*
+============
+idMapEntity::WriteBinary
+============
+*/
+void idMapEntity::WriteBinary( idFile *fp ) const {
+	int i;
+	idMapPrimitive *mapPrim;
+
+	epairs.WriteToFileHandle( fp );
+
+	fp->WriteInt( GetNumPrimitives() );
+	for ( i = 0; i < GetNumPrimitives(); i++ ) {
+		mapPrim = GetPrimitive( i );
+		fp->WriteInt( mapPrim->GetType() );
+		switch( mapPrim->GetType() ) {
+			case idMapPrimitive::TYPE_BRUSH:
+				static_cast<idMapBrush*>(mapPrim)->WriteBinary( fp );
+				break;
+			case idMapPrimitive::TYPE_PATCH:
+				static_cast<idMapPatch*>(mapPrim)->WriteBinary( fp );
+				break;
+		}
+	}
+}
+
 /*
 ===============
 idMapEntity::RemovePrimitiveData
@@ -720,46 +899,91 @@ bool idMapFile::Parse( const char *filename, bool ignoreRegion, bool osPath ) {
 	// no string concatenation for epairs and allow path names for materials
 	idLexer src( LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES );
 	idToken token;
-	idStr fullName;
+	idStr fullName, binaryName;
 	idMapEntity *mapEnt;
 	int i, j, k;
+	void *buffer;
+	int length;
+	unsigned int crc;
 
 	name = filename;
 	name.StripFileExtension();
 	fullName = name;
 	hasPrimitiveData = false;
+	buffer = NULL;
+	length = 0;
+	crc = 0;
 
-	if ( !ignoreRegion ) {
-		// try loading a .reg file first
-		fullName.SetFileExtension( "reg" );
-		src.LoadFile( fullName, osPath );
-	}
+	if ( !osPath && map_binary.GetBool() ) {
+		// read the text ourselves so it can be checked against the binary version
+		if ( !ignoreRegion ) {
+			// try loading a .reg file first
+			fullName.SetFileExtension( "reg" );
+			length = idLib::fileSystem->ReadFile( fullName, &buffer, &fileTime );
+		}
+
+		if ( !buffer ) {
+			// now try a .map file
+			fullName.SetFileExtension( "map" );
+			length = idLib::fileSystem->ReadFile( fullName, &buffer, &fileTime );
+			if ( !buffer ) {
+				// didn't get anything at all
+				return false;
+			}
+		}
+
+		crc = CRC32_BlockChecksum( buffer, length );
+		binaryName = fullName + "b";
+
+		if ( ParseBinary( binaryName, crc, length ) ) {
+			idLib::fileSystem->FreeFile( buffer );
+			buffer = NULL;
+		} else {
+			src.LoadMemory( (const char *)buffer, length, fullName );
+		}
+	} else {
+		if ( !ignoreRegion ) {
+			// try loading a .reg file first
+			fullName.SetFileExtension( "reg" );
+			src.LoadFile( fullName, osPath );
+		}
 
-	if ( !src.IsLoaded() ) {
-		// now try a .map file
-		fullName.SetFileExtension( "map" );
-		src.LoadFile( fullName, osPath );
 		if ( !src.IsLoaded() ) {
-			// didn't get anything at all
-			return false;
+			// now try a .map file
+			fullName.SetFileExtension( "map" );
+			src.LoadFile( fullName, osPath );
+			if ( !src.IsLoaded() ) {
+				// didn't get anything at all
+				return false;
+			}
 		}
+
+		fileTime = src.GetFileTime();
 	}
 
-	version = OLD_MAP_VERSION;
-	fileTime = src.GetFileTime();
-	entities.DeleteContents( true );
+	if ( src.IsLoaded() ) {
+		version = OLD_MAP_VERSION;
+		entities.DeleteContents( true );
 
-	if ( src.CheckTokenString( "Version" ) ) {
-		src.ReadTokenOnLine( &token );
-		version = token.GetFloatValue();
-	}
+		if ( src.CheckTokenString( "Version" ) ) {
+			src.ReadTokenOnLine( &token );
+			version = token.GetFloatValue();
+		}
 
-	while( 1 ) {
-		mapEnt = idMapEntity::Parse( src, ( entities.Num() == 0 ), version );
-		if ( !mapEnt ) {
-			break;
+		while( 1 ) {
+			mapEnt = idMapEntity::Parse( src, ( entities.Num() == 0 ), version );
+			if ( !mapEnt ) {
+				break;
+			}
+			entities.Append( mapEnt );
+		}
+
+		if ( buffer ) {
+			// store the parsed map before any of the worldspawn options below change it
+			WriteBinary( binaryName, crc, length );
+			src.FreeSource();
+			idLib::fileSystem->FreeFile( buffer );
 		}
-		entities.Append( mapEnt );
 	}
 
 	SetGeometryCRC();
@@ -862,6 +1086,148 @@ bool idMapFile::Write( const char *fileName, const char *ext, bool fromBasePath
 	return true;
 }
 
+/*
+===============
+idMapFile::ParseBinary
+
+Loads the entities from a binary map, returns false if it doesn't exist
+or was written for a different version of the text file.
+===============
+*/
+bool idMapFile::ParseBinary( const char *fileName, unsigned int sourceCRC, int sourceLength ) {
+	void *buffer;
+	int i, length, ident, binaryVersion, binaryLength, numEntities;
+	unsigned int binaryCRC;
+	idMapEntity *mapEnt;
+
+	length = idLib::fileSystem->ReadFile( fileName, &buffer, NULL );
+	if ( !buffer ) {
+		return false;
+	}
+
+	idFile_Memory fp( fileName, (const char *)buffer, length );
+
+	fp.ReadInt( ident );
+	fp.ReadInt( binaryVersion );
+	fp.ReadUnsignedInt( binaryCRC );
+	fp.ReadInt( binaryLength );
+	if ( ident != BINARY_MAP_ID || binaryVersion != BINARY_MAP_VERSION || binaryCRC != sourceCRC || binaryLength != sourceLength ) {
+		idLib::fileSystem->FreeFile( buffer );
+		return false;
+	}
+
+	entities.DeleteContents( true );
+
+	fp.ReadFloat( version );
+	fp.ReadInt( numEntities );
+	for ( i = 0; i < numEntities && fp.Tell() < fp.Length(); i++ ) {
+		mapEnt = idMapEntity::ParseBinary( &fp );
+		if ( !mapEnt ) {
+			break;
+		}
+		entities.Append( mapEnt );
+	}
+
+	if ( i < numEntities || fp.Tell() != fp.Length() ) {
+		idLib::common->Warning( "%s is corrupt", fileName );
+		entities.DeleteContents( true );
+		idLib::fileSystem->FreeFile( buffer );
+		return false;
+	}
+
+	idLib::fileSystem->FreeFile( buffer );
+	return true;
+}
+
+/*
+===============
+idMapFile::WriteBinary
+===============
+*/
+void idMapFile::WriteBinary( const char *fileName, unsigned int sourceCRC, int sourceLength ) const {
+	int i;
+	idFile *fp;
+
+	fp = idLib::fileSystem->OpenFileWrite( fileName );
+	if ( !fp ) {
+		return;
+	}
+
+	fp->WriteInt( BINARY_MAP_ID );
+	fp->WriteInt( BINARY_MAP_VERSION );
+	fp->WriteUnsignedInt( sourceCRC );
+	fp->WriteInt( sourceLength );
+
+	fp->WriteFloat( version );
+	fp->WriteInt( entities.Num() );
+	for ( i = 0; i < entities.Num(); i++ ) {
+		entities[i]->WriteBinary( fp );
+	}
+
+	idLib::fileSystem->CloseFile( fp );
+}
+
+/*
+===============
+idMapFile::Benchmark_f
+
+Compares the time it takes to load a map from text and from the binary version.
+===============
+*/
+void idMapFile::Benchmark_f( const idCmdArgs &args ) {
+	int i, count, start, textTime, binaryTime;
+	bool useBinary;
+	idStr mapName;
+
+	if ( args.Argc() < 2 ) {
+		idLib::common->Printf( "usage: benchMapFile <mapname> [count]\n" );
+		return;
+	}
+
+	mapName = args.Argv( 1 );
+	if ( mapName.Icmpn( "maps/", 5 ) != 0 ) {
+		mapName = "maps/" + mapName;
+	}
+	count = ( args.Argc() > 2 ) ? atoi( args.Argv( 2 ) ) : 5;
+	if ( count < 1 ) {
+		count = 1;
+	}
+
+	useBinary = map_binary.GetBool();
+
+	// make sure the binary version exists before it is timed
+	map_binary.SetBool( true );
+	{
+		idMapFile mapFile;
+		if ( !mapFile.Parse( mapName ) ) {
+			idLib::common->Printf( "couldn't load %s\n", mapName.c_str() );
+			map_binary.SetBool( useBinary );
+			return;
+		}
+	}
+
+	map_binary.SetBool( false );
+	start = idLib::sys->GetMilliseconds();
+	for ( i = 0; i < count; i++ ) {
+		idMapFile mapFile;
+		mapFile.Parse( mapName );
+	}
+	textTime = idLib::sys->GetMilliseconds() - start;
+
+	map_binary.SetBool( true );
+	start = idLib::sys->GetMilliseconds();
+	for ( i = 0; i < count; i++ ) {
+		idMapFile mapFile;
+		mapFile.Parse( mapName );
+	}
+	binaryTime = idLib::sys->GetMilliseconds() - start;
+
+	map_binary.SetBool( useBinary );
+
+	idLib::common->Printf( "%s: text %.1f msec, binary %.1f msec per load (%d loads)\n", mapName.c_str(),
+							(float)textTime / count, (float)binaryTime / count, count );
+}
+
 /*
 ===============
 idMapFile::SetGeometryCRC
@@ -55,6 +55,11 @@ const float DEFAULT_CURVE_MAX_ERROR_CD		= 24.0f;
 const float DEFAULT_CURVE_MAX_LENGTH		= -1.0f;
 const float DEFAULT_CURVE_MAX_LENGTH_CD		= -1.0f;
 
+// binary .mapb files are written next to the text file the first time it is parsed
+// and reused as long as the length and CRC of the text file match
+const int BINARY_MAP_ID						= ( ('B'<<24)|('P'<<16)|('A'<<8)|'M' );
+const int BINARY_MAP_VERSION				= 1;
+
 
 class idMapPrimitive {
 public:
@@ -107,6 +112,8 @@ public:
 	static idMapBrush *		Parse( idLexer &src, const idVec3 &origin, bool newFormat = true, float version = CURRENT_MAP_VERSION );
 	static idMapBrush *		ParseQ3( idLexer &src, const idVec3 &origin );
 	bool					Write( idFile *fp, int primitiveNum, const idVec3 &origin ) const;
+	static idMapBrush *		ParseBinary( idFile *fp );
+	void					WriteBinary( idFile *fp ) const;
 	int						GetNumSides( void ) const { return sides.Num(); }
 	int						AddSide( idMapBrushSide *side ) { return sides.Append( side ); }
 	idMapBrushSide *		GetSide( int i ) const { return sides[i]; }
@@ -125,6 +132,8 @@ public:
 							~idMapPatch( void ) { }
 	static idMapPatch *		Parse( idLexer &src, const idVec3 &origin, bool patchDef3 = true, float version = CURRENT_MAP_VERSION );
 	bool					Write( idFile *fp, int primitiveNum, const idVec3 &origin ) const;
+	static idMapPatch *		ParseBinary( idFile *fp );
+	void					WriteBinary( idFile *fp ) const;
 	const char *			GetMaterial( void ) const { return material; }
 	void					SetMaterial( const char *p ) { material = p; }
 	int						GetHorzSubdivisions( void ) const { return horzSubdivisions; }
@@ -174,6 +183,8 @@ public:
 							~idMapEntity( void ) { primitives.DeleteContents( true ); }
 	static idMapEntity *	Parse( idLexer &src, bool worldSpawn = false, float version = CURRENT_MAP_VERSION );
 	bool					Write( idFile *fp, int entityNum ) const;
+	static idMapEntity *	ParseBinary( idFile *fp );
+	void					WriteBinary( idFile *fp ) const;
 	int						GetNumPrimitives( void ) const { return primitives.Num(); }
 	idMapPrimitive *		GetPrimitive( int i ) const { return primitives[i]; }
 	void					AddPrimitive( idMapPrimitive *p ) { primitives.Append( p ); }
@@ -218,6 +229,8 @@ public:
 	void					RemovePrimitiveData();
 	bool					HasPrimitiveData() { return hasPrimitiveData; }
 
+	static void				Benchmark_f( const class idCmdArgs &args );
+
 protected:
 	float					version;
 	ID_TIME_T					fileTime;
@@ -228,6 +241,8 @@ protected:
 
 private:
 	void					SetGeometryCRC( void );
+	bool					ParseBinary( const char *fileName, unsigned int sourceCRC, int sourceLength );
+	void					WriteBinary( const char *fileName, unsigned int sourceCRC, int sourceLength ) const;
 };
 
 ID_INLINE idMapFile::idMapFile( void ) {
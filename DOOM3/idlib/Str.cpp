@@ -99,7 +99,13 @@ void idStr::ReAllocate( int amount, bool keepold ) {
 	alloced = newsize;
 
 #ifdef USE_STRING_DATA_ALLOCATOR
-	newbuffer = stringDataAllocator.Alloc( alloced );
+	if ( Mem_IsThreadSafe() ) {
+		Sys_EnterCriticalSection( CRITICAL_SECTION_HEAP );
+		newbuffer = stringDataAllocator.Alloc( alloced );
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_HEAP );
+	} else {
+		newbuffer = stringDataAllocator.Alloc( alloced );
+	}
 #else
 	newbuffer = new char[ alloced ];
 #endif
@@ -110,7 +116,13 @@ void idStr::ReAllocate( int amount, bool keepold ) {
 
 	if ( data && data != baseBuffer ) {
 #ifdef USE_STRING_DATA_ALLOCATOR
-		stringDataAllocator.Free( data );
+		if ( Mem_IsThreadSafe() ) {
+			Sys_EnterCriticalSection( CRITICAL_SECTION_HEAP );
+			stringDataAllocator.Free( data );
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_HEAP );
+		} else {
+			stringDataAllocator.Free( data );
+		}
 #else
 		delete [] data;
 #endif
@@ -127,7 +139,13 @@ idStr::FreeData
 void idStr::FreeData( void ) {
 	if ( data && data != baseBuffer ) {
 #ifdef USE_STRING_DATA_ALLOCATOR
-		stringDataAllocator.Free( data );
+		if ( Mem_IsThreadSafe() ) {
+			Sys_EnterCriticalSection( CRITICAL_SECTION_HEAP );
+			stringDataAllocator.Free( data );
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_HEAP );
+		} else {
+			stringDataAllocator.Free( data );
+		}
 #else
 		delete[] data;
 #endif
@@ -29,6 +29,7 @@ If you have questions concerning this license or the applicable additional terms
 #ifndef __STRPOOL_H__
 #define __STRPOOL_H__
 
+#include "idlib/Heap.h"
 #include "idlib/containers/List.h"
 #include "idlib/containers/HashIndex.h"
 
@@ -82,8 +83,38 @@ private:
 	bool				caseSensitive;
 	idList<idPoolStr *>	pool;
 	idHashIndex			poolHash;
+
+						// the dictionaries of decls parsed on the job threads share the global pools
+	static bool			Lock( void );
+	static void			Unlock( bool locked );
 };
 
+/*
+================
+idStrPool::Lock
+
+the heap lock is taken anyway when a string is allocated, so the pools use the same one
+================
+*/
+ID_INLINE bool idStrPool::Lock( void ) {
+	if ( Mem_IsThreadSafe() ) {
+		Sys_EnterCriticalSection( CRITICAL_SECTION_HEAP );
+		return true;
+	}
+	return false;
+}
+
+/*
+================
+idStrPool::Unlock
+================
+*/
+ID_INLINE void idStrPool::Unlock( bool locked ) {
+	if ( locked ) {
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_HEAP );
+	}
+}
+
 /*
 ================
 idStrPool::SetCaseSensitive
@@ -101,20 +132,25 @@ idStrPool::AllocString
 ID_INLINE const idPoolStr *idStrPool::AllocString( const char *string ) {
 	int i, hash;
 	idPoolStr *poolStr;
+	bool locked = Lock();
 
 	hash = poolHash.GenerateKey( string, caseSensitive );
 	if ( caseSensitive ) {
 		for ( i = poolHash.First( hash ); i != -1; i = poolHash.Next( i ) ) {
 			if ( pool[i]->Cmp( string ) == 0 ) {
-				pool[i]->numUsers++;
-				return pool[i];
+				poolStr = pool[i];
+				poolStr->numUsers++;
+				Unlock( locked );
+				return poolStr;
 			}
 		}
 	} else {
 		for ( i = poolHash.First( hash ); i != -1; i = poolHash.Next( i ) ) {
 			if ( pool[i]->Icmp( string ) == 0 ) {
-				pool[i]->numUsers++;
-				return pool[i];
+				poolStr = pool[i];
+				poolStr->numUsers++;
+				Unlock( locked );
+				return poolStr;
 			}
 		}
 	}
@@ -124,6 +160,7 @@ ID_INLINE const idPoolStr *idStrPool::AllocString( const char *string ) {
 	poolStr->pool = this;
 	poolStr->numUsers = 1;
 	poolHash.Add( hash, pool.Append( poolStr ) );
+	Unlock( locked );
 	return poolStr;
 }
 
@@ -138,6 +175,8 @@ ID_INLINE void idStrPool::FreeString( const idPoolStr *poolStr ) {
 	assert( poolStr->numUsers >= 1 );
 	assert( poolStr->pool == this );
 
+	bool locked = Lock();
+
 	poolStr->numUsers--;
 	if ( poolStr->numUsers <= 0 ) {
 		hash = poolHash.GenerateKey( poolStr->c_str(), caseSensitive );
@@ -160,6 +199,8 @@ ID_INLINE void idStrPool::FreeString( const idPoolStr *poolStr ) {
 		pool.RemoveIndex( i );
 		poolHash.RemoveIndex( hash, i );
 	}
+
+	Unlock( locked );
 }
 
 /*
@@ -173,7 +214,9 @@ ID_INLINE const idPoolStr *idStrPool::CopyString( const idPoolStr *poolStr ) {
 
 	if ( poolStr->pool == this ) {
 		// the string is from this pool so just increase the user count
+		bool locked = Lock();
 		poolStr->numUsers++;
+		Unlock( locked );
 		return poolStr;
 	} else {
 		// the string is from another pool so it needs to be re-allocated from this pool.
@@ -44,6 +44,7 @@ If you have questions concerning this license or the applicable additional terms
 #include "idlib/math/Simd_SSE2.h"
 #include "idlib/math/Simd_SSE3.h"
 #include "idlib/math/Simd_AltiVec.h"
+#include "idlib/math/Simd_NEON.h"
 #include "idlib/math/Plane.h"
 #include "idlib/bv/Bounds.h"
 #include "idlib/Lib.h"
@@ -88,6 +89,8 @@ void idSIMD::InitProcessor( const char *module, bool forceGeneric ) {
 		if ( !processor ) {
 			if ( ( cpuid & CPUID_ALTIVEC ) ) {
 				processor = new idSIMD_AltiVec;
+			} else if ( ( cpuid & CPUID_NEON ) ) {
+				processor = new idSIMD_NEON;
 			} else if ( ( cpuid & CPUID_MMX ) && ( cpuid & CPUID_SSE ) && ( cpuid & CPUID_SSE2 ) && ( cpuid & CPUID_SSE3 ) ) {
 				processor = new idSIMD_SSE3;
 			} else if ( ( cpuid & CPUID_MMX ) && ( cpuid & CPUID_SSE ) && ( cpuid & CPUID_SSE2 ) ) {
@@ -175,7 +178,7 @@ int saved_ebx = 0;
 	__asm xor eax, eax						\
 	__asm cpuid
 
-#elif MACOS_X
+#elif defined( MACOS_X ) || defined( __APPLE__ )
 
 double ticksPerNanosecond;
 
@@ -2731,6 +2734,256 @@ void TestOverlayPointCull( void ) {
 	PrintClocks( va( "   simd->OverlayPointCull() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestShadowPointCull
+============
+*/
+void TestShadowPointCull( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( idPlane planes[6] );
+	ALIGN16( idDrawVert drawVerts[COUNT] );
+	ALIGN16( unsigned short pointCull1[COUNT] );
+	ALIGN16( unsigned short pointCull2[COUNT] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	planes[0].SetNormal( idVec3(  1,  0,  0 ) );
+	planes[1].SetNormal( idVec3( -1,  0,  0 ) );
+	planes[2].SetNormal( idVec3(  0,  1,  0 ) );
+	planes[3].SetNormal( idVec3(  0, -1,  0 ) );
+	planes[4].SetNormal( idVec3(  0,  0,  1 ) );
+	planes[5].SetNormal( idVec3(  0,  0, -1 ) );
+	planes[0][3] = 5.3f;
+	planes[1][3] = 5.3f;
+	planes[2][3] = 4.4f;
+	planes[3][3] = 4.4f;
+	planes[4][3] = 3.5f;
+	planes[5][3] = 3.5f;
+
+	for ( i = 0; i < COUNT; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			drawVerts[i].xyz[j] = srnd.CRandomFloat() * 10.0f;
+		}
+	}
+
+	// the surface is known to be in front of the last plane
+	const int frontBits = 1 << ( 5 + 6 );
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->ShadowPointCull( pointCull1, planes, frontBits, 0.1f, drawVerts, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ShadowPointCull()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->ShadowPointCull( pointCull2, planes, frontBits, 0.1f, drawVerts, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( pointCull1[i] != pointCull2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->ShadowPointCull() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestShadowSilEdges
+============
+*/
+void TestShadowSilEdges( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( silEdge_t silEdges[COUNT] );
+	ALIGN16( byte faceCastsShadow[COUNT+1] );
+	ALIGN16( int silEdgeNums1[COUNT] );
+	ALIGN16( int silEdgeNums2[COUNT] );
+	int numSilEdges1 = 0, numSilEdges2 = 0;
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < COUNT; i++ ) {
+		faceCastsShadow[i] = ( srnd.CRandomFloat() > 0.0f ) ? 1 : 0;
+		silEdges[i].p1 = srnd.RandomInt( COUNT );
+		silEdges[i].p2 = srnd.RandomInt( COUNT + 1 );
+		silEdges[i].v1 = 0;
+		silEdges[i].v2 = 0;
+	}
+	faceCastsShadow[COUNT] = 0;
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		numSilEdges1 = p_generic->ShadowSilEdges( silEdgeNums1, faceCastsShadow, silEdges, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ShadowSilEdges()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		numSilEdges2 = p_simd->ShadowSilEdges( silEdgeNums2, faceCastsShadow, silEdges, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < numSilEdges1; i++ ) {
+		if ( silEdgeNums1[i] != silEdgeNums2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= numSilEdges1 && numSilEdges1 == numSilEdges2 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->ShadowSilEdges() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestCreateParticleQuads
+============
+*/
+void TestCreateParticleQuads( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( float x[COUNT/4] );
+	ALIGN16( float y[COUNT/4] );
+	ALIGN16( float z[COUNT/4] );
+	ALIGN16( float width[COUNT/4] );
+	ALIGN16( float height[COUNT/4] );
+	ALIGN16( float cosAngle[COUNT/4] );
+	ALIGN16( float sinAngle[COUNT/4] );
+	ALIGN16( idDrawVert drawVerts1[COUNT] );
+	ALIGN16( idDrawVert drawVerts2[COUNT] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	// one less than a multiple of four to test the remainder
+	const int numParticles = COUNT / 4 - 1;
+
+	for ( i = 0; i < numParticles; i++ ) {
+		x[i] = srnd.CRandomFloat() * 100.0f;
+		y[i] = srnd.CRandomFloat() * 100.0f;
+		z[i] = srnd.CRandomFloat() * 100.0f;
+		width[i] = srnd.RandomFloat() * 10.0f;
+		height[i] = srnd.RandomFloat() * 10.0f;
+		idMath::SinCos( srnd.RandomFloat() * idMath::TWO_PI, sinAngle[i], cosAngle[i] );
+	}
+
+	idVec3 left( 0.6f, 0.8f, 0.0f );
+	idVec3 up( 0.0f, 0.0f, 1.0f );
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->CreateParticleQuads( drawVerts1, x, y, z, width, height, cosAngle, sinAngle, left, up, numParticles );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->CreateParticleQuads()", numParticles, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->CreateParticleQuads( drawVerts2, x, y, z, width, height, cosAngle, sinAngle, left, up, numParticles );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < numParticles * 4; i++ ) {
+		if ( !drawVerts1[i].xyz.Compare( drawVerts2[i].xyz, 1e-4f ) ) {
+			break;
+		}
+	}
+	result = ( i >= numParticles * 4 ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->CreateParticleQuads() %s", result ), numParticles, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestRasterizeOccluder
+============
+*/
+void TestRasterizeOccluder( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	const int width = 64, height = 32, numTris = 16;
+	ALIGN16( float depth1[width*height] );
+	ALIGN16( float depth2[width*height] );
+	idVec3 edges[numTris][3], zPlanes[numTris];
+	int bounds[numTris][4];
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < numTris; i++ ) {
+		idVec3 v[3];
+		for ( j = 0; j < 3; j++ ) {
+			v[j].Set( srnd.RandomFloat() * width, srnd.RandomFloat() * height, srnd.RandomFloat() );
+		}
+		if ( ( v[1].x - v[0].x ) * ( v[2].y - v[0].y ) - ( v[2].x - v[0].x ) * ( v[1].y - v[0].y ) < 0.0f ) {
+			idSwap( v[1], v[2] );
+		}
+		for ( j = 0; j < 3; j++ ) {
+			const idVec3 &p = v[j];
+			const idVec3 &q = v[(j+1)%3];
+			edges[i][j].Set( p.y - q.y, q.x - p.x, ( q.y - p.y ) * p.x - ( q.x - p.x ) * p.y );
+		}
+		zPlanes[i].Set( srnd.CRandomFloat() * 0.01f, srnd.CRandomFloat() * 0.01f, srnd.RandomFloat() );
+		// odd starts and ends to test the masked first and the remainder pixels
+		bounds[i][0] = srnd.RandomInt( width / 2 ) | 1;
+		bounds[i][1] = srnd.RandomInt( height / 2 );
+		bounds[i][2] = bounds[i][0] + srnd.RandomInt( width / 2 ) + 1;
+		bounds[i][3] = bounds[i][1] + srnd.RandomInt( height / 2 );
+	}
+
+	for ( i = 0; i < width * height; i++ ) {
+		depth1[i] = depth2[i] = 0.0f;
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		for ( j = 0; j < numTris; j++ ) {
+			p_generic->RasterizeOccluder( depth1, width, bounds[j][0], bounds[j][1], bounds[j][2], bounds[j][3], edges[j], zPlanes[j], 0.1f, 0.9f );
+		}
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->RasterizeOccluder()", width * height, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		for ( j = 0; j < numTris; j++ ) {
+			p_simd->RasterizeOccluder( depth2, width, bounds[j][0], bounds[j][1], bounds[j][2], bounds[j][3], edges[j], zPlanes[j], 0.1f, 0.9f );
+		}
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < width * height; i++ ) {
+		if ( idMath::Fabs( depth1[i] - depth2[i] ) > 1e-5f ) {
+			break;
+		}
+	}
+	result = ( i >= width * height ) ? "ok" :  S_COLOR_RED "X";
+	PrintClocks( va( "   simd->RasterizeOccluder() %s", result ), width * height, bestClocksSIMD, bestClocksGeneric );
+}
+
 /*
 ============
 TestDeriveTriPlanes
@@ -3528,6 +3781,105 @@ void TestSoundMixing( void ) {
 	PrintClocks( va( "   simd->MixedSoundToSamples() %s", result ), MIXBUFFER_SAMPLES, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestImageProcessing
+============
+*/
+#define IMAGE_NUMTESTS		8
+
+void TestImageProcessing( void ) {
+	int i, j, size;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	byte *src, *dst1, *dst2;
+	unsigned int *offsets0, *offsets1;
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	src = (byte *) Mem_Alloc16( 2048 * 2048 * 4 );
+	dst1 = (byte *) Mem_Alloc16( 2048 * 2048 * 4 );
+	dst2 = (byte *) Mem_Alloc16( 2048 * 2048 * 4 );
+	offsets0 = (unsigned int *) Mem_Alloc16( 2048 * 2 * sizeof( unsigned int ) );
+	offsets1 = (unsigned int *) Mem_Alloc16( 2048 * 2 * sizeof( unsigned int ) );
+
+	for ( i = 0; i < 2048 * 2048 * 4; i++ ) {
+		src[i] = srnd.RandomInt( 256 );
+	}
+
+	for ( size = 512; size <= 2048; size <<= 1 ) {
+
+		bestClocksGeneric = 0;
+		for ( i = 0; i < IMAGE_NUMTESTS; i++ ) {
+			StartRecordTime( start );
+			p_generic->MipMapRGBA( dst1, src, size, size );
+			StopRecordTime( end );
+			GetBest( start, end, bestClocksGeneric );
+		}
+		PrintClocks( va( "generic->MipMapRGBA( %d )", size ), size * size / 4, bestClocksGeneric );
+
+		bestClocksSIMD = 0;
+		for ( i = 0; i < IMAGE_NUMTESTS; i++ ) {
+			StartRecordTime( start );
+			p_simd->MipMapRGBA( dst2, src, size, size );
+			StopRecordTime( end );
+			GetBest( start, end, bestClocksSIMD );
+		}
+
+		for ( i = 0; i < size * size; i++ ) {
+			if ( dst1[i] != dst2[i] ) {
+				break;
+			}
+		}
+		result = ( i >= size * size ) ? "ok" : S_COLOR_RED "X";
+		PrintClocks( va( "   simd->MipMapRGBA( %d ) %s", size, result ), size * size / 4, bestClocksSIMD, bestClocksGeneric );
+	}
+
+	for ( size = 512; size <= 2048; size <<= 1 ) {
+
+		// upsample a size wide row to twice the width the way R_ResampleTexture does
+		for ( i = 0; i < size * 2; i++ ) {
+			offsets0[i] = 4 * ( ( i * size / 2 + size / 8 ) / size );
+			offsets1[i] = 4 * ( ( i * size / 2 + 3 * size / 8 ) / size );
+		}
+
+		bestClocksGeneric = 0;
+		for ( i = 0; i < IMAGE_NUMTESTS; i++ ) {
+			StartRecordTime( start );
+			for ( j = 0; j < 64; j++ ) {
+				p_generic->ResampleRowRGBA( dst1 + j * size * 8, src + j * size * 8, src + j * size * 8 + size * 4, offsets0, offsets1, size * 2 );
+			}
+			StopRecordTime( end );
+			GetBest( start, end, bestClocksGeneric );
+		}
+		PrintClocks( va( "generic->ResampleRowRGBA( %d )", size ), size * 2 * 64, bestClocksGeneric );
+
+		bestClocksSIMD = 0;
+		for ( i = 0; i < IMAGE_NUMTESTS; i++ ) {
+			StartRecordTime( start );
+			for ( j = 0; j < 64; j++ ) {
+				p_simd->ResampleRowRGBA( dst2 + j * size * 8, src + j * size * 8, src + j * size * 8 + size * 4, offsets0, offsets1, size * 2 );
+			}
+			StopRecordTime( end );
+			GetBest( start, end, bestClocksSIMD );
+		}
+
+		for ( i = 0; i < size * 8 * 64; i++ ) {
+			if ( dst1[i] != dst2[i] ) {
+				break;
+			}
+		}
+		result = ( i >= size * 8 * 64 ) ? "ok" : S_COLOR_RED "X";
+		PrintClocks( va( "   simd->ResampleRowRGBA( %d ) %s", size, result ), size * 2 * 64, bestClocksSIMD, bestClocksGeneric );
+	}
+
+	Mem_Free16( src );
+	Mem_Free16( dst1 );
+	Mem_Free16( dst2 );
+	Mem_Free16( offsets0 );
+	Mem_Free16( offsets1 );
+}
+
 /*
 ============
 TestMath
@@ -4044,8 +4396,14 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 				return;
 			}
 			p_simd = new idSIMD_AltiVec();
+		} else if ( idStr::Icmp( argString, "NEON" ) == 0 ) {
+			if ( !( cpuid & CPUID_NEON ) ) {
+				common->Printf( "CPU does not support NEON\n" );
+				return;
+			}
+			p_simd = new idSIMD_NEON();
 		} else {
-			common->Printf( "invalid argument, use: MMX, 3DNow, SSE, SSE2, SSE3, AltiVec\n" );
+			common->Printf( "invalid argument, use: MMX, 3DNow, SSE, SSE2, SSE3, AltiVec, NEON\n" );
 			return;
 		}
 	}
@@ -4092,6 +4450,10 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 	TestTracePointCull();
 	TestDecalPointCull();
 	TestOverlayPointCull();
+	TestShadowPointCull();
+	TestShadowSilEdges();
+	TestCreateParticleQuads();
+	TestRasterizeOccluder();
 	TestDeriveTriPlanes();
 	TestDeriveTangents();
 	TestDeriveUnsmoothedTangents();
@@ -4105,6 +4467,10 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 	TestSoundUpSampling();
 	TestSoundMixing();
 
+	idLib::common->Printf("====================================\n" );
+
+	TestImageProcessing();
+
 	idLib::common->SetRefreshOnPrint( false );
 
 	if ( p_simd != processor ) {
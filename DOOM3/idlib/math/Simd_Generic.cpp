@@ -2454,6 +2454,130 @@ void VPCALL idSIMD_Generic::OverlayPointCull( byte *cullBits, idVec2 *texCoords,
 	}
 }
 
+/*
+============
+idSIMD_Generic::ShadowPointCull
+
+  Sets bit j when a vertex is on or behind frustum plane j and bit j+6 when it
+  is on or in front of it. Planes with their bit set in frontBits are known to
+  have the whole surface in front and are not tested.
+============
+*/
+void VPCALL idSIMD_Generic::ShadowPointCull( unsigned short *pointCull, const idPlane *planes, const int frontBits, const float epsilon, const idDrawVert *verts, const int numVerts ) {
+	int i, j, numTestPlanes;
+	int testPlanes[6];
+
+	numTestPlanes = 0;
+	for ( j = 0; j < 6; j++ ) {
+		if ( !( frontBits & ( 1 << ( j + 6 ) ) ) ) {
+			testPlanes[numTestPlanes++] = j;
+		}
+	}
+
+	for ( i = 0; i < numVerts; i++ ) {
+		const idVec3 &v = verts[i].xyz;
+		int bits = frontBits;
+
+		for ( j = 0; j < numTestPlanes; j++ ) {
+			int p = testPlanes[j];
+			float d = planes[p].Distance( v );
+			bits |= ( d < epsilon ) << p;
+			bits |= ( d > -epsilon ) << ( p + 6 );
+		}
+
+		pointCull[i] = bits;
+	}
+}
+
+/*
+============
+idSIMD_Generic::ShadowSilEdges
+
+  Writes the numbers of the silhouette edges between a shadow casting and a
+  non shadow casting face to silEdgeNums and returns the number of edges.
+============
+*/
+int VPCALL idSIMD_Generic::ShadowSilEdges( int *silEdgeNums, const byte *faceCastsShadow, const silEdge_s *silEdges, const int numSilEdges ) {
+	int i, num;
+
+	num = 0;
+	for ( i = 0; i < numSilEdges; i++ ) {
+		silEdgeNums[num] = i;
+		num += faceCastsShadow[silEdges[i].p1] ^ faceCastsShadow[silEdges[i].p2];
+	}
+	return num;
+}
+
+/*
+============
+idSIMD_Generic::CreateParticleQuads
+
+  Sets the positions of the four verts of each particle quad. The quad of a
+  particle is rotated by its angle in the plane of the left and up vectors
+  and scaled by its width and height, the vertex order is:
+
+  0 1
+  2 3
+============
+*/
+void VPCALL idSIMD_Generic::CreateParticleQuads( idDrawVert *verts, const float *x, const float *y, const float *z, const float *width, const float *height, const float *cosAngle, const float *sinAngle, const idVec3 &left, const idVec3 &up, const int numParticles ) {
+	int i;
+
+	for ( i = 0; i < numParticles; i++, verts += 4 ) {
+		const float c = cosAngle[i];
+		const float s = sinAngle[i];
+		const idVec3 origin( x[i], y[i], z[i] );
+
+		idVec3 l = left * c + up * s;
+		idVec3 u = up * c - left * s;
+
+		l *= width[i];
+		u *= height[i];
+
+		verts[0].xyz = origin - l + u;
+		verts[1].xyz = origin + l + u;
+		verts[2].xyz = origin - l - u;
+		verts[3].xyz = origin + l - u;
+	}
+}
+
+/*
+============
+idSIMD_Generic::RasterizeOccluder
+
+  Writes the depth of a triangle to the pixels of the rectangle x0,y0 - x1,y1
+  whose centers are inside all three edges. Each edge is the function
+  x * e.x + y * e.y + e.z which is >= 0 inside, and the depth at a center is
+  x * zPlane.x + y * zPlane.y + zPlane.z clamped to zMin and zMax. A pixel only
+  takes the depth when it is bigger than the depth already in the buffer.
+============
+*/
+void VPCALL idSIMD_Generic::RasterizeOccluder( float *depth, const int stride, const int x0, const int y0, const int x1, const int y1, const idVec3 edges[3], const idVec3 &zPlane, const float zMin, const float zMax ) {
+	int x, y;
+
+	for ( y = y0; y <= y1; y++ ) {
+		const float yc = y + 0.5f;
+		const float e0 = edges[0].x * 0.5f + edges[0].y * yc + edges[0].z;
+		const float e1 = edges[1].x * 0.5f + edges[1].y * yc + edges[1].z;
+		const float e2 = edges[2].x * 0.5f + edges[2].y * yc + edges[2].z;
+		const float zRow = zPlane.x * 0.5f + zPlane.y * yc + zPlane.z;
+		float *row = depth + y * stride;
+
+		for ( x = x0; x <= x1; x++ ) {
+			const float fx = (float) x;
+
+			if ( e0 + edges[0].x * fx < 0.0f || e1 + edges[1].x * fx < 0.0f || e2 + edges[2].x * fx < 0.0f ) {
+				continue;
+			}
+
+			float z = zRow + zPlane.x * fx;
+			z = ( z < zMin ) ? zMin : z;
+			z = ( z > zMax ) ? zMax : z;
+			row[x] = ( z > row[x] ) ? z : row[x];
+		}
+	}
+}
+
 /*
 ============
 idSIMD_Generic::DeriveTriPlanes
@@ -3264,3 +3388,49 @@ void VPCALL idSIMD_Generic::MixedSoundToSamples( short *samples, const float *mi
 		}
 	}
 }
+
+/*
+============
+idSIMD_Generic::MipMapRGBA
+
+  box filters width x height texels down to ( width / 2 ) x ( height / 2 )
+  width and height must be at least 2
+============
+*/
+void VPCALL idSIMD_Generic::MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) {
+	int row = width * 4;
+	int newWidth = width >> 1;
+	int newHeight = height >> 1;
+
+	for ( int i = 0; i < newHeight; i++ ) {
+		const byte *in0 = src + i * 2 * row;
+		const byte *in1 = in0 + row;
+		for ( int j = 0; j < newWidth; j++, dst += 4, in0 += 8, in1 += 8 ) {
+			dst[0] = ( in0[0] + in0[4] + in1[0] + in1[4] ) >> 2;
+			dst[1] = ( in0[1] + in0[5] + in1[1] + in1[5] ) >> 2;
+			dst[2] = ( in0[2] + in0[6] + in1[2] + in1[6] ) >> 2;
+			dst[3] = ( in0[3] + in0[7] + in1[3] + in1[7] ) >> 2;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::ResampleRowRGBA
+
+  dst[i] = average of the texels at row0 + offsets0[i], row0 + offsets1[i], row1 + offsets0[i] and row1 + offsets1[i]
+  offsets are in bytes
+============
+*/
+void VPCALL idSIMD_Generic::ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	for ( int i = 0; i < count; i++, dst += 4 ) {
+		const byte *pix1 = row0 + offsets0[i];
+		const byte *pix2 = row0 + offsets1[i];
+		const byte *pix3 = row1 + offsets0[i];
+		const byte *pix4 = row1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
@@ -119,6 +119,10 @@ public:
 	virtual void VPCALL TracePointCull( byte *cullBits, byte &totalOr, const float radius, const idPlane *planes, const idDrawVert *verts, const int numVerts );
 	virtual void VPCALL DecalPointCull( byte *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts );
 	virtual void VPCALL OverlayPointCull( byte *cullBits, idVec2 *texCoords, const idPlane *planes, const idDrawVert *verts, const int numVerts );
+	virtual void VPCALL ShadowPointCull( unsigned short *pointCull, const idPlane *planes, const int frontBits, const float epsilon, const idDrawVert *verts, const int numVerts );
+	virtual int  VPCALL ShadowSilEdges( int *silEdgeNums, const byte *faceCastsShadow, const silEdge_s *silEdges, const int numSilEdges );
+	virtual void VPCALL CreateParticleQuads( idDrawVert *verts, const float *x, const float *y, const float *z, const float *width, const float *height, const float *cosAngle, const float *sinAngle, const idVec3 &left, const idVec3 &up, const int numParticles );
+	virtual void VPCALL RasterizeOccluder( float *depth, const int stride, const int x0, const int y0, const int x1, const int y1, const idVec3 edges[3], const idVec3 &zPlane, const float zMin, const float zMax );
 	virtual void VPCALL DeriveTriPlanes( idPlane *planes, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
   	virtual void VPCALL DeriveTriPlanes( idPlane *planes, const idDrawVert *verts, const int numVerts, const short *indexes, const int numIndexes );
 	virtual void VPCALL DeriveTangents( idPlane *planes, idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
@@ -137,6 +141,9 @@ public:
 	virtual void VPCALL MixSoundSixSpeakerMono( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixSoundSixSpeakerStereo( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples );
+
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
 };
 
 #endif /* !__MATH_SIMD_GENERIC_H__ */
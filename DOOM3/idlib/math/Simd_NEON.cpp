@@ -0,0 +1,321 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+#include "sys/platform.h"
+#include "idlib/geometry/DrawVert.h"
+#include "idlib/math/Plane.h"
+
+#include "idlib/math/Simd_NEON.h"
+
+//===============================================================
+//
+//	NEON implementation of idSIMDProcessor
+//
+//===============================================================
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+/*
+============
+idSIMD_NEON::GetName
+============
+*/
+const char * idSIMD_NEON::GetName( void ) const {
+	return "NEON";
+}
+
+/*
+============
+idSIMD_NEON::MipMapRGBA
+
+  eight destination texels per iteration, the loads de-interleave the
+  channels so neighbouring texels can be added with pairwise adds
+============
+*/
+void VPCALL idSIMD_NEON::MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) {
+	int row = width * 4;
+	int newWidth = width >> 1;
+	int newHeight = height >> 1;
+
+	for ( int i = 0; i < newHeight; i++ ) {
+		const byte *in0 = src + i * 2 * row;
+		const byte *in1 = in0 + row;
+		byte *out = dst + i * newWidth * 4;
+		int j;
+
+		for ( j = 0; j + 8 <= newWidth; j += 8, out += 32, in0 += 64, in1 += 64 ) {
+			uint8x16x4_t a = vld4q_u8( in0 );
+			uint8x16x4_t b = vld4q_u8( in1 );
+			uint8x8x4_t d;
+
+			d.val[0] = vshrn_n_u16( vpadalq_u8( vpaddlq_u8( a.val[0] ), b.val[0] ), 2 );
+			d.val[1] = vshrn_n_u16( vpadalq_u8( vpaddlq_u8( a.val[1] ), b.val[1] ), 2 );
+			d.val[2] = vshrn_n_u16( vpadalq_u8( vpaddlq_u8( a.val[2] ), b.val[2] ), 2 );
+			d.val[3] = vshrn_n_u16( vpadalq_u8( vpaddlq_u8( a.val[3] ), b.val[3] ), 2 );
+
+			vst4_u8( out, d );
+		}
+
+		for ( ; j < newWidth; j++, out += 4, in0 += 8, in1 += 8 ) {
+			out[0] = ( in0[0] + in0[4] + in1[0] + in1[4] ) >> 2;
+			out[1] = ( in0[1] + in0[5] + in1[1] + in1[5] ) >> 2;
+			out[2] = ( in0[2] + in0[6] + in1[2] + in1[6] ) >> 2;
+			out[3] = ( in0[3] + in0[7] + in1[3] + in1[7] ) >> 2;
+		}
+	}
+}
+
+/*
+============
+idSIMD_NEON::ResampleRowRGBA
+============
+*/
+void VPCALL idSIMD_NEON::ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	int i;
+
+	for ( i = 0; i + 2 <= count; i += 2, dst += 8 ) {
+		// gather the four source texels of two destination texels
+		uint32x2_t p0 = vdup_n_u32( 0 );
+		uint32x2_t p1 = vdup_n_u32( 0 );
+		uint32x2_t p2 = vdup_n_u32( 0 );
+		uint32x2_t p3 = vdup_n_u32( 0 );
+
+		p0 = vld1_lane_u32( (const uint32_t *)( row0 + offsets0[i+0] ), p0, 0 );
+		p0 = vld1_lane_u32( (const uint32_t *)( row0 + offsets0[i+1] ), p0, 1 );
+		p1 = vld1_lane_u32( (const uint32_t *)( row0 + offsets1[i+0] ), p1, 0 );
+		p1 = vld1_lane_u32( (const uint32_t *)( row0 + offsets1[i+1] ), p1, 1 );
+		p2 = vld1_lane_u32( (const uint32_t *)( row1 + offsets0[i+0] ), p2, 0 );
+		p2 = vld1_lane_u32( (const uint32_t *)( row1 + offsets0[i+1] ), p2, 1 );
+		p3 = vld1_lane_u32( (const uint32_t *)( row1 + offsets1[i+0] ), p3, 0 );
+		p3 = vld1_lane_u32( (const uint32_t *)( row1 + offsets1[i+1] ), p3, 1 );
+
+		uint16x8_t sum = vaddl_u8( vreinterpret_u8_u32( p0 ), vreinterpret_u8_u32( p1 ) );
+		sum = vaddw_u8( sum, vreinterpret_u8_u32( p2 ) );
+		sum = vaddw_u8( sum, vreinterpret_u8_u32( p3 ) );
+
+		vst1_u8( dst, vshrn_n_u16( sum, 2 ) );
+	}
+
+	for ( ; i < count; i++, dst += 4 ) {
+		const byte *pix1 = row0 + offsets0[i];
+		const byte *pix2 = row0 + offsets1[i];
+		const byte *pix3 = row1 + offsets0[i];
+		const byte *pix4 = row1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
+
+/*
+============
+LoadDrawVertXYZ4
+
+  transposes the positions of four draw verts into x, y and z vectors,
+  the fourth float of each load is the first texture coordinate
+============
+*/
+static ID_INLINE void LoadDrawVertXYZ4( const idDrawVert *verts, float32x4_t &x, float32x4_t &y, float32x4_t &z ) {
+	float32x4x2_t t0 = vtrnq_f32( vld1q_f32( verts[0].xyz.ToFloatPtr() ), vld1q_f32( verts[1].xyz.ToFloatPtr() ) );
+	float32x4x2_t t1 = vtrnq_f32( vld1q_f32( verts[2].xyz.ToFloatPtr() ), vld1q_f32( verts[3].xyz.ToFloatPtr() ) );
+
+	x = vcombine_f32( vget_low_f32( t0.val[0] ), vget_low_f32( t1.val[0] ) );
+	y = vcombine_f32( vget_low_f32( t0.val[1] ), vget_low_f32( t1.val[1] ) );
+	z = vcombine_f32( vget_high_f32( t0.val[0] ), vget_high_f32( t1.val[0] ) );
+}
+
+/*
+============
+idSIMD_NEON::ShadowPointCull
+
+  eight verts per iteration, each plane test produces lane masks that are
+  reduced to the bit of that plane without branching
+============
+*/
+void VPCALL idSIMD_NEON::ShadowPointCull( unsigned short *pointCull, const idPlane *planes, const int frontBits, const float epsilon, const idDrawVert *verts, const int numVerts ) {
+	int i, j, numTestPlanes;
+	int testPlanes[6];
+
+	numTestPlanes = 0;
+	for ( j = 0; j < 6; j++ ) {
+		if ( !( frontBits & ( 1 << ( j + 6 ) ) ) ) {
+			testPlanes[numTestPlanes++] = j;
+		}
+	}
+
+	const float32x4_t eps = vdupq_n_f32( epsilon );
+	const float32x4_t negEps = vdupq_n_f32( -epsilon );
+	const uint32x4_t front = vdupq_n_u32( frontBits );
+
+	for ( i = 0; i + 8 <= numVerts; i += 8 ) {
+		float32x4_t x0, y0, z0, x1, y1, z1;
+		uint32x4_t bits0 = front;
+		uint32x4_t bits1 = front;
+
+		LoadDrawVertXYZ4( verts + i + 0, x0, y0, z0 );
+		LoadDrawVertXYZ4( verts + i + 4, x1, y1, z1 );
+
+		for ( j = 0; j < numTestPlanes; j++ ) {
+			const idPlane &plane = planes[testPlanes[j]];
+			const uint32x4_t backBit = vdupq_n_u32( 1 << testPlanes[j] );
+			const uint32x4_t frontBit = vdupq_n_u32( 1 << ( testPlanes[j] + 6 ) );
+			const float32x4_t nx = vdupq_n_f32( plane[0] );
+			const float32x4_t ny = vdupq_n_f32( plane[1] );
+			const float32x4_t nz = vdupq_n_f32( plane[2] );
+			const float32x4_t nd = vdupq_n_f32( plane[3] );
+
+			float32x4_t d0 = vmlaq_f32( vmlaq_f32( vmlaq_f32( nd, x0, nx ), y0, ny ), z0, nz );
+			float32x4_t d1 = vmlaq_f32( vmlaq_f32( vmlaq_f32( nd, x1, nx ), y1, ny ), z1, nz );
+
+			bits0 = vorrq_u32( bits0, vandq_u32( vcltq_f32( d0, eps ), backBit ) );
+			bits0 = vorrq_u32( bits0, vandq_u32( vcgtq_f32( d0, negEps ), frontBit ) );
+			bits1 = vorrq_u32( bits1, vandq_u32( vcltq_f32( d1, eps ), backBit ) );
+			bits1 = vorrq_u32( bits1, vandq_u32( vcgtq_f32( d1, negEps ), frontBit ) );
+		}
+
+		vst1q_u16( pointCull + i, vcombine_u16( vmovn_u32( bits0 ), vmovn_u32( bits1 ) ) );
+	}
+
+	if ( i < numVerts ) {
+		idSIMD_Generic::ShadowPointCull( pointCull + i, planes, frontBits, epsilon, verts + i, numVerts - i );
+	}
+}
+
+/*
+============
+idSIMD_NEON::CreateParticleQuads
+
+  four particles per iteration, the corners are computed with one particle
+  in each lane and written to the verts with interleaving lane stores
+============
+*/
+#define STORE_PARTICLE_QUAD( lane )																\
+	vst3q_lane_f32( verts[(lane)*4+0].xyz.ToFloatPtr(), v0, lane );								\
+	vst3q_lane_f32( verts[(lane)*4+1].xyz.ToFloatPtr(), v1, lane );								\
+	vst3q_lane_f32( verts[(lane)*4+2].xyz.ToFloatPtr(), v2, lane );								\
+	vst3q_lane_f32( verts[(lane)*4+3].xyz.ToFloatPtr(), v3, lane );
+
+void VPCALL idSIMD_NEON::CreateParticleQuads( idDrawVert *verts, const float *x, const float *y, const float *z, const float *width, const float *height, const float *cosAngle, const float *sinAngle, const idVec3 &left, const idVec3 &up, const int numParticles ) {
+	int i, j;
+
+	for ( i = 0; i + 4 <= numParticles; i += 4, verts += 16 ) {
+		const float32x4_t c = vld1q_f32( cosAngle + i );
+		const float32x4_t s = vld1q_f32( sinAngle + i );
+		const float32x4_t w = vld1q_f32( width + i );
+		const float32x4_t h = vld1q_f32( height + i );
+		float32x4_t o[3], l[3], u[3];
+
+		o[0] = vld1q_f32( x + i );
+		o[1] = vld1q_f32( y + i );
+		o[2] = vld1q_f32( z + i );
+
+		for ( j = 0; j < 3; j++ ) {
+			l[j] = vmulq_f32( vaddq_f32( vmulq_n_f32( c, left[j] ), vmulq_n_f32( s, up[j] ) ), w );
+			u[j] = vmulq_f32( vsubq_f32( vmulq_n_f32( c, up[j] ), vmulq_n_f32( s, left[j] ) ), h );
+		}
+
+		float32x4x3_t v0, v1, v2, v3;
+		for ( j = 0; j < 3; j++ ) {
+			v0.val[j] = vaddq_f32( vsubq_f32( o[j], l[j] ), u[j] );
+			v1.val[j] = vaddq_f32( vaddq_f32( o[j], l[j] ), u[j] );
+			v2.val[j] = vsubq_f32( vsubq_f32( o[j], l[j] ), u[j] );
+			v3.val[j] = vsubq_f32( vaddq_f32( o[j], l[j] ), u[j] );
+		}
+
+		STORE_PARTICLE_QUAD( 0 )
+		STORE_PARTICLE_QUAD( 1 )
+		STORE_PARTICLE_QUAD( 2 )
+		STORE_PARTICLE_QUAD( 3 )
+	}
+
+	if ( i < numParticles ) {
+		idSIMD_Generic::CreateParticleQuads( verts, x + i, y + i, z + i, width + i, height + i, cosAngle + i, sinAngle + i, left, up, numParticles - i );
+	}
+}
+
+#undef STORE_PARTICLE_QUAD
+
+/*
+============
+idSIMD_NEON::RasterizeOccluder
+
+  four pixels of a row per iteration, the three edge functions and the depth
+  are stepped across the row in the lanes and the inside test selects which
+  lanes take the new depth, so there are no branches per pixel. The first
+  iteration of a row starts on a multiple of four and masks off the pixels
+  left of x0.
+============
+*/
+void VPCALL idSIMD_NEON::RasterizeOccluder( float *depth, const int stride, const int x0, const int y0, const int x1, const int y1, const idVec3 edges[3], const idVec3 &zPlane, const float zMin, const float zMax ) {
+	static const int laneOffsets[4] = { 0, 1, 2, 3 };
+	int x, y;
+
+	const int32x4_t lanes = vld1q_s32( laneOffsets );
+	const int32x4_t left = vdupq_n_s32( x0 );
+	const float32x4_t zero = vdupq_n_f32( 0.0f );
+	const float32x4_t ex0 = vdupq_n_f32( edges[0].x );
+	const float32x4_t ex1 = vdupq_n_f32( edges[1].x );
+	const float32x4_t ex2 = vdupq_n_f32( edges[2].x );
+	const float32x4_t dzdx = vdupq_n_f32( zPlane.x );
+	const float32x4_t zLow = vdupq_n_f32( zMin );
+	const float32x4_t zHigh = vdupq_n_f32( zMax );
+
+	for ( y = y0; y <= y1; y++ ) {
+		const float yc = y + 0.5f;
+		const float32x4_t e0 = vdupq_n_f32( edges[0].x * 0.5f + edges[0].y * yc + edges[0].z );
+		const float32x4_t e1 = vdupq_n_f32( edges[1].x * 0.5f + edges[1].y * yc + edges[1].z );
+		const float32x4_t e2 = vdupq_n_f32( edges[2].x * 0.5f + edges[2].y * yc + edges[2].z );
+		const float32x4_t zRow = vdupq_n_f32( zPlane.x * 0.5f + zPlane.y * yc + zPlane.z );
+		float *row = depth + y * stride;
+
+		for ( x = x0 & ~3; x + 3 <= x1; x += 4 ) {
+			const int32x4_t ix = vaddq_s32( vdupq_n_s32( x ), lanes );
+			const float32x4_t fx = vcvtq_f32_s32( ix );
+
+			uint32x4_t inside = vcgeq_s32( ix, left );
+			inside = vandq_u32( inside, vcgeq_f32( vmlaq_f32( e0, ex0, fx ), zero ) );
+			inside = vandq_u32( inside, vcgeq_f32( vmlaq_f32( e1, ex1, fx ), zero ) );
+			inside = vandq_u32( inside, vcgeq_f32( vmlaq_f32( e2, ex2, fx ), zero ) );
+
+			float32x4_t z = vmlaq_f32( zRow, dzdx, fx );
+			z = vminq_f32( vmaxq_f32( z, zLow ), zHigh );
+
+			const float32x4_t old = vld1q_f32( row + x );
+			vst1q_f32( row + x, vbslq_f32( inside, vmaxq_f32( z, old ), old ) );
+		}
+
+		if ( x <= x1 ) {
+			idSIMD_Generic::RasterizeOccluder( depth, stride, ( x > x0 ) ? x : x0, y, x1, y, edges, zPlane, zMin, zMax );
+		}
+	}
+}
+
+#endif /* __ARM_NEON__ */
@@ -0,0 +1,56 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+#ifndef __MATH_SIMD_NEON_H__
+#define __MATH_SIMD_NEON_H__
+
+#include "idlib/math/Simd_Generic.h"
+
+/*
+===============================================================================
+
+	NEON implementation of idSIMDProcessor
+
+===============================================================================
+*/
+
+class idSIMD_NEON : public idSIMD_Generic {
+public:
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	virtual const char * VPCALL GetName( void ) const;
+
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
+	virtual void VPCALL ShadowPointCull( unsigned short *pointCull, const idPlane *planes, const int frontBits, const float epsilon, const idDrawVert *verts, const int numVerts );
+	virtual void VPCALL CreateParticleQuads( idDrawVert *verts, const float *x, const float *y, const float *z, const float *width, const float *height, const float *cosAngle, const float *sinAngle, const idVec3 &left, const idVec3 &up, const int numParticles );
+	virtual void VPCALL RasterizeOccluder( float *depth, const int stride, const int x0, const int y0, const int x1, const int y1, const idVec3 edges[3], const idVec3 &zPlane, const float zMin, const float zMax );
+#endif
+};
+
+#endif /* !__MATH_SIMD_NEON_H__ */
@@ -239,6 +239,91 @@ void VPCALL idSIMD_SSE2::CmpLT( byte *dst, const byte bitNum, const float *src0,
 	}
 }
 
+/*
+============
+idSIMD_SSE2::MipMapRGBA
+
+  four destination texels per iteration, the rows are widened to 16 bits,
+  summed, and neighbouring texels are added by swapping 64 bit halves
+============
+*/
+void VPCALL idSIMD_SSE2::MipMapRGBA( byte *dst, const byte *src, const int width, const int height ) {
+	int row = width * 4;
+	int newWidth = width >> 1;
+	int newHeight = height >> 1;
+	const __m128i zero = _mm_setzero_si128();
+
+	for ( int i = 0; i < newHeight; i++ ) {
+		const byte *in0 = src + i * 2 * row;
+		const byte *in1 = in0 + row;
+		byte *out = dst + i * newWidth * 4;
+		int j;
+
+		for ( j = 0; j + 4 <= newWidth; j += 4, out += 16, in0 += 32, in1 += 32 ) {
+			__m128i a0 = _mm_loadu_si128( (const __m128i *)( in0 + 0 ) );
+			__m128i a1 = _mm_loadu_si128( (const __m128i *)( in0 + 16 ) );
+			__m128i b0 = _mm_loadu_si128( (const __m128i *)( in1 + 0 ) );
+			__m128i b1 = _mm_loadu_si128( (const __m128i *)( in1 + 16 ) );
+
+			// texels 0,1 2,3 4,5 6,7 with both rows summed
+			__m128i s01 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+			__m128i s23 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+			__m128i s45 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+			__m128i s67 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+			__m128i d01 = _mm_add_epi16( _mm_unpacklo_epi64( s01, s23 ), _mm_unpackhi_epi64( s01, s23 ) );
+			__m128i d23 = _mm_add_epi16( _mm_unpacklo_epi64( s45, s67 ), _mm_unpackhi_epi64( s45, s67 ) );
+
+			d01 = _mm_srli_epi16( d01, 2 );
+			d23 = _mm_srli_epi16( d23, 2 );
+
+			_mm_storeu_si128( (__m128i *)out, _mm_packus_epi16( d01, d23 ) );
+		}
+
+		for ( ; j < newWidth; j++, out += 4, in0 += 8, in1 += 8 ) {
+			out[0] = ( in0[0] + in0[4] + in1[0] + in1[4] ) >> 2;
+			out[1] = ( in0[1] + in0[5] + in1[1] + in1[5] ) >> 2;
+			out[2] = ( in0[2] + in0[6] + in1[2] + in1[6] ) >> 2;
+			out[3] = ( in0[3] + in0[7] + in1[3] + in1[7] ) >> 2;
+		}
+	}
+}
+
+/*
+============
+idSIMD_SSE2::ResampleRowRGBA
+============
+*/
+void VPCALL idSIMD_SSE2::ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	const __m128i zero = _mm_setzero_si128();
+	int i;
+
+	for ( i = 0; i + 2 <= count; i += 2, dst += 8 ) {
+		// gather the four source texels of two destination texels
+		__m128i p0 = _mm_unpacklo_epi32( _mm_cvtsi32_si128( *(const int *)( row0 + offsets0[i+0] ) ), _mm_cvtsi32_si128( *(const int *)( row0 + offsets0[i+1] ) ) );
+		__m128i p1 = _mm_unpacklo_epi32( _mm_cvtsi32_si128( *(const int *)( row0 + offsets1[i+0] ) ), _mm_cvtsi32_si128( *(const int *)( row0 + offsets1[i+1] ) ) );
+		__m128i p2 = _mm_unpacklo_epi32( _mm_cvtsi32_si128( *(const int *)( row1 + offsets0[i+0] ) ), _mm_cvtsi32_si128( *(const int *)( row1 + offsets0[i+1] ) ) );
+		__m128i p3 = _mm_unpacklo_epi32( _mm_cvtsi32_si128( *(const int *)( row1 + offsets1[i+0] ) ), _mm_cvtsi32_si128( *(const int *)( row1 + offsets1[i+1] ) ) );
+
+		__m128i sum = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( p0, zero ), _mm_unpacklo_epi8( p1, zero ) ),
+									 _mm_add_epi16( _mm_unpacklo_epi8( p2, zero ), _mm_unpacklo_epi8( p3, zero ) ) );
+		sum = _mm_srli_epi16( sum, 2 );
+
+		_mm_storel_epi64( (__m128i *)dst, _mm_packus_epi16( sum, zero ) );
+	}
+
+	for ( ; i < count; i++, dst += 4 ) {
+		const byte *pix1 = row0 + offsets0[i];
+		const byte *pix2 = row0 + offsets1[i];
+		const byte *pix3 = row1 + offsets0[i];
+		const byte *pix4 = row1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
+
 #elif defined(_MSC_VER) && defined(_M_IX86)
 
 #include <xmmintrin.h>
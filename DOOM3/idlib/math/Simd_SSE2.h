@@ -47,6 +47,9 @@ public:
 	virtual const char * VPCALL GetName( void ) const;
 	virtual void VPCALL CmpLT( byte *dst,			const byte bitNum,		const float *src0,		const float constant,	const int count );
 
+	virtual void VPCALL MipMapRGBA( byte *dst, const byte *src, const int width, const int height );
+	virtual void VPCALL ResampleRowRGBA( byte *dst, const byte *row0, const byte *row1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
+
 #elif defined(_MSC_VER) && defined(_M_IX86)
 	virtual const char * VPCALL GetName( void ) const;
 
@@ -201,6 +201,129 @@ void idGuiModel::EmitSurface( guiModelSurface_t *surf, float modelMatrix[16], fl
 	R_AddDrawSurf( tri, guiSpace, &renderEntity, surf->material, tr.viewDef->scissor );
 }
 
+/*
+================
+R_GuiSurfaceFitsAtlas
+
+The color has to fit in the vertex colors and the texture coordinates
+can't reach outside the image, a tile isn't surrounded by its own texels
+================
+*/
+static bool R_GuiSurfaceFitsAtlas( const guiModelSurface_t *surf, const idDrawVert *verts ) {
+	const float epsilon = 0.001f;
+
+	if ( surf->material->GetSort() != SS_GUI ) {
+		return false;
+	}
+	for ( int i = 0; i < 4; i++ ) {
+		if ( surf->color[i] < 0.0f || surf->color[i] > 1.0f ) {
+			return false;
+		}
+	}
+	for ( int i = 0; i < surf->numVerts; i++ ) {
+		const idVec2 &st = verts[surf->firstVert + i].st;
+		if ( st.x < -epsilon || st.x > 1.0f + epsilon || st.y < -epsilon || st.y > 1.0f + epsilon ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+================
+BatchSurfaces
+
+Fills drawSurfaces from surfaces, consecutive surfaces with images in the
+same gui atlas page are merged into one that draws with the page material.
+Their colors go into the vertex colors and their texture coordinates are
+moved into the page, the new verts and indexes are added after the recorded
+ones, the Emit functions drop them again when they are done.
+================
+*/
+void idGuiModel::BatchSurfaces() {
+	guiModelSurface_t	*batch = NULL;
+
+	drawSurfaces.SetNum( 0, false );
+
+	for ( int i = 0 ; i < surfaces.Num() ; i++ ) {
+		const guiModelSurface_t *s = &surfaces[i];
+
+		if ( s->numVerts == 0 ) {
+			continue;
+		}
+		tr.pc.c_guiModelSurfs++;
+
+		const guiAtlasTile_t *tile = NULL;
+		if ( r_useGuiAtlas.GetBool() && R_GuiSurfaceFitsAtlas( s, verts.Ptr() ) ) {
+			tile = R_GuiAtlasTile( s->material );
+		}
+		if ( !tile ) {
+			drawSurfaces.Append( *s );
+			batch = NULL;
+			continue;
+		}
+
+		// the page is blended by the alpha of the vertex colors
+		if ( s->color[3] == 0.0f ) {
+			continue;
+		}
+
+#if GL_INDEX_TYPE == GL_UNSIGNED_SHORT
+		const bool batchFull = ( batch && batch->numVerts + s->numVerts > 0x10000 );
+#else
+		const bool batchFull = false;
+#endif
+		if ( !batch || batch->material != tile->pageMaterial || batchFull ) {
+			guiModelSurface_t	b;
+
+			b.material = tile->pageMaterial;
+			const_cast<idMaterial *>( b.material )->EnsureNotPurged();
+			b.material->SetSort( SS_GUI );
+			b.color[0] = 1;
+			b.color[1] = 1;
+			b.color[2] = 1;
+			b.color[3] = 1;
+			b.firstVert = verts.Num();
+			b.numVerts = 0;
+			b.firstIndex = indexes.Num();
+			b.numIndexes = 0;
+
+			drawSurfaces.Append( b );
+			batch = &drawSurfaces[ drawSurfaces.Num() - 1 ];
+		}
+
+		byte color[4];
+		for ( int j = 0; j < 4; j++ ) {
+			color[j] = idMath::FtoiFast( s->color[j] * 255.0f );
+		}
+
+		int numVerts = verts.Num();
+		verts.SetNum( numVerts + s->numVerts, false );
+		for ( int j = 0; j < s->numVerts; j++ ) {
+			idDrawVert *dv = &verts[numVerts + j];
+
+			*dv = verts[s->firstVert + j];
+			dv->st.x = idMath::ClampFloat( 0.0f, 1.0f, dv->st.x ) * tile->scale.x + tile->bias.x;
+			dv->st.y = idMath::ClampFloat( 0.0f, 1.0f, dv->st.y ) * tile->scale.y + tile->bias.y;
+			dv->color[0] = color[0];
+			dv->color[1] = color[1];
+			dv->color[2] = color[2];
+			dv->color[3] = color[3];
+		}
+
+		int numIndexes = indexes.Num();
+		indexes.SetNum( numIndexes + s->numIndexes, false );
+		for ( int j = 0; j < s->numIndexes; j++ ) {
+			indexes[numIndexes + j] = indexes[s->firstIndex + j] + batch->numVerts;
+		}
+
+		batch->numVerts += s->numVerts;
+		batch->numIndexes += s->numIndexes;
+	}
+
+	tr.pc.c_guiModelDraws += drawSurfaces.Num();
+}
+
 /*
 ====================
 EmitToCurrentView
@@ -208,13 +331,21 @@ EmitToCurrentView
 */
 void idGuiModel::EmitToCurrentView( float modelMatrix[16], bool depthHack ) {
 	float	modelViewMatrix[16];
+	int		numVerts = verts.Num();
+	int		numIndexes = indexes.Num();
 
 	myGlMultMatrix( modelMatrix, tr.viewDef->worldSpace.modelViewMatrix,
 			modelViewMatrix );
 
-	for ( int i = 0 ; i < surfaces.Num() ; i++ ) {
-		EmitSurface( &surfaces[i], modelMatrix, modelViewMatrix, depthHack );
+	BatchSurfaces();
+
+	for ( int i = 0 ; i < drawSurfaces.Num() ; i++ ) {
+		EmitSurface( &drawSurfaces[i], modelMatrix, modelViewMatrix, depthHack );
 	}
+
+	// drop the merged surfaces
+	verts.SetNum( numVerts, false );
+	indexes.SetNum( numIndexes, false );
 }
 
 /*
@@ -226,11 +357,15 @@ Creates a view that covers the screen and emit the surfaces
 */
 void idGuiModel::EmitFullScreen( void ) {
 	viewDef_t	*viewDef;
+	int			numVerts = verts.Num();
+	int			numIndexes = indexes.Num();
 
 	if ( surfaces[0].numVerts == 0 ) {
 		return;
 	}
 
+	BatchSurfaces();
+
 	viewDef = (viewDef_t *)R_ClearedFrameAlloc( sizeof( *viewDef ) );
 
 	// for gui editor
@@ -287,12 +422,16 @@ void idGuiModel::EmitFullScreen( void ) {
 	tr.viewDef = viewDef;
 
 	// add the surfaces to this view
-	for ( int i = 0 ; i < surfaces.Num() ; i++ ) {
-		EmitSurface( &surfaces[i], viewDef->worldSpace.modelMatrix, viewDef->worldSpace.modelViewMatrix, false );
+	for ( int i = 0 ; i < drawSurfaces.Num() ; i++ ) {
+		EmitSurface( &drawSurfaces[i], viewDef->worldSpace.modelMatrix, viewDef->worldSpace.modelViewMatrix, false );
 	}
 
 	tr.viewDef = oldViewDef;
 
+	// drop the merged surfaces
+	verts.SetNum( numVerts, false );
+	indexes.SetNum( numIndexes, false );
+
 	// add the command to draw this view
 	R_AddDrawViewCmd( viewDef );
 }
@@ -64,11 +64,13 @@ public:
 	//---------------------------
 private:
 	void	AdvanceSurf();
+	void	BatchSurfaces();
 	void	EmitSurface( guiModelSurface_t *surf, float modelMatrix[16], float modelViewMatrix[16], bool depthHack );
 
 	guiModelSurface_t		*surf;
 
 	idList<guiModelSurface_t>	surfaces;
+	idList<guiModelSurface_t>	drawSurfaces;	// surfaces after the atlas batching, only valid while emitting
 	idList<glIndex_t>		indexes;
 	idList<idDrawVert>	verts;
 };
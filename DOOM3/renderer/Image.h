@@ -125,6 +125,39 @@ typedef struct
 	unsigned int dwReserved2[3];
 } ddsFileHeader_t;
 
+// ETC2 is core in OpenGL ES 3.0
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2				0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC		0x9278
+#endif
+
+// image programs compressed to ETC2 are cached as etc2/<image program>.etc2
+// under fs_savepath, the header is followed by numLevels of an int size and
+// the compressed data, all little endian
+const unsigned int IMAGE_CACHE_MAGIC	= DDS_MAKEFOURCC( 'E', 'T', 'C', '2' );
+const int IMAGE_CACHE_VERSION			= 2;
+
+// mip options that change the cached data
+const int IMAGE_CACHE_GAMMA_MIPS		= 1;
+const int IMAGE_CACHE_NORMALIZE_MIPS	= 2;
+
+typedef struct {
+	unsigned int	magic;
+	int				version;
+	unsigned int	sourceCRC;					// idImageFiles::Checksum of the files used by the image program, pak files have no timestamps
+	int				sourceWidth, sourceHeight;
+	int				requestWidth, requestHeight;	// after GetDownsize, to catch changed image_downSize settings
+	int				width, height;				// of the first level
+	int				depth;						// image programs may turn an image into a bump map
+	int				repeat;
+	int				mipFlags;
+	int				imageHash;
+	int				internalFormat;
+	int				numLevels;
+} imageCacheHeader_t;
+
 
 // increasing numeric values imply more information is stored
 typedef enum {
@@ -150,6 +183,38 @@ typedef enum {
 
 #define	MAX_IMAGE_NAME	256
 
+class idImage;
+class idImageFiles;
+
+// the pixels of a 2D image on their way to GL, GenerateImage is split up into
+// BeginGenerateImage, R_BuildMipChain and FinishGenerateImage so the middle
+// part can run on a job thread while images are loaded for a level
+typedef struct {
+	idImage *			image;
+	idImageFiles *		files;					// if set, R_BuildMipChain decodes pic from these first
+	const byte *		pic;					// RGBA source, only owned by the chain if it was decoded from files
+	int					width, height;
+	int					downSizeLimit;			// from the image_downSize cvars, 0 for none
+	int					scaledWidth, scaledHeight;	// upload size of the first level
+	textureRepeat_t		repeat;
+	textureDepth_t		depth;
+	bool				colorMipLevels;
+	bool				gammaMips;				// filter the levels in linear space
+	bool				normalizeMips;			// renormalize the levels of a normal map
+	bool				hashPic;				// compute imageHash from pic
+	int					imageHash;
+	bool				keepUnswizzled;			// for image_writeTGA
+	byte *				unswizzled;
+	bool				compress;				// encode the levels to ETC2 and write them to the image cache
+	int					compressedFormat;		// 0 if the levels are RGBA
+	int					numLevels;
+	byte *				levels[MAX_TEXTURE_LEVELS];
+	int					levelSizes[MAX_TEXTURE_LEVELS];	// only set for compressed levels
+} imageMipChain_t;
+
+void	R_BuildMipChain( imageMipChain_t &chain );
+void	R_BuildMipChainJob( void *data );
+
 class idImage {
 public:
 				idImage();
@@ -166,6 +231,13 @@ public:
 	// deletes the texture object, but leaves the structure so it can be reloaded
 	void		PurgeImage();
 
+	// deletes the texture object and uploads the placeholder in its place,
+	// the image is streamed back in when it is bound again
+	void		EvictImage();
+
+	// deletes the placeholder texture and frees its levels
+	void		FreePlaceholder();
+
 	// used by callback functions to specify the actual data
 	// data goes from the bottom to the top line of the image, as OpenGL expects it
 	// These perform an implicit Bind() on the current texture unit
@@ -177,12 +249,22 @@ public:
 						textureFilter_t filter, bool allowDownSize,
 						textureDepth_t depth );
 
+	bool		BeginGenerateImage( imageMipChain_t &chain, const byte *pic, int width, int height,
+						textureFilter_t filter, bool allowDownSize,
+						textureRepeat_t repeat, textureDepth_t depth );
+	void		FinishGenerateImage( imageMipChain_t &chain );
+
 	void		CopyFramebuffer( int x, int y, int width, int height, bool useOversizedBuffer );
 
 	void		CopyDepthbuffer( int x, int y, int width, int height );
 
 	void		UploadScratch( const byte *pic, int width, int height );
 
+	// replaces a rectangle of the first level of a 2D image, the
+	// other levels are left alone until GenerateMipmaps is called
+	void		UploadSubImage( const byte *pic, int x, int y, int width, int height );
+	void		GenerateMipmaps();
+
 	// just for resource tracking
 	void		SetClassification( int tag );
 
@@ -200,13 +282,22 @@ public:
 //==========================================================
 
 	void		GetDownsize( int &scaled_width, int &scaled_height ) const;
+	int			DownsizeLimit() const;
 	void		MakeDefault();	// fill with a grid pattern
 	void		SetImageFilterAndRepeat() const;
 	void		ActuallyLoadImage( bool fromBackEnd );
+	bool		BeginLoadImage( imageMipChain_t &chain, idImageFiles *files = NULL );	// ActuallyLoadImage for the level load jobs
+	void		FinishLoadImage( imageMipChain_t &chain );
 	int			BitsForInternalFormat( int internalFormat ) const;
 	void		UploadCompressedNormalMap( int width, int height, const byte *rgba, int mipLevel );
 	void		ImageProgramStringToCompressedFileName( const char *imageProg, char *fileName ) const;
+	void		ImageProgramStringToCacheFileName( const char *imageProg, char *fileName ) const;
+	bool		LoadCachedImage( unsigned int sourceCRC );	// uploads the ETC2 image cache if it is up to date
+	void		WriteCachedImage( const imageMipChain_t &chain ) const;
 	int			NumLevelsForImageSize( int width, int height ) const;
+	void		SetResidentSize();
+	void		KeepPlaceholder( const byte * const *levels, int numLevels, int width, int height );
+	void		UploadPlaceholder();
 
 	// data commonly accessed is grouped here
 	static const int TEXTURE_NOT_LOADED = -1;
@@ -247,6 +338,14 @@ public:
 	idImage *			hashNext;				// for hash chains to speed lookup
 
 	int					refCount;				// overall ref count
+
+	// residency, see idImageManager::UpdateResidency
+	int					residentSize;			// bytes counted against image_residentMegs
+	bool				streaming;				// queued or being built to replace the placeholder, or in a level load batch
+	bool				streamFailed;			// couldn't be loaded again, the placeholder stays
+	GLuint				placeholderTexnum;		// bound in place of an evicted image
+	byte *				placeholder;			// the smallest mip levels, back to back
+	int					placeholderWidth, placeholderHeight, placeholderLevels, placeholderFormat;
 };
 
 ID_INLINE idImage::idImage() {
@@ -275,6 +374,12 @@ ID_INLINE idImage::idImage() {
 	cacheUsagePrev = cacheUsageNext = NULL;
 	hashNext = NULL;
 	refCount = 0;
+	residentSize = 0;
+	streaming = false;
+	streamFailed = false;
+	placeholderTexnum = TEXTURE_NOT_LOADED;
+	placeholder = NULL;
+	placeholderWidth = placeholderHeight = placeholderLevels = placeholderFormat = 0;
 }
 
 
@@ -314,6 +419,16 @@ public:
 	// called each frame to allow some cvars to automatically force changes
 	void				CheckCvars();
 
+	// called each frame, evicts the least recently used images while over
+	// image_residentMegs and streams evicted images back in when they are bound
+	void				UpdateResidency();
+
+	// queues an evicted image to be loaded again
+	void				StreamImage( idImage *image );
+
+	// uploads the images that are being streamed in and clears the queue
+	void				FinishStreaming();
+
 	// purges all the images before a vid_restart
 	void				PurgeAllImages();
 
@@ -360,6 +475,13 @@ public:
 	static idCVar		image_downSizeBump;			// downsize bump maps
 	static idCVar		image_downSizeBumpLimit;	// downsize bump limit
 	static idCVar		image_downSizeLimit;		// downsize diffuse limit
+	static idCVar		image_loadJobs;				// build mip chains on the job threads during level loads
+	static idCVar		image_mipGamma;				// filter diffuse mip levels in linear space
+	static idCVar		image_mipNormalize;			// renormalize the normals of bump map mip levels
+	static idCVar		image_useETC2;				// compress images to ETC2 and cache them in etc2/
+	static idCVar		image_residentMegs;			// texture memory budget, 0 = no limit
+	static idCVar		image_streamPerFrame;		// evicted images started loading again per frame
+	static idCVar		image_showResidency;		// print evictions and streamed images
 
 	// built-in images
 	idImage *			defaultImage;
@@ -389,6 +511,8 @@ public:
 
 	idImage *			AllocImage( const char *name );
 	void				SetNormalPalette();
+	void				FinishImageBatch( imageMipChain_t *chains, int numChains, idJobList &jobList );
+	void				FinishStreamBatch();
 	void				ChangeTextureFilter();
 
 	idList<idImage*>	images;
@@ -413,6 +537,15 @@ public:
 
 	int	numActiveBackgroundImageLoads;
 	const static int MAX_BACKGROUND_IMAGE_LOADS = 8;
+
+	// images streamed back in after being evicted
+	const static int	MAX_STREAM_IMAGES = 8;
+	idList<idImage *>	streamQueue;
+	idList<idImage *>	streamReads;				// the files of these are being read
+	idList<idImageFiles *>	streamFiles;
+	imageMipChain_t		streamChains[MAX_STREAM_IMAGES];
+	int					numStreamChains;
+	idJobList			streamJobs;
 };
 
 extern idImageManager	*globalImages;		// pointer to global list for the rest of the system
@@ -434,6 +567,7 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 							int outwidth, int outheight );
 byte *R_MipMapWithAlphaSpecularity( const byte *in, int width, int height );
 byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder );
+byte *R_MipMapGamma( const byte *in, int width, int height, bool preserveBorder );
 byte *R_MipMap3D( const byte *in, int width, int height, int depth, bool preserveBorder );
 
 // these operate in-place on the provided pixels
@@ -443,6 +577,14 @@ void R_BlendOverTexture( byte *data, int pixelCount, const byte blend[4] );
 void R_HorizontalFlip( byte *data, int width, int height );
 void R_VerticalFlip( byte *data, int width, int height );
 void R_RotatePic( byte *data, int width );
+void R_RenormalizeRXGB( byte *data, int pixelCount );
+
+// ETC2 compression, Image_etc.cpp
+int  R_ETC2LevelSize( int width, int height, bool alpha );
+void R_CompressETC2( byte *dst, const byte *rgba, int width, int height, bool alpha );
+
+// builds the sRGB tables used by R_MipMapGamma, must be called before any jobs use it
+void R_InitMipMapTables( void );
 
 /*
 ====================================================================
@@ -452,7 +594,56 @@ IMAGEFILES
 ====================================================================
 */
 
-void R_LoadImage( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, bool makePowerOf2 );
+/*
+================================================
+idImageFiles
+
+The source files of an image program. They are read on the main thread,
+then the program can be run on a job thread with the files handed to
+R_LoadImageProgram in place of the file system. Errors of such a run
+are kept here for the main thread to print.
+================================================
+*/
+class idImageFiles {
+public:
+						idImageFiles( void );
+						~idImageFiles( void );
+
+	// looks the program up the way R_LoadImageProgram does when it is only
+	// after the timestamp, and reads every file it comes across
+	void				ReadFiles( const char *imageProgram, ID_TIME_T *timestamp, textureDepth_t *depth );
+	// same, but the files are only looked up and read with idFileSystem::ReadFileAsync,
+	// the object can't be used or deleted before ReadsDone
+	void				ReadFilesAsync( const char *imageProgram );
+	bool				ReadsDone( void ) const { return pendingReads == 0; }
+	void				Clear( void );
+	// CRC32 over the names and contents of the files
+	unsigned int		Checksum( void ) const;
+	const char *		GetError( void ) const { return error.c_str(); }
+
+	// for the image loaders, the buffers stay owned by this
+	int					ReadFile( const char *name, byte **buffer, ID_TIME_T *timestamp );
+	void				Error( const char *fmt, ... ) id_attribute((format(printf,2,3)));
+	bool				HasError( void ) const { return error.Length() > 0; }
+
+private:
+	typedef struct {
+		idStr			name;
+		byte *			buffer;			// NULL if the file wasn't found
+		int				length;
+		ID_TIME_T		timestamp;
+	} imageFile_t;
+
+	idList<imageFile_t>	files;
+	bool				reading;		// inside ReadFiles, reads go to the file system
+	bool				async;			// inside ReadFilesAsync
+	int					pendingReads;	// ReadFileAsync calls that didn't call back yet
+	idStr				error;
+
+	static void			ReadDone( const char *relativePath, void *buffer, int length, void *data );
+};
+
+void R_LoadImage( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, bool makePowerOf2, idImageFiles *files = NULL );
 // pic is in top to bottom raster format
 bool R_LoadCubeImages( const char *cname, cubeFiles_t extensions, byte *pic[6], int *size, ID_TIME_T *timestamp );
 
@@ -464,7 +655,8 @@ IMAGEPROGRAM
 ====================================================================
 */
 
-void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, textureDepth_t *depth = NULL );
+// files is set when the program is run on a job thread, see idImageFiles
+void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, textureDepth_t *depth = NULL, idImageFiles *files = NULL );
 const char *R_ParsePastImageProgram( idLexer &src );
 
 #endif
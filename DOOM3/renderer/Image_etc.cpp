@@ -0,0 +1,364 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "sys/platform.h"
+#include "renderer/tr_local.h"
+
+#include "renderer/Image.h"
+
+/*
+================================================================================================
+
+	ETC2 texture compression
+
+	Every level is cut into 4x4 blocks, the color of a block is stored as an ETC1
+	compatible individual or differential block and the alpha, if there is any,
+	as an 8 bit EAC block in front of it. Blocks hanging over the edge of a level
+	repeat the last row and column.
+
+	The encoder only does a small search around the average color of each half
+	block, which is fast enough to run on the job threads during a level load and
+	close to what the offline tools manage for game textures.
+
+================================================================================================
+*/
+
+static const int etcModifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int eacModifiers[16][8] = {
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 },
+	{ -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 },
+	{ -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 },
+	{ -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 },
+	{ -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 },
+	{ -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 },
+	{ -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 },
+	{ -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+/*
+================
+ETC_Clamp
+================
+*/
+static ID_INLINE int ETC_Clamp( int c ) {
+	return ( c < 0 ) ? 0 : ( ( c > 255 ) ? 255 : c );
+}
+
+/*
+================
+ETC_FitSubBlock
+
+Picks the modifier table and per texel modifiers for one half of a block
+around the given base color, returns the squared error
+================
+*/
+static int ETC_FitSubBlock( const int texels[8][3], const int base[3], int &table, int selectors[8] ) {
+	int		bestError = INT_MAX;
+
+	for ( int t = 0; t < 8; t++ ) {
+		int		error = 0;
+		int		sel[8];
+
+		for ( int i = 0; i < 8 && error < bestError; i++ ) {
+			int	bestTexelError = INT_MAX;
+
+			for ( int s = 0; s < 4; s++ ) {
+				int mod = ( s & 2 ) ? -etcModifiers[t][s & 1] : etcModifiers[t][s & 1];
+				int dr = ETC_Clamp( base[0] + mod ) - texels[i][0];
+				int dg = ETC_Clamp( base[1] + mod ) - texels[i][1];
+				int db = ETC_Clamp( base[2] + mod ) - texels[i][2];
+				int e = dr * dr + dg * dg + db * db;
+				if ( e < bestTexelError ) {
+					bestTexelError = e;
+					sel[i] = s;
+				}
+			}
+			error += bestTexelError;
+		}
+
+		if ( error < bestError ) {
+			bestError = error;
+			table = t;
+			memcpy( selectors, sel, sizeof( sel ) );
+		}
+	}
+
+	return bestError;
+}
+
+/*
+================
+ETC_EncodeColorBlock
+================
+*/
+static void ETC_EncodeColorBlock( byte *out, const byte block[16][4] ) {
+	int		bestError = INT_MAX;
+	int		bestFlip = 0, bestDiff = 0;
+	int		bestColors[2][3];
+	int		bestTables[2];
+	int		bestSelectors[2][8];
+
+	for ( int flip = 0; flip < 2; flip++ ) {
+		int		texels[2][8][3];
+		int		avg[2][3];
+		int		counts[2] = { 0, 0 };
+
+		// split the block in two halves, side by side or on top of each other
+		for ( int y = 0; y < 4; y++ ) {
+			for ( int x = 0; x < 4; x++ ) {
+				int half = flip ? ( y >> 1 ) : ( x >> 1 );
+				int n = counts[half]++;
+				texels[half][n][0] = block[y * 4 + x][0];
+				texels[half][n][1] = block[y * 4 + x][1];
+				texels[half][n][2] = block[y * 4 + x][2];
+			}
+		}
+		for ( int h = 0; h < 2; h++ ) {
+			for ( int c = 0; c < 3; c++ ) {
+				int sum = 0;
+				for ( int i = 0; i < 8; i++ ) {
+					sum += texels[h][i][c];
+				}
+				avg[h][c] = sum;	// times 8
+			}
+		}
+
+		for ( int diff = 0; diff < 2; diff++ ) {
+			int		colors[2][3];
+			int		base[2][3];
+			int		tables[2];
+			int		selectors[2][8];
+
+			if ( diff ) {
+				// 555 base color and a 333 signed delta to the second one
+				bool fits = true;
+				for ( int h = 0; h < 2; h++ ) {
+					for ( int c = 0; c < 3; c++ ) {
+						colors[h][c] = ( avg[h][c] * 31 + 255 * 4 ) / ( 255 * 8 );
+						base[h][c] = ( colors[h][c] << 3 ) | ( colors[h][c] >> 2 );
+					}
+				}
+				for ( int c = 0; c < 3; c++ ) {
+					int d = colors[1][c] - colors[0][c];
+					if ( d < -4 || d > 3 ) {
+						fits = false;
+					}
+				}
+				if ( !fits ) {
+					continue;
+				}
+			} else {
+				// two 444 base colors
+				for ( int h = 0; h < 2; h++ ) {
+					for ( int c = 0; c < 3; c++ ) {
+						colors[h][c] = ( avg[h][c] * 15 + 255 * 4 ) / ( 255 * 8 );
+						base[h][c] = colors[h][c] * 17;
+					}
+				}
+			}
+
+			int error = ETC_FitSubBlock( texels[0], base[0], tables[0], selectors[0] );
+			if ( error >= bestError ) {
+				continue;
+			}
+			error += ETC_FitSubBlock( texels[1], base[1], tables[1], selectors[1] );
+			if ( error >= bestError ) {
+				continue;
+			}
+
+			bestError = error;
+			bestFlip = flip;
+			bestDiff = diff;
+			memcpy( bestColors, colors, sizeof( colors ) );
+			memcpy( bestTables, tables, sizeof( tables ) );
+			memcpy( bestSelectors, selectors, sizeof( selectors ) );
+		}
+	}
+
+	// pack the block, the selectors are stored column by column
+	unsigned int high, low = 0;
+
+	if ( bestDiff ) {
+		high = ( bestColors[0][0] << 27 ) | ( ( ( bestColors[1][0] - bestColors[0][0] ) & 7 ) << 24 )
+			| ( bestColors[0][1] << 19 ) | ( ( ( bestColors[1][1] - bestColors[0][1] ) & 7 ) << 16 )
+			| ( bestColors[0][2] << 11 ) | ( ( ( bestColors[1][2] - bestColors[0][2] ) & 7 ) << 8 );
+	} else {
+		high = ( bestColors[0][0] << 28 ) | ( bestColors[1][0] << 24 )
+			| ( bestColors[0][1] << 20 ) | ( bestColors[1][1] << 16 )
+			| ( bestColors[0][2] << 12 ) | ( bestColors[1][2] << 8 );
+	}
+	high |= ( bestTables[0] << 5 ) | ( bestTables[1] << 2 ) | ( bestDiff << 1 ) | bestFlip;
+
+	int counts[2] = { 0, 0 };
+	for ( int y = 0; y < 4; y++ ) {
+		for ( int x = 0; x < 4; x++ ) {
+			int half = bestFlip ? ( y >> 1 ) : ( x >> 1 );
+			int s = bestSelectors[half][counts[half]++];
+			int bit = x * 4 + y;
+			low |= ( ( s >> 1 ) << ( bit + 16 ) ) | ( ( s & 1 ) << bit );
+		}
+	}
+
+	out[0] = high >> 24;
+	out[1] = high >> 16;
+	out[2] = high >> 8;
+	out[3] = high;
+	out[4] = low >> 24;
+	out[5] = low >> 16;
+	out[6] = low >> 8;
+	out[7] = low;
+}
+
+/*
+================
+EAC_EncodeAlphaBlock
+================
+*/
+static void EAC_EncodeAlphaBlock( byte *out, const byte block[16][4] ) {
+	int		minAlpha = 255, maxAlpha = 0;
+	int		bestError = INT_MAX;
+	int		bestBase = 0, bestMul = 1, bestTable = 13;
+	int		bestSelectors[16];
+
+	for ( int i = 0; i < 16; i++ ) {
+		minAlpha = Min( minAlpha, (int)block[i][3] );
+		maxAlpha = Max( maxAlpha, (int)block[i][3] );
+	}
+
+	if ( minAlpha == maxAlpha ) {
+		// table 13 has a zero modifier
+		bestBase = minAlpha;
+		for ( int i = 0; i < 16; i++ ) {
+			bestSelectors[i] = 4;
+		}
+	} else {
+		for ( int t = 0; t < 16 && bestError > 0; t++ ) {
+			int tableMin = eacModifiers[t][3];
+			int tableMax = eacModifiers[t][7];
+			int mul0 = ( maxAlpha - minAlpha + ( tableMax - tableMin ) / 2 ) / ( tableMax - tableMin );
+
+			for ( int mul = Max( mul0 - 1, 1 ); mul <= Min( mul0 + 1, 15 ); mul++ ) {
+				int base = ETC_Clamp( ( minAlpha + maxAlpha - ( tableMin + tableMax ) * mul + 1 ) >> 1 );
+				int error = 0;
+				int selectors[16];
+
+				for ( int i = 0; i < 16 && error < bestError; i++ ) {
+					int	bestTexelError = INT_MAX;
+					for ( int s = 0; s < 8; s++ ) {
+						int d = ETC_Clamp( base + eacModifiers[t][s] * mul ) - block[i][3];
+						if ( d * d < bestTexelError ) {
+							bestTexelError = d * d;
+							selectors[i] = s;
+						}
+					}
+					error += bestTexelError;
+				}
+
+				if ( error < bestError ) {
+					bestError = error;
+					bestBase = base;
+					bestMul = mul;
+					bestTable = t;
+					memcpy( bestSelectors, selectors, sizeof( selectors ) );
+				}
+			}
+		}
+	}
+
+	// 48 bits of 3 bit selectors, stored column by column
+	out[0] = bestBase;
+	out[1] = ( bestMul << 4 ) | bestTable;
+	unsigned int high = 0, low = 0;
+	for ( int x = 0; x < 4; x++ ) {
+		for ( int y = 0; y < 4; y++ ) {
+			int n = x * 4 + y;
+			int s = bestSelectors[y * 4 + x];
+			if ( n < 8 ) {
+				high |= s << ( 21 - n * 3 );
+			} else {
+				low |= s << ( 21 - ( n - 8 ) * 3 );
+			}
+		}
+	}
+	out[2] = high >> 16;
+	out[3] = high >> 8;
+	out[4] = high;
+	out[5] = low >> 16;
+	out[6] = low >> 8;
+	out[7] = low;
+}
+
+/*
+================
+R_ETC2LevelSize
+================
+*/
+int R_ETC2LevelSize( int width, int height, bool alpha ) {
+	return ( ( width + 3 ) >> 2 ) * ( ( height + 3 ) >> 2 ) * ( alpha ? 16 : 8 );
+}
+
+/*
+================
+R_CompressETC2
+
+Compresses an RGBA level to GL_COMPRESSED_RGB8_ETC2 or, with alpha,
+GL_COMPRESSED_RGBA8_ETC2_EAC. dst must hold R_ETC2LevelSize bytes.
+Only touches the given memory, so this is safe to run on a job thread.
+================
+*/
+void R_CompressETC2( byte *dst, const byte *rgba, int width, int height, bool alpha ) {
+	byte	block[16][4];
+
+	for ( int by = 0; by < height; by += 4 ) {
+		for ( int bx = 0; bx < width; bx += 4 ) {
+			for ( int y = 0; y < 4; y++ ) {
+				const byte *row = rgba + Min( by + y, height - 1 ) * width * 4;
+				for ( int x = 0; x < 4; x++ ) {
+					*(int *)block[y * 4 + x] = *(const int *)( row + Min( bx + x, width - 1 ) * 4 );
+				}
+			}
+			if ( alpha ) {
+				EAC_EncodeAlphaBlock( dst, block );
+				dst += 8;
+			}
+			ETC_EncodeColorBlock( dst, block );
+			dst += 8;
+		}
+	}
+}
@@ -27,6 +27,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/CRC32.h"
 
 #include "renderer/tr_local.h"
 
@@ -43,6 +44,244 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, bool ma
 
 */
 
+/*
+================
+R_ReadImageFile
+
+The loaders read through the files of an idImageFiles when they
+decode on a job thread, the buffer is only freed with R_FreeImageFile
+================
+*/
+static int R_ReadImageFile( idImageFiles *files, const char *name, byte **buffer, ID_TIME_T *timestamp ) {
+	if ( files ) {
+		return files->ReadFile( name, buffer, timestamp );
+	}
+	return fileSystem->ReadFile( name, (void **)buffer, timestamp );
+}
+
+/*
+================
+R_FreeImageFile
+================
+*/
+static void R_FreeImageFile( idImageFiles *files, byte *buffer ) {
+	if ( !files ) {
+		fileSystem->FreeFile( buffer );
+	}
+}
+
+/*
+================
+R_ImageFileError
+
+Only returns if there are files to keep the error in, the caller
+has to give up on the image then
+================
+*/
+static void R_ImageFileError( idImageFiles *files, const char *fmt, ... ) {
+	va_list	argptr;
+	char	text[MAX_STRING_CHARS];
+
+	va_start( argptr, fmt );
+	idStr::vsnPrintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	if ( files ) {
+		files->Error( "%s", text );
+		return;
+	}
+	common->Error( "%s", text );
+}
+
+/*
+================
+idImageFiles::idImageFiles
+================
+*/
+idImageFiles::idImageFiles( void ) {
+	reading = false;
+	async = false;
+	pendingReads = 0;
+}
+
+/*
+================
+idImageFiles::~idImageFiles
+================
+*/
+idImageFiles::~idImageFiles( void ) {
+	assert( pendingReads == 0 );
+	Clear();
+}
+
+/*
+================
+idImageFiles::Clear
+================
+*/
+void idImageFiles::Clear( void ) {
+	for ( int i = 0; i < files.Num(); i++ ) {
+		if ( files[i].buffer ) {
+			fileSystem->FreeFile( files[i].buffer );
+		}
+	}
+	files.Clear();
+	error.Clear();
+}
+
+/*
+================
+idImageFiles::ReadFiles
+================
+*/
+void idImageFiles::ReadFiles( const char *imageProgram, ID_TIME_T *timestamp, textureDepth_t *depth ) {
+	Clear();
+
+	reading = true;
+	R_LoadImageProgram( imageProgram, NULL, NULL, NULL, timestamp, depth, this );
+	reading = false;
+}
+
+/*
+================
+idImageFiles::ReadFilesAsync
+================
+*/
+void idImageFiles::ReadFilesAsync( const char *imageProgram ) {
+	ID_TIME_T		timestamp;
+	textureDepth_t	depth;
+
+	assert( pendingReads == 0 );
+	Clear();
+
+	// the timestamp makes the loaders fall back to the .jpg of a missing .tga
+	reading = true;
+	async = true;
+	R_LoadImageProgram( imageProgram, NULL, NULL, NULL, &timestamp, &depth, this );
+	async = false;
+	reading = false;
+}
+
+/*
+================
+idImageFiles::ReadDone
+
+The idFileSystem::ReadFileAsync callback
+================
+*/
+void idImageFiles::ReadDone( const char *relativePath, void *buffer, int length, void *data ) {
+	idImageFiles *self = (idImageFiles *)data;
+
+	for ( int i = 0; i < self->files.Num(); i++ ) {
+		imageFile_t &file = self->files[i];
+		if ( !file.name.Icmp( relativePath ) ) {
+			file.buffer = (byte *)buffer;
+			file.length = length;
+			if ( !buffer ) {
+				file.timestamp = FILE_NOT_FOUND_TIMESTAMP;
+			}
+			break;
+		}
+	}
+	self->pendingReads--;
+}
+
+/*
+================
+idImageFiles::Checksum
+================
+*/
+unsigned int idImageFiles::Checksum( void ) const {
+	unsigned int crc;
+
+	CRC32_InitChecksum( crc );
+	for ( int i = 0; i < files.Num(); i++ ) {
+		CRC32_UpdateChecksum( crc, files[i].name.c_str(), files[i].name.Length() );
+		CRC32_UpdateChecksum( crc, &files[i].length, sizeof( files[i].length ) );
+		if ( files[i].buffer ) {
+			CRC32_UpdateChecksum( crc, files[i].buffer, files[i].length );
+		}
+	}
+	CRC32_FinishChecksum( crc );
+
+	return crc;
+}
+
+/*
+================
+idImageFiles::ReadFile
+
+Same as idFileSystem::ReadFile, but while the files are read the loaders
+only ask for timestamps, so the whole file is read anyway
+================
+*/
+int idImageFiles::ReadFile( const char *name, byte **buffer, ID_TIME_T *timestamp ) {
+	imageFile_t *file = NULL;
+
+	for ( int i = 0; i < files.Num(); i++ ) {
+		if ( !files[i].name.Icmp( name ) ) {
+			file = &files[i];
+			break;
+		}
+	}
+
+	if ( !file ) {
+		if ( !reading ) {
+			// the program took a turn it didn't take while the files were read
+			if ( buffer ) {
+				*buffer = NULL;
+			}
+			if ( timestamp ) {
+				*timestamp = FILE_NOT_FOUND_TIMESTAMP;
+			}
+			return -1;
+		}
+
+		file = &files.Alloc();
+		file->name = name;
+		file->buffer = NULL;
+		if ( async ) {
+			// the loaders only need to know the file is there, ReadDone fills in the data
+			file->length = fileSystem->ReadFile( name, NULL, &file->timestamp );
+			if ( file->length >= 0 ) {
+				pendingReads++;
+				fileSystem->ReadFileAsync( name, ReadDone, this );
+			}
+		} else {
+			file->length = fileSystem->ReadFile( name, (void **)&file->buffer, &file->timestamp );
+		}
+	}
+
+	if ( buffer ) {
+		*buffer = file->buffer;
+	}
+	if ( timestamp ) {
+		*timestamp = file->timestamp;
+	}
+	return file->length;
+}
+
+/*
+================
+idImageFiles::Error
+================
+*/
+void idImageFiles::Error( const char *fmt, ... ) {
+	va_list	argptr;
+	char	text[MAX_STRING_CHARS];
+
+	// the first error is what went wrong
+	if ( error.Length() ) {
+		return;
+	}
+
+	va_start( argptr, fmt );
+	idStr::vsnPrintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	error = text;
+}
+
 /*
 ================
 R_WriteTGA
@@ -126,9 +365,9 @@ void R_WritePalTGA( const char *filename, const byte *data, const byte *palette,
 }
 
 
-static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp );
-static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp );
-static void LoadJPG( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp );
+static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files );
+static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files );
+static void LoadJPG( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files );
 
 
 /*
@@ -206,7 +445,7 @@ typedef struct
 LoadBMP
 ==============
 */
-static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp )
+static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files )
 {
 	int		columns, rows, numPixels;
 	byte	*pixbuf;
@@ -218,7 +457,7 @@ static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_T
 	byte		*bmpRGBA;
 
 	if ( !pic ) {
-		fileSystem->ReadFile ( name, NULL, timestamp );
+		R_ReadImageFile( files, name, NULL, timestamp );
 		return;	// just getting timestamp
 	}
 
@@ -227,7 +466,7 @@ static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_T
 	//
 	// load the file
 	//
-	length = fileSystem->ReadFile( name, (void **)&buffer, timestamp );
+	length = R_ReadImageFile( files, name, &buffer, timestamp );
 	if ( !buffer ) {
 		return;
 	}
@@ -272,19 +511,27 @@ static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_T
 
 	if ( bmpHeader.id[0] != 'B' && bmpHeader.id[1] != 'M' )
 	{
-		common->Error( "LoadBMP: only Windows-style BMP files supported (%s)\n", name );
+		R_ImageFileError( files, "LoadBMP: only Windows-style BMP files supported (%s)\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 	if ( bmpHeader.fileSize != length )
 	{
-		common->Error( "LoadBMP: header size does not match file size (%u vs. %d) (%s)\n", bmpHeader.fileSize, length, name );
+		R_ImageFileError( files, "LoadBMP: header size does not match file size (%u vs. %d) (%s)\n", bmpHeader.fileSize, length, name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 	if ( bmpHeader.compression != 0 )
 	{
-		common->Error( "LoadBMP: only uncompressed BMP files supported (%s)\n", name );
+		R_ImageFileError( files, "LoadBMP: only uncompressed BMP files supported (%s)\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 	if ( bmpHeader.bitsPerPixel < 8 )
 	{
-		common->Error( "LoadBMP: monochrome and 4-bit BMP files not supported (%s)\n", name );
+		R_ImageFileError( files, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 
 	columns = bmpHeader.width;
@@ -350,13 +597,18 @@ static void LoadBMP( const char *name, byte **pic, int *width, int *height, ID_T
 				*pixbuf++ = alpha;
 				break;
 			default:
-				common->Error( "LoadBMP: illegal pixel_size '%d' in file '%s'\n", bmpHeader.bitsPerPixel, name );
+				R_ImageFileError( files, "LoadBMP: illegal pixel_size '%d' in file '%s'\n", bmpHeader.bitsPerPixel, name );
 				break;
 			}
 		}
 	}
 
-	fileSystem->FreeFile( buffer );
+	if ( files && files->HasError() ) {
+		R_StaticFree( *pic );
+		*pic = NULL;
+	}
+
+	R_FreeImageFile( files, buffer );
 
 }
 
@@ -376,7 +628,7 @@ LoadPCX
 ==============
 */
 static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *width, int *height,
-					 ID_TIME_T *timestamp ) {
+					 ID_TIME_T *timestamp, idImageFiles *files ) {
 	byte	*raw;
 	pcx_t	*pcx;
 	int		x, y;
@@ -386,7 +638,7 @@ static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *wid
 	int		xmax, ymax;
 
 	if ( !pic ) {
-		fileSystem->ReadFile( filename, NULL, timestamp );
+		R_ReadImageFile( files, filename, NULL, timestamp );
 		return;	// just getting timestamp
 	}
 
@@ -396,7 +648,7 @@ static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *wid
 	//
 	// load the file
 	//
-	len = fileSystem->ReadFile( filename, (void **)&raw, timestamp );
+	len = R_ReadImageFile( files, filename, &raw, timestamp );
 	if (!raw) {
 		return;
 	}
@@ -417,7 +669,12 @@ static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *wid
 		|| xmax >= 1024
 		|| ymax >= 1024)
 	{
-		common->Printf( "Bad pcx file %s (%i x %i) (%i x %i)\n", filename, xmax+1, ymax+1, pcx->xmax, pcx->ymax);
+		if ( files ) {
+			files->Error( "Bad pcx file %s (%i x %i) (%i x %i)\n", filename, xmax+1, ymax+1, pcx->xmax, pcx->ymax );
+		} else {
+			common->Printf( "Bad pcx file %s (%i x %i) (%i x %i)\n", filename, xmax+1, ymax+1, pcx->xmax, pcx->ymax);
+		}
+		R_FreeImageFile( files, (byte *)pcx );
 		return;
 	}
 
@@ -461,12 +718,16 @@ static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *wid
 
 	if ( raw - (byte *)pcx > len)
 	{
-		common->Printf( "PCX file %s was malformed", filename );
+		if ( files ) {
+			files->Error( "PCX file %s was malformed", filename );
+		} else {
+			common->Printf( "PCX file %s was malformed", filename );
+		}
 		R_StaticFree (*pic);
 		*pic = NULL;
 	}
 
-	fileSystem->FreeFile( pcx );
+	R_FreeImageFile( files, (byte *)pcx );
 }
 
 
@@ -475,17 +736,17 @@ static void LoadPCX ( const char *filename, byte **pic, byte **palette, int *wid
 LoadPCX32
 ==============
 */
-static void LoadPCX32 ( const char *filename, byte **pic, int *width, int *height, ID_TIME_T *timestamp) {
+static void LoadPCX32 ( const char *filename, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files ) {
 	byte	*palette;
 	byte	*pic8;
 	int		i, c, p;
 	byte	*pic32;
 
 	if ( !pic ) {
-		fileSystem->ReadFile( filename, NULL, timestamp );
+		R_ReadImageFile( files, filename, NULL, timestamp );
 		return;	// just getting timestamp
 	}
-	LoadPCX (filename, &pic8, &palette, width, height, timestamp);
+	LoadPCX (filename, &pic8, &palette, width, height, timestamp, files);
 	if (!pic8) {
 		*pic = NULL;
 		return;
@@ -519,7 +780,7 @@ TARGA LOADING
 LoadTGA
 =============
 */
-static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp ) {
+static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files ) {
 	int		columns, rows, numPixels, fileSize, numBytes;
 	byte	*pixbuf;
 	int		row, column;
@@ -529,7 +790,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 	byte		*targa_rgba;
 
 	if ( !pic ) {
-		fileSystem->ReadFile( name, NULL, timestamp );
+		R_ReadImageFile( files, name, NULL, timestamp );
 		return;	// just getting timestamp
 	}
 
@@ -538,7 +799,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 	//
 	// load the file
 	//
-	fileSize = fileSystem->ReadFile( name, (void **)&buffer, timestamp );
+	fileSize = R_ReadImageFile( files, name, &buffer, timestamp );
 	if ( !buffer ) {
 		return;
 	}
@@ -566,21 +827,29 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 	targa_header.attributes = *buf_p++;
 
 	if ( targa_header.image_type != 2 && targa_header.image_type != 10 && targa_header.image_type != 3 ) {
-		common->Error( "LoadTGA( %s ): Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported\n", name );
+		R_ImageFileError( files, "LoadTGA( %s ): Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 
 	if ( targa_header.colormap_type != 0 ) {
-		common->Error( "LoadTGA( %s ): colormaps not supported\n", name );
+		R_ImageFileError( files, "LoadTGA( %s ): colormaps not supported\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 ) {
-		common->Error( "LoadTGA( %s ): Only 32 or 24 bit images supported (no colormaps)\n", name );
+		R_ImageFileError( files, "LoadTGA( %s ): Only 32 or 24 bit images supported (no colormaps)\n", name );
+		R_FreeImageFile( files, buffer );
+		return;
 	}
 
 	if ( targa_header.image_type == 2 || targa_header.image_type == 3 ) {
 		numBytes = targa_header.width * targa_header.height * ( targa_header.pixel_size >> 3 );
 		if ( numBytes > fileSize - 18 - targa_header.id_length ) {
-			common->Error( "LoadTGA( %s ): incomplete file\n", name );
+			R_ImageFileError( files, "LoadTGA( %s ): incomplete file\n", name );
+			R_FreeImageFile( files, buffer );
+			return;
 		}
 	}
 
@@ -644,7 +913,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 					*pixbuf++ = alphabyte;
 					break;
 				default:
-					common->Error( "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
+					R_ImageFileError( files, "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
 					break;
 				}
 			}
@@ -678,7 +947,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 								alphabyte = *buf_p++;
 								break;
 						default:
-							common->Error( "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
+							R_ImageFileError( files, "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
 							break;
 					}
 
@@ -723,7 +992,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 									*pixbuf++ = alphabyte;
 									break;
 							default:
-								common->Error( "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
+								R_ImageFileError( files, "LoadTGA( %s ): illegal pixel_size '%d'\n", name, targa_header.pixel_size );
 								break;
 						}
 						column++;
@@ -748,7 +1017,12 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 		R_VerticalFlip( *pic, *width, *height );
 	}
 
-	fileSystem->FreeFile( buffer );
+	if ( files && files->HasError() ) {
+		R_StaticFree( *pic );
+		*pic = NULL;
+	}
+
+	R_FreeImageFile( files, buffer );
 }
 
 /*
@@ -756,7 +1030,7 @@ static void LoadTGA( const char *name, byte **pic, int *width, int *height, ID_T
 LoadJPG
 =============
 */
-static void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height, ID_TIME_T *timestamp ) {
+static void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height, ID_TIME_T *timestamp, idImageFiles *files ) {
   /* This struct contains the JPEG decompression parameters and pointers to
    * working space (which is allocated as needed by the JPEG library).
    */
@@ -796,21 +1070,32 @@ static void LoadJPG( const char *filename, unsigned char **pic, int *width, int
 	int len;
 	idFile *f;
 
-	f = fileSystem->OpenFileRead( filename );
-	if ( !f ) {
-		return;
-	}
-	len = f->Length();
-	if ( timestamp ) {
-		*timestamp = f->Timestamp();
-	}
-	if ( !pic ) {
+	if ( files ) {
+		byte *data;
+
+		len = files->ReadFile( filename, &data, timestamp );
+		if ( !data || !pic ) {
+			return;
+		}
+		fbuffer = (byte *)Mem_ClearedAlloc( len + 4096 );
+		memcpy( fbuffer, data, len );
+	} else {
+		f = fileSystem->OpenFileRead( filename );
+		if ( !f ) {
+			return;
+		}
+		len = f->Length();
+		if ( timestamp ) {
+			*timestamp = f->Timestamp();
+		}
+		if ( !pic ) {
+			fileSystem->CloseFile( f );
+			return;	// just getting timestamp
+		}
+		fbuffer = (byte *)Mem_ClearedAlloc( len + 4096 );
+		f->Read( fbuffer, len );
 		fileSystem->CloseFile( f );
-		return;	// just getting timestamp
 	}
-	fbuffer = (byte *)Mem_ClearedAlloc( len + 4096 );
-	f->Read( fbuffer, len );
-	fileSystem->CloseFile( f );
 
   /* Step 1: allocate and initialize JPEG decompression object */
 
@@ -859,7 +1144,7 @@ static void LoadJPG( const char *filename, unsigned char **pic, int *width, int
   /* JSAMPLEs per row in output buffer */
   row_stride = cinfo.output_width * cinfo.output_components;
 
-  if (cinfo.output_components!=4) {
+  if (cinfo.output_components!=4 && !files) {
 		common->DWarning( "JPG %s is unsupported color depth (%d)",
 			filename, cinfo.output_components);
   }
@@ -950,7 +1235,7 @@ If pic is NULL, the image won't actually be loaded, it will just find the
 timestamp.
 =================
 */
-void R_LoadImage( const char *cname, byte **pic, int *width, int *height, ID_TIME_T *timestamp, bool makePowerOf2 ) {
+void R_LoadImage( const char *cname, byte **pic, int *width, int *height, ID_TIME_T *timestamp, bool makePowerOf2, idImageFiles *files ) {
 	idStr name = cname;
 
 	if ( pic ) {
@@ -977,18 +1262,18 @@ void R_LoadImage( const char *cname, byte **pic, int *width, int *height, ID_TIM
 	name.ExtractFileExtension( ext );
 
 	if ( ext == "tga" ) {
-		LoadTGA( name.c_str(), pic, width, height, timestamp );            // try tga first
+		LoadTGA( name.c_str(), pic, width, height, timestamp, files );            // try tga first
 		if ( ( pic && *pic == 0 ) || ( timestamp && *timestamp == -1 ) ) {
 			name.StripFileExtension();
 			name.DefaultFileExtension( ".jpg" );
-			LoadJPG( name.c_str(), pic, width, height, timestamp );
+			LoadJPG( name.c_str(), pic, width, height, timestamp, files );
 		}
 	} else if ( ext == "pcx" ) {
-		LoadPCX32( name.c_str(), pic, width, height, timestamp );
+		LoadPCX32( name.c_str(), pic, width, height, timestamp, files );
 	} else if ( ext == "bmp" ) {
-		LoadBMP( name.c_str(), pic, width, height, timestamp );
+		LoadBMP( name.c_str(), pic, width, height, timestamp, files );
 	} else if ( ext == "jpg" ) {
-		LoadJPG( name.c_str(), pic, width, height, timestamp );
+		LoadJPG( name.c_str(), pic, width, height, timestamp, files );
 	}
 
 	if ( ( width && *width < 1 ) || ( height && *height < 1 ) ) {
@@ -54,6 +54,13 @@ idCVar idImageManager::image_anisotropy( "image_anisotropy", "1", CVAR_RENDERER
 idCVar idImageManager::image_colorMipLevels( "image_colorMipLevels", "0", CVAR_RENDERER | CVAR_BOOL, "development aid to see texture mip usage" );
 idCVar idImageManager::image_preload( "image_preload", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "if 0, dynamically load all images" );
 idCVar idImageManager::image_showBackgroundLoads( "image_showBackgroundLoads", "0", CVAR_RENDERER | CVAR_BOOL, "1 = print number of outstanding background loads" );
+idCVar idImageManager::image_loadJobs( "image_loadJobs", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "build image mip chains on the job threads during level loads" );
+idCVar idImageManager::image_mipGamma( "image_mipGamma", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "filter diffuse mip levels in linear space instead of sRGB" );
+idCVar idImageManager::image_mipNormalize( "image_mipNormalize", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "renormalize the normals of bump map mip levels" );
+idCVar idImageManager::image_useETC2( "image_useETC2", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "compress images to ETC2 on first use and load them from etc2/ after that" );
+idCVar idImageManager::image_residentMegs( "image_residentMegs", "0", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "texture memory budget in megabytes, least recently used images are evicted above it, 0 = no limit" );
+idCVar idImageManager::image_streamPerFrame( "image_streamPerFrame", "4", CVAR_RENDERER | CVAR_INTEGER, "evicted images that start loading again each frame", 1, idImageManager::MAX_STREAM_IMAGES );
+idCVar idImageManager::image_showResidency( "image_showResidency", "0", CVAR_RENDERER | CVAR_BOOL, "print evicted and streamed images" );
 #if 1
 idCVar idImageManager::image_downSize( "image_downSize", "0", CVAR_RENDERER | CVAR_ROM, "controls texture downsampling" );
 idCVar idImageManager::image_forceDownSize( "image_forceDownSize", "0", CVAR_RENDERER | CVAR_ROM | CVAR_BOOL, "" );
@@ -1025,6 +1032,40 @@ void idImage::Reload( bool force ) {
 	ActuallyLoadImage( false );
 }
 
+/*
+===============
+R_CompressImages_f
+
+Builds the ETC2 image cache for all loaded images, so a level can be
+compressed once before it is shipped or played on a device
+===============
+*/
+void R_CompressImages_f( const idCmdArgs &args ) {
+	int		i, count;
+	idImage	*image;
+	bool	useETC2;
+
+	useETC2 = globalImages->image_useETC2.GetBool();
+	globalImages->image_useETC2.SetBool( true );
+
+	count = 0;
+	for ( i = 0 ; i < globalImages->images.Num() ; i++ ) {
+		image = globalImages->images[ i ];
+		if ( image->generatorFunction || image->cubeFiles != CF_2D || image->texnum == idImage::TEXTURE_NOT_LOADED ) {
+			continue;
+		}
+		image->PurgeImage();
+		image->ActuallyLoadImage( false );
+		if ( image->internalFormat == GL_COMPRESSED_RGB8_ETC2 || image->internalFormat == GL_COMPRESSED_RGBA8_ETC2_EAC ) {
+			count++;
+		}
+	}
+
+	globalImages->image_useETC2.SetBool( useETC2 );
+
+	common->Printf( "%i images in the ETC2 cache\n", count );
+}
+
 /*
 ===============
 R_ReloadImages_f
@@ -1580,9 +1621,12 @@ void idImageManager::PurgeAllImages() {
 	int		i;
 	idImage	*image;
 
+	FinishStreaming();
+
 	for ( i = 0; i < images.Num() ; i++ ) {
 		image = images[i];
 		image->PurgeImage();
+		image->FreePlaceholder();
 	}
 }
 
@@ -1739,6 +1783,11 @@ void idImageManager::Init() {
 
 	images.Resize( 1024, 1024 );
 
+	R_InitMipMapTables();
+
+	totalCachedImageSize = 0;
+	numStreamChains = 0;
+
 	// clear the cached LRU
 	cacheLRU.cacheUsageNext = &cacheLRU;
 	cacheLRU.cacheUsagePrev = &cacheLRU;
@@ -1774,6 +1823,7 @@ void idImageManager::Init() {
 	currentRenderImage = ImageFromFunction("_currentRender", R_RGBA8Image );
 
 	cmdSystem->AddCommand( "reloadImages", R_ReloadImages_f, CMD_FL_RENDERER, "reloads images" );
+	cmdSystem->AddCommand( "compressImages", R_CompressImages_f, CMD_FL_RENDERER, "builds the ETC2 image cache for the loaded images" );
 	cmdSystem->AddCommand( "listImages", R_ListImages_f, CMD_FL_RENDERER, "lists images" );
 	cmdSystem->AddCommand( "combineCubeImages", R_CombineCubeImages_f, CMD_FL_RENDERER, "combines six images for roq compression" );
 
@@ -1786,6 +1836,10 @@ Shutdown
 ===============
 */
 void idImageManager::Shutdown() {
+	FinishStreaming();
+	for ( int i = 0; i < images.Num(); i++ ) {
+		images[i]->FreePlaceholder();
+	}
 	images.DeleteContents( true );
 }
 
@@ -1802,6 +1856,9 @@ loading the actual data.
 void idImageManager::BeginLevelLoad() {
 	insideLevelLoad = true;
 
+	// the level load reloads anything that is still evicted
+	FinishStreaming();
+
 	for ( int i = 0 ; i < images.Num() ; i++ ) {
 		idImage	*image = images[ i ];
 
@@ -1857,6 +1914,7 @@ void idImageManager::EndLevelLoad() {
 //			common->Printf( "Purging %s\n", image->imgName.c_str() );
 			purgeCount++;
 			image->PurgeImage();
+			image->FreePlaceholder();
 		} else if ( image->texnum != idImage::TEXTURE_NOT_LOADED ) {
 //			common->Printf( "Keeping %s\n", image->imgName.c_str() );
 			keepCount++;
@@ -1864,6 +1922,15 @@ void idImageManager::EndLevelLoad() {
 	}
 
 	// load the ones we do need, if we are preloading
+	// images are read and decoded here in batches, while the mip chains of
+	// the previous batch are built on the job threads
+	const int	IMAGE_LOAD_BATCH = 16;
+	imageMipChain_t	chains[2][IMAGE_LOAD_BATCH];
+	idJobList	jobLists[2];
+	int			numChains[2] = { 0, 0 };
+	int			batch = 0;
+	bool		useJobs = image_loadJobs.GetBool();
+
 	for ( int i = 0 ; i < images.Num() ; i++ ) {
 		idImage	*image = images[ i ];
 		if ( image->generatorFunction ) {
@@ -1873,7 +1940,22 @@ void idImageManager::EndLevelLoad() {
 		if ( image->levelLoadReferenced && image->texnum == idImage::TEXTURE_NOT_LOADED ) {
 //			common->Printf( "Loading %s\n", image->imgName.c_str() );
 			loadCount++;
-			image->ActuallyLoadImage( false );
+
+			if ( !useJobs || image->cubeFiles != CF_2D ) {
+				image->ActuallyLoadImage( false );
+			} else if ( image->BeginLoadImage( chains[batch][numChains[batch]] ) ) {
+				// draw a stand-in until the batch is uploaded
+				image->streaming = true;
+				jobLists[batch].AddJob( R_BuildMipChainJob, &chains[batch][numChains[batch]] );
+				numChains[batch]++;
+
+				if ( numChains[batch] == IMAGE_LOAD_BATCH ) {
+					jobLists[batch].Submit();
+					batch ^= 1;
+					FinishImageBatch( chains[batch], numChains[batch], jobLists[batch] );
+					numChains[batch] = 0;
+				}
+			}
 
 			if ( ( loadCount & 15 ) == 0 ) {
 				session->PacifierUpdate();
@@ -1884,6 +1966,10 @@ void idImageManager::EndLevelLoad() {
 		}
 	}
 
+	// upload whatever is still being built
+	FinishImageBatch( chains[batch ^ 1], numChains[batch ^ 1], jobLists[batch ^ 1] );
+	FinishImageBatch( chains[batch], numChains[batch], jobLists[batch] );
+
 	int	end = Sys_Milliseconds();
 	common->Printf( "%5i purged from previous\n", purgeCount );
 	common->Printf( "%5i kept from previous\n", keepCount );
@@ -1891,6 +1977,202 @@ void idImageManager::EndLevelLoad() {
 	common->Printf( "all images loaded in %5.1f seconds\n", (end-start) * 0.001 );
 }
 
+/*
+===============
+idImageManager::FinishImageBatch
+
+Waits for the mip chains of a batch and uploads them
+===============
+*/
+void idImageManager::FinishImageBatch( imageMipChain_t *chains, int numChains, idJobList &jobList ) {
+	jobList.Wait();
+
+	for ( int i = 0; i < numChains; i++ ) {
+		chains[i].image->streaming = false;
+		chains[i].image->FinishLoadImage( chains[i] );
+	}
+
+	jobList.Clear();
+}
+
+/*
+===============
+R_CompareImageFrameUsed
+===============
+*/
+static int R_CompareImageFrameUsed( idImage * const *a, idImage * const *b ) {
+	return (*a)->frameUsed - (*b)->frameUsed;
+}
+
+/*
+===============
+idImageManager::UpdateResidency
+
+Evicted images are drawn with their placeholder and queued by Bind. Their
+files are read a few images at a time with idFileSystem::ReadFileAsync, then
+the mip chains are built on the job threads, they are uploaded on a later
+frame once they are done.
+===============
+*/
+void idImageManager::UpdateResidency() {
+	int i;
+
+	// upload the images that finished building
+	if ( numStreamChains > 0 && streamJobs.IsDone() ) {
+		FinishStreamBatch();
+	}
+
+	// build the ones whose files were read
+	if ( numStreamChains == 0 && streamReads.Num() > 0 ) {
+		for ( i = 0; i < streamFiles.Num(); i++ ) {
+			if ( !streamFiles[i]->ReadsDone() ) {
+				break;
+			}
+		}
+		if ( i == streamFiles.Num() ) {
+			for ( i = 0; i < streamReads.Num(); i++ ) {
+				idImage *image = streamReads[i];
+
+				if ( image->texnum != idImage::TEXTURE_NOT_LOADED ) {
+					// already loaded some other way
+					image->streaming = false;
+					delete streamFiles[i];
+				} else if ( image->BeginLoadImage( streamChains[numStreamChains], streamFiles[i] ) ) {
+					streamJobs.AddJob( R_BuildMipChainJob, &streamChains[numStreamChains] );
+					numStreamChains++;
+				} else {
+					image->streaming = false;
+					if ( image->texnum == idImage::TEXTURE_NOT_LOADED ) {
+						// Bind would queue it again every frame
+						common->Warning( "Couldn't stream image: %s", image->imgName.c_str() );
+						image->streamFailed = true;
+					}
+				}
+			}
+			streamReads.Clear();
+			streamFiles.Clear();
+
+			if ( numStreamChains > 0 ) {
+				streamJobs.Submit();
+				if ( Sys_NumJobThreads() == 0 ) {
+					FinishStreamBatch();
+				}
+			}
+		}
+	}
+
+	// start reading the next ones while those build
+	if ( streamReads.Num() == 0 && streamQueue.Num() > 0 ) {
+		int count = Min( streamQueue.Num(), image_streamPerFrame.GetInteger() );
+
+		for ( i = 0; i < count; i++ ) {
+			idImage *image = streamQueue[i];
+
+			if ( image->texnum != idImage::TEXTURE_NOT_LOADED ) {
+				// already loaded some other way
+				image->streaming = false;
+				continue;
+			}
+			if ( image_showResidency.GetBool() ) {
+				common->Printf( "streaming %s\n", image->imgName.c_str() );
+			}
+			idImageFiles *files = new idImageFiles;
+			files->ReadFilesAsync( image->imgName );
+			streamReads.Append( image );
+			streamFiles.Append( files );
+		}
+		for ( i = 0; i < count; i++ ) {
+			streamQueue.RemoveIndex( 0 );
+		}
+	}
+
+	int budget = image_residentMegs.GetInteger() * 1024 * 1024;
+	if ( budget <= 0 || totalCachedImageSize <= budget ) {
+		return;
+	}
+
+	// evict the least recently used images that weren't drawn in the last
+	// few frames until there is some room, so this doesn't happen every frame
+	const int EVICT_FRAMES = 30;
+	idList<idImage *> candidates;
+
+	for ( int i = 0; i < images.Num(); i++ ) {
+		idImage *image = images[i];
+		if ( image->placeholder && image->texnum != idImage::TEXTURE_NOT_LOADED && !image->streaming
+			&& image->frameUsed < backEnd.frameCount - EVICT_FRAMES ) {
+			candidates.Append( image );
+		}
+	}
+	candidates.Sort( R_CompareImageFrameUsed );
+
+	int target = budget - budget / 8;
+	int evictCount = 0;
+	int evictSize = 0;
+	for ( int i = 0; i < candidates.Num() && totalCachedImageSize > target; i++ ) {
+		evictSize += candidates[i]->residentSize;
+		candidates[i]->EvictImage();
+		evictCount++;
+	}
+
+	if ( image_showResidency.GetBool() && evictCount > 0 ) {
+		common->Printf( "evicted %i images, %i kB, %i kB resident\n", evictCount, evictSize >> 10, totalCachedImageSize >> 10 );
+	}
+}
+
+/*
+===============
+idImageManager::StreamImage
+===============
+*/
+void idImageManager::StreamImage( idImage *image ) {
+	if ( image->streaming || image->streamFailed || insideLevelLoad ) {
+		return;
+	}
+	image->streaming = true;
+	streamQueue.Append( image );
+}
+
+/*
+===============
+idImageManager::FinishStreamBatch
+===============
+*/
+void idImageManager::FinishStreamBatch() {
+	if ( numStreamChains == 0 ) {
+		return;
+	}
+	for ( int i = 0; i < numStreamChains; i++ ) {
+		streamChains[i].image->streaming = false;
+	}
+	FinishImageBatch( streamChains, numStreamChains, streamJobs );
+	numStreamChains = 0;
+}
+
+/*
+===============
+idImageManager::FinishStreaming
+===============
+*/
+void idImageManager::FinishStreaming() {
+	FinishStreamBatch();
+
+	// the callbacks of the reads still point at the files
+	for ( int i = 0; i < streamFiles.Num(); i++ ) {
+		while ( !streamFiles[i]->ReadsDone() ) {
+			fileSystem->FinishAsyncReads( false );
+		}
+		delete streamFiles[i];
+		streamReads[i]->streaming = false;
+	}
+	streamReads.Clear();
+	streamFiles.Clear();
+
+	for ( int i = 0; i < streamQueue.Num(); i++ ) {
+		streamQueue[i]->streaming = false;
+	}
+	streamQueue.Clear();
+}
+
 /*
 ===============
 idImageManager::StartBuild
@@ -53,11 +53,16 @@ int idImage::BitsForInternalFormat( int internalFormat ) const {
 	case 2:
 	case 3:
 	case 4:
+	case GL_RGBA:
 		return 32;
 	case GL_RGBA4:
 		return 16;
 	case GL_RGB5_A1:
 		return 16;
+	case GL_COMPRESSED_RGB8_ETC2:
+		return 4;
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		return 8;
 	default:
 		common->Error( "R_BitsForInternalFormat: BAD FORMAT:%i", internalFormat );
 	}
@@ -205,31 +210,12 @@ void idImage::SetImageFilterAndRepeat() const {
 
 /*
 ================
-idImage::Downsize
-helper function that takes the current width/height and might make them smaller
+R_DownsizeImage
+
+Doesn't look at any cvars, so R_BuildMipChain can use it on a job thread
 ================
 */
-void idImage::GetDownsize( int &scaled_width, int &scaled_height ) const {
-	int size = 0;
-
-	// perform optional picmip operation to save texture memory
-	if ( depth == TD_SPECULAR && globalImages->image_downSizeSpecular.GetInteger() ) {
-		size = globalImages->image_downSizeSpecularLimit.GetInteger();
-		if ( size == 0 ) {
-			size = 64;
-		}
-	} else if ( depth == TD_BUMP && globalImages->image_downSizeBump.GetInteger() ) {
-		size = globalImages->image_downSizeBumpLimit.GetInteger();
-		if ( size == 0 ) {
-			size = 64;
-		}
-	} else if ( ( allowDownSize || globalImages->image_forceDownSize.GetBool() ) && globalImages->image_downSize.GetInteger() ) {
-		size = globalImages->image_downSizeLimit.GetInteger();
-		if ( size == 0 ) {
-			size = 256;
-		}
-	}
-
+static void R_DownsizeImage( int &scaled_width, int &scaled_height, int size ) {
 	if ( size > 0 ) {
 		while ( scaled_width > size || scaled_height > size ) {
 			if ( scaled_width > 1 ) {
@@ -261,6 +247,47 @@ void idImage::GetDownsize( int &scaled_width, int &scaled_height ) const {
 	}
 }
 
+/*
+================
+idImage::Downsize
+helper function that takes the current width/height and might make them smaller
+================
+*/
+void idImage::GetDownsize( int &scaled_width, int &scaled_height ) const {
+	R_DownsizeImage( scaled_width, scaled_height, DownsizeLimit() );
+}
+
+/*
+================
+DownsizeLimit
+
+The picmip size from the cvars, 0 if the image keeps its size
+================
+*/
+int idImage::DownsizeLimit() const {
+	int size = 0;
+
+	// perform optional picmip operation to save texture memory
+	if ( depth == TD_SPECULAR && globalImages->image_downSizeSpecular.GetInteger() ) {
+		size = globalImages->image_downSizeSpecularLimit.GetInteger();
+		if ( size == 0 ) {
+			size = 64;
+		}
+	} else if ( depth == TD_BUMP && globalImages->image_downSizeBump.GetInteger() ) {
+		size = globalImages->image_downSizeBumpLimit.GetInteger();
+		if ( size == 0 ) {
+			size = 64;
+		}
+	} else if ( ( allowDownSize || globalImages->image_forceDownSize.GetBool() ) && globalImages->image_downSize.GetInteger() ) {
+		size = globalImages->image_downSizeLimit.GetInteger();
+		if ( size == 0 ) {
+			size = 256;
+		}
+	}
+
+	return size;
+}
+
 /*
 ================
 GenerateImage
@@ -293,11 +320,28 @@ There is no way to specify explicit mip map levels
 void idImage::GenerateImage( const byte *pic, int width, int height,
 					   textureFilter_t filterParm, bool allowDownSizeParm,
 					   textureRepeat_t repeatParm, textureDepth_t depthParm ) {
-	bool	preserveBorder;
-	byte		*scaledBuffer;
-	int			scaled_width, scaled_height;
-	byte		*shrunk;
+	imageMipChain_t	chain;
+
+	if ( !BeginGenerateImage( chain, pic, width, height, filterParm, allowDownSizeParm, repeatParm, depthParm ) ) {
+		return;
+	}
+	R_BuildMipChain( chain );
+	FinishGenerateImage( chain );
+}
+
+/*
+================
+BeginGenerateImage
 
+Sets the parameters and reads the settings for the upload size, everything
+that needs cvars is done here so R_BuildMipChain can run on a job thread.
+pic is NULL if R_BuildMipChain decodes it from the chain's files.
+Returns false if there is nothing to build.
+================
+*/
+bool idImage::BeginGenerateImage( imageMipChain_t &chain, const byte *pic, int width, int height,
+					   textureFilter_t filterParm, bool allowDownSizeParm,
+					   textureRepeat_t repeatParm, textureDepth_t depthParm ) {
 	PurgeImage();
 
 	filter = filterParm;
@@ -310,45 +354,89 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 	// an image match from a shader before OpenGL starts would miss
 	// the generated texture
 	if ( !glConfig.isInitialized ) {
-		return;
+		return false;
 	}
 
-	// don't let mip mapping smear the texture into the clamped border
-	if ( repeat == TR_CLAMP_TO_ZERO ) {
-		preserveBorder = true;
-	} else {
-		preserveBorder = false;
+	// make sure it is a power of 2, the image files are made one when they are loaded
+	if ( pic && ( MakePowerOfTwo( width ) != width || MakePowerOfTwo( height ) != height ) ) {
+		common->Error( "R_CreateImage: not a power of 2 image" );
 	}
 
-	// make sure it is a power of 2
-	scaled_width = MakePowerOfTwo( width );
-	scaled_height = MakePowerOfTwo( height );
+	memset( &chain, 0, sizeof( chain ) );
+	chain.image = this;
+	chain.pic = pic;
+	chain.width = width;
+	chain.height = height;
+	chain.downSizeLimit = DownsizeLimit();
+	chain.repeat = repeat;
+	chain.depth = depth;
+	chain.colorMipLevels = ( depth == TD_DIFFUSE && globalImages->image_colorMipLevels.GetBool() );
+	chain.gammaMips = ( depth == TD_DIFFUSE && globalImages->image_mipGamma.GetBool() );
+	chain.normalizeMips = ( depth == TD_BUMP && globalImages->image_mipNormalize.GetBool() );
 
-	if ( scaled_width != width || scaled_height != height ) {
-		common->Error( "R_CreateImage: not a power of 2 image" );
+	if ( generatorFunction == NULL && ( (depth == TD_BUMP && globalImages->image_writeNormalTGA.GetBool()) || (depth != TD_BUMP && globalImages->image_writeTGA.GetBool()) ) ) {
+		chain.keepUnswizzled = true;
 	}
 
-	// Optionally modify our width/height based on options/hardware
-	GetDownsize( scaled_width, scaled_height );
+	return true;
+}
+
+/*
+================
+R_BuildMipChain
 
-	scaledBuffer = NULL;
+Decodes the picture if the chain has files, resamples it down to the upload
+size and builds all mip levels. Only touches the chain, so this is safe to
+run on a job thread.
+================
+*/
+void R_BuildMipChain( imageMipChain_t &chain ) {
+	bool	preserveBorder;
+	byte	*scaledBuffer;
+	byte	*shrunk;
 
-	// generate the texture number
-	qglGenTextures( 1, &texnum );
+	if ( chain.files ) {
+		byte *pic;
 
-	// select proper internal format before we resample
-	internalFormat = GL_RGBA;
+		R_LoadImageProgram( chain.image->imgName, &pic, &chain.width, &chain.height, NULL, NULL, chain.files );
+		chain.pic = pic;
+		if ( !pic ) {
+			// FinishLoadImage makes it a default image
+			return;
+		}
+	}
+
+	int		width = chain.width;
+	int		height = chain.height;
+	int		scaled_width = width;
+	int		scaled_height = height;
+
+	// Optionally modify our width/height based on options/hardware
+	R_DownsizeImage( scaled_width, scaled_height, chain.downSizeLimit );
+
+	if ( chain.hashPic ) {
+		// build a hash for checking duplicate image files
+		// NOTE: takes about 10% of image load times (SD)
+		chain.imageHash = MD4_BlockChecksum( chain.pic, width * height * 4 );
+	}
+
+	// don't let mip mapping smear the texture into the clamped border
+	if ( chain.repeat == TR_CLAMP_TO_ZERO ) {
+		preserveBorder = true;
+	} else {
+		preserveBorder = false;
+	}
 
 	// copy or resample data as appropriate for first MIP level
 	if ( ( scaled_width == width ) && ( scaled_height == height ) ) {
 		// we must copy even if unchanged, because the border zeroing
 		// would otherwise modify const data
 		scaledBuffer = (byte *)R_StaticAlloc( sizeof( unsigned ) * scaled_width * scaled_height );
-		memcpy (scaledBuffer, pic, width*height*4);
+		memcpy (scaledBuffer, chain.pic, width*height*4);
 	} else {
 		// resample down as needed (FIXME: this doesn't seem like it resamples anymore!)
 		// scaledBuffer = R_ResampleTexture( pic, width, height, width >>= 1, height >>= 1 );
-		scaledBuffer = R_MipMap( pic, width, height, preserveBorder );
+		scaledBuffer = R_MipMap( chain.pic, width, height, preserveBorder );
 		width >>= 1;
 		height >>= 1;
 		if ( width < 1 ) {
@@ -378,20 +466,19 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		scaled_height = height;
 	}
 
-	uploadHeight = scaled_height;
-	uploadWidth = scaled_width;
-	type = TT_2D;
+	chain.scaledWidth = scaled_width;
+	chain.scaledHeight = scaled_height;
 
 	// zero the border if desired, allowing clamped projection textures
 	// even after picmip resampling or careless artists.
-	if ( repeat == TR_CLAMP_TO_ZERO ) {
+	if ( chain.repeat == TR_CLAMP_TO_ZERO ) {
 		byte	rgba[4];
 
 		rgba[0] = rgba[1] = rgba[2] = 0;
 		rgba[3] = 255;
 		R_SetBorderTexels( (byte *)scaledBuffer, width, height, rgba );
 	}
-	if ( repeat == TR_CLAMP_TO_ZERO_ALPHA ) {
+	if ( chain.repeat == TR_CLAMP_TO_ZERO_ALPHA ) {
 		byte	rgba[4];
 
 		rgba[0] = rgba[1] = rgba[2] = 255;
@@ -399,59 +486,33 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		R_SetBorderTexels( (byte *)scaledBuffer, width, height, rgba );
 	}
 
-	if ( generatorFunction == NULL && ( (depth == TD_BUMP && globalImages->image_writeNormalTGA.GetBool()) || (depth != TD_BUMP && globalImages->image_writeTGA.GetBool()) ) ) {
-		// Optionally write out the texture to a .tga
-		char filename[MAX_IMAGE_NAME];
-		ImageProgramStringToCompressedFileName( imgName, filename );
-		char *ext = strrchr(filename, '.');
-		if ( ext ) {
-			strcpy( ext, ".tga" );
-			// swap the red/alpha for the write
-			/*
-			if ( depth == TD_BUMP ) {
-				for ( int i = 0; i < scaled_width * scaled_height * 4; i += 4 ) {
-					scaledBuffer[ i ] = scaledBuffer[ i + 3 ];
-					scaledBuffer[ i + 3 ] = 0;
-				}
-			}
-			*/
-			R_WriteTGA( filename, scaledBuffer, scaled_width, scaled_height, false );
-
-			// put it back
-			/*
-			if ( depth == TD_BUMP ) {
-				for ( int i = 0; i < scaled_width * scaled_height * 4; i += 4 ) {
-					scaledBuffer[ i + 3 ] = scaledBuffer[ i ];
-					scaledBuffer[ i ] = 0;
-				}
-			}
-			*/
-		}
+	// the debug .tga is written from the data before the swizzle
+	if ( chain.keepUnswizzled ) {
+		chain.unswizzled = (byte *)R_StaticAlloc( scaled_width * scaled_height * 4 );
+		memcpy( chain.unswizzled, scaledBuffer, scaled_width * scaled_height * 4 );
 	}
 
 	// swap the red and alpha for rxgb support
 	// do this even on tga normal maps so we only have to use
 	// one fragment program
-	if ( depth == TD_BUMP ) {
+	if ( chain.depth == TD_BUMP ) {
 		for ( int i = 0; i < scaled_width * scaled_height * 4; i += 4 ) {
 			scaledBuffer[ i + 3 ] = scaledBuffer[ i ];
 			scaledBuffer[ i ] = 0;
 		}
 	}
-	// upload the main image level
-	Bind();
-
-
-	qglTexImage2D( GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
 
-	// create and upload the mip map levels, which we do in all cases, even if we don't think they are needed
-	int		miplevel;
+	chain.levels[0] = scaledBuffer;
+	chain.numLevels = 1;
 
-	miplevel = 0;
+	// create the mip map levels, which we do in all cases, even if we don't think they are needed
 	while ( scaled_width > 1 || scaled_height > 1 ) {
 		// preserve the border after mip map unless repeating
-		shrunk = R_MipMap( scaledBuffer, scaled_width, scaled_height, preserveBorder );
-		R_StaticFree( scaledBuffer );
+		if ( chain.gammaMips ) {
+			shrunk = R_MipMapGamma( scaledBuffer, scaled_width, scaled_height, preserveBorder );
+		} else {
+			shrunk = R_MipMap( scaledBuffer, scaled_width, scaled_height, preserveBorder );
+		}
 		scaledBuffer = shrunk;
 
 		scaled_width >>= 1;
@@ -462,27 +523,135 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		if ( scaled_height < 1 ) {
 			scaled_height = 1;
 		}
-		miplevel++;
+
+		// averaging shortens the normals, which darkens distant bumpy surfaces
+		if ( chain.normalizeMips ) {
+			R_RenormalizeRXGB( (byte *)scaledBuffer, scaled_width * scaled_height );
+		}
 
 		// this is a visualization tool that shades each mip map
 		// level with a different color so you can see the
 		// rasterizer's texture level selection algorithm
 		// Changing the color doesn't help with lumminance/alpha/intensity formats...
-		if ( depth == TD_DIFFUSE && globalImages->image_colorMipLevels.GetBool() ) {
-			R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
+		if ( chain.colorMipLevels ) {
+			R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[chain.numLevels] );
 		}
 
-		// upload the mip map
-			qglTexImage2D( GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height,
-				0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+		chain.levels[chain.numLevels++] = scaledBuffer;
 	}
 
-	if ( scaledBuffer != 0 ) {
-		R_StaticFree( scaledBuffer );
+	if ( chain.compress ) {
+		// bump maps keep x in alpha, everything else only
+		// needs the alpha block if it isn't opaque
+		bool alpha = ( chain.depth == TD_BUMP );
+		for ( int i = 3; i < chain.scaledWidth * chain.scaledHeight * 4 && !alpha; i += 4 ) {
+			if ( chain.levels[0][i] != 255 ) {
+				alpha = true;
+			}
+		}
+		chain.compressedFormat = alpha ? GL_COMPRESSED_RGBA8_ETC2_EAC : GL_COMPRESSED_RGB8_ETC2;
+
+		scaled_width = chain.scaledWidth;
+		scaled_height = chain.scaledHeight;
+		for ( int i = 0; i < chain.numLevels; i++ ) {
+			chain.levelSizes[i] = R_ETC2LevelSize( scaled_width, scaled_height, alpha );
+			byte *compressed = (byte *)R_StaticAlloc( chain.levelSizes[i] );
+			R_CompressETC2( compressed, chain.levels[i], scaled_width, scaled_height, alpha );
+			R_StaticFree( chain.levels[i] );
+			chain.levels[i] = compressed;
+
+			scaled_width = Max( scaled_width >> 1, 1 );
+			scaled_height = Max( scaled_height >> 1, 1 );
+		}
 	}
+}
+
+/*
+================
+R_BuildMipChainJob
+================
+*/
+void R_BuildMipChainJob( void *data ) {
+	R_BuildMipChain( *(imageMipChain_t *)data );
+}
+
+/*
+================
+FinishGenerateImage
+
+Uploads a mip chain built by R_BuildMipChain and frees it
+================
+*/
+void idImage::FinishGenerateImage( imageMipChain_t &chain ) {
+	int		scaled_width = chain.scaledWidth;
+	int		scaled_height = chain.scaledHeight;
+
+	uploadHeight = scaled_height;
+	uploadWidth = scaled_width;
+	type = TT_2D;
+
+	if ( chain.unswizzled ) {
+		// Optionally write out the texture to a .tga
+		char filename[MAX_IMAGE_NAME];
+		ImageProgramStringToCompressedFileName( imgName, filename );
+		char *ext = strrchr(filename, '.');
+		if ( ext ) {
+			strcpy( ext, ".tga" );
+			R_WriteTGA( filename, chain.unswizzled, scaled_width, scaled_height, false );
+		}
+		R_StaticFree( chain.unswizzled );
+		chain.unswizzled = NULL;
+	}
+
+	// generate the texture number
+	qglGenTextures( 1, &texnum );
+
+	if ( chain.compressedFormat ) {
+		WriteCachedImage( chain );
+	}
+
+	// a streamed image replaces its placeholder
+	PurgeImage();
+	FreePlaceholder();
+
+	// select proper internal format before we resample
+	internalFormat = chain.compressedFormat ? chain.compressedFormat : GL_RGBA;
+
+	// keep the smallest levels of file images around in case they are evicted,
+	// image_residentMegs can be lowered at any time
+	if ( chain.hashPic ) {
+		KeepPlaceholder( chain.levels, chain.numLevels, scaled_width, scaled_height );
+	}
+
+	// upload the main image level
+	Bind();
+
+	for ( int miplevel = 0; miplevel < chain.numLevels; miplevel++ ) {
+		if ( chain.compressedFormat ) {
+			qglCompressedTexImage2D( GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height,
+				0, chain.levelSizes[miplevel], chain.levels[miplevel] );
+		} else {
+			qglTexImage2D( GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height,
+				0, GL_RGBA, GL_UNSIGNED_BYTE, chain.levels[miplevel] );
+		}
+		R_StaticFree( chain.levels[miplevel] );
+		chain.levels[miplevel] = NULL;
+
+		scaled_width >>= 1;
+		scaled_height >>= 1;
+		if ( scaled_width < 1 ) {
+			scaled_width = 1;
+		}
+		if ( scaled_height < 1 ) {
+			scaled_height = 1;
+		}
+	}
+	chain.numLevels = 0;
 
 	SetImageFilterAndRepeat();
 
+	SetResidentSize();
+
 	// see if we messed anything up
 	GL_CheckErrors();
 }
@@ -596,6 +765,8 @@ void idImage::GenerateCubeImage( const byte *pic[6], int size,
 		miplevel++;
 	}
 
+	SetResidentSize();
+
 	// see if we messed anything up
 	GL_CheckErrors();
 }
@@ -640,6 +811,248 @@ void idImage::ImageProgramStringToCompressedFileName( const char *imageProg, cha
 	strcat( fileName, ".dds" );
 }
 
+/*
+================
+ImageProgramStringToCacheFileName
+================
+*/
+void idImage::ImageProgramStringToCacheFileName( const char *imageProg, char *fileName ) const {
+	char	ddsName[MAX_IMAGE_NAME];
+	idStr	name;
+
+	ImageProgramStringToCompressedFileName( imageProg, ddsName );
+	name = "etc2/";
+	name += ddsName + 4;	// skip dds/
+	name.SetFileExtension( "etc2" );
+	idStr::Copynz( fileName, name.c_str(), MAX_IMAGE_NAME );
+}
+
+/*
+================
+R_ImageCacheMipFlags
+================
+*/
+static int R_ImageCacheMipFlags( textureDepth_t depth ) {
+	int	flags = 0;
+
+	if ( depth == TD_DIFFUSE && globalImages->image_mipGamma.GetBool() ) {
+		flags |= IMAGE_CACHE_GAMMA_MIPS;
+	}
+	if ( depth == TD_BUMP && globalImages->image_mipNormalize.GetBool() ) {
+		flags |= IMAGE_CACHE_NORMALIZE_MIPS;
+	}
+	return flags;
+}
+
+/*
+================
+WriteCachedImage
+
+Writes a compressed mip chain built by R_BuildMipChain to the image cache
+================
+*/
+void idImage::WriteCachedImage( const imageMipChain_t &chain ) const {
+	char				filename[MAX_IMAGE_NAME];
+	imageCacheHeader_t	header;
+	int					requestWidth, requestHeight;
+	int					size, i;
+	byte				*data, *data_p;
+
+	requestWidth = chain.width;
+	requestHeight = chain.height;
+	GetDownsize( requestWidth, requestHeight );
+
+	header.magic = LittleInt( IMAGE_CACHE_MAGIC );
+	header.version = LittleInt( IMAGE_CACHE_VERSION );
+	header.sourceCRC = LittleInt( chain.files->Checksum() );
+	header.sourceWidth = LittleInt( chain.width );
+	header.sourceHeight = LittleInt( chain.height );
+	header.requestWidth = LittleInt( requestWidth );
+	header.requestHeight = LittleInt( requestHeight );
+	header.width = LittleInt( chain.scaledWidth );
+	header.height = LittleInt( chain.scaledHeight );
+	header.depth = LittleInt( chain.depth );
+	header.repeat = LittleInt( chain.repeat );
+	header.mipFlags = LittleInt( R_ImageCacheMipFlags( chain.depth ) );
+	header.imageHash = LittleInt( chain.imageHash );
+	header.internalFormat = LittleInt( chain.compressedFormat );
+	header.numLevels = LittleInt( chain.numLevels );
+
+	size = sizeof( header );
+	for ( i = 0; i < chain.numLevels; i++ ) {
+		size += sizeof( int ) + chain.levelSizes[i];
+	}
+
+	data = (byte *)R_StaticAlloc( size );
+	memcpy( data, &header, sizeof( header ) );
+	data_p = data + sizeof( header );
+	for ( i = 0; i < chain.numLevels; i++ ) {
+		int levelSize = LittleInt( chain.levelSizes[i] );
+		memcpy( data_p, &levelSize, sizeof( int ) );
+		data_p += sizeof( int );
+		memcpy( data_p, chain.levels[i], chain.levelSizes[i] );
+		data_p += chain.levelSizes[i];
+	}
+
+	ImageProgramStringToCacheFileName( imgName, filename );
+	fileSystem->WriteFile( filename, data, size );
+
+	R_StaticFree( data );
+}
+
+/*
+================
+LoadCachedImage
+
+Uploads the compressed mip chain from the image cache if it was built
+from the current source files with the current settings.
+Returns false if the image needs to be generated.
+================
+*/
+bool idImage::LoadCachedImage( unsigned int sourceCRC ) {
+	char				filename[MAX_IMAGE_NAME];
+	imageCacheHeader_t	header;
+	textureDepth_t		oldDepth;
+	int					requestWidth, requestHeight;
+	int					scaled_width, scaled_height;
+	int					len, i;
+	byte				*data, *data_p;
+
+	if ( !glConfig.isInitialized ) {
+		return false;
+	}
+
+	if ( timestamp == FILE_NOT_FOUND_TIMESTAMP ) {
+		return false;
+	}
+
+	ImageProgramStringToCacheFileName( imgName, filename );
+	len = fileSystem->ReadFile( filename, (void **)&data, NULL );
+	if ( len < (int)sizeof( header ) ) {
+		if ( data ) {
+			fileSystem->FreeFile( data );
+		}
+		return false;
+	}
+
+	memcpy( &header, data, sizeof( header ) );
+	header.magic = LittleInt( header.magic );
+	header.version = LittleInt( header.version );
+	header.sourceCRC = LittleInt( header.sourceCRC );
+	header.sourceWidth = LittleInt( header.sourceWidth );
+	header.sourceHeight = LittleInt( header.sourceHeight );
+	header.requestWidth = LittleInt( header.requestWidth );
+	header.requestHeight = LittleInt( header.requestHeight );
+	header.width = LittleInt( header.width );
+	header.height = LittleInt( header.height );
+	header.depth = LittleInt( header.depth );
+	header.repeat = LittleInt( header.repeat );
+	header.mipFlags = LittleInt( header.mipFlags );
+	header.imageHash = LittleInt( header.imageHash );
+	header.internalFormat = LittleInt( header.internalFormat );
+	header.numLevels = LittleInt( header.numLevels );
+
+	if ( header.magic != IMAGE_CACHE_MAGIC || header.version != IMAGE_CACHE_VERSION
+		|| header.sourceCRC != sourceCRC || header.repeat != repeat
+		|| header.numLevels < 1 || header.numLevels > MAX_TEXTURE_LEVELS
+		|| header.mipFlags != R_ImageCacheMipFlags( (textureDepth_t)header.depth ) ) {
+		fileSystem->FreeFile( data );
+		return false;
+	}
+
+	// the downsize settings depend on the depth an image program may have set
+	oldDepth = depth;
+	depth = (textureDepth_t)header.depth;
+	requestWidth = header.sourceWidth;
+	requestHeight = header.sourceHeight;
+	GetDownsize( requestWidth, requestHeight );
+	if ( requestWidth != header.requestWidth || requestHeight != header.requestHeight ) {
+		depth = oldDepth;
+		fileSystem->FreeFile( data );
+		return false;
+	}
+
+	// only what WriteCachedImage produces goes to GL
+	bool alpha = ( header.internalFormat == GL_COMPRESSED_RGBA8_ETC2_EAC );
+	if ( ( header.internalFormat != GL_COMPRESSED_RGB8_ETC2 && !alpha )
+		|| header.width < 1 || header.width > glConfig.maxTextureSize
+		|| header.height < 1 || header.height > glConfig.maxTextureSize ) {
+		common->Warning( "Bad image cache file: %s", filename );
+		depth = oldDepth;
+		fileSystem->FreeFile( data );
+		return false;
+	}
+
+	// make sure all the levels are there and have the right size before touching GL
+	int remaining = len - (int)sizeof( header );
+	scaled_width = header.width;
+	scaled_height = header.height;
+	data_p = data + sizeof( header );
+	for ( i = 0; i < header.numLevels; i++ ) {
+		int levelSize;
+		if ( remaining < (int)sizeof( int ) ) {
+			break;
+		}
+		memcpy( &levelSize, data_p, sizeof( int ) );
+		levelSize = LittleInt( levelSize );
+		if ( levelSize != R_ETC2LevelSize( scaled_width, scaled_height, alpha ) || levelSize > remaining - (int)sizeof( int ) ) {
+			break;
+		}
+		data_p += sizeof( int ) + levelSize;
+		remaining -= sizeof( int ) + levelSize;
+
+		scaled_width = Max( scaled_width >> 1, 1 );
+		scaled_height = Max( scaled_height >> 1, 1 );
+	}
+	if ( i < header.numLevels ) {
+		common->Warning( "Truncated or bad image cache file: %s", filename );
+		depth = oldDepth;
+		fileSystem->FreeFile( data );
+		return false;
+	}
+
+	PurgeImage();
+	FreePlaceholder();
+
+	imageHash = header.imageHash;
+	internalFormat = header.internalFormat;
+	uploadWidth = scaled_width = header.width;
+	uploadHeight = scaled_height = header.height;
+	type = TT_2D;
+
+	qglGenTextures( 1, &texnum );
+	Bind();
+
+	const byte *levels[MAX_TEXTURE_LEVELS];
+
+	data_p = data + sizeof( header );
+	for ( i = 0; i < header.numLevels; i++ ) {
+		int levelSize;
+		memcpy( &levelSize, data_p, sizeof( int ) );
+		levelSize = LittleInt( levelSize );
+		data_p += sizeof( int );
+
+		qglCompressedTexImage2D( GL_TEXTURE_2D, i, internalFormat, scaled_width, scaled_height, 0, levelSize, data_p );
+		levels[i] = data_p;
+		data_p += levelSize;
+
+		scaled_width = Max( scaled_width >> 1, 1 );
+		scaled_height = Max( scaled_height >> 1, 1 );
+	}
+
+	KeepPlaceholder( levels, header.numLevels, header.width, header.height );
+
+	fileSystem->FreeFile( data );
+
+	SetImageFilterAndRepeat();
+
+	SetResidentSize();
+
+	GL_CheckErrors();
+
+	return true;
+}
+
 /*
 ==================
 NumLevelsForImageSize
@@ -666,8 +1079,7 @@ On exit, the idImage will have a valid OpenGL texture number that can be bound
 ===============
 */
 void	idImage::ActuallyLoadImage( bool fromBackEnd ) {
-	int		width, height;
-	byte	*pic;
+	int		width;
 
 	// this is the ONLY place generatorFunction will ever be called
 	if ( generatorFunction ) {
@@ -698,27 +1110,82 @@ void	idImage::ActuallyLoadImage( bool fromBackEnd ) {
 			}
 		}
 	} else {
-		// see if we have a pre-generated image file that is
-		// already image processed and compressed
-
-		R_LoadImageProgram( imgName, &pic, &width, &height, &timestamp, &depth );
+		imageMipChain_t	chain;
 
-		if ( pic == NULL ) {
-			common->Warning( "Couldn't load image: %s", imgName.c_str() );
-			MakeDefault();
-			return;
+		// BeginLoadImage uploads the image by itself if it
+		// finds it already compressed in the image cache
+		if ( BeginLoadImage( chain ) ) {
+			R_BuildMipChain( chain );
+			FinishLoadImage( chain );
 		}
+	}
+}
 
-		// build a hash for checking duplicate image files
-		// NOTE: takes about 10% of image load times (SD)
-		// may not be strictly necessary, but some code uses it, so let's leave it in
-		imageHash = MD4_BlockChecksum( pic, width * height * 4 );
+/*
+===============
+BeginLoadImage
+
+The file part of ActuallyLoadImage for a 2D image, the mip chain is left to
+be built by R_BuildMipChain and uploaded by FinishLoadImage.
+The files may have been read ahead with idImageFiles::ReadFilesAsync,
+they are owned by the image from here on.
+Returns false if the image was fully handled here.
+===============
+*/
+bool idImage::BeginLoadImage( imageMipChain_t &chain, idImageFiles *files ) {
+	assert( generatorFunction == NULL && cubeFiles == CF_2D );
+
+	// the files are read here, the image program runs in R_BuildMipChain
+	if ( !files ) {
+		files = new idImageFiles;
+		files->ReadFiles( imgName, &timestamp, &depth );
+	} else {
+		// only looks at the files that were read
+		R_LoadImageProgram( imgName, NULL, NULL, NULL, &timestamp, &depth, files );
+	}
+
+	// see if we have a pre-generated image file that is
+	// already image processed and compressed
+	if ( globalImages->image_useETC2.GetBool() && LoadCachedImage( files->Checksum() ) ) {
+		delete files;
+		return false;
+	}
+
+	if ( !BeginGenerateImage( chain, NULL, 0, 0, filter, allowDownSize, repeat, depth ) ) {
+		delete files;
+		return false;
+	}
+	chain.files = files;
+	chain.hashPic = true;
+	chain.compress = ( globalImages->image_useETC2.GetBool() && !chain.colorMipLevels );
+
+	return true;
+}
+
+/*
+===============
+FinishLoadImage
+===============
+*/
+void idImage::FinishLoadImage( imageMipChain_t &chain ) {
+	if ( !chain.pic ) {
+		// the errors of the job are printed here
+		if ( chain.files->HasError() ) {
+			common->Warning( "%s", chain.files->GetError() );
+		}
+		common->Warning( "Couldn't load image: %s", imgName.c_str() );
+		MakeDefault();
+	} else {
+		imageHash = chain.imageHash;
 
-		GenerateImage( pic, width, height, filter, allowDownSize, repeat, depth );
-		timestamp = timestamp;
+		FinishGenerateImage( chain );
 
-		R_StaticFree( pic );
+		R_StaticFree( (byte *)chain.pic );
+		chain.pic = NULL;
 	}
+
+	delete chain.files;
+	chain.files = NULL;
 }
 
 //=========================================================================================================
@@ -733,6 +1200,143 @@ void idImage::PurgeImage() {
 		qglDeleteTextures( 1, &texnum );	// this should be the ONLY place it is ever called!
 		texnum = TEXTURE_NOT_LOADED;
 	}
+
+	globalImages->totalCachedImageSize -= residentSize;
+	residentSize = 0;
+}
+
+/*
+===============
+SetResidentSize
+
+Called after an upload to count the image against image_residentMegs
+===============
+*/
+void idImage::SetResidentSize() {
+	globalImages->totalCachedImageSize -= residentSize;
+	residentSize = StorageSize();
+	globalImages->totalCachedImageSize += residentSize;
+}
+
+/*
+===============
+R_LevelSize
+===============
+*/
+static int R_LevelSize( int internalFormat, int width, int height ) {
+	if ( internalFormat == GL_COMPRESSED_RGB8_ETC2 ) {
+		return R_ETC2LevelSize( width, height, false );
+	}
+	if ( internalFormat == GL_COMPRESSED_RGBA8_ETC2_EAC ) {
+		return R_ETC2LevelSize( width, height, true );
+	}
+	return width * height * 4;
+}
+
+/*
+===============
+KeepPlaceholder
+
+Copies the levels of a mip chain that are no larger than
+IMAGE_PLACEHOLDER_SIZE, in the current internalFormat
+===============
+*/
+static const int IMAGE_PLACEHOLDER_SIZE = 16;
+
+void idImage::KeepPlaceholder( const byte * const *levels, int numLevels, int width, int height ) {
+	int		first, size, i, w, h;
+
+	FreePlaceholder();
+
+	// find the first small enough level
+	for ( first = 0; first < numLevels - 1; first++ ) {
+		if ( width <= IMAGE_PLACEHOLDER_SIZE && height <= IMAGE_PLACEHOLDER_SIZE ) {
+			break;
+		}
+		width = Max( width >> 1, 1 );
+		height = Max( height >> 1, 1 );
+	}
+
+	size = 0;
+	for ( i = first, w = width, h = height; i < numLevels; i++ ) {
+		size += R_LevelSize( internalFormat, w, h );
+		w = Max( w >> 1, 1 );
+		h = Max( h >> 1, 1 );
+	}
+
+	placeholder = (byte *)R_StaticAlloc( size );
+	placeholderWidth = width;
+	placeholderHeight = height;
+	placeholderLevels = numLevels - first;
+	placeholderFormat = internalFormat;
+
+	size = 0;
+	for ( i = first, w = width, h = height; i < numLevels; i++ ) {
+		int levelSize = R_LevelSize( internalFormat, w, h );
+		memcpy( placeholder + size, levels[i], levelSize );
+		size += levelSize;
+		w = Max( w >> 1, 1 );
+		h = Max( h >> 1, 1 );
+	}
+}
+
+/*
+===============
+UploadPlaceholder
+===============
+*/
+void idImage::UploadPlaceholder() {
+	const byte	*data_p;
+	int			i, w, h;
+
+	if ( placeholderTexnum == TEXTURE_NOT_LOADED ) {
+		qglGenTextures( 1, &placeholderTexnum );
+	}
+	qglBindTexture( GL_TEXTURE_2D, placeholderTexnum );
+
+	data_p = placeholder;
+	for ( i = 0, w = placeholderWidth, h = placeholderHeight; i < placeholderLevels; i++ ) {
+		int levelSize = R_LevelSize( placeholderFormat, w, h );
+		if ( placeholderFormat == GL_RGBA ) {
+			qglTexImage2D( GL_TEXTURE_2D, i, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data_p );
+		} else {
+			qglCompressedTexImage2D( GL_TEXTURE_2D, i, placeholderFormat, w, h, 0, levelSize, data_p );
+		}
+		data_p += levelSize;
+		w = Max( w >> 1, 1 );
+		h = Max( h >> 1, 1 );
+	}
+
+	SetImageFilterAndRepeat();
+}
+
+/*
+===============
+EvictImage
+===============
+*/
+void idImage::EvictImage() {
+	assert( placeholder != NULL );
+
+	PurgeImage();
+	UploadPlaceholder();
+}
+
+/*
+===============
+FreePlaceholder
+===============
+*/
+void idImage::FreePlaceholder() {
+	if ( placeholderTexnum != TEXTURE_NOT_LOADED ) {
+		qglDeleteTextures( 1, &placeholderTexnum );
+		placeholderTexnum = TEXTURE_NOT_LOADED;
+	}
+	if ( placeholder ) {
+		R_StaticFree( placeholder );
+		placeholder = NULL;
+	}
+	streamFailed = false;
 }
 
 /*
@@ -746,6 +1350,22 @@ void idImage::Bind() {
 	// load the image if necessary (FIXME: not SMP safe!)
 	if ( texnum == TEXTURE_NOT_LOADED ) {
 
+		if ( placeholderTexnum != TEXTURE_NOT_LOADED ) {
+			// evicted, draw the placeholder until it is streamed back in
+			globalImages->StreamImage( this );
+			frameUsed = backEnd.frameCount;
+			bindCount++;
+			qglBindTexture( GL_TEXTURE_2D, placeholderTexnum );
+			return;
+		}
+
+		if ( streaming ) {
+			// the mip chain is still being built by a level load batch,
+			// the loading screen can draw before it is uploaded
+			globalImages->blackImage->Bind();
+			return;
+		}
+
 		// load the image on demand here, which isn't our normal game operating mode
 		ActuallyLoadImage( true );
 	}
@@ -775,6 +1395,22 @@ void idImage::BindFragment() {
 
 	// load the image if necessary (FIXME: not SMP safe!)
 	if ( texnum == TEXTURE_NOT_LOADED ) {
+		if ( placeholderTexnum != TEXTURE_NOT_LOADED ) {
+			// evicted, draw the placeholder until it is streamed back in
+			globalImages->StreamImage( this );
+			frameUsed = backEnd.frameCount;
+			bindCount++;
+			qglBindTexture( GL_TEXTURE_2D, placeholderTexnum );
+			return;
+		}
+
+		if ( streaming ) {
+			// the mip chain is still being built by a level load batch,
+			// the loading screen can draw before it is uploaded
+			globalImages->blackImage->BindFragment();
+			return;
+		}
+
 		// load the image on demand here, which isn't our normal game operating mode
 		ActuallyLoadImage( true );
 	}
@@ -978,6 +1614,31 @@ void idImage::UploadScratch( const byte *data, int cols, int rows ) {
 	}
 }
 
+/*
+====================
+UploadSubImage
+
+The image must already be a 2D RGBA image of at least x + width by y + height
+====================
+*/
+void idImage::UploadSubImage( const byte *pic, int x, int y, int width, int height ) {
+	Bind();
+
+	qglTexSubImage2D( GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pic );
+}
+
+/*
+====================
+GenerateMipmaps
+
+Rebuilds the lower levels from the first one after UploadSubImage
+====================
+*/
+void idImage::GenerateMipmaps() {
+	Bind();
+
+	qglGenerateMipmap( GL_TEXTURE_2D );
+}
 
 void idImage::SetClassification( int tag ) {
 	classification = tag;
@@ -47,11 +47,10 @@ after resampling to the next lower power of two.
 #define	MAX_DIMENSION	4096
 byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 							int outwidth, int outheight ) {
-	int		i, j;
+	int		i;
 	const byte	*inrow, *inrow2;
 	unsigned int	frac, fracstep;
 	unsigned int	p1[MAX_DIMENSION], p2[MAX_DIMENSION];
-	const byte		*pix1, *pix2, *pix3, *pix4;
 	byte		*out, *out_p;
 
 	if ( outwidth > MAX_DIMENSION ) {
@@ -80,17 +79,7 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 	for (i=0 ; i<outheight ; i++, out_p += outwidth*4 ) {
 		inrow = in + 4 * inwidth * (int)( ( i + 0.25f ) * inheight / outheight );
 		inrow2 = in + 4 * inwidth * (int)( ( i + 0.75f ) * inheight / outheight );
-		frac = fracstep >> 1;
-		for (j=0 ; j<outwidth ; j++) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			out_p[j*4+0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-			out_p[j*4+1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-			out_p[j*4+2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-			out_p[j*4+3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-		}
+		SIMDProcessor->ResampleRowRGBA( out_p, inrow, inrow2, p1, p2, outwidth );
 	}
 
 	return out;
@@ -254,32 +243,31 @@ Should we rewrite the normal as the centered average?
 ================
 */
 void	R_SetAlphaNormalDivergence( byte *in, int width, int height ) {
+	// normalize every texel once instead of once per neighbor
+	idVec3	*normals = (idVec3 *)R_StaticAlloc( width * height * sizeof( idVec3 ) );
+	for ( int i = 0 ; i < width * height ; i++ ) {
+		const byte	*pic_p = in + i * 4;
+		normals[i][0] = ( pic_p[0] - 128 ) / 127;
+		normals[i][1] = ( pic_p[1] - 128 ) / 127;
+		normals[i][2] = ( pic_p[2] - 128 ) / 127;
+		normals[i].Normalize();
+	}
+
 	for ( int y = 0 ; y < height ; y++ ) {
 		for ( int x = 0 ; x < width ; x++ ) {
 			// the divergence is the smallest dot product of any of the eight surrounding texels
-			byte	*pic_p = in + ( y * width + x ) * 4;
-			idVec3	center;
-			center[0] = ( pic_p[0] - 128 ) / 127;
-			center[1] = ( pic_p[1] - 128 ) / 127;
-			center[2] = ( pic_p[2] - 128 ) / 127;
-			center.Normalize();
+			const idVec3	&center = normals[ y * width + x ];
 
 			float	maxDiverge = 1.0;
 
 			// FIXME: this assumes wrap mode, but should handle clamp modes and border colors
 			for ( int yy = -1 ; yy <= 1 ; yy++ ) {
+				const idVec3	*row = normals + ((y+yy)&(height-1)) * width;
 				for ( int xx = -1 ; xx <= 1 ; xx++ ) {
 					if ( yy == 0 && xx == 0 ) {
 						continue;
 					}
-					byte	*corner_p = in + ( ((y+yy)&(height-1)) * width + ((x+xx)&(width-1)) ) * 4;
-					idVec3	corner;
-					corner[0] = ( corner_p[0] - 128 ) / 127;
-					corner[1] = ( corner_p[1] - 128 ) / 127;
-					corner[2] = ( corner_p[2] - 128 ) / 127;
-					corner.Normalize();
-
-					float	diverge = corner * center;
+					float	diverge = row[ (x+xx)&(width-1) ] * center;
 					if ( diverge < maxDiverge ) {
 						maxDiverge = diverge;
 					}
@@ -290,9 +278,11 @@ void	R_SetAlphaNormalDivergence( byte *in, int width, int height ) {
 			if ( maxDiverge < 0 ) {
 				maxDiverge = 0;
 			}
-			pic_p[3] = maxDiverge * 255;
+			in[ ( y * width + x ) * 4 + 3 ] = maxDiverge * 255;
 		}
 	}
+
+	R_StaticFree( normals );
 }
 
 /*
@@ -392,12 +382,12 @@ smeared clamps...
 ================
 */
 byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
-	int		i, j;
+	int		i;
 	const byte	*in_p;
 	byte	*out, *out_p;
-	int		row;
 	byte	border[4];
 	int		newWidth, newHeight;
+	int		srcWidth, srcHeight;
 
 	if ( width < 1 || height < 1 || ( width + height == 2 ) ) {
 		common->FatalError( "R_MipMap called with size %i,%i", width, height );
@@ -408,8 +398,6 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 	border[2] = in[2];
 	border[3] = in[3];
 
-	row = width * 4;
-
 	newWidth = width >> 1;
 	newHeight = height >> 1;
 	if ( !newWidth ) {
@@ -423,6 +411,8 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 
 	in_p = in;
 
+	srcWidth = width;
+	srcHeight = height;
 	width >>= 1;
 	height >>= 1;
 
@@ -446,12 +436,97 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 		return out;
 	}
 
-	for (i=0 ; i<height ; i++, in_p+=row) {
-		for (j=0 ; j<width ; j++, out_p+=4, in_p+=8) {
-			out_p[0] = (in_p[0] + in_p[4] + in_p[row+0] + in_p[row+4])>>2;
-			out_p[1] = (in_p[1] + in_p[5] + in_p[row+1] + in_p[row+5])>>2;
-			out_p[2] = (in_p[2] + in_p[6] + in_p[row+2] + in_p[row+6])>>2;
-			out_p[3] = (in_p[3] + in_p[7] + in_p[row+3] + in_p[row+7])>>2;
+	// box filter each 2x2 block down to one texel
+	SIMDProcessor->MipMapRGBA( out, in, srcWidth, srcHeight );
+
+	// copy the old border texel back around if desired
+	if ( preserveBorder ) {
+		R_SetBorderTexels( out, width, height, border );
+	}
+
+	return out;
+}
+
+/*
+================
+R_InitMipMapTables
+
+R_MipMapGamma converts to linear light through these tables, so they
+are built once on the main thread before any image jobs are started
+================
+*/
+#define	LINEAR_TABLE_BITS	12
+#define	LINEAR_TABLE_SIZE	( 1 << LINEAR_TABLE_BITS )
+
+static unsigned short	sRGBToLinear[256];
+static byte				linearToSRGB[LINEAR_TABLE_SIZE];
+
+void R_InitMipMapTables( void ) {
+	int		i;
+	float	f;
+
+	for ( i = 0 ; i < 256 ; i++ ) {
+		f = i / 255.0f;
+		if ( f <= 0.04045f ) {
+			f = f / 12.92f;
+		} else {
+			f = idMath::Pow( ( f + 0.055f ) / 1.055f, 2.4f );
+		}
+		sRGBToLinear[i] = idMath::FtoiFast( f * ( LINEAR_TABLE_SIZE - 1 ) + 0.5f );
+	}
+
+	for ( i = 0 ; i < LINEAR_TABLE_SIZE ; i++ ) {
+		f = (float)i / ( LINEAR_TABLE_SIZE - 1 );
+		if ( f <= 0.0031308f ) {
+			f = f * 12.92f;
+		} else {
+			f = 1.055f * idMath::Pow( f, 1.0f / 2.4f ) - 0.055f;
+		}
+		linearToSRGB[i] = idMath::ClampInt( 0, 255, idMath::FtoiFast( f * 255.0f + 0.5f ) );
+	}
+}
+
+/*
+================
+R_MipMapGamma
+
+Same as R_MipMap, but the color channels are averaged in linear
+light so bright detail doesn't darken as the texture shrinks.
+Alpha is coverage and is averaged directly.
+================
+*/
+byte *R_MipMapGamma( const byte *in, int width, int height, bool preserveBorder ) {
+	int		i, j;
+	const byte	*in_p, *in_p2;
+	byte	*out, *out_p;
+	int		row;
+	byte	border[4];
+
+	// the degenerate 1 wide and 1 high levels are small enough to not matter
+	if ( width < 2 || height < 2 ) {
+		return R_MipMap( in, width, height, preserveBorder );
+	}
+
+	border[0] = in[0];
+	border[1] = in[1];
+	border[2] = in[2];
+	border[3] = in[3];
+
+	row = width * 4;
+	width >>= 1;
+	height >>= 1;
+
+	out = (byte *)R_StaticAlloc( width * height * 4 );
+	out_p = out;
+
+	for ( i = 0 ; i < height ; i++ ) {
+		in_p = in + i * 2 * row;
+		in_p2 = in_p + row;
+		for ( j = 0 ; j < width ; j++, out_p += 4, in_p += 8, in_p2 += 8 ) {
+			out_p[0] = linearToSRGB[ ( sRGBToLinear[in_p[0]] + sRGBToLinear[in_p[4]] + sRGBToLinear[in_p2[0]] + sRGBToLinear[in_p2[4]] ) >> 2 ];
+			out_p[1] = linearToSRGB[ ( sRGBToLinear[in_p[1]] + sRGBToLinear[in_p[5]] + sRGBToLinear[in_p2[1]] + sRGBToLinear[in_p2[5]] ) >> 2 ];
+			out_p[2] = linearToSRGB[ ( sRGBToLinear[in_p[2]] + sRGBToLinear[in_p[6]] + sRGBToLinear[in_p2[2]] + sRGBToLinear[in_p2[6]] ) >> 2 ];
+			out_p[3] = ( in_p[3] + in_p[7] + in_p2[3] + in_p2[7] ) >> 2;
 		}
 	}
 
@@ -566,6 +641,31 @@ void R_BlendOverTexture( byte *data, int pixelCount, const byte blend[4] ) {
 	}
 }
 
+/*
+==================
+R_RenormalizeRXGB
+
+Rescales the normals of a mip level that has already been swizzled
+for rxgb, so X is in alpha, Y in green and Z in blue
+==================
+*/
+void R_RenormalizeRXGB( byte *data, int pixelCount ) {
+	int		i;
+	idVec3	n;
+
+	for ( i = 0 ; i < pixelCount ; i++, data+=4 ) {
+		n[0] = ( data[3] - 128 ) / 127.0f;
+		n[1] = ( data[1] - 128 ) / 127.0f;
+		n[2] = ( data[2] - 128 ) / 127.0f;
+		if ( n.Normalize() == 0.0f ) {
+			continue;
+		}
+		data[3] = idMath::ClampInt( 0, 255, idMath::FtoiFast( n[0] * 127.0f + 128.0f ) );
+		data[1] = idMath::ClampInt( 0, 255, idMath::FtoiFast( n[1] * 127.0f + 128.0f ) );
+		data[2] = idMath::ClampInt( 0, 255, idMath::FtoiFast( n[2] * 127.0f + 128.0f ) );
+	}
+}
+
 
 /*
 ==================
@@ -330,20 +330,25 @@ static void R_ImageAdd( byte *data1, int width1, int height1, byte *data2, int w
 }
 
 
-// we build a canonical token form of the image program here
+// R_ParsePastImageProgram builds a canonical token form of the image program here
 static char parseBuffer[MAX_IMAGE_NAME];
 
 /*
 ===================
 AppendToken
+
+buffer is NULL when the program is loaded, which may happen on a job thread
 ===================
 */
-static void AppendToken( idToken &token ) {
+static void AppendToken( char *buffer, idToken &token ) {
+	if ( !buffer ) {
+		return;
+	}
 	// add a leading space if not at the beginning
-	if ( parseBuffer[0] ) {
-		idStr::Append( parseBuffer, MAX_IMAGE_NAME, " " );
+	if ( buffer[0] ) {
+		idStr::Append( buffer, MAX_IMAGE_NAME, " " );
 	}
-	idStr::Append( parseBuffer, MAX_IMAGE_NAME, token.c_str() );
+	idStr::Append( buffer, MAX_IMAGE_NAME, token.c_str() );
 }
 
 /*
@@ -351,12 +356,12 @@ static void AppendToken( idToken &token ) {
 MatchAndAppendToken
 ===================
 */
-static void MatchAndAppendToken( idLexer &src, const char *match ) {
-	if ( !src.ExpectTokenString( match ) ) {
+static void MatchAndAppendToken( char *buffer, idLexer &src, const char *match ) {
+	if ( !src.ExpectTokenString( match ) || !buffer ) {
 		return;
 	}
 	// a matched token won't need a leading space
-	idStr::Append( parseBuffer, MAX_IMAGE_NAME, match );
+	idStr::Append( buffer, MAX_IMAGE_NAME, match );
 }
 
 /*
@@ -366,39 +371,41 @@ R_ParseImageProgram_r
 If pic is NULL, the timestamps will be filled in, but no image will be generated
 If both pic and timestamps are NULL, it will just advance past it, which can be
 used to parse an image program from a text stream.
+The canonical form is appended to buffer if it isn't NULL.
 ===================
 */
-static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *height,
-								  ID_TIME_T *timestamps, textureDepth_t *depth ) {
+static bool R_ParseImageProgram_r( char *buffer, idLexer &src, byte **pic, int *width, int *height,
+								  ID_TIME_T *timestamps, textureDepth_t *depth, idImageFiles *files ) {
 	idToken		token;
 	float		scale;
 	ID_TIME_T		timestamp;
 
 	src.ReadToken( &token );
-	AppendToken( token );
+	AppendToken( buffer, token );
 
 	if ( !token.Icmp( "heightmap" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
 		src.ReadToken( &token );
-		AppendToken( token );
+		AppendToken( buffer, token );
 		scale = token.GetFloatValue();
 
 		// process it
 		if ( pic ) {
 			R_HeightmapToNormalMap( *pic, *width, *height, scale );
-			if ( depth ) {
-				*depth = TD_BUMP;
-			}
+		}
+		// also without pic, so idImageFiles::ReadFiles gets the depth
+		if ( depth ) {
+			*depth = TD_BUMP;
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -406,15 +413,15 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		byte	*pic2;
 		int		width2, height2;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
-		if ( !R_ParseImageProgram_r( src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth, files ) ) {
 			if ( pic ) {
 				R_StaticFree( *pic );
 				*pic = NULL;
@@ -426,30 +433,30 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		if ( pic ) {
 			R_AddNormalMaps( *pic, *width, *height, pic2, width2, height2 );
 			R_StaticFree( pic2 );
-			if ( depth ) {
-				*depth = TD_BUMP;
-			}
+		}
+		if ( depth ) {
+			*depth = TD_BUMP;
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "smoothnormals" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files ) ) {
 			return false;
 		}
 
 		if ( pic ) {
 			R_SmoothNormalMap( *pic, *width, *height );
-			if ( depth ) {
-				*depth = TD_BUMP;
-			}
+		}
+		if ( depth ) {
+			*depth = TD_BUMP;
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -457,15 +464,15 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		byte	*pic2;
 		int		width2, height2;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
-		if ( !R_ParseImageProgram_r( src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth, files ) ) {
 			if ( pic ) {
 				R_StaticFree( *pic );
 				*pic = NULL;
@@ -479,7 +486,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			R_StaticFree( pic2 );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -487,14 +494,14 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		float	scale[4];
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files );
 
 		for ( i = 0 ; i < 4 ; i++ ) {
-			MatchAndAppendToken( src, "," );
+			MatchAndAppendToken( buffer, src, "," );
 			src.ReadToken( &token );
-			AppendToken( token );
+			AppendToken( buffer, token );
 			scale[i] = token.GetFloatValue();
 		}
 
@@ -503,44 +510,44 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			R_ImageScale( *pic, *width, *height, scale );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "invertAlpha" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files );
 
 		// process it
 		if ( pic ) {
 			R_InvertAlpha( *pic, *width, *height );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "invertColor" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files );
 
 		// process it
 		if ( pic ) {
 			R_InvertColor( *pic, *width, *height );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "makeIntensity" ) ) {
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files );
 
 		// copy red to green, blue, and alpha
 		if ( pic ) {
@@ -553,16 +560,16 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "makeAlpha" ) ) {
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth, files );
 
 		// average RGB into alpha, then set RGB to white
 		if ( pic ) {
@@ -576,7 +583,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -587,7 +594,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 	}
 
 	// load it as an image
-	R_LoadImage( token.c_str(), pic, width, height, &timestamp, true );
+	R_LoadImage( token.c_str(), pic, width, height, &timestamp, true, files );
 
 	if ( timestamp == -1 ) {
 		return false;
@@ -609,18 +616,23 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 R_LoadImageProgram
 ===================
 */
-void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamps, textureDepth_t *depth ) {
+void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamps, textureDepth_t *depth, idImageFiles *files ) {
 	idLexer src;
+	int		flags = LEXFL_NOFATALERRORS | LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES;
+
+	// the errors were printed when the files were read
+	if ( files && pic ) {
+		flags |= LEXFL_NOERRORS | LEXFL_NOWARNINGS;
+	}
 
 	src.LoadMemory( name, strlen(name), name );
-	src.SetFlags( LEXFL_NOFATALERRORS | LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES );
+	src.SetFlags( flags );
 
-	parseBuffer[0] = 0;
 	if ( timestamps ) {
 		*timestamps = 0;
 	}
 
-	R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+	R_ParseImageProgram_r( NULL, src, pic, width, height, timestamps, depth, files );
 
 	src.FreeSource();
 }
@@ -632,6 +644,6 @@ R_ParsePastImageProgram
 */
 const char *R_ParsePastImageProgram( idLexer &src ) {
 	parseBuffer[0] = 0;
-	R_ParseImageProgram_r( src, NULL, NULL, NULL, NULL, NULL );
+	R_ParseImageProgram_r( parseBuffer, src, NULL, NULL, NULL, NULL, NULL, NULL );
 	return parseBuffer;
 }
@@ -318,6 +318,16 @@ static srfTriangles_t *R_CreateLightTris( const idRenderEntityLocal *ent,
 	newTri->numVerts = tri->numVerts;
 	R_ReferenceStaticTriSurfVerts( newTri, tri );
 
+	// the verts of a surface skinned by the vertex programs are in the bind pose,
+	// so the culling is left to the shadow mapped light scissor
+	if ( tri->skinning ) {
+		newTri->skinning = tri->skinning;
+		R_ReferenceStaticTriSurfIndexes( newTri, tri );
+		newTri->numIndexes = tri->numIndexes;
+		newTri->bounds = tri->bounds;
+		return newTri;
+	}
+
 	// calculate cull information
 	if ( !includeBackFaces ) {
 		R_CalcInteractionFacing( ent, tri, light, cullInfo );
@@ -448,6 +458,7 @@ idInteraction::idInteraction( void ) {
 	lightPrev				= NULL;
 	entityNext				= NULL;
 	entityPrev				= NULL;
+	tableIndex				= -1;
 	dynamicModelFrameCount	= 0;
 	frustumState			= FRUSTUM_UNINITIALIZED;
 	frustumAreas			= NULL;
@@ -479,34 +490,10 @@ idInteraction *idInteraction::AllocAndLink( idRenderEntityLocal *edef, idRenderL
 	interaction->frustumState = idInteraction::FRUSTUM_UNINITIALIZED;
 	interaction->frustumAreas = NULL;
 
-	// link at the start of the entity's list
-	interaction->lightNext = ldef->firstInteraction;
-	interaction->lightPrev = NULL;
-	ldef->firstInteraction = interaction;
-	if ( interaction->lightNext != NULL ) {
-		interaction->lightNext->lightPrev = interaction;
-	} else {
-		ldef->lastInteraction = interaction;
-	}
-
-	// link at the start of the light's list
-	interaction->entityNext = edef->firstInteraction;
-	interaction->entityPrev = NULL;
-	edef->firstInteraction = interaction;
-	if ( interaction->entityNext != NULL ) {
-		interaction->entityNext->entityPrev = interaction;
-	} else {
-		edef->lastInteraction = interaction;
-	}
+	interaction->Link();
 
 	// update the interaction table
-	if ( renderWorld->interactionTable ) {
-		int index = ldef->index * renderWorld->interactionTableWidth + edef->index;
-		if ( renderWorld->interactionTable[index] != NULL ) {
-			common->Error( "idInteraction::AllocAndLink: non NULL table entry" );
-		}
-		renderWorld->interactionTable[ index ] = interaction;
-	}
+	renderWorld->interactionTable.Add( interaction );
 
 	return interaction;
 }
@@ -547,6 +534,34 @@ void idInteraction::FreeSurfaces( void ) {
 	this->numSurfaces = -1;
 }
 
+/*
+===============
+idInteraction::Link
+===============
+*/
+void idInteraction::Link( void ) {
+
+	// link at the start of the light's list
+	this->lightNext = this->lightDef->firstInteraction;
+	this->lightPrev = NULL;
+	this->lightDef->firstInteraction = this;
+	if ( this->lightNext != NULL ) {
+		this->lightNext->lightPrev = this;
+	} else {
+		this->lightDef->lastInteraction = this;
+	}
+
+	// link at the start of the entity's list
+	this->entityNext = this->entityDef->firstInteraction;
+	this->entityPrev = NULL;
+	this->entityDef->firstInteraction = this;
+	if ( this->entityNext != NULL ) {
+		this->entityNext->entityPrev = this;
+	} else {
+		this->entityDef->lastInteraction = this;
+	}
+}
+
 /*
 ===============
 idInteraction::Unlink
@@ -592,27 +607,54 @@ void idInteraction::UnlinkAndFree( void ) {
 
 	// clear the table pointer
 	idRenderWorldLocal *renderWorld = this->lightDef->world;
-	if ( renderWorld->interactionTable ) {
-		int index = this->lightDef->index * renderWorld->interactionTableWidth + this->entityDef->index;
-		if ( renderWorld->interactionTable[index] != this ) {
-			common->Error( "idInteraction::UnlinkAndFree: interactionTable wasn't set" );
-		}
-		renderWorld->interactionTable[index] = NULL;
-	}
+	renderWorld->interactionTable.Remove( this );
 
 	Unlink();
 
 	FreeSurfaces();
 
-	// free the interaction area references
+	FreeFrustumAreas();
+
+	// put it back on the free list
+	renderWorld->interactionAllocator.Free( this );
+}
+
+/*
+===============
+idInteraction::FreeFrustumAreas
+===============
+*/
+void idInteraction::FreeFrustumAreas( void ) {
 	areaNumRef_t *area, *nextArea;
+
 	for ( area = frustumAreas; area; area = nextArea ) {
 		nextArea = area->next;
-		renderWorld->areaNumRefAllocator.Free( area );
+		this->lightDef->world->areaNumRefAllocator.Free( area );
 	}
+	frustumAreas = NULL;
+}
 
-	// put it back on the free list
-	renderWorld->interactionAllocator.Free( this );
+/*
+===============
+idInteraction::Reset
+
+Frees everything that depends on the shape of the light or entity, and
+moves an empty interaction back to the start of the lists so it will be
+tested again.
+===============
+*/
+void idInteraction::Reset( void ) {
+	bool wasEmpty = IsEmpty();
+
+	FreeSurfaces();
+	FreeFrustumAreas();
+	frustumState = FRUSTUM_UNINITIALIZED;
+	dynamicModelFrameCount = 0;
+
+	if ( wasEmpty ) {
+		Unlink();
+		Link();
+	}
 }
 
 /*
@@ -909,11 +951,16 @@ void idInteraction::CreateInteraction( const idRenderModel *model ) {
 		// if the interaction has shadows and this surface casts a shadow
 		if ( HasShadows() && shader->SurfaceCastsShadow() && tri->silEdges != NULL ) {
 
+			// shadow maps rasterize the surface itself, so there is no silhouette to find
+			if ( R_LightCastsShadowMap( lightDef ) ) {
+				sint->castsShadowMap = true;
+				interactionGenerated = true;
+
 			// if the light has an optimized shadow volume, don't create shadows for any models that are part of the base areas
-			if ( lightDef->parms.prelightModel == NULL || !model->IsStaticWorldModel() || !r_useOptimizedShadows.GetBool() ) {
+			} else if ( lightDef->parms.prelightModel == NULL || !model->IsStaticWorldModel() || !r_useOptimizedShadows.GetBool() ) {
 
 				// this is the only place during gameplay (outside the utilities) that R_CreateShadowVolume() is called
-				sint->shadowTris = R_CreateShadowVolume( entityDef, tri, lightDef, shadowGen, sint->cullInfo );
+				sint->shadowTris = R_CreateCachedShadowVolume( entityDef, tri, lightDef, shadowGen, sint->cullInfo, c );
 				if ( sint->shadowTris ) {
 					if ( shader->Coverage() != MC_OPAQUE || ( !r_skipSuppress.GetBool() && entityDef->parms.suppressSurfaceInViewID ) ) {
 						// if any surface is a shadow-casting perforated or translucent surface, or the
@@ -1066,8 +1113,8 @@ void idInteraction::AddActiveInteraction( void ) {
 
 	// We will need the dynamic surface created to make interactions, even if the
 	// model itself wasn't visible.  This just returns a cached value after it
-	// has been generated once in the view.
-	idRenderModel *model = R_EntityDefDynamicModel( entityDef );
+	// has been generated once in the view.  Shadow volumes need the skinned verts.
+	idRenderModel *model = R_EntityDefDynamicModel( entityDef, HasShadows() && !R_LightCastsShadowMap( lightDef ) );
 	if ( model == NULL || model->NumSurfaces() <= 0 ) {
 		return;
 	}
@@ -1229,6 +1276,42 @@ void idInteraction::AddActiveInteraction( void ) {
 					shadowTris, vEntity, lightDef, NULL, shadowScissor, inside );
 			}
 		}
+
+		// shadow map casters go on the same lists, with their own vertexes
+		if ( sint->castsShadowMap ) {
+
+			// check for view specific shadow suppression (player shadows, etc)
+			if ( !r_skipSuppress.GetBool() ) {
+				if ( entityDef->parms.suppressShadowInViewID &&
+					entityDef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
+					continue;
+				}
+				if ( entityDef->parms.suppressShadowInLightID &&
+					entityDef->parms.suppressShadowInLightID == lightDef->parms.lightId ) {
+					continue;
+				}
+			}
+
+			// derive the tangents like the lit path would, the cache is shared with it
+			if ( !R_CreateAmbientCache( sint->ambientTris, sint->shader->ReceivesLighting() ) ) {
+				// skip if we were out of vertex memory
+				continue;
+			}
+			if ( !R_CreateIndexCache( sint->ambientTris ) ) {
+				// skip if we were out of vertex memory
+				continue;
+			}
+			vertexCache.Touch( sint->ambientTris->ambientCache );
+			vertexCache.Touch( sint->ambientTris->indexCache );
+
+			if ( sint->shader->TestMaterialFlag( MF_NOSELFSHADOW ) ) {
+				R_LinkLightSurf( &vLight->localShadows,
+					sint->ambientTris, vEntity, lightDef, NULL, shadowScissor, false );
+			} else {
+				R_LinkLightSurf( &vLight->globalShadows,
+					sint->ambientTris, vEntity, lightDef, NULL, shadowScissor, false );
+			}
+		}
 	}
 }
 
@@ -1294,4 +1377,99 @@ void R_ShowInteractionMemory_f( const idCmdArgs &args ) {
 	common->Printf( "%i deferred interactions, %i empty interactions\n", deferredInteractions, emptyInteractions );
 	common->Printf( "%5i indexes %5i verts in %5i light tris\n", lightTriIndexes, lightTriVerts, lightTris );
 	common->Printf( "%5i indexes %5i verts in %5i shadow tris\n", shadowTriIndexes, shadowTriVerts, shadowTris );
+	common->Printf( "interactionTable: %i entries in %ik\n", tr.primaryWorld->interactionTable.Num(), (int)( tr.primaryWorld->interactionTable.Allocated() / 1024 ) );
+}
+
+/*
+===========================================================================
+
+idInteractionTable
+
+===========================================================================
+*/
+
+#define INTERACTION_TABLE_HASH_SIZE		4096
+#define INTERACTION_TABLE_GRANULARITY	1024
+
+/*
+===============
+idInteractionTable::idInteractionTable
+===============
+*/
+idInteractionTable::idInteractionTable( void ) {
+	hash.Clear( INTERACTION_TABLE_HASH_SIZE, INTERACTION_TABLE_GRANULARITY );
+	hash.SetGranularity( INTERACTION_TABLE_GRANULARITY );
+	interactions.SetGranularity( INTERACTION_TABLE_GRANULARITY );
+}
+
+/*
+===============
+idInteractionTable::Clear
+===============
+*/
+void idInteractionTable::Clear( void ) {
+	for ( int i = 0; i < interactions.Num(); i++ ) {
+		interactions[i]->tableIndex = -1;
+	}
+	interactions.Clear();
+	hash.Free();
+}
+
+/*
+===============
+idInteractionTable::Find
+===============
+*/
+idInteraction *idInteractionTable::Find( const idRenderLightLocal *ldef, const idRenderEntityLocal *edef ) const {
+	int key = GenerateKey( ldef->index, edef->index );
+
+	for ( int i = hash.First( key ); i != -1; i = hash.Next( i ) ) {
+		idInteraction *inter = interactions[i];
+		if ( inter->lightDef == ldef && inter->entityDef == edef ) {
+			return inter;
+		}
+	}
+	return NULL;
+}
+
+/*
+===============
+idInteractionTable::Add
+===============
+*/
+void idInteractionTable::Add( idInteraction *interaction ) {
+	if ( Find( interaction->lightDef, interaction->entityDef ) != NULL ) {
+		common->Error( "idInteractionTable::Add: interaction already in table" );
+	}
+	interaction->tableIndex = interactions.Append( interaction );
+	hash.Add( GenerateKey( interaction->lightDef->index, interaction->entityDef->index ), interaction->tableIndex );
+}
+
+/*
+===============
+idInteractionTable::Remove
+
+Moves the last interaction into the freed slot to keep the table compact.
+===============
+*/
+void idInteractionTable::Remove( idInteraction *interaction ) {
+	int index = interaction->tableIndex;
+
+	if ( index < 0 || index >= interactions.Num() || interactions[index] != interaction ) {
+		common->Error( "idInteractionTable::Remove: interaction wasn't in table" );
+	}
+
+	hash.Remove( GenerateKey( interaction->lightDef->index, interaction->entityDef->index ), index );
+	interaction->tableIndex = -1;
+
+	int last = interactions.Num() - 1;
+	if ( index != last ) {
+		idInteraction *moved = interactions[last];
+		int key = GenerateKey( moved->lightDef->index, moved->entityDef->index );
+		hash.Remove( key, last );
+		hash.Add( key, index );
+		interactions[index] = moved;
+		moved->tableIndex = index;
+	}
+	interactions.SetNum( last, false );
 }
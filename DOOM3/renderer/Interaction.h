@@ -30,6 +30,8 @@ If you have questions concerning this license or the applicable additional terms
 #define __INTERACTION_H__
 
 #include "idlib/bv/Frustum.h"
+#include "idlib/containers/HashIndex.h"
+#include "idlib/containers/List.h"
 #include "renderer/Model.h"
 #include "renderer/tr_local.h"
 
@@ -73,6 +75,9 @@ typedef struct {
 	// shadow volume triangle surface
 	srfTriangles_t *		shadowTris;
 
+	// the light uses a shadow map, ambientTris is drawn into it instead of a shadow volume
+	bool					castsShadowMap;
+
 	// so we can check ambientViewCount before adding lightTris, and get
 	// at the shared vertex and possibly shadowVertex caches
 	srfTriangles_t *		ambientTris;
@@ -114,6 +119,8 @@ public:
 	idInteraction *			entityNext;				// for entityDef chains
 	idInteraction *			entityPrev;
 
+	int						tableIndex;				// in the world's interactionTable
+
 public:
 							idInteraction( void );
 
@@ -129,6 +136,10 @@ public:
 	// free the interaction surfaces
 	void					FreeSurfaces( void );
 
+	// frees everything derived from the light and entity shape, but keeps the
+	// interaction linked in when the light or entity moved and they still share an area
+	void					Reset( void );
+
 	// makes the interaction empty for when the light and entity do not actually intersect
 	// all empty interactions are linked at the end of the light's and entity's interaction list
 	void					MakeEmpty( void );
@@ -166,9 +177,15 @@ private:
 	// actually create the interaction
 	void					CreateInteraction( const idRenderModel *model );
 
+	// link at the start of the entity and light lists
+	void					Link( void );
+
 	// unlink from entity and light lists
 	void					Unlink( void );
 
+	// free the areas the interaction frustum touches
+	void					FreeFrustumAreas( void );
+
 	// try to determine if the entire interaction, including shadows, is guaranteed
 	// to be outside the view frustum
 	bool					CullInteractionByViewFrustum( const idFrustum &viewFrustum );
@@ -179,6 +196,34 @@ private:
 };
 
 
+/*
+===============================================================================
+
+	Sparse table of all the interactions of a world, keyed by lightDef and entityDef
+	index. Only existing interactions take space, so adding defs never resizes it.
+
+===============================================================================
+*/
+
+class idInteractionTable {
+public:
+							idInteractionTable( void );
+
+	void					Clear( void );
+	idInteraction *			Find( const idRenderLightLocal *ldef, const idRenderEntityLocal *edef ) const;
+	void					Add( idInteraction *interaction );
+	void					Remove( idInteraction *interaction );
+	int						Num( void ) const { return interactions.Num(); }
+	size_t					Allocated( void ) const { return interactions.Allocated() + hash.Allocated(); }
+
+private:
+	idList<idInteraction *>	interactions;
+	idHashIndex				hash;
+
+	static int				GenerateKey( int lightIndex, int entityIndex ) { return ( lightIndex * 331 ) ^ entityIndex; }
+};
+
+
 void R_CalcInteractionFacing( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, srfCullInfo_t &cullInfo );
 void R_CalcInteractionCullBits( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, srfCullInfo_t &cullInfo );
 void R_FreeInteractionCullInfo( srfCullInfo_t &cullInfo );
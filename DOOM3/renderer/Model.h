@@ -47,6 +47,13 @@ If you have questions concerning this license or the applicable additional terms
 #define MD5_CAMERA_EXT			"md5camera"
 #define MD5_VERSION				10
 
+// binary versions of the md5 files hold the parsed data in its runtime layout,
+// they are written next to the text file and rebuilt when the checksum of its text changes
+#define MD5_MESH_BINARY_EXT		"md5meshb"
+#define MD5_ANIM_BINARY_EXT		"md5animb"
+#define MD5_BINARY_ID			( ('B'<<24)|('5'<<16)|('D'<<8)|'M' )
+#define MD5_BINARY_VERSION		2
+
 // using shorts for triangle indexes can save a significant amount of traffic, but
 // to support the large models that renderBump loads, they need to be 32 bits
 #if 1
@@ -62,7 +69,7 @@ typedef short glIndex_t;
 #endif
 
 
-typedef struct {
+typedef struct silEdge_s {
 	// NOTE: making this a glIndex is dubious, as there can be 2x the faces as verts
 	glIndex_t					p1, p2;					// planes defining the edge
 	glIndex_t					v1, v2;					// verts defining the edge
@@ -80,6 +87,23 @@ typedef struct shadowCache_s {
 
 const int SHADOW_CAP_INFINITE	= 64;
 
+// the vertex programs that skin md5 surfaces blend up to four joints per vertex,
+// from a palette that fits their uniforms
+const int MAX_GPU_SKINNING_JOINTS	= 64;
+
+typedef struct skinWeight_s {
+	byte						joints[4];				// into the joint palette of the surface
+	byte						weights[4];				// sum to 255
+} skinWeight_t;
+
+// md5 surfaces skinned by the vertex programs keep the bind pose in their verts,
+// the joint weights follow the verts in the ambientCache
+typedef struct gpuSkinning_s {
+	int							numJoints;
+	idJointMat *				joints;					// [numJoints] from the bind pose to the current pose
+	skinWeight_t *				weights;				// [numVerts]
+} gpuSkinning_t;
+
 // our only drawing geometry type
 typedef struct srfTriangles_s {
 	idBounds					bounds;					// for culling
@@ -131,6 +155,9 @@ typedef struct srfTriangles_s {
 
 	struct srfTriangles_s *		nextDeferredFree;		// chain of tris to free next frame
 
+	gpuSkinning_t *				skinning;				// non-NULL if the vertex programs skin the verts, light
+														// interactions reference the one of their ambientSurface
+
 	// data in vertex object space, not directly readable by the CPU
 	struct vertCache_s *		indexCache;				// int
 	struct vertCache_s *		ambientCache;			// idDrawVert
@@ -46,6 +46,7 @@ public:
 	virtual void			FreeModel( idRenderModel *model );
 	virtual idRenderModel *	FindModel( const char *modelName );
 	virtual idRenderModel *	CheckModel( const char *modelName );
+	virtual void			PrefetchModel( const char *modelName );
 	virtual idRenderModel *	DefaultModel();
 	virtual void			AddModel( idRenderModel *model );
 	virtual void			RemoveModel( idRenderModel *model );
@@ -398,6 +399,36 @@ idRenderModel *idRenderModelManagerLocal::CheckModel( const char *modelName ) {
 	return GetModel( modelName, false );
 }
 
+/*
+=================
+idRenderModelManagerLocal::PrefetchModel
+=================
+*/
+void idRenderModelManagerLocal::PrefetchModel( const char *modelName ) {
+	idStr	extension;
+
+	if ( !modelName || !modelName[0] ) {
+		return;
+	}
+
+	int key = hash.GenerateKey( modelName, false );
+	for ( int i = hash.First( key ); i != -1; i = hash.Next( i ) ) {
+		if ( idStr::Icmp( modelName, models[i]->Name() ) == 0 ) {
+			if ( models[i]->IsLoaded() ) {
+				return;
+			}
+			break;
+		}
+	}
+
+	// inline models of the map are named after their entity and have no extension
+	idStr( modelName ).ExtractFileExtension( extension );
+	if ( ( extension.Icmp( "ase" ) == 0 ) || ( extension.Icmp( "lwo" ) == 0 ) || ( extension.Icmp( "flt" ) == 0 ) ||
+			( extension.Icmp( "ma" ) == 0 ) || ( extension.Icmp( MD5_MESH_EXT ) == 0 ) || ( extension.Icmp( "md3" ) == 0 ) ) {
+		fileSystem->PrefetchFile( modelName );
+	}
+}
+
 /*
 =================
 idRenderModelManagerLocal::DefaultModel
@@ -441,6 +472,9 @@ void idRenderModelManagerLocal::ReloadModels( bool forceAll ) {
 
 	R_FreeDerivedData();
 
+	// the shadow volumes were made from the old surfaces
+	R_PurgeShadowCache( NULL, NULL );
+
 	// skip the default model at index 0
 	for ( int i = 1 ; i < models.Num() ; i++ ) {
 		idRenderModel	*model = models[i];
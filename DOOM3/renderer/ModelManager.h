@@ -71,6 +71,10 @@ public:
 	// returns NULL if not loadable
 	virtual	idRenderModel *	CheckModel( const char *modelName ) = 0;
 
+	// starts reading the file of a model that will be asked for soon, does nothing
+	// if it's loaded or not a model file
+	virtual void			PrefetchModel( const char *modelName ) = 0;
+
 	// returns the default cube model
 	virtual	idRenderModel *	DefaultModel() = 0;
 
@@ -138,6 +138,15 @@ protected:
 ===============================================================================
 */
 
+// bind pose normal and tangents of a vertex in the space of one of its joints,
+// scaled by the joint weight
+typedef struct {
+	idVec3						normal;
+	idVec3						tangents[2];
+	int							joint;
+	int							nextVertex;			// true if this is the last weight of the vertex
+} md5TangentWeight_t;
+
 class idMD5Mesh {
 	friend class				idRenderModelMD5;
 
@@ -146,7 +155,15 @@ public:
 								~idMD5Mesh();
 
 	void						ParseMesh( idLexer &parser, int numJoints, const idJointMat *joints );
+	bool						ReadBinary( idFile *file );
+	void						WriteBinary( idFile *file ) const;
 	void						UpdateSurface( const struct renderEntity_s *ent, const idJointMat *joints, modelSurface_t *surf );
+	srfTriangles_t *			SetupSurface( modelSurface_t *surf );
+	void						SkinSurface( srfTriangles_t *tri, const idJointMat *joints, float skinScale, bool skinTangents );
+	void						BuildTangentWeights( const idJointMat *joints );
+	void						BuildGPUSkinning( const idJointMat *joints );
+	bool						SkinsOnGPU( void ) const;
+	void						SetupSkinnedSurface( const idJointMat *joints, modelSurface_t *surf );
 	idBounds					CalcBounds( const idJointMat *joints );
 	int							NearestJoint( int a, int b, int c ) const;
 	int							NumVerts( void ) const;
@@ -162,9 +179,18 @@ private:
 	int							numTris;			// number of triangles
 	struct deformInfo_s *		deformInfo;			// used to create srfTriangles_t from base frames and new vertexes
 	int							surfaceNum;			// number of the static surface created for this mesh
+	idList<md5TangentWeight_t>	tangentWeights;		// for every output vertex, built on first use by r_skinnedTangents
+	bool						gpuSkinningBuilt;	// the members below are built on first use by tr.skinOnGPU
+	idList<idDrawVert>			bindVerts;			// output vertexes in the bind pose, empty if the palette is too large
+	idList<skinWeight_t>		skinWeights;		// for every output vertex
+	idList<int>					skinJoints;			// model joint of every palette entry
+	idList<idJointMat>			invBindJoints;		// inverse bind pose of every palette entry
 
 	void						TransformVerts( idDrawVert *verts, const idJointMat *joints );
 	void						TransformScaledVerts( idDrawVert *verts, const idJointMat *joints, float scale );
+	void						TransformTangents( idDrawVert *verts, const idJointMat *joints ) const;
+	void						CompareTangents( srfTriangles_t *tri );
+	void						DeriveBindPose( srfTriangles_t *tri, const idJointMat *joints );
 };
 
 class idRenderModelMD5 : public idRenderModelStatic {
@@ -194,7 +220,14 @@ private:
 	void						CalculateBounds( const idJointMat *joints );
 	void						GetFrameBounds( const renderEntity_t *ent, idBounds &bounds ) const;
 	void						DrawJoints( const renderEntity_t *ent, const struct viewDef_s *view ) const;
+	void						BuildTangentWeights( void );
+	void						BuildGPUSkinning( void );
+	void						BindPoseJoints( idJointMat *poseMats ) const;
 	void						ParseJoint( idLexer &parser, idMD5Joint *joint, idJointQuat *defaultPose );
+	bool						LoadBinary( unsigned int sourceCRC, int sourceLength );
+	void						WriteBinary( unsigned int sourceCRC, int sourceLength ) const;
+
+	static void					SkinJob( void *data );
 };
 
 /*
@@ -301,6 +334,8 @@ public:
 
 private:
 	const idDeclParticle *		particleSystem;
+
+	static void					StageJob( void *data );
 };
 
 /*
@@ -27,6 +27,7 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/CRC32.h"
 #include "framework/Session.h"
 #include "renderer/tr_local.h"
 
@@ -63,6 +64,7 @@ idMD5Mesh::idMD5Mesh() {
 	numTris			= 0;
 	deformInfo		= NULL;
 	surfaceNum		= 0;
+	gpuSkinningBuilt = false;
 }
 
 /*
@@ -244,6 +246,83 @@ void idMD5Mesh::ParseMesh( idLexer &parser, int numJoints, const idJointMat *joi
 	deformInfo = R_BuildDeformInfo( texCoords.Num(), verts, tris.Num(), tris.Ptr(), shader->UseUnsmoothedTangents() );
 }
 
+/*
+====================
+idMD5Mesh::ReadBinary
+====================
+*/
+bool idMD5Mesh::ReadBinary( idFile *file ) {
+	idStr		shaderName;
+	bool		unsmoothedTangents;
+	int			count;
+	int			i;
+
+	file->ReadString( shaderName );
+	file->ReadBool( unsmoothedTangents );
+
+	shader = declManager->FindMaterial( shaderName );
+
+	// the deform info depends on the material
+	if ( shader->UseUnsmoothedTangents() != unsmoothedTangents ) {
+		return false;
+	}
+
+	file->ReadInt( count );
+	if ( count < 0 || count * (int)sizeof( texCoords[0] ) > file->Length() - file->Tell() ) {
+		return false;
+	}
+	texCoords.SetNum( count );
+	file->Read( texCoords.Ptr(), count * sizeof( texCoords[0] ) );
+
+	file->ReadInt( numWeights );
+	if ( numWeights < 0 || numWeights * (int)( sizeof( scaledWeights[0] ) + 2 * sizeof( weightIndex[0] ) ) > file->Length() - file->Tell() ) {
+		numWeights = 0;
+		return false;
+	}
+	scaledWeights = (idVec4 *) Mem_Alloc16( numWeights * sizeof( scaledWeights[0] ) );
+	weightIndex = (int *) Mem_Alloc16( numWeights * 2 * sizeof( weightIndex[0] ) );
+	file->Read( scaledWeights, numWeights * sizeof( scaledWeights[0] ) );
+	file->Read( weightIndex, numWeights * 2 * sizeof( weightIndex[0] ) );
+
+	file->ReadInt( numTris );
+
+	deformInfo = R_ReadDeformInfo( file );
+	if ( !deformInfo ) {
+		return false;
+	}
+
+	// update counters
+	c_numVerts += texCoords.Num();
+	c_numWeights += numWeights;
+	c_numWeightJoints++;
+	for ( i = 0; i < numWeights; i++ ) {
+		c_numWeightJoints += weightIndex[i*2+1];
+	}
+
+	return true;
+}
+
+/*
+====================
+idMD5Mesh::WriteBinary
+====================
+*/
+void idMD5Mesh::WriteBinary( idFile *file ) const {
+	file->WriteString( shader->GetName() );
+	file->WriteBool( shader->UseUnsmoothedTangents() );
+
+	file->WriteInt( texCoords.Num() );
+	file->Write( texCoords.Ptr(), texCoords.Num() * sizeof( texCoords[0] ) );
+
+	file->WriteInt( numWeights );
+	file->Write( scaledWeights, numWeights * sizeof( scaledWeights[0] ) );
+	file->Write( weightIndex, numWeights * 2 * sizeof( weightIndex[0] ) );
+
+	file->WriteInt( numTris );
+
+	R_WriteDeformInfo( file, deformInfo );
+}
+
 /*
 ====================
 idMD5Mesh::TransformVerts
@@ -268,11 +347,276 @@ void idMD5Mesh::TransformScaledVerts( idDrawVert *verts, const idJointMat *entJo
 
 /*
 ====================
-idMD5Mesh::UpdateSurface
+idMD5Mesh::BuildTangentWeights
+
+Derives the normals and tangents of the mesh in the bind pose, and moves them
+into the space of each joint that weights the vertex, so they can be skinned
+like the positions instead of being derived from the triangles every frame.
+The mirror seam vertexes get their own weights, because their tangents differ.
 ====================
 */
-void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMat *entJoints, modelSurface_t *surf ) {
-	int i, base;
+void idMD5Mesh::BuildTangentWeights( const idJointMat *joints ) {
+	srfTriangles_t	tri;
+	idList<int>		firstWeight;
+	int				i, j, base, source, count;
+
+	DeriveBindPose( &tri, joints );
+
+	// the first weight of every source vertex
+	firstWeight.SetNum( texCoords.Num() + 1 );
+	firstWeight[0] = 0;
+	for ( i = 0, j = 1; i < numWeights; i++ ) {
+		if ( weightIndex[i * 2 + 1] ) {
+			firstWeight[j++] = i + 1;
+		}
+	}
+
+	base = deformInfo->numOutputVerts - deformInfo->numMirroredVerts;
+	count = numWeights;
+	for ( i = 0; i < deformInfo->numMirroredVerts; i++ ) {
+		source = deformInfo->mirroredVerts[i];
+		count += firstWeight[source + 1] - firstWeight[source];
+	}
+	tangentWeights.SetGranularity( 1 );
+	tangentWeights.SetNum( count );
+
+	count = 0;
+	for ( i = 0; i < deformInfo->numOutputVerts; i++ ) {
+		const idDrawVert &v = tri.verts[i];
+
+		source = ( i < base ) ? i : deformInfo->mirroredVerts[i - base];
+		for ( j = firstWeight[source]; j < firstWeight[source + 1]; j++ ) {
+			md5TangentWeight_t &w = tangentWeights[count++];
+			int joint = weightIndex[j * 2 + 0] / sizeof( idJointMat );
+			const float *m = joints[joint].ToFloatPtr();
+			float weight = scaledWeights[j].w;
+
+			// inverse rotation of the joint
+			w.normal.Set( m[0] * v.normal.x + m[4] * v.normal.y + m[8] * v.normal.z,
+						m[1] * v.normal.x + m[5] * v.normal.y + m[9] * v.normal.z,
+						m[2] * v.normal.x + m[6] * v.normal.y + m[10] * v.normal.z );
+			w.normal *= weight;
+			for ( int k = 0; k < 2; k++ ) {
+				const idVec3 &t = v.tangents[k];
+				w.tangents[k].Set( m[0] * t.x + m[4] * t.y + m[8] * t.z,
+								m[1] * t.x + m[5] * t.y + m[9] * t.z,
+								m[2] * t.x + m[6] * t.y + m[10] * t.z );
+				w.tangents[k] *= weight;
+			}
+			w.joint = joint;
+			w.nextVertex = ( j == firstWeight[source + 1] - 1 );
+		}
+	}
+
+	Mem_Free16( tri.verts );
+}
+
+/*
+====================
+idMD5Mesh::DeriveBindPose
+
+Skins the output vertexes in the bind pose and derives their tangents,
+the caller frees tri->verts
+====================
+*/
+void idMD5Mesh::DeriveBindPose( srfTriangles_t *tri, const idJointMat *joints ) {
+	memset( tri, 0, sizeof( *tri ) );
+	tri->numVerts = deformInfo->numOutputVerts;
+	tri->numIndexes = deformInfo->numIndexes;
+	tri->indexes = deformInfo->indexes;
+	tri->numMirroredVerts = deformInfo->numMirroredVerts;
+	tri->mirroredVerts = deformInfo->mirroredVerts;
+	tri->numDupVerts = deformInfo->numDupVerts;
+	tri->dupVerts = deformInfo->dupVerts;
+	tri->dominantTris = deformInfo->dominantTris;
+	tri->verts = (idDrawVert *) Mem_Alloc16( tri->numVerts * sizeof( tri->verts[0] ) );
+	for ( int i = 0; i < deformInfo->numSourceVerts; i++ ) {
+		tri->verts[i].Clear();
+		tri->verts[i].st = texCoords[i];
+	}
+
+	SkinSurface( tri, joints, 0.0f, false );
+	R_DeriveTangents( tri, false );
+}
+
+/*
+====================
+idMD5Mesh::BuildGPUSkinning
+
+Keeps the bind pose vertexes with the four largest joint weights of every
+vertex, for the vertex programs to blend.  The joints are renumbered into
+a palette of the ones the mesh uses, meshes with a larger palette than
+MAX_GPU_SKINNING_JOINTS stay skinned on the CPU.
+====================
+*/
+void idMD5Mesh::BuildGPUSkinning( const idJointMat *joints ) {
+	srfTriangles_t	tri;
+	idList<int>		palette;
+	idList<int>		firstWeight;
+	int				i, j, k, base, source;
+
+	gpuSkinningBuilt = true;
+
+	if ( numWeights == 0 ) {
+		return;
+	}
+
+	// the palette of the joints the mesh uses
+	palette.SetNum( numWeights );
+	for ( i = 0; i < numWeights; i++ ) {
+		palette[i] = skinJoints.AddUnique( weightIndex[i * 2 + 0] / sizeof( idJointMat ) );
+	}
+	if ( skinJoints.Num() > MAX_GPU_SKINNING_JOINTS ) {
+		skinJoints.Clear();
+		return;
+	}
+
+	invBindJoints.SetNum( skinJoints.Num() );
+	for ( i = 0; i < skinJoints.Num(); i++ ) {
+		invBindJoints[i].SetRotation( mat3_identity );
+		invBindJoints[i].SetTranslation( vec3_origin );
+		invBindJoints[i] /= joints[skinJoints[i]];
+	}
+
+	// the first weight of every source vertex
+	firstWeight.SetNum( texCoords.Num() + 1 );
+	firstWeight[0] = 0;
+	for ( i = 0, j = 1; i < numWeights; i++ ) {
+		if ( weightIndex[i * 2 + 1] ) {
+			firstWeight[j++] = i + 1;
+		}
+	}
+
+	base = deformInfo->numOutputVerts - deformInfo->numMirroredVerts;
+	skinWeights.SetNum( deformInfo->numOutputVerts );
+	for ( i = 0; i < deformInfo->numOutputVerts; i++ ) {
+		int		best[4] = { 0, 0, 0, 0 };
+		float	bestWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float	total;
+		int		sum;
+
+		source = ( i < base ) ? i : deformInfo->mirroredVerts[i - base];
+		for ( j = firstWeight[source]; j < firstWeight[source + 1]; j++ ) {
+			float weight = scaledWeights[j].w;
+			for ( k = 3; k >= 0 && weight > bestWeight[k]; k-- ) {
+				if ( k < 3 ) {
+					best[k + 1] = best[k];
+					bestWeight[k + 1] = bestWeight[k];
+				}
+				best[k] = palette[j];
+				bestWeight[k] = weight;
+			}
+		}
+
+		// renormalize the kept weights, the rounding error goes to the largest one
+		total = bestWeight[0] + bestWeight[1] + bestWeight[2] + bestWeight[3];
+		skinWeight_t &w = skinWeights[i];
+		sum = 0;
+		for ( k = 3; k >= 0; k-- ) {
+			w.joints[k] = best[k];
+			w.weights[k] = ( k == 0 ) ? 255 - sum : idMath::FtoiFast( bestWeight[k] * 255.0f / total );
+			sum += w.weights[k];
+		}
+	}
+
+	DeriveBindPose( &tri, joints );
+	bindVerts.SetGranularity( 1 );
+	bindVerts.SetNum( tri.numVerts );
+	memcpy( bindVerts.Ptr(), tri.verts, tri.numVerts * sizeof( tri.verts[0] ) );
+	Mem_Free16( tri.verts );
+}
+
+/*
+====================
+idMD5Mesh::SkinsOnGPU
+====================
+*/
+bool idMD5Mesh::SkinsOnGPU( void ) const {
+	return bindVerts.Num() > 0;
+}
+
+/*
+====================
+idMD5Mesh::TransformTangents
+
+Blends the joint space normals and tangents of every output vertex
+====================
+*/
+void idMD5Mesh::TransformTangents( idDrawVert *verts, const idJointMat *entJoints ) const {
+	const md5TangentWeight_t *w = tangentWeights.Ptr();
+
+	for ( int i = 0; i < deformInfo->numOutputVerts; i++ ) {
+		idVec3 normal, tangent0, tangent1;
+
+		normal.Zero();
+		tangent0.Zero();
+		tangent1.Zero();
+		while( 1 ) {
+			const idJointMat &joint = entJoints[w->joint];
+			normal += joint * w->normal;
+			tangent0 += joint * w->tangents[0];
+			tangent1 += joint * w->tangents[1];
+			if ( ( w++ )->nextVertex ) {
+				break;
+			}
+		}
+
+		// blending the joints shortens the vectors a little
+		normal.NormalizeFast();
+		tangent0.NormalizeFast();
+		tangent1.NormalizeFast();
+
+		verts[i].normal = normal;
+		verts[i].tangents[0] = tangent0;
+		verts[i].tangents[1] = tangent1;
+	}
+}
+
+/*
+====================
+idMD5Mesh::CompareTangents
+
+Derives the tangents from the triangles, and adds the angles to the skinned
+tangents to the r_skinnedTangents 2 report.  The derived tangents are kept.
+====================
+*/
+void idMD5Mesh::CompareTangents( srfTriangles_t *tri ) {
+	idVec3 *skinned = (idVec3 *) _alloca16( tri->numVerts * 3 * sizeof( skinned[0] ) );
+	int i, j;
+
+	for ( i = 0; i < tri->numVerts; i++ ) {
+		skinned[i * 3 + 0] = tri->verts[i].normal;
+		skinned[i * 3 + 1] = tri->verts[i].tangents[0];
+		skinned[i * 3 + 2] = tri->verts[i].tangents[1];
+	}
+
+	tri->tangentsCalculated = false;
+	R_DeriveTangents( tri );
+
+	for ( i = 0; i < tri->numVerts; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			idVec3 derived = ( j == 0 ) ? tri->verts[i].normal : tri->verts[i].tangents[j - 1];
+			derived.Normalize();
+			float angle = RAD2DEG( idMath::ACos( derived * skinned[i * 3 + j] ) );
+			tr.pc.skinnedTangentError += angle;
+			if ( angle > tr.pc.skinnedTangentMaxError ) {
+				tr.pc.skinnedTangentMaxError = angle;
+			}
+		}
+	}
+	tr.pc.c_skinnedTangentVerts += tri->numVerts;
+}
+
+/*
+====================
+idMD5Mesh::SetupSurface
+
+Sets up the triangle surface for the skinned vertexes.  This allocates memory,
+so it can't be done on the job threads.
+====================
+*/
+srfTriangles_t *idMD5Mesh::SetupSurface( modelSurface_t *surf ) {
+	int i;
 	srfTriangles_t *tri;
 
 	tr.pc.c_deformedSurfaces++;
@@ -281,6 +625,12 @@ void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMa
 
 	surf->shader = shader;
 
+	// the surface was skinned by the vertex programs before
+	if ( surf->geometry && surf->geometry->skinning ) {
+		R_FreeStaticTriSurf( surf->geometry );
+		surf->geometry = NULL;
+	}
+
 	if ( surf->geometry ) {
 		// if the number of verts and indexes are the same we can re-use the triangle surface
 		// the number of indexes must be the same to assure the correct amount of memory is allocated for the facePlanes
@@ -321,8 +671,79 @@ void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMa
 		}
 	}
 
-	if ( ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ] != 0.0f ) {
-		TransformScaledVerts( tri->verts, entJoints, ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ] );
+	return tri;
+}
+
+/*
+====================
+idMD5Mesh::SetupSkinnedSurface
+
+Sets up a triangle surface that keeps the bind pose, and the joints that take
+it to the current pose for the vertex programs.  The vertexes never change, so
+the surface and its vertex caches are kept when the model is instantiated again.
+====================
+*/
+void idMD5Mesh::SetupSkinnedSurface( const idJointMat *entJoints, modelSurface_t *surf ) {
+	srfTriangles_t *tri;
+
+	surf->shader = shader;
+
+	if ( surf->geometry && !surf->geometry->skinning ) {
+		R_FreeStaticTriSurf( surf->geometry );
+		surf->geometry = NULL;
+	}
+
+	if ( !surf->geometry ) {
+		tri = surf->geometry = R_AllocStaticTriSurf();
+
+		// note that some of the data is references, and should not be freed
+		tri->deformedSurface = true;
+		tri->tangentsCalculated = true;
+		tri->facePlanesCalculated = false;
+
+		tri->numIndexes = deformInfo->numIndexes;
+		tri->indexes = deformInfo->indexes;
+		tri->silIndexes = deformInfo->silIndexes;
+		tri->numMirroredVerts = deformInfo->numMirroredVerts;
+		tri->mirroredVerts = deformInfo->mirroredVerts;
+		tri->numDupVerts = deformInfo->numDupVerts;
+		tri->dupVerts = deformInfo->dupVerts;
+		tri->numSilEdges = deformInfo->numSilEdges;
+		tri->silEdges = deformInfo->silEdges;
+		tri->dominantTris = deformInfo->dominantTris;
+		tri->numVerts = deformInfo->numOutputVerts;
+
+		R_AllocStaticTriSurfVerts( tri, tri->numVerts );
+		memcpy( tri->verts, bindVerts.Ptr(), tri->numVerts * sizeof( tri->verts[0] ) );
+
+		tri->skinning = (gpuSkinning_t *)R_StaticAlloc( sizeof( gpuSkinning_t ) +
+							skinJoints.Num() * sizeof( idJointMat ) + tri->numVerts * sizeof( skinWeight_t ) );
+		tri->skinning->numJoints = skinJoints.Num();
+		tri->skinning->joints = (idJointMat *)( tri->skinning + 1 );
+		tri->skinning->weights = (skinWeight_t *)( tri->skinning->joints + skinJoints.Num() );
+		memcpy( tri->skinning->weights, skinWeights.Ptr(), tri->numVerts * sizeof( skinWeight_t ) );
+	}
+
+	tri = surf->geometry;
+
+	for ( int i = 0; i < skinJoints.Num(); i++ ) {
+		tri->skinning->joints[i] = invBindJoints[i];
+		tri->skinning->joints[i] *= entJoints[skinJoints[i]];
+	}
+}
+
+/*
+====================
+idMD5Mesh::SkinSurface
+
+Only writes the vertexes and bounds of the surface, so it can run on the job threads.
+====================
+*/
+void idMD5Mesh::SkinSurface( srfTriangles_t *tri, const idJointMat *entJoints, float skinScale, bool skinTangents ) {
+	int i, base;
+
+	if ( skinScale != 0.0f ) {
+		TransformScaledVerts( tri->verts, entJoints, skinScale );
 	} else {
 		TransformVerts( tri->verts, entJoints );
 	}
@@ -333,13 +754,37 @@ void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMa
 		tri->verts[base + i] = tri->verts[deformInfo->mirroredVerts[i]];
 	}
 
+	if ( skinTangents ) {
+		TransformTangents( tri->verts, entJoints );
+		tri->tangentsCalculated = true;
+	}
+
 	R_BoundTriSurf( tri );
+}
+
+/*
+====================
+idMD5Mesh::UpdateSurface
+====================
+*/
+void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMat *entJoints, modelSurface_t *surf ) {
+	srfTriangles_t *tri;
+
+	tri = SetupSurface( surf );
+
+	bool skinTangents = r_skinnedTangents.GetInteger() != 0 && tangentWeights.Num() > 0;
+
+	SkinSurface( tri, entJoints, ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ], skinTangents );
+
+	if ( skinTangents && r_skinnedTangents.GetInteger() == 2 ) {
+		CompareTangents( tri );
+	}
 
 	// If a surface is going to be have a lighting interaction generated, it will also have to call
 	// R_DeriveTangents() to get normals, tangents, and face planes.  If it only
 	// needs shadows generated, it will only have to generate face planes.  If it only
 	// has ambient drawing, or is culled, no additional work will be necessary
-	if ( !r_useDeferredTangents.GetBool() ) {
+	if ( !r_useDeferredTangents.GetBool() && !tri->tangentsCalculated ) {
 		// set face planes, vertex normals, tangents
 		R_DeriveTangents( tri );
 	}
@@ -497,13 +942,35 @@ void idRenderModelMD5::LoadModel() {
 	idJointQuat	*pose;
 	idMD5Joint	*joint;
 	idJointMat *poseMat3;
+	void		*buffer;
+	int			length;
+	unsigned int crc;
 
 	if ( !purged ) {
 		PurgeModel();
 	}
 	purged = false;
 
-	if ( !parser.LoadFile( name ) ) {
+	buffer = NULL;
+	length = 0;
+	crc = 0;
+
+	if ( r_binaryMD5.GetBool() ) {
+		// read the text ourselves so it can be checked against the binary version
+		length = fileSystem->ReadFile( name, &buffer, &timeStamp );
+		if ( !buffer ) {
+			MakeDefaultModel();
+			return;
+		}
+
+		crc = CRC32_BlockChecksum( buffer, length );
+		if ( LoadBinary( crc, length ) ) {
+			fileSystem->FreeFile( buffer );
+			return;
+		}
+
+		parser.LoadMemory( (const char *)buffer, length, name );
+	} else if ( !parser.LoadFile( name ) ) {
 		MakeDefaultModel();
 		return;
 	}
@@ -568,8 +1035,148 @@ void idRenderModelMD5::LoadModel() {
 	//
 	CalculateBounds( poseMat3 );
 
-	// set the timestamp for reloadmodels
-	fileSystem->ReadFile( name, NULL, &timeStamp );
+	if ( buffer ) {
+		WriteBinary( crc, length );
+		parser.FreeSource();
+		fileSystem->FreeFile( buffer );
+	} else {
+		// set the timestamp for reloadmodels
+		fileSystem->ReadFile( name, NULL, &timeStamp );
+	}
+}
+
+/*
+====================
+MD5_BinaryMeshLayout
+
+Changes whenever the size of one of the arrays stored in their runtime layout changes.
+====================
+*/
+static int MD5_BinaryMeshLayout( void ) {
+	return sizeof( idJointMat ) | ( sizeof( glIndex_t ) << 8 ) | ( sizeof( silEdge_t ) << 16 ) | ( sizeof( dominantTri_t ) << 24 );
+}
+
+/*
+====================
+idRenderModelMD5::LoadBinary
+
+Loads the model from the binary file written by WriteBinary if it was made from the current text file,
+pak files have no timestamps so the text is identified by its checksum and length.
+====================
+*/
+bool idRenderModelMD5::LoadBinary( unsigned int sourceCRC, int sourceLength ) {
+	idStr		binaryName;
+	void *		buffer;
+	int			length;
+	int			ident, version, layout, binaryLength;
+	unsigned int binaryCRC;
+	int			i, num, parentNum;
+
+	binaryName = name;
+	binaryName.SetFileExtension( MD5_MESH_BINARY_EXT );
+	length = fileSystem->ReadFile( binaryName, &buffer, NULL );
+	if ( !buffer ) {
+		return false;
+	}
+
+	idFile_Memory file( binaryName, (const char *)buffer, length );
+
+	file.ReadInt( ident );
+	file.ReadInt( version );
+	file.ReadInt( layout );
+	file.ReadInt( binaryLength );
+	binaryCRC = 0;
+	file.ReadUnsignedInt( binaryCRC );
+	if ( ident != MD5_BINARY_ID || version != MD5_BINARY_VERSION || layout != MD5_BinaryMeshLayout() ||
+			binaryLength != sourceLength || binaryCRC != sourceCRC ) {
+		fileSystem->FreeFile( buffer );
+		return false;
+	}
+
+	file.ReadInt( num );
+	if ( num < 0 || num > file.Length() - file.Tell() ) {
+		fileSystem->FreeFile( buffer );
+		return false;
+	}
+	joints.SetGranularity( 1 );
+	joints.SetNum( num );
+	defaultPose.SetGranularity( 1 );
+	defaultPose.SetNum( num );
+	for( i = 0; i < joints.Num(); i++ ) {
+		file.ReadString( joints[ i ].name );
+		file.ReadInt( parentNum );
+		joints[ i ].parent = ( parentNum >= 0 && parentNum < i ) ? &joints[ parentNum ] : NULL;
+		file.Read( &defaultPose[ i ], sizeof( defaultPose[ i ] ) );
+	}
+
+	file.ReadInt( num );
+	if ( num < 0 || num > file.Length() - file.Tell() ) {
+		PurgeModel();
+		purged = false;
+		fileSystem->FreeFile( buffer );
+		return false;
+	}
+	meshes.SetGranularity( 1 );
+	meshes.SetNum( num );
+	for( i = 0; i < meshes.Num(); i++ ) {
+		if ( !meshes[ i ].ReadBinary( &file ) ) {
+			break;
+		}
+	}
+
+	file.Read( &bounds, sizeof( bounds ) );
+
+	if ( i < meshes.Num() || file.Tell() != file.Length() ) {
+		common->Warning( "%s is out of date or corrupt", binaryName.c_str() );
+		PurgeModel();
+		purged = false;
+		fileSystem->FreeFile( buffer );
+		return false;
+	}
+
+	fileSystem->FreeFile( buffer );
+
+	return true;
+}
+
+/*
+====================
+idRenderModelMD5::WriteBinary
+====================
+*/
+void idRenderModelMD5::WriteBinary( unsigned int sourceCRC, int sourceLength ) const {
+	idStr		binaryName;
+	idFile *	file;
+	int			i;
+
+	binaryName = name;
+	binaryName.SetFileExtension( MD5_MESH_BINARY_EXT );
+	file = fileSystem->OpenFileWrite( binaryName );
+	if ( !file ) {
+		return;
+	}
+
+	file->WriteInt( MD5_BINARY_ID );
+	file->WriteInt( MD5_BINARY_VERSION );
+	file->WriteInt( MD5_BinaryMeshLayout() );
+	file->WriteInt( sourceLength );
+	file->WriteUnsignedInt( sourceCRC );
+
+	file->WriteInt( joints.Num() );
+	for( i = 0; i < joints.Num(); i++ ) {
+		file->WriteString( joints[ i ].name );
+		file->WriteInt( joints[ i ].parent ? joints[ i ].parent - joints.Ptr() : -1 );
+		file->Write( &defaultPose[ i ], sizeof( defaultPose[ i ] ) );
+	}
+
+	file->WriteInt( meshes.Num() );
+	for( i = 0; i < meshes.Num(); i++ ) {
+		meshes[ i ].WriteBinary( file );
+	}
+
+	file->Write( &bounds, sizeof( bounds ) );
+
+	fileSystem->CloseFile( file );
 }
 
 /*
@@ -713,9 +1320,121 @@ void idRenderModelMD5::DrawJoints( const renderEntity_t *ent, const struct viewD
 	}
 }
 
+/*
+====================
+idRenderModelMD5::BuildTangentWeights
+
+Builds the joint space tangents of the meshes that don't have them yet
+====================
+*/
+void idRenderModelMD5::BuildTangentWeights( void ) {
+	idJointMat	*poseMats;
+	int			i;
+
+	for ( i = 0; i < meshes.Num(); i++ ) {
+		if ( meshes[i].tangentWeights.Num() == 0 ) {
+			break;
+		}
+	}
+	if ( i == meshes.Num() || joints.Num() == 0 ) {
+		return;
+	}
+
+	poseMats = (idJointMat *) _alloca16( joints.Num() * sizeof( poseMats[0] ) );
+	BindPoseJoints( poseMats );
+
+	for ( i = 0; i < meshes.Num(); i++ ) {
+		if ( meshes[i].tangentWeights.Num() == 0 ) {
+			meshes[i].BuildTangentWeights( poseMats );
+		}
+	}
+}
+
+/*
+====================
+idRenderModelMD5::BuildGPUSkinning
+
+Builds the bind pose vertexes and joint weights of the meshes that don't have them yet
+====================
+*/
+void idRenderModelMD5::BuildGPUSkinning( void ) {
+	idJointMat	*poseMats;
+	int			i;
+
+	for ( i = 0; i < meshes.Num(); i++ ) {
+		if ( !meshes[i].gpuSkinningBuilt ) {
+			break;
+		}
+	}
+	if ( i == meshes.Num() || joints.Num() == 0 ) {
+		return;
+	}
+
+	poseMats = (idJointMat *) _alloca16( joints.Num() * sizeof( poseMats[0] ) );
+	BindPoseJoints( poseMats );
+
+	for ( i = 0; i < meshes.Num(); i++ ) {
+		if ( !meshes[i].gpuSkinningBuilt ) {
+			meshes[i].BuildGPUSkinning( poseMats );
+		}
+	}
+}
+
+/*
+====================
+idRenderModelMD5::BindPoseJoints
+
+The model space joints of the default pose
+====================
+*/
+void idRenderModelMD5::BindPoseJoints( idJointMat *poseMats ) const {
+	int *parents = (int *) _alloca16( joints.Num() * sizeof( parents[0] ) );
+	for ( int i = 0; i < joints.Num(); i++ ) {
+		parents[i] = joints[i].parent ? joints[i].parent - joints.Ptr() : -1;
+	}
+	SIMDProcessor->ConvertJointQuatsToJointMats( poseMats, defaultPose.Ptr(), joints.Num() );
+	SIMDProcessor->TransformJoints( poseMats, parents, 1, joints.Num() - 1 );
+}
+
+/*
+====================
+idRenderModelMD5::SkinJob
+
+Skins all the surfaces of one snapshot model
+====================
+*/
+typedef struct {
+	idMD5Mesh *				mesh;
+	srfTriangles_t *		tri;
+} md5SkinSurface_t;
+
+typedef struct {
+	const idJointMat *		joints;
+	float					skinScale;
+	bool					skinTangents;
+	int						numSurfaces;
+	md5SkinSurface_t *		surfaces;
+	idBounds *				bounds;				// of the snapshot model
+} md5SkinJob_t;
+
+void idRenderModelMD5::SkinJob( void *data ) {
+	md5SkinJob_t *job = (md5SkinJob_t *)data;
+
+	for ( int i = 0; i < job->numSurfaces; i++ ) {
+		job->surfaces[i].mesh->SkinSurface( job->surfaces[i].tri, job->joints, job->skinScale, job->skinTangents );
+		job->bounds->AddBounds( job->surfaces[i].tri->bounds );
+	}
+}
+
 /*
 ====================
 idRenderModelMD5::InstantiateDynamicModel
+
+If tr.modelJobs is set the surfaces are only set up here, and skinned by a job
+that is added to the list.  With r_skinnedTangents the bind pose tangents are
+skinned along with the positions, otherwise they are left for R_DeriveTangents
+to derive on demand.  If tr.skinOnGPU is set, the meshes that the vertex programs
+can skin only get the joints of the pose, see idMD5Mesh::SetupSkinnedSurface.
 ====================
 */
 idRenderModel *idRenderModelMD5::InstantiateDynamicModel( const struct renderEntity_s *ent, const struct viewDef_s *view, idRenderModel *cachedModel ) {
@@ -769,6 +1488,28 @@ idRenderModel *idRenderModelMD5::InstantiateDynamicModel( const struct renderEnt
 		}
 	}
 
+	if ( r_skinnedTangents.GetInteger() != 0 ) {
+		BuildTangentWeights();
+	}
+
+	// the vertex programs have no skin scale, and can't derive tangents for the comparison
+	bool skinOnGPU = tr.skinOnGPU && ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ] == 0.0f && r_skinnedTangents.GetInteger() != 2;
+	if ( skinOnGPU ) {
+		BuildGPUSkinning();
+	}
+
+	// the tangent comparison prints, so it can't run in a job
+	md5SkinJob_t *skinJob = NULL;
+	if ( tr.modelJobs && r_useSkinningJobs.GetBool() && r_skinnedTangents.GetInteger() != 2 ) {
+		skinJob = (md5SkinJob_t *)R_FrameAlloc( sizeof( *skinJob ) );
+		skinJob->joints = ent->joints;
+		skinJob->skinScale = ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ];
+		skinJob->skinTangents = r_skinnedTangents.GetInteger() != 0;
+		skinJob->numSurfaces = 0;
+		skinJob->surfaces = (md5SkinSurface_t *)R_FrameAlloc( meshes.Num() * sizeof( skinJob->surfaces[0] ) );
+		skinJob->bounds = &staticModel->bounds;
+	}
+
 	// create all the surfaces
 	for( mesh = meshes.Ptr(), i = 0; i < meshes.Num(); i++, mesh++ ) {
 		// avoid deforming the surface if it will be a nodraw due to a skin remapping
@@ -800,12 +1541,32 @@ idRenderModel *idRenderModelMD5::InstantiateDynamicModel( const struct renderEnt
 			surf->id = i;
 		}
 
+		// surfaces with deforms, ambient stages, guis or subviews read the skinned vertexes
+		if ( skinOnGPU && mesh->SkinsOnGPU() && shader->Deform() == DFRM_NONE && !shader->HasAmbient()
+				&& !shader->HasGui() && !shader->HasSubview() ) {
+			mesh->SetupSkinnedSurface( ent->joints, surf );
+			surf->geometry->bounds = ent->bounds;
+			staticModel->bounds.AddBounds( ent->bounds );
+			continue;
+		}
+
+		if ( skinJob ) {
+			md5SkinSurface_t &skinSurf = skinJob->surfaces[skinJob->numSurfaces++];
+			skinSurf.mesh = mesh;
+			skinSurf.tri = mesh->SetupSurface( surf );
+			continue;
+		}
+
 		mesh->UpdateSurface( ent, ent->joints, surf );
 
 		staticModel->bounds.AddPoint( surf->geometry->bounds[0] );
 		staticModel->bounds.AddPoint( surf->geometry->bounds[1] );
 	}
 
+	if ( skinJob && skinJob->numSurfaces > 0 ) {
+		tr.modelJobs->AddJob( SkinJob, skinJob );
+	}
+
 	return staticModel;
 }
 
@@ -952,6 +1713,8 @@ int	idRenderModelMD5::Memory() const {
 		const idMD5Mesh *mesh = &meshes[i];
 
 		total += mesh->texCoords.MemoryUsed() + mesh->numWeights * ( sizeof( mesh->scaledWeights[0] ) + sizeof( mesh->weightIndex[0] ) * 2 );
+		total += mesh->tangentWeights.MemoryUsed() + mesh->bindVerts.MemoryUsed() + mesh->skinWeights.MemoryUsed();
+		total += mesh->skinJoints.MemoryUsed() + mesh->invBindJoints.MemoryUsed();
 
 		// sum up deform info
 		total += sizeof( mesh->deformInfo );
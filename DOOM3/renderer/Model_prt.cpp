@@ -62,9 +62,177 @@ void idRenderModelPrt::TouchData( void ) {
 	particleSystem = static_cast<const idDeclParticle *>( declManager->FindType( DECL_PARTICLE, name ) );
 }
 
+/*
+====================
+idRenderModelPrt::StageJob
+
+Creates the particles of one stage in its snapshot surface
+====================
+*/
+typedef struct {
+	const idParticleStage *	stage;
+	particleGen_t			g;
+	srfTriangles_t *		tri;
+	bool					useBatches;
+	int						numParticles;		// that passed the age tests
+	int						usec;
+} prtStageJob_t;
+
+// stages with fewer particles are not worth a job of their own
+static const int MIN_JOB_PARTICLES = 32;
+
+// queued jobs waiting for R_FinishParticleJobs to add up their counters
+static idList<prtStageJob_t *> prtQueuedStageJobs;
+
+void idRenderModelPrt::StageJob( void *data ) {
+	prtStageJob_t *job = (prtStageJob_t *)data;
+	const idParticleStage *stage = job->stage;
+	const struct renderEntity_s *renderEntity = job->g.renderEnt;
+	particleGen_t &g = job->g;
+	particleBatch_t batch;
+
+	unsigned int start = Sys_Microseconds();
+
+	idRandom steppingRandom, steppingRandom2;
+
+	int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
+	int	stageCycle = stageAge / stage->cycleMsec;
+
+	// some particles will be in this cycle, some will be in the previous cycle
+	steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+	steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+
+	int numVerts = 0;
+	idDrawVert *verts = job->tri->verts;
+
+	batch.numParticles = 0;
+	batch.localOrigins = false;
+	job->numParticles = 0;
+
+	for ( int index = 0; index < stage->totalParticles; index++ ) {
+		g.index = index;
+
+		// bump the random
+		steppingRandom.RandomInt();
+		steppingRandom2.RandomInt();
+
+		// calculate local age for this index
+		int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / stage->totalParticles;
+
+		int particleAge = stageAge - bunchOffset;
+		int	particleCycle = particleAge / stage->cycleMsec;
+		if ( particleCycle < 0 ) {
+			// before the particleSystem spawned
+			continue;
+		}
+		if ( stage->cycles && particleCycle >= stage->cycles ) {
+			// cycled systems will only run cycle times
+			continue;
+		}
+
+		if ( particleCycle == stageCycle ) {
+			g.random = steppingRandom;
+		} else {
+			g.random = steppingRandom2;
+		}
+
+		int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
+
+		if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] &&
+			g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
+			// don't fire any more particles
+			continue;
+		}
+
+		// supress particles before or after the age clamp
+		g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
+		if ( g.frac < 0.0f ) {
+			// yet to be spawned
+			continue;
+		}
+		if ( g.frac > 1.0f ) {
+			// this particle is in the deadTime band
+			continue;
+		}
+
+		job->numParticles++;
+
+		if ( job->useBatches ) {
+			batch.index[batch.numParticles] = index;
+			batch.frac[batch.numParticles] = g.frac;
+			batch.random[batch.numParticles] = g.random;
+			if ( ++batch.numParticles == MAX_PARTICLE_BATCH ) {
+				numVerts += stage->CreateParticleBatch( &g, &batch, verts + numVerts );
+			}
+			continue;
+		}
+
+		// this is needed so aimed particles can calculate origins at different times
+		g.originalRandom = g.random;
+
+		g.age = g.frac * stage->particleLife;
+
+		// if the particle doesn't get drawn because it is faded out or beyond a kill region, don't increment the verts
+		numVerts += stage->CreateParticle( &g, verts + numVerts );
+	}
+
+	if ( batch.numParticles > 0 ) {
+		numVerts += stage->CreateParticleBatch( &g, &batch, verts + numVerts );
+	}
+
+	// numVerts must be a multiple of 4
+	assert( ( numVerts & 3 ) == 0 && numVerts <= 4 * stage->totalParticles * stage->NumQuadsPerParticle() );
+
+	// build the indexes
+	int	numIndexes = 0;
+	glIndex_t *indexes = job->tri->indexes;
+	for ( int i = 0; i < numVerts; i += 4 ) {
+		indexes[numIndexes+0] = i;
+		indexes[numIndexes+1] = i+2;
+		indexes[numIndexes+2] = i+3;
+		indexes[numIndexes+3] = i;
+		indexes[numIndexes+4] = i+3;
+		indexes[numIndexes+5] = i+1;
+		numIndexes += 6;
+	}
+
+	job->tri->numVerts = numVerts;
+	job->tri->numIndexes = numIndexes;
+
+	job->usec = Sys_Microseconds() - start;
+}
+
+/*
+====================
+R_AddParticleStageCounters
+====================
+*/
+static void R_AddParticleStageCounters( const prtStageJob_t *job ) {
+	tr.pc.c_particleStages++;
+	tr.pc.c_particles += job->numParticles;
+	tr.pc.c_particleUsec += job->usec;
+}
+
+/*
+====================
+R_FinishParticleJobs
+
+Called after the jobs of tr.modelJobs are done
+====================
+*/
+void R_FinishParticleJobs( void ) {
+	for ( int i = 0; i < prtQueuedStageJobs.Num(); i++ ) {
+		R_AddParticleStageCounters( prtQueuedStageJobs[i] );
+	}
+	prtQueuedStageJobs.SetNum( 0, false );
+}
+
 /*
 ====================
 idRenderModelPrt::InstantiateDynamicModel
+
+If tr.modelJobs is set the stages with enough particles are only set up here,
+and created by jobs that are added to the list.
 ====================
 */
 idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEntity_s *renderEntity, const struct viewDef_s *viewDef, idRenderModel *cachedModel ) {
@@ -107,12 +275,9 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 		staticModel->InitEmpty( parametricParticle_SnapshotName );
 	}
 
-	particleGen_t g;
-
-	g.renderEnt = renderEntity;
-	g.renderView = &viewDef->renderView;
-	g.origin.Zero();
-	g.axis.Identity();
+	// the jobs run after the time of a time group entity has been restored in the view
+	const renderView_t *renderView = &viewDef->renderView;
+	bool useJobs = ( tr.modelJobs != NULL && r_useParticleJobs.GetBool() );
 
 	for ( int stageNum = 0; stageNum < particleSystem->stages.Num(); stageNum++ ) {
 		idParticleStage *stage = particleSystem->stages[stageNum];
@@ -128,15 +293,6 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 			continue;
 		}
 
-		idRandom steppingRandom, steppingRandom2;
-
-		int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
-		int	stageCycle = stageAge / stage->cycleMsec;
-
-		// some particles will be in this cycle, some will be in the previous cycle
-		steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
-		steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
-
 		int	count = stage->totalParticles * stage->NumQuadsPerParticle();
 
 		int surfaceNum;
@@ -155,85 +311,42 @@ idRenderModel *idRenderModelPrt::InstantiateDynamicModel( const struct renderEnt
 			R_AllocStaticTriSurfPlanes( surf->geometry, 6 * count );
 		}
 
-		int numVerts = 0;
-		idDrawVert *verts = surf->geometry->verts;
-
-		for ( int index = 0; index < stage->totalParticles; index++ ) {
-			g.index = index;
-
-			// bump the random
-			steppingRandom.RandomInt();
-			steppingRandom2.RandomInt();
-
-			// calculate local age for this index
-			int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / stage->totalParticles;
-
-			int particleAge = stageAge - bunchOffset;
-			int	particleCycle = particleAge / stage->cycleMsec;
-			if ( particleCycle < 0 ) {
-				// before the particleSystem spawned
-				continue;
-			}
-			if ( stage->cycles && particleCycle >= stage->cycles ) {
-				// cycled systems will only run cycle times
-				continue;
-			}
-
-			if ( particleCycle == stageCycle ) {
-				g.random = steppingRandom;
-			} else {
-				g.random = steppingRandom2;
-			}
-
-			int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
-
-			if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] &&
-				g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
-				// don't fire any more particles
-				continue;
-			}
+		surf->geometry->tangentsCalculated = false;
+		surf->geometry->facePlanesCalculated = false;
+		surf->geometry->bounds = stage->bounds;		// just always draw the particles
 
-			// supress particles before or after the age clamp
-			g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
-			if ( g.frac < 0.0f ) {
-				// yet to be spawned
-				continue;
-			}
-			if ( g.frac > 1.0f ) {
-				// this particle is in the deadTime band
-				continue;
+		if ( useJobs && stage->totalParticles >= MIN_JOB_PARTICLES ) {
+			if ( renderView == &viewDef->renderView ) {
+				renderView_t *copy = (renderView_t *)R_FrameAlloc( sizeof( *copy ) );
+				*copy = viewDef->renderView;
+				renderView = copy;
 			}
 
-			// this is needed so aimed particles can calculate origins at different times
-			g.originalRandom = g.random;
-
-			g.age = g.frac * stage->particleLife;
-
-			// if the particle doesn't get drawn because it is faded out or beyond a kill region, don't increment the verts
-			numVerts += stage->CreateParticle( &g, verts + numVerts );
-		}
-
-		// numVerts must be a multiple of 4
-		assert( ( numVerts & 3 ) == 0 && numVerts <= 4 * count );
-
-		// build the indexes
-		int	numIndexes = 0;
-		glIndex_t *indexes = surf->geometry->indexes;
-		for ( int i = 0; i < numVerts; i += 4 ) {
-			indexes[numIndexes+0] = i;
-			indexes[numIndexes+1] = i+2;
-			indexes[numIndexes+2] = i+3;
-			indexes[numIndexes+3] = i;
-			indexes[numIndexes+4] = i+3;
-			indexes[numIndexes+5] = i+1;
-			numIndexes += 6;
+			prtStageJob_t *job = (prtStageJob_t *)R_FrameAlloc( sizeof( *job ) );
+			job->stage = stage;
+			job->g.renderEnt = renderEntity;
+			job->g.renderView = renderView;
+			job->g.origin.Zero();
+			job->g.axis.Identity();
+			job->tri = surf->geometry;
+			job->useBatches = r_useParticleBatches.GetBool();
+
+			tr.modelJobs->AddJob( StageJob, job );
+			prtQueuedStageJobs.Append( job );
+			continue;
 		}
 
-		surf->geometry->tangentsCalculated = false;
-		surf->geometry->facePlanesCalculated = false;
-		surf->geometry->numVerts = numVerts;
-		surf->geometry->numIndexes = numIndexes;
-		surf->geometry->bounds = stage->bounds;		// just always draw the particles
+		prtStageJob_t job;
+		job.stage = stage;
+		job.g.renderEnt = renderEntity;
+		job.g.renderView = &viewDef->renderView;
+		job.g.origin.Zero();
+		job.g.axis.Identity();
+		job.tri = surf->geometry;
+		job.useBatches = r_useParticleBatches.GetBool();
+
+		StageJob( &job );
+		R_AddParticleStageCounters( &job );
 	}
 
 	return staticModel;
@@ -41,6 +41,8 @@ idRenderEntityLocal::idRenderEntityLocal() {
 	dynamicModel			= NULL;
 	dynamicModelFrameCount	= 0;
 	cachedDynamicModel		= NULL;
+	dynamicModelHash		= 0;
+	dynamicModelOnGPU		= false;
 	referenceBounds			= bounds_zero;
 	viewCount				= 0;
 	viewEntity				= NULL;
@@ -48,6 +50,7 @@ idRenderEntityLocal::idRenderEntityLocal() {
 	decals					= NULL;
 	overlay					= NULL;
 	entityRefs				= NULL;
+	moveCount				= 0;
 	firstInteraction		= NULL;
 	lastInteraction			= NULL;
 	needsPortalSky			= false;
@@ -101,6 +104,7 @@ idRenderLightLocal::idRenderLightLocal() {
 	foggedPortals			= NULL;
 	firstInteraction		= NULL;
 	lastInteraction			= NULL;
+	interactionSweepCount	= -1;
 }
 
 void idRenderLightLocal::FreeRenderLight() {
@@ -56,7 +56,7 @@ static void R_PerformanceCounters( void ) {
 		float megaBytes = globalImages->SumOfUsedImages() / ( 1024*1024.0 );
 
 		if ( r_showPrimitives.GetInteger() > 1 ) {
-			common->Printf( "v:%i ds:%i t:%i/%i v:%i/%i st:%i sv:%i image:%5.1f MB\n",
+			common->Printf( "v:%i ds:%i t:%i/%i v:%i/%i st:%i sv:%i shc:%i/%i image:%5.1f MB\n",
 				tr.pc.c_numViews,
 				backEnd.pc.c_drawElements + backEnd.pc.c_shadowElements,
 				backEnd.pc.c_drawIndexes / 3,
@@ -65,15 +65,19 @@ static void R_PerformanceCounters( void ) {
 				( backEnd.pc.c_drawVertexes - backEnd.pc.c_drawRefVertexes ),
 				backEnd.pc.c_shadowIndexes / 3,
 				backEnd.pc.c_shadowVertexes,
+				tr.pc.c_shadowCacheHits,
+				tr.pc.c_shadowCacheMisses,
 				megaBytes
 				);
 		} else {
-			common->Printf( "views:%i draws:%i tris:%i (shdw:%i) (vbo:%i) image:%5.1f MB\n",
+			common->Printf( "views:%i draws:%i tris:%i (shdw:%i) (vbo:%i) (shdwCache:%i/%i) image:%5.1f MB\n",
 				tr.pc.c_numViews,
 				backEnd.pc.c_drawElements + backEnd.pc.c_shadowElements,
 				( backEnd.pc.c_drawIndexes + backEnd.pc.c_shadowIndexes ) / 3,
 				backEnd.pc.c_shadowIndexes / 3,
 				backEnd.pc.c_vboIndexes / 3,
+				tr.pc.c_shadowCacheHits,
+				tr.pc.c_shadowCacheMisses,
 				megaBytes
 				);
 		}
@@ -96,6 +100,33 @@ static void R_PerformanceCounters( void ) {
 			tr.pc.c_box_cull_in, tr.pc.c_box_cull_out );
 	}
 
+	if ( r_showPortalFlood.GetBool() ) {
+		common->Printf( "floodAreas:%i portalClips:%i floodCacheHits:%i floodCacheMisses:%i floodUsec:%i\n",
+			tr.pc.c_portalFloodAreas, tr.pc.c_portalClips,
+			tr.pc.c_portalFloodCacheHits, tr.pc.c_portalFloodCacheMisses, tr.pc.c_portalFloodUsec );
+	}
+
+	if ( r_skinnedTangents.GetInteger() == 2 && tr.pc.c_skinnedTangentVerts ) {
+		common->Printf( "skinnedTangentVerts:%i average error:%1.2f max error:%1.2f degrees\n", tr.pc.c_skinnedTangentVerts,
+			tr.pc.skinnedTangentError / ( tr.pc.c_skinnedTangentVerts * 3 ), tr.pc.skinnedTangentMaxError );
+	}
+
+	if ( r_showOcclusion.GetBool() ) {
+		common->Printf( "occluderTris:%i occlusionTests:%i occludedEntities:%i occludedLights:%i occlusionUsec:%i\n",
+			tr.pc.c_occluderTris, tr.pc.c_occlusionTests,
+			tr.pc.c_occludedEntities, tr.pc.c_occludedLights, tr.pc.c_occlusionUsec );
+	}
+
+	if ( r_showParticles.GetBool() ) {
+		common->Printf( "particleStages:%i particles:%i particleUsec:%i\n",
+			tr.pc.c_particleStages, tr.pc.c_particles, tr.pc.c_particleUsec );
+	}
+
+	if ( r_showGuiSurfaces.GetBool() ) {
+		common->Printf( "guiSurfs:%i guiDraws:%i guiAtlasTiles:%i\n",
+			tr.pc.c_guiModelSurfs, tr.pc.c_guiModelDraws, tr.pc.c_guiAtlasTiles );
+	}
+
 	if ( r_showAlloc.GetBool() ) {
 		common->Printf( "alloc:%i free:%i\n", tr.pc.c_alloc, tr.pc.c_free );
 	}
@@ -285,6 +316,21 @@ static void R_CheckCvars( void ) {
 		r_brightness.ClearModified();
 		R_SetColorMappings();
 	}
+
+	// the interactions hold either shadow volumes or shadow map casters,
+	// and the dynamic models may have been skinned by the vertex programs
+	if ( r_useShadowMapping.IsModified() || r_useGPUSkinning.IsModified() ) {
+		r_useShadowMapping.ClearModified();
+		r_useGPUSkinning.ClearModified();
+		for ( int i = 0; i < tr.worlds.Num(); i++ ) {
+			tr.worlds[i]->FreeInteractions();
+			for ( int j = 0; j < tr.worlds[i]->entityDefs.Num(); j++ ) {
+				if ( tr.worlds[i]->entityDefs[j] ) {
+					R_ClearEntityDefDynamicModel( tr.worlds[i]->entityDefs[j] );
+				}
+			}
+		}
+	}
 }
 
 /*
@@ -631,6 +677,9 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	// check for dynamic changes that require some initialization
 	R_CheckCvars();
 
+	// evict or stream images to stay in the texture memory budget
+	globalImages->UpdateResidency();
+
 	// check for errors
 	GL_CheckErrors();
 
@@ -68,12 +68,19 @@ idCVar r_specularExponent("r_specularExponent", "3", CVAR_RENDERER | CVAR_FLOAT,
 idCVar r_useConstantMaterials( "r_useConstantMaterials", "1", CVAR_RENDERER | CVAR_BOOL, "use pre-calculated material registers if possible" );
 idCVar r_useSilRemap( "r_useSilRemap", "1", CVAR_RENDERER | CVAR_BOOL, "consider verts with the same XYZ, but different ST the same for shadows" );
 idCVar r_useNodeCommonChildren( "r_useNodeCommonChildren", "1", CVAR_RENDERER | CVAR_BOOL, "stop pushing reference bounds early when possible" );
+idCVar r_usePortalFloodCache( "r_usePortalFloodCache", "1", CVAR_RENDERER | CVAR_BOOL, "reuse the portal flood of a view that didn't leave its area or move" );
+idCVar r_portalFloodCacheDist( "r_portalFloodCacheDist", "0.1", CVAR_RENDERER | CVAR_FLOAT, "distance the view origin can move and still reuse a portal flood" );
 idCVar r_useShadowProjectedCull( "r_useShadowProjectedCull", "1", CVAR_RENDERER | CVAR_BOOL, "discard triangles outside light volume before shadowing" );
 idCVar r_useShadowSurfaceScissor( "r_useShadowSurfaceScissor", "1", CVAR_RENDERER | CVAR_BOOL, "scissor shadows by the scissor rect of the interaction surfaces" );
-idCVar r_useInteractionTable( "r_useInteractionTable", "1", CVAR_RENDERER | CVAR_BOOL, "create a full entityDefs * lightDefs table to make finding interactions faster" );
+idCVar r_useInteractionTable( "r_useInteractionTable", "1", CVAR_RENDERER | CVAR_BOOL, "use the sparse lightDef / entityDef table instead of the entityDef interaction lists to find interactions" );
 idCVar r_useTurboShadow( "r_useTurboShadow", "1", CVAR_RENDERER | CVAR_BOOL, "use the infinite projection with W technique for dynamic shadows" );
 idCVar r_useDeferredTangents( "r_useDeferredTangents", "1", CVAR_RENDERER | CVAR_BOOL, "defer tangents calculations after deform" );
 idCVar r_useCachedDynamicModels( "r_useCachedDynamicModels", "1", CVAR_RENDERER | CVAR_BOOL, "cache snapshots of dynamic models" );
+idCVar r_useSkinningJobs( "r_useSkinningJobs", "1", CVAR_RENDERER | CVAR_BOOL, "skin the md5 models of the visible entities on the job threads" );
+idCVar r_useParticleJobs( "r_useParticleJobs", "1", CVAR_RENDERER | CVAR_BOOL, "create the particles of the visible particle systems on the job threads" );
+idCVar r_useParticleBatches( "r_useParticleBatches", "1", CVAR_RENDERER | CVAR_BOOL, "create particles in batches with the SIMD processor instead of one at a time" );
+idCVar r_useGuiAtlas( "r_useGuiAtlas", "1", CVAR_RENDERER | CVAR_BOOL, "copy small gui images and font pages into a texture atlas and merge the gui surfaces that use it" );
+idCVar r_skinnedTangents( "r_skinnedTangents", "1", CVAR_RENDERER | CVAR_INTEGER, "0 = derive md5 tangents from the triangles every frame, 1 = skin the bind pose tangents with the joints, 2 = draw derived tangents and report their angle to the skinned ones", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
 idCVar r_useStateCaching( "r_useStateCaching", "1", CVAR_RENDERER | CVAR_BOOL, "avoid redundant state changes in GL_*() calls" );
 idCVar r_useInfiniteFarZ( "r_useInfiniteFarZ", "1", CVAR_RENDERER | CVAR_BOOL, "use the no-far-clip-plane trick" );
 
@@ -121,6 +128,8 @@ idCVar r_useLightScissors( "r_useLightScissors", "1", CVAR_RENDERER | CVAR_BOOL,
 idCVar r_useClippedLightScissors( "r_useClippedLightScissors", "1", CVAR_RENDERER | CVAR_INTEGER, "0 = full screen when near clipped, 1 = exact when near clipped, 2 = exact always", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
 idCVar r_useEntityCulling( "r_useEntityCulling", "1", CVAR_RENDERER | CVAR_BOOL, "0 = none, 1 = box" );
 idCVar r_useEntityScissors( "r_useEntityScissors", "0", CVAR_RENDERER | CVAR_BOOL, "1 = use custom scissor rectangle for each entity" );
+idCVar r_useOcclusionCulling( "r_useOcclusionCulling", "1", CVAR_RENDERER | CVAR_BOOL, "1 = cull entities and lights hidden behind the world with a software depth buffer" );
+idCVar r_occluderMinArea( "r_occluderMinArea", "2", CVAR_RENDERER | CVAR_FLOAT, "smallest occluder triangle rasterized, in occlusion buffer pixels" );
 idCVar r_useInteractionCulling( "r_useInteractionCulling", "1", CVAR_RENDERER | CVAR_BOOL, "1 = cull interactions" );
 idCVar r_useInteractionScissors( "r_useInteractionScissors", "2", CVAR_RENDERER | CVAR_INTEGER, "1 = use a custom scissor rectangle for each shadow interaction, 2 = also crop using portal scissors", -2, 2, idCmdSystem::ArgCompletion_Integer<-2,2> );
 idCVar r_useShadowCulling( "r_useShadowCulling", "1", CVAR_RENDERER | CVAR_BOOL, "try to cull shadows from partially visible lights" );
@@ -155,6 +164,15 @@ idCVar r_singleSurface( "r_singleSurface", "-1", CVAR_RENDERER | CVAR_INTEGER, "
 idCVar r_singleArea( "r_singleArea", "0", CVAR_RENDERER | CVAR_BOOL, "only draw the portal area the view is actually in" );
 idCVar r_forceLoadImages( "r_forceLoadImages", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "draw all images to screen after registration" );
 idCVar r_orderIndexes( "r_orderIndexes", "1", CVAR_RENDERER | CVAR_BOOL, "perform index reorganization to optimize vertex use" );
+idCVar r_useShadowCache( "r_useShadowCache", "1", CVAR_RENDERER | CVAR_BOOL, "reuse the shadow volumes of animated entities when neither the pose nor the light changed" );
+idCVar r_useShadowMapping( "r_useShadowMapping", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "use shadow maps instead of stencil shadow volumes, parallel lights keep their shadow volumes" );
+idCVar r_useGPUSkinning( "r_useGPUSkinning", "1", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "skin md5 models in the vertex programs when shadow mapping, instead of on the CPU" );
+idCVar r_shadowMapAtlasSize( "r_shadowMapAtlasSize", "2048", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "size of the shadow map atlas texture, rounded down to a power of two", 256, 4096 );
+idCVar r_shadowMapSize( "r_shadowMapSize", "512", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "tile size of a light covering the whole screen, smaller lights get smaller tiles", 32, 2048 );
+idCVar r_shadowMapMinSize( "r_shadowMapMinSize", "64", CVAR_RENDERER | CVAR_INTEGER, "smallest shadow map tile size", 16, 512 );
+idCVar r_shadowMapBias( "r_shadowMapBias", "2", CVAR_RENDERER | CVAR_FLOAT, "depth bias in world units for shadow map comparisons" );
+idCVar r_shadowMapSlopeBias( "r_shadowMapSlopeBias", "2", CVAR_RENDERER | CVAR_FLOAT, "polygon offset factor for the shadow map casters, scales with their slope to the light" );
+idCVar r_binaryMD5( "r_binaryMD5", "1", CVAR_RENDERER | CVAR_BOOL, "load md5 meshes and anims from binary files generated from the text files" );
 idCVar r_lightAllBackFaces( "r_lightAllBackFaces", "0", CVAR_RENDERER | CVAR_BOOL, "light all the back faces, even when they would be shadowed" );
 
 // visual debugging info
@@ -180,6 +198,10 @@ idCVar r_showSurfaceInfo( "r_showSurfaceInfo", "0", CVAR_RENDERER | CVAR_BOOL, "
 idCVar r_showNormals( "r_showNormals", "0", CVAR_RENDERER | CVAR_FLOAT, "draws wireframe normals" );
 idCVar r_showMemory( "r_showMemory", "0", CVAR_RENDERER | CVAR_BOOL, "print frame memory utilization" );
 idCVar r_showCull( "r_showCull", "0", CVAR_RENDERER | CVAR_BOOL, "report sphere and box culling stats" );
+idCVar r_showPortalFlood( "r_showPortalFlood", "0", CVAR_RENDERER | CVAR_BOOL, "report portal flood areas, clips, cache hits and time" );
+idCVar r_showOcclusion( "r_showOcclusion", "0", CVAR_RENDERER | CVAR_BOOL, "report occluder triangles, occlusion tests and culled entities and lights" );
+idCVar r_showParticles( "r_showParticles", "0", CVAR_RENDERER | CVAR_BOOL, "report particle stages, particles and time" );
+idCVar r_showGuiSurfaces( "r_showGuiSurfaces", "0", CVAR_RENDERER | CVAR_BOOL, "report gui surfaces, the draws they were batched into and images added to the gui atlas" );
 idCVar r_showInteractions( "r_showInteractions", "0", CVAR_RENDERER | CVAR_BOOL, "report interaction generation activity" );
 idCVar r_showDepth( "r_showDepth", "0", CVAR_RENDERER | CVAR_BOOL, "display the contents of the depth buffer and the depth range" );
 idCVar r_showSurfaces( "r_showSurfaces", "0", CVAR_RENDERER | CVAR_BOOL, "report surface/light/shadow counts" );
@@ -1600,6 +1622,7 @@ void R_InitCommands( void ) {
 	cmdSystem->AddCommand( "regenerateWorld", R_RegenerateWorld_f, CMD_FL_RENDERER, "regenerates all interactions" );
 	cmdSystem->AddCommand( "showInteractionMemory", R_ShowInteractionMemory_f, CMD_FL_RENDERER, "shows memory used by interactions" );
 	cmdSystem->AddCommand( "showTriSurfMemory", R_ShowTriSurfMemory_f, CMD_FL_RENDERER, "shows memory used by triangle surfaces" );
+	cmdSystem->AddCommand( "benchShadowCull", R_BenchShadowCull_f, CMD_FL_RENDERER, "times the shadow volume point cull and sil edge kernels on the current map" );
 	cmdSystem->AddCommand( "vid_restart", R_VidRestart_f, CMD_FL_RENDERER, "restarts renderSystem" );
 	cmdSystem->AddCommand( "listRenderEntityDefs", R_ListRenderEntityDefs_f, CMD_FL_RENDERER, "lists the entity defs" );
 	cmdSystem->AddCommand( "listRenderLightDefs", R_ListRenderLightDefs_f, CMD_FL_RENDERER, "lists the light defs" );
@@ -1632,6 +1655,8 @@ void idRenderSystemLocal::Clear( void ) {
 	testImage = NULL;
 	ambientCubeImage = NULL;
 	viewDef = NULL;
+	modelJobs = NULL;
+	skinOnGPU = false;
 	memset( &pc, 0, sizeof( pc ) );
 	memset( &lockSurfacesCmd, 0, sizeof( lockSurfacesCmd ) );
 	memset( &identitySpace, 0, sizeof( identitySpace ) );
@@ -1705,6 +1730,8 @@ void idRenderSystemLocal::Shutdown( void ) {
 
 	idCinematic::ShutdownCinematic( );
 
+	R_ShutdownGuiAtlas();
+
 	globalImages->Shutdown();
 
 	// free frame memory
@@ -1731,6 +1758,7 @@ idRenderSystemLocal::BeginLevelLoad
 void idRenderSystemLocal::BeginLevelLoad( void ) {
 	renderModelManager->BeginLevelLoad();
 	globalImages->BeginLevelLoad();
+	R_ClearGuiAtlas();
 }
 
 /*
@@ -1741,6 +1769,7 @@ idRenderSystemLocal::EndLevelLoad
 void idRenderSystemLocal::EndLevelLoad( void ) {
 	renderModelManager->EndLevelLoad();
 	globalImages->EndLevelLoad();
+	R_FillGuiAtlas();
 }
 
 /*
@@ -142,9 +142,13 @@ idRenderWorldLocal::idRenderWorldLocal() {
 	doublePortals = NULL;
 	numInterAreaPortals = 0;
 
-	interactionTable = 0;
-	interactionTableWidth = 0;
-	interactionTableHeight = 0;
+	portalStateCount = 0;
+	portalFloodRecord = NULL;
+	portalFloodCacheUses = 0;
+	ClearPortalFloodCaches();
+
+	entityRefChangeCount = 0;
+	entityMoveCount = 0;
 }
 
 /*
@@ -162,19 +166,6 @@ idRenderWorldLocal::~idRenderWorldLocal() {
 	//RB_ClearDebugText( 0 );
 }
 
-/*
-===================
-ResizeInteractionTable
-===================
-*/
-void idRenderWorldLocal::ResizeInteractionTable() {
-	// we overflowed the interaction table, so dump it
-	// we may want to resize this in the future if it turns out to be common
-	common->Printf( "idRenderWorldLocal::ResizeInteractionTable: overflowed interactionTableWidth, dumping\n" );
-	R_StaticFree( interactionTable );
-	interactionTable = NULL;
-}
-
 /*
 ===================
 AddEntityDef
@@ -185,9 +176,6 @@ qhandle_t idRenderWorldLocal::AddEntityDef( const renderEntity_t *re ){
 	int entityHandle = entityDefs.FindNull();
 	if ( entityHandle == -1 ) {
 		entityHandle = entityDefs.Append( NULL );
-		if ( interactionTable && entityDefs.Num() > interactionTableWidth ) {
-			ResizeInteractionTable();
-		}
 	}
 
 	UpdateEntityDef( entityHandle, re );
@@ -256,11 +244,14 @@ void idRenderWorldLocal::UpdateEntityDef( qhandle_t entityHandle, const renderEn
 			}
 		}
 
+		// the areas the entity leaves are marked, see AddEntityRefToArea
+		def->moveCount = ++entityMoveCount;
+
 		// save any decals if the model is the same, allowing marks to move with entities
 		if ( def->parms.hModel == re->hModel ) {
-			R_FreeEntityDefDerivedData( def, true, true );
+			R_FreeEntityDefDerivedData( def, true, true, true );
 		} else {
-			R_FreeEntityDefDerivedData( def, false, false );
+			R_FreeEntityDefDerivedData( def, false, false, true );
 		}
 	} else {
 		// creating a new one
@@ -289,6 +280,10 @@ void idRenderWorldLocal::UpdateEntityDef( qhandle_t entityHandle, const renderEn
 	// based on the model bounds, add references in each area
 	// that may contain the updated surface
 	R_CreateEntityRefs( def );
+	def->moveCount = 0;
+
+	// drop the interactions with lights the entity moved away from
+	R_UpdateEntityDefInteractions( def );
 }
 
 /*
@@ -313,7 +308,10 @@ void idRenderWorldLocal::FreeEntityDef( qhandle_t entityHandle ) {
 		return;
 	}
 
-	R_FreeEntityDefDerivedData( def, false, false );
+	R_FreeEntityDefDerivedData( def, false, false, false );
+
+	// the shadow cache keys on the entityDef pointer
+	R_PurgeShadowCache( def, NULL );
 
 	if ( session->writeDemo && def->archived ) {
 		WriteFreeEntity( entityHandle );
@@ -364,9 +362,6 @@ qhandle_t idRenderWorldLocal::AddLightDef( const renderLight_t *rlight ) {
 
 	if ( lightHandle == -1 ) {
 		lightHandle = lightDefs.Append( NULL );
-		if ( interactionTable && lightDefs.Num() > interactionTableHeight ) {
-			ResizeInteractionTable();
-		}
 	}
 	UpdateLightDef( lightHandle, rlight );
 
@@ -414,7 +409,7 @@ void idRenderWorldLocal::UpdateLightDef( qhandle_t lightHandle, const renderLigh
 		} else {
 			// if we are updating shadows, the prelight model is no longer valid
 			light->lightHasMoved = true;
-			R_FreeLightDefDerivedData( light );
+			R_FreeLightDefDerivedData( light, true );
 		}
 	} else {
 		// create a new one
@@ -440,6 +435,7 @@ void idRenderWorldLocal::UpdateLightDef( qhandle_t lightHandle, const renderLigh
 		R_DeriveLightData( light );
 		R_CreateLightRefs( light );
 		R_CreateLightDefFogPortals( light );
+		R_UpdateLightDefInteractions( light );
 	}
 }
 
@@ -465,7 +461,10 @@ void idRenderWorldLocal::FreeLightDef( qhandle_t lightHandle ) {
 		return;
 	}
 
-	R_FreeLightDefDerivedData( light );
+	R_FreeLightDefDerivedData( light, false );
+
+	// the shadow cache keys on the lightDef pointer
+	R_PurgeShadowCache( NULL, light );
 
 	if ( session->writeDemo && light->archived ) {
 		WriteFreeLight( lightHandle );
@@ -625,7 +624,7 @@ void idRenderWorldLocal::ProjectOverlay( qhandle_t entityHandle, const idPlane l
 	if ( model->IsDynamicModel() != DM_CACHED ) {	// FIXME: probably should be MD5 only
 		return;
 	}
-	model = R_EntityDefDynamicModel( def );
+	model = R_EntityDefDynamicModel( def, true );
 
 	if ( def->overlay == NULL ) {
 		def->overlay = idRenderModelOverlay::Alloc();
@@ -1072,7 +1071,7 @@ bool idRenderWorldLocal::ModelTrace( modelTrace_t &trace, qhandle_t entityHandle
 
 	renderEntity_t *refEnt = &def->parms;
 
-	model = R_EntityDefDynamicModel( def );
+	model = R_EntityDefDynamicModel( def, true );
 	if ( !model ) {
 		return false;
 	}
@@ -1215,7 +1214,7 @@ bool idRenderWorldLocal::Trace( modelTrace_t &trace, const idVec3 &start, const
 				}
 #endif
 
-				model = R_EntityDefDynamicModel( def );
+				model = R_EntityDefDynamicModel( def, true );
 				if ( !model ) {
 					continue;	// can happen with particle systems, which don't instantiate without a valid view
 				}
@@ -1403,6 +1402,12 @@ void idRenderWorldLocal::AddEntityRefToArea( idRenderEntityLocal *def, portalAre
 	ref->areaPrev = area->entityRefs.areaPrev;
 	ref->areaNext->areaPrev = ref;
 	ref->areaPrev->areaNext = ref;
+
+	// lights touching the area will have to look for new interactions, unless
+	// a moving entity is only put back in an area it was already in
+	if ( def->moveCount == 0 || area->entityMoveCount != def->moveCount ) {
+		area->entityRefChangeCount = ++entityRefChangeCount;
+	}
 }
 
 /*
@@ -1437,8 +1442,7 @@ Force the generation of all light / surface interactions at the start of a level
 If this isn't called, they will all be dynamically generated
 
 This really isn't all that helpful anymore, because the calculation of shadows
-and light interactions is deferred from idRenderWorldLocal::CreateLightDefInteractions(), but we
-use it as an oportunity to size the interactionTable
+and light interactions is deferred from idRenderWorldLocal::CreateLightDefInteractions()
 ===================
 */
 void idRenderWorldLocal::GenerateAllInteractions() {
@@ -1471,32 +1475,8 @@ void idRenderWorldLocal::GenerateAllInteractions() {
 	common->Printf( "idRenderWorld::GenerateAllInteractions, msec = %i, staticAllocCount = %i.\n", msec, tr.staticAllocCount );
 
 
-	// build the interaction table
-	if ( r_useInteractionTable.GetBool() ) {
-		interactionTableWidth = entityDefs.Num() + 100;
-		interactionTableHeight = lightDefs.Num() + 100;
-		int	size =  interactionTableWidth * interactionTableHeight * sizeof( *interactionTable );
-		interactionTable = (idInteraction **)R_ClearedStaticAlloc( size );
-
-		int	count = 0;
-		for ( int i = 0 ; i < this->lightDefs.Num() ; i++ ) {
-			idRenderLightLocal	*ldef = this->lightDefs[i];
-			if ( !ldef ) {
-				continue;
-			}
-			idInteraction	*inter;
-			for ( inter = ldef->firstInteraction; inter != NULL; inter = inter->lightNext ) {
-				idRenderEntityLocal	*edef = inter->entityDef;
-				int index = ldef->index * interactionTableWidth + edef->index;
-
-				interactionTable[ index ] = inter;
-				count++;
-			}
-		}
-
-		common->Printf( "interactionTable size: %i bytes\n", size );
-		common->Printf( "%d interaction take %zd bytes\n", count, count * sizeof( idInteraction ) );
-	}
+	common->Printf( "interactionTable size: %zd bytes\n", interactionTable.Allocated() );
+	common->Printf( "%d interaction take %zd bytes\n", interactionTable.Num(), interactionTable.Num() * sizeof( idInteraction ) );
 
 	// entities flagged as noDynamicInteractions will no longer make any
 	generateAllInteractionsCalled = true;
@@ -1521,6 +1501,13 @@ void idRenderWorldLocal::FreeInteractions() {
 			def->firstInteraction->UnlinkAndFree();
 		}
 	}
+
+	// the lights will have to find their interactions again
+	for ( i = 0 ; i < lightDefs.Num(); i++ ) {
+		if ( lightDefs[i] ) {
+			lightDefs[i]->interactionSweepCount = -1;
+		}
+	}
 }
 
 /*
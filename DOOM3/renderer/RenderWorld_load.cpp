@@ -44,6 +44,9 @@ void idRenderWorldLocal::FreeWorld() {
 	// this will free all the lightDefs and entityDefs
 	FreeDefs();
 
+	// a new world reuses the def indexes the cached shadow volumes were made for
+	R_PurgeShadowCache( NULL, NULL );
+
 	// free all the portals and check light/model references
 	for ( i = 0 ; i < numPortalAreas ; i++ ) {
 		portalArea_t	*area;
@@ -72,6 +75,7 @@ void idRenderWorldLocal::FreeWorld() {
 		R_StaticFree( areaScreenRect );
 		areaScreenRect = NULL;
 	}
+	ClearPortalFloodCaches();
 
 	if ( doublePortals ) {
 		R_StaticFree( doublePortals );
@@ -441,11 +445,6 @@ void idRenderWorldLocal::FreeDefs() {
 
 	generateAllInteractionsCalled = false;
 
-	if ( interactionTable ) {
-		R_StaticFree( interactionTable );
-		interactionTable = NULL;
-	}
-
 	// free all lightDefs
 	for ( i = 0 ; i < lightDefs.Num() ; i++ ) {
 		idRenderLightLocal	*light;
@@ -467,6 +466,9 @@ void idRenderWorldLocal::FreeDefs() {
 			entityDefs[i] = NULL;
 		}
 	}
+
+	// all the interactions have been unlinked by now
+	interactionTable.Clear();
 }
 
 /*
@@ -59,6 +59,47 @@ typedef struct doublePortal_s {
 } doublePortal_t;
 
 
+// if we hit this many planes, we will just stop cropping the
+// view down, which is still correct, just conservative
+const int MAX_PORTAL_PLANES	= 20;
+
+typedef struct portalStack_s {
+	portal_t	*p;
+	const struct portalStack_s *next;
+
+	idScreenRect	rect;
+
+	int			numPortalPlanes;
+	idPlane		portalPlanes[MAX_PORTAL_PLANES+1];
+	// positive side is outside the visible frustum
+} portalStack_t;
+
+
+// the areas and portal stacks a view flooded through, so a following view
+// from the same place can skip FloodViewThroughArea_r
+const int MAX_PORTAL_FLOOD_CACHES	= 4;
+
+typedef struct {
+	int						areaNum;
+	portalStack_t			stack;				// without the portal links
+} portalFloodArea_t;
+
+typedef struct {
+	bool					valid;
+	bool					fogged;				// flooded through a fog portal, so it can't be reused
+	int						lastUsed;			// for replacing the least recently used cache
+	int						portalStateCount;	// world portalStateCount when flooded
+	int						areaNum;
+	idVec3					origin;
+	int						numPlanes;
+	idPlane					planes[5];
+	idScreenRect			scissor;
+	idScreenRect			viewport;
+	idList<portalFloodArea_t>	areas;				// in AddAreaRefs order
+	idList<idScreenRect>	areaScreenRect;
+} portalFloodCache_t;
+
+
 typedef struct portalArea_s {
 	int				areaNum;
 	int				connectedAreaNum[NUM_PORTAL_ATTRIBUTES];	// if two areas have matching connectedAreaNum, they are
@@ -67,6 +108,8 @@ typedef struct portalArea_s {
 	portal_t *		portals;		// never changes after load
 	areaReference_t	entityRefs;		// head/tail of doubly linked list, may change
 	areaReference_t	lightRefs;		// head/tail of doubly linked list, may change
+	int				entityRefChangeCount;	// world entityRefChangeCount when an entityRef was last added
+	int				entityMoveCount;		// moveCount of the last moving entityDef that left the area
 } portalArea_t;
 
 
@@ -148,9 +191,14 @@ public:
 	portalArea_t *			portalAreas;
 	int						numPortalAreas;
 	int						connectedAreaNum;		// incremented every time a door portal state changes
+	int						portalStateCount;		// incremented when a portal is opened, closed or fogged
 
 	idScreenRect *			areaScreenRect;
 
+	portalFloodCache_t		portalFloodCaches[MAX_PORTAL_FLOOD_CACHES];
+	portalFloodCache_t *	portalFloodRecord;		// cache being filled by FloodViewThroughArea_r
+	int						portalFloodCacheUses;
+
 	doublePortal_t *		doublePortals;
 	int						numInterAreaPortals;
 
@@ -164,13 +212,17 @@ public:
 	idBlockAlloc<areaNumRef_t, 1024>	areaNumRefAllocator;
 
 	// all light / entity interactions are referenced here for fast lookup without
-	// having to crawl the doubly linked lists.  EnntityDefs are sequential for better
-	// cache access, because the table is accessed by light in idRenderWorldLocal::CreateLightDefInteractions()
-	// Growing this table is time consuming, so we add a pad value to the number
-	// of entityDefs and lightDefs
-	idInteraction **		interactionTable;
-	int						interactionTableWidth;		// entityDefs
-	int						interactionTableHeight;		// lightDefs
+	// having to crawl the doubly linked lists.  The table is updated at
+	// idInteraction::AllocAndLink() and idInteraction::UnlinkAndFree()
+	idInteractionTable		interactionTable;
+
+	// incremented for every entityRef added to an area, so a light can tell
+	// if any entity entered its areas since they were last swept for interactions
+	int						entityRefChangeCount;
+
+	// incremented for every entityDef moved with its interactions kept, an entity
+	// that is added back to an area it just left doesn't count as a change
+	int						entityMoveCount;
 
 
 	bool					generateAllInteractionsCalled;
@@ -199,6 +251,8 @@ public:
 	bool					PortalIsFoggedOut( const portal_t *p );
 	void					FloodViewThroughArea_r( const idVec3 origin, int areaNum, const struct portalStack_s *ps );
 	void					FlowViewThroughPortals( const idVec3 origin, int numPlanes, const idPlane *planes );
+	portalFloodCache_t *	FindPortalFloodCache( const idVec3 &origin, int numPlanes, const idPlane *planes );
+	void					ClearPortalFloodCaches( void );
 	void					FloodLightThroughArea_r( idRenderLightLocal *light, int areaNum, const struct portalStack_s *ps );
 	void					FlowLightThroughPortals( idRenderLightLocal *light );
 	areaNumRef_t *			FloodFrustumAreas_r( const idFrustum &frustum, const int areaNum, const idBounds &bounds, areaNumRef_t *areas );
@@ -241,7 +295,6 @@ public:
 	//--------------------------
 	// RenderWorld.cpp
 
-	void					ResizeInteractionTable();
 
 	void					AddEntityRefToArea( idRenderEntityLocal *def, portalArea_t *area );
 	void					AddLightRefToArea( idRenderLightLocal *light, portalArea_t *area );
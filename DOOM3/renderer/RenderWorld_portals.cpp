@@ -43,22 +43,6 @@ in the portal areas that can be seen from the current viewpoint.
 */
 
 
-// if we hit this many planes, we will just stop cropping the
-// view down, which is still correct, just conservative
-const int MAX_PORTAL_PLANES	= 20;
-
-typedef struct portalStack_s {
-	portal_t	*p;
-	const struct portalStack_s *next;
-
-	idScreenRect	rect;
-
-	int			numPortalPlanes;
-	idPlane		portalPlanes[MAX_PORTAL_PLANES+1];
-	// positive side is outside the visible frustum
-} portalStack_t;
-
-
 //====================================================================
 
 
@@ -168,6 +152,17 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 	// cull models and lights to the current collection of planes
 	AddAreaRefs( areaNum, ps );
 
+	tr.pc.c_portalFloodAreas++;
+
+	// remember the stack so the flood can be replayed
+	if ( portalFloodRecord ) {
+		portalFloodArea_t &record = portalFloodRecord->areas.Alloc();
+		record.areaNum = areaNum;
+		record.stack = *ps;
+		record.stack.p = NULL;
+		record.stack.next = NULL;
+	}
+
 	if ( areaScreenRect[areaNum].IsEmpty() ) {
 		areaScreenRect[areaNum] = ps->rect;
 	} else {
@@ -211,6 +206,7 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 		}
 
 		// clip the portal winding to all of the planes
+		tr.pc.c_portalClips++;
 		w = *p->w;
 		for ( j = 0; j < ps->numPortalPlanes; j++ ) {
 			if ( !w.ClipInPlace( -ps->portalPlanes[j], 0 ) ) {
@@ -221,6 +217,11 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 			continue;	// portal not visible
 		}
 
+		// the fog density may change every frame, so the flood can't be reused
+		if ( p->doublePortal->fogLight && portalFloodRecord ) {
+			portalFloodRecord->fogged = true;
+		}
+
 		// see if it is fogged out
 		if ( PortalIsFoggedOut( p ) ) {
 			continue;
@@ -274,6 +275,85 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 	}
 }
 
+/*
+=======================
+ClearPortalFloodCaches
+=======================
+*/
+void idRenderWorldLocal::ClearPortalFloodCaches( void ) {
+	for ( int i = 0 ; i < MAX_PORTAL_FLOOD_CACHES ; i++ ) {
+		portalFloodCaches[i].valid = false;
+		portalFloodCaches[i].lastUsed = 0;
+		portalFloodCaches[i].areas.Clear();
+		portalFloodCaches[i].areaScreenRect.Clear();
+	}
+	portalFloodRecord = NULL;
+}
+
+/*
+=======================
+FindPortalFloodCache
+
+Returns the cached flood of a view from the same area, with the same frustum and
+an origin that moved less than r_portalFloodCacheDist, or the least recently
+used cache, which is invalidated and keyed for the current view
+=======================
+*/
+portalFloodCache_t *idRenderWorldLocal::FindPortalFloodCache( const idVec3 &origin, int numPlanes, const idPlane *planes ) {
+	portalFloodCache_t	*cache, *oldest;
+	float				dist;
+	int					i, j;
+
+	dist = r_portalFloodCacheDist.GetFloat();
+
+	oldest = &portalFloodCaches[0];
+	for ( i = 0 ; i < MAX_PORTAL_FLOOD_CACHES ; i++ ) {
+		cache = &portalFloodCaches[i];
+		if ( cache->lastUsed < oldest->lastUsed ) {
+			oldest = cache;
+		}
+		if ( !cache->valid || cache->portalStateCount != portalStateCount ) {
+			continue;
+		}
+		if ( cache->areaNum != tr.viewDef->areaNum || cache->numPlanes != numPlanes ) {
+			continue;
+		}
+		if ( !cache->scissor.Equals( tr.viewDef->scissor ) || !cache->viewport.Equals( tr.viewDef->viewport ) ) {
+			continue;
+		}
+		if ( ( cache->origin - origin ).LengthSqr() > dist * dist ) {
+			continue;
+		}
+		for ( j = 0 ; j < numPlanes ; j++ ) {
+			if ( !cache->planes[j].Compare( planes[j], 1e-4f, dist + 1e-2f ) ) {
+				break;
+			}
+		}
+		if ( j < numPlanes ) {
+			continue;
+		}
+		cache->lastUsed = ++portalFloodCacheUses;
+		return cache;
+	}
+
+	cache = oldest;
+	cache->valid = false;
+	cache->fogged = false;
+	cache->lastUsed = ++portalFloodCacheUses;
+	cache->portalStateCount = portalStateCount;
+	cache->areaNum = tr.viewDef->areaNum;
+	cache->origin = origin;
+	cache->numPlanes = numPlanes;
+	for ( j = 0 ; j < numPlanes ; j++ ) {
+		cache->planes[j] = planes[j];
+	}
+	cache->scissor = tr.viewDef->scissor;
+	cache->viewport = tr.viewDef->viewport;
+	cache->areas.SetNum( 0, false );
+
+	return cache;
+}
+
 /*
 =======================
 FlowViewThroughPortals
@@ -282,11 +362,17 @@ Finds viewLights and viewEntities by flowing from an origin through the visible
 origin point can see into.  The planes array defines a volume (positive
 sides facing in) that should contain the origin, such as a view frustum or a point light box.
 Zero planes assumes an unbounded volume.
+
+Views that don't move, like a menu over the game or a cinematic camera, replay
+the areas and portal stacks of the last flood from the same place instead.
 =======================
 */
 void idRenderWorldLocal::FlowViewThroughPortals( const idVec3 origin, int numPlanes, const idPlane *planes ) {
 	portalStack_t	ps;
 	int				i;
+	unsigned int	start;
+
+	start = Sys_Microseconds();
 
 	ps.next = NULL;
 	ps.p = NULL;
@@ -309,14 +395,48 @@ void idRenderWorldLocal::FlowViewThroughPortals( const idVec3 origin, int numPla
 			AddAreaRefs( i, &ps );
 		}
 	} else {
+		portalFloodCache_t *cache = NULL;
+
+		if ( r_usePortalFloodCache.GetBool() && numPlanes <= 5 ) {
+			cache = FindPortalFloodCache( origin, numPlanes, planes );
+			if ( cache->valid ) {
+				tr.pc.c_portalFloodCacheHits++;
+
+				for ( i = 0; i < numPortalAreas; i++ ) {
+					areaScreenRect[i] = cache->areaScreenRect[i];
+				}
+				for ( i = 0 ; i < cache->areas.Num() ; i++ ) {
+					AddAreaRefs( cache->areas[i].areaNum, &cache->areas[i].stack );
+				}
+
+				tr.pc.c_portalFloodUsec += Sys_Microseconds() - start;
+				return;
+			}
+		}
+
+		if ( cache ) {
+			tr.pc.c_portalFloodCacheMisses++;
+		}
 
 		for ( i = 0; i < numPortalAreas; i++ ) {
 			areaScreenRect[i].Clear();
 		}
 
 		// flood out through portals, setting area viewCount
+		portalFloodRecord = cache;
 		FloodViewThroughArea_r( origin, tr.viewDef->areaNum, &ps );
+		portalFloodRecord = NULL;
+
+		if ( cache ) {
+			cache->areaScreenRect.SetNum( numPortalAreas, false );
+			for ( i = 0; i < numPortalAreas; i++ ) {
+				cache->areaScreenRect[i] = areaScreenRect[i];
+			}
+			cache->valid = !cache->fogged;
+		}
 	}
+
+	tr.pc.c_portalFloodUsec += Sys_Microseconds() - start;
 }
 
 //==================================================================================================
@@ -996,6 +1116,7 @@ void		idRenderWorldLocal::SetPortalState( qhandle_t portal, int blockTypes ) {
 		return;
 	}
 	doublePortals[portal-1].blockingBits = blockTypes;
+	portalStateCount++;
 
 	// leave the connectedAreaGroup the same on one side,
 	// then flood fill from the other side with a new number for each changed attribute
@@ -82,12 +82,15 @@ void RB_RenderView(void) {
   drawSurf_t **drawSurfs = (drawSurf_t * *) & backEnd.viewDef->drawSurfs[0];
   const int numDrawSurfs = backEnd.viewDef->numDrawSurfs;
 
-  // clear the z buffer, set the projection matrix, etc
-  RB_BeginDrawingView();
-
   // Setup GLSL shader state
   RB_GLSL_PrepareShaders();
 
+  // render the shadow map atlas first, as it binds its own framebuffer
+  RB_GLSL_RenderShadowMaps();
+
+  // clear the z buffer, set the projection matrix, etc
+  RB_BeginDrawingView();
+
   // fill the depth buffer and clear color buffer to black except on subviews
 	RB_GLSL_FillDepthBuffer( drawSurfs, numDrawSurfs );
 
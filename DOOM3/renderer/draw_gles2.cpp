@@ -16,6 +16,7 @@
 */
 
 #include "sys/platform.h"
+#include "idlib/geometry/JointTransform.h"
 #include "renderer/VertexCache.h"
 
 #include "tr_local.h"
@@ -33,6 +34,42 @@ shaderProgram_t diffuseCubeShader;
 shaderProgram_t skyboxCubeShader;
 shaderProgram_t reflectionCubeShader;
 shaderProgram_t stencilShadowShader;
+shaderProgram_t interactionShadowMapShader;
+shaderProgram_t interactionPhongShadowMapShader;
+shaderProgram_t shadowMapShader;
+
+// versions of the programs that skin md5 surfaces, see RB_GLSL_SelectSkinning
+shaderProgram_t interactionSkinnedShader;
+shaderProgram_t interactionPhongSkinnedShader;
+shaderProgram_t interactionShadowMapSkinnedShader;
+shaderProgram_t interactionPhongShadowMapSkinnedShader;
+shaderProgram_t fogSkinnedShader;
+shaderProgram_t blendLightSkinnedShader;
+shaderProgram_t zfillSkinnedShader;
+shaderProgram_t zfillClipSkinnedShader;
+shaderProgram_t shadowMapSkinnedShader;
+static bool skinnedShadersLoaded = false;
+static bool skinningArraysEnabled = false;
+
+// shadow map atlas, shared by all the lights of a view
+static GLuint shadowMapFramebuffer = 0;
+static GLuint shadowMapTexture = 0;
+static int shadowMapAtlasSize = 0;
+static bool shadowMapsRendered = false;
+
+// depth textures with hardware comparison are core in OpenGL ES 3.0
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24			0x81A6
+#endif
+#ifndef GL_TEXTURE_COMPARE_MODE
+#define GL_TEXTURE_COMPARE_MODE			0x884C
+#endif
+#ifndef GL_TEXTURE_COMPARE_FUNC
+#define GL_TEXTURE_COMPARE_FUNC			0x884D
+#endif
+#ifndef GL_COMPARE_REF_TO_TEXTURE
+#define GL_COMPARE_REF_TO_TEXTURE		0x884E
+#endif
 
 #define ATTR_VERTEX     0   // Don't change this, as WebGL require the vertex attrib 0 to be always bound
 #define ATTR_COLOR      1
@@ -40,6 +77,12 @@ shaderProgram_t stencilShadowShader;
 #define ATTR_NORMAL     3
 #define ATTR_TANGENT    4
 #define ATTR_BITANGENT  5
+#define ATTR_JOINTINDICES 6
+#define ATTR_JOINTWEIGHTS 7
+
+#ifndef GL_MAX_VERTEX_UNIFORM_VECTORS
+#define GL_MAX_VERTEX_UNIFORM_VECTORS	0x8DFB
+#endif
 
 /*
 ====================
@@ -125,19 +168,40 @@ static void GL_VertexAttribPointer(GLuint index, GLint size, GLenum type,
 =================
 R_LoadGLSLShader
 
-loads GLSL vertex or fragment shaders
+loads GLSL vertex or fragment shaders, the prologue is inserted after the #version line
 =================
 */
-static void R_LoadGLSLShader(const char* buffer, shaderProgram_t* shaderProgram, GLenum type) {
+static void R_LoadGLSLShader(const char* buffer, shaderProgram_t* shaderProgram, GLenum type, const char* prologue = NULL) {
   if ( !glConfig.isInitialized ) {
     return;
   }
 
+  const GLchar* sources[3];
+  GLint lengths[3];
+  GLsizei numSources = 1;
+
+  sources[0] = buffer;
+  lengths[0] = -1;
+
+  if ( prologue ) {
+    const char* version = strstr(buffer, "#version");
+    const char* rest = version ? strchr(version, '\n') : NULL;
+    if ( rest ) {
+      rest++;
+      lengths[0] = rest - buffer;
+      sources[1] = prologue;
+      lengths[1] = -1;
+      sources[2] = rest;
+      lengths[2] = -1;
+      numSources = 3;
+    }
+  }
+
   switch ( type ) {
     case GL_VERTEX_SHADER:
       // create vertex shader
       shaderProgram->vertexShader = qglCreateShader(GL_VERTEX_SHADER);
-      qglShaderSource(shaderProgram->vertexShader, 1, (const GLchar**) &buffer, 0);
+      qglShaderSource(shaderProgram->vertexShader, numSources, sources, lengths);
       qglCompileShader(shaderProgram->vertexShader);
       break;
     case GL_FRAGMENT_SHADER:
@@ -176,6 +240,8 @@ static bool R_LinkGLSLShader(shaderProgram_t* shaderProgram, const char* name) {
   qglBindAttribLocation(shaderProgram->program, ATTR_NORMAL, "attr_Normal");
   qglBindAttribLocation(shaderProgram->program, ATTR_TANGENT, "attr_Tangent");
   qglBindAttribLocation(shaderProgram->program, ATTR_BITANGENT, "attr_Bitangent");
+  qglBindAttribLocation(shaderProgram->program, ATTR_JOINTINDICES, "attr_JointIndices");
+  qglBindAttribLocation(shaderProgram->program, ATTR_JOINTWEIGHTS, "attr_JointWeights");
 
   qglLinkProgram(shaderProgram->program);
 
@@ -252,6 +318,10 @@ static void RB_GLSL_GetUniformLocations(shaderProgram_t* shader) {
   shader->textureMatrix = qglGetUniformLocation(shader->program, "u_textureMatrix");
   shader->clipPlane = qglGetUniformLocation(shader->program, "u_clipPlane");
   shader->fogMatrix = qglGetUniformLocation(shader->program, "u_fogMatrix");
+  shader->shadowMapMatrix = qglGetUniformLocation(shader->program, "u_shadowMapMatrix");
+  shader->shadowMapParms = qglGetUniformLocation(shader->program, "u_shadowMapParms");
+  shader->shadowMapTiles = qglGetUniformLocation(shader->program, "u_shadowMapTiles");
+  shader->joints = qglGetUniformLocation(shader->program, "u_joints");
 
   shader->attr_TexCoord = qglGetAttribLocation(shader->program, "attr_TexCoord");
   shader->attr_Tangent = qglGetAttribLocation(shader->program, "attr_Tangent");
@@ -259,6 +329,8 @@ static void RB_GLSL_GetUniformLocations(shaderProgram_t* shader) {
   shader->attr_Normal = qglGetAttribLocation(shader->program, "attr_Normal");
   shader->attr_Vertex = qglGetAttribLocation(shader->program, "attr_Vertex");
   shader->attr_Color = qglGetAttribLocation(shader->program, "attr_Color");
+  shader->attr_JointIndices = qglGetAttribLocation(shader->program, "attr_JointIndices");
+  shader->attr_JointWeights = qglGetAttribLocation(shader->program, "attr_JointWeights");
 
   // Init default values
   for ( i = 0; i < MAX_FRAGMENT_IMAGES; i++ ) {
@@ -298,6 +370,67 @@ static void RB_GLSL_GetUniformLocations(shaderProgram_t* shader) {
   GL_UseProgram(NULL);
 }
 
+/*
+=================
+RB_GLSL_InitSkinnedShader
+
+=================
+*/
+static bool RB_GLSL_InitSkinnedShader(shaderProgram_t* shader, const char* vp, const char* fp, const char* name) {
+  memset(shader, 0, sizeof(shaderProgram_t));
+
+  R_LoadGLSLShader(vp, shader, GL_VERTEX_SHADER, skinningShaderVP);
+  R_LoadGLSLShader(fp, shader, GL_FRAGMENT_SHADER);
+
+  if ( !R_LinkGLSLShader(shader, name) && !R_ValidateGLSLProgram(shader)) {
+    return false;
+  }
+  else {
+    RB_GLSL_GetUniformLocations(shader);
+  }
+
+  return true;
+}
+
+/*
+=================
+RB_GLSL_InitSkinnedShaders
+
+The joint palette takes MAX_GPU_SKINNING_JOINTS * 3 vertex uniforms, without
+enough of them the md5 models stay skinned on the CPU
+=================
+*/
+static bool RB_GLSL_InitSkinnedShaders(void) {
+  GLint maxVertexUniforms = 0;
+
+  skinnedShadersLoaded = false;
+
+  qglGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &maxVertexUniforms);
+  if ( maxVertexUniforms < MAX_GPU_SKINNING_JOINTS * 3 + 32 ) {
+    common->Printf("Skipping skinned shaders, %d vertex uniforms\n", maxVertexUniforms);
+    r_useGPUSkinning.SetBool(false);
+    return true;
+  }
+
+  common->Printf("Loading skinned shaders\n");
+
+  if ( !RB_GLSL_InitSkinnedShader(&interactionSkinnedShader, interactionShaderVP, interactionShaderFP, "interactionSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&interactionPhongSkinnedShader, interactionPhongShaderVP, interactionPhongShaderFP, "interactionPhongSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&interactionShadowMapSkinnedShader, interactionShadowMapShaderVP, interactionShadowMapShaderFP, "interactionShadowMapSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&interactionPhongShadowMapSkinnedShader, interactionPhongShadowMapShaderVP, interactionPhongShadowMapShaderFP, "interactionPhongShadowMapSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&fogSkinnedShader, fogShaderVP, fogShaderFP, "fogSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&blendLightSkinnedShader, blendLightShaderVP, fogShaderFP, "blendLightSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&zfillSkinnedShader, zfillShaderVP, zfillShaderFP, "zfillSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&zfillClipSkinnedShader, zfillClipShaderVP, zfillClipShaderFP, "zfillClipSkinned") ||
+       !RB_GLSL_InitSkinnedShader(&shadowMapSkinnedShader, shadowMapShaderVP, shadowMapShaderFP, "shadowMapSkinned")) {
+    return false;
+  }
+
+  skinnedShadersLoaded = true;
+
+  return true;
+}
+
 /*
 =================
 RB_GLSL_InitShaders
@@ -461,6 +594,55 @@ static bool RB_GLSL_InitShaders(void) {
     RB_GLSL_GetUniformLocations(&stencilShadowShader);
   }
 
+  // main Interaction shader, shadow mapped version
+  common->Printf("Loading main interaction shader (shadow mapped)\n");
+  memset(&interactionShadowMapShader, 0, sizeof(shaderProgram_t));
+
+  R_LoadGLSLShader(interactionShadowMapShaderVP, &interactionShadowMapShader, GL_VERTEX_SHADER);
+  R_LoadGLSLShader(interactionShadowMapShaderFP, &interactionShadowMapShader, GL_FRAGMENT_SHADER);
+
+  if ( !R_LinkGLSLShader(&interactionShadowMapShader, "interactionShadowMap") &&
+       !R_ValidateGLSLProgram(&interactionShadowMapShader)) {
+    return false;
+  }
+  else {
+    RB_GLSL_GetUniformLocations(&interactionShadowMapShader);
+  }
+
+  // main Interaction shader, Phong shadow mapped version
+  common->Printf("Loading main interaction shader (Phong, shadow mapped)\n");
+  memset(&interactionPhongShadowMapShader, 0, sizeof(shaderProgram_t));
+
+  R_LoadGLSLShader(interactionPhongShadowMapShaderVP, &interactionPhongShadowMapShader, GL_VERTEX_SHADER);
+  R_LoadGLSLShader(interactionPhongShadowMapShaderFP, &interactionPhongShadowMapShader, GL_FRAGMENT_SHADER);
+
+  if ( !R_LinkGLSLShader(&interactionPhongShadowMapShader, "interactionPhongShadowMap") &&
+       !R_ValidateGLSLProgram(&interactionPhongShadowMapShader)) {
+    return false;
+  }
+  else {
+    RB_GLSL_GetUniformLocations(&interactionPhongShadowMapShader);
+  }
+
+  // Shadow map caster shader
+  common->Printf("Loading Shadow map shader\n");
+  memset(&shadowMapShader, 0, sizeof(shaderProgram_t));
+
+  R_LoadGLSLShader(shadowMapShaderVP, &shadowMapShader, GL_VERTEX_SHADER);
+  R_LoadGLSLShader(shadowMapShaderFP, &shadowMapShader, GL_FRAGMENT_SHADER);
+
+  if ( !R_LinkGLSLShader(&shadowMapShader, "shadowMap") && !R_ValidateGLSLProgram(&shadowMapShader)) {
+    return false;
+  }
+  else {
+    RB_GLSL_GetUniformLocations(&shadowMapShader);
+  }
+
+  // Skinned versions of the shaders the md5 surfaces go through with shadow mapping
+  if ( !RB_GLSL_InitSkinnedShaders()) {
+    return false;
+  }
+
   return true;
 }
 
@@ -504,6 +686,63 @@ void RB_ComputeMVP( const drawSurf_t * const surf, float mvp[16] )
   myGlMultMatrix(surf->space->modelViewMatrix, localProjectionMatrix, mvp);
 }
 
+/*
+==================
+RB_GLSL_SelectSkinning
+
+Uses the skinned version of the program for surfaces the vertex programs skin,
+with the joints of the surface and the weights that follow the vertexes in the
+ambient cache, see R_CreateAmbientCache.  Returns true if the program changed,
+so the caller sets its per space uniforms again.
+==================
+*/
+static bool RB_GLSL_SelectSkinning(const srfTriangles_t* tri, shaderProgram_t* program, shaderProgram_t* skinnedProgram) {
+  const bool skinned = ( tri->skinning != NULL && tri->ambientCache != NULL && skinnedShadersLoaded );
+  shaderProgram_t* selected = skinned ? skinnedProgram : program;
+  const bool changed = ( backEnd.glState.currentProgram != selected );
+
+  GL_UseProgram(selected);
+
+  if ( skinned != skinningArraysEnabled ) {
+    if ( skinned ) {
+      GL_EnableVertexAttribArray(ATTR_JOINTINDICES);
+      GL_EnableVertexAttribArray(ATTR_JOINTWEIGHTS);
+    }
+    else {
+      GL_DisableVertexAttribArray(ATTR_JOINTINDICES);
+      GL_DisableVertexAttribArray(ATTR_JOINTWEIGHTS);
+    }
+    skinningArraysEnabled = skinned;
+  }
+
+  if ( skinned ) {
+    qglUniform4fv(selected->joints, tri->skinning->numJoints * 3, tri->skinning->joints[0].ToFloatPtr());
+
+    skinWeight_t* weights = (skinWeight_t*) ((byte*) vertexCache.Position(tri->ambientCache) + tri->numVerts * sizeof(idDrawVert));
+    GL_VertexAttribPointer(offsetof(shaderProgram_t, attr_JointIndices), 4, GL_UNSIGNED_BYTE, false, sizeof(skinWeight_t),
+                           weights->joints);
+    GL_VertexAttribPointer(offsetof(shaderProgram_t, attr_JointWeights), 4, GL_UNSIGNED_BYTE, true, sizeof(skinWeight_t),
+                           weights->weights);
+  }
+
+  return changed;
+}
+
+/*
+==================
+RB_GLSL_EndSkinning
+
+Disables the joint arrays RB_GLSL_SelectSkinning may have left enabled
+==================
+*/
+static void RB_GLSL_EndSkinning(void) {
+  if ( skinningArraysEnabled ) {
+    GL_DisableVertexAttribArray(ATTR_JOINTINDICES);
+    GL_DisableVertexAttribArray(ATTR_JOINTWEIGHTS);
+    skinningArraysEnabled = false;
+  }
+}
+
 /*
 ==================
 RB_GLSL_DrawInteraction
@@ -741,24 +980,67 @@ RB_GLSL_CreateDrawInteractions
 
 =============
 */
-static void RB_GLSL_CreateDrawInteractions(const drawSurf_t* surf, const viewLight_t* vLight, const int depthFunc = GLS_DEPTHFUNC_EQUAL) {
+static void RB_GLSL_CreateDrawInteractions(const drawSurf_t* surf, const viewLight_t* vLight, const int depthFunc = GLS_DEPTHFUNC_EQUAL,
+                                           const int shadowMapSet = -1) {
   if ( !surf ) {
     return;
   }
 
+  const bool shadowMapped = ( shadowMapSet >= 0 );
+
   // perform setup here that will be constant for all interactions
   GL_State(GLS_SRCBLEND_ONE | GLS_DSTBLEND_ONE | GLS_DEPTHMASK | depthFunc);
 
-  // bind the vertex and fragment shader
-  if ( r_usePhong.GetBool()) {
-    GL_UseProgram(&interactionPhongShader);
-
-    // Set the specular exponent now (NB: it could be cached instead)
-    const float f = r_specularExponent.GetFloat();
-    GL_Uniform1fv(offsetof(shaderProgram_t, specularExponent), &f);
+  // pick the vertex and fragment shader, and its skinned version
+  shaderProgram_t* programs[2];
+  if ( shadowMapped ) {
+    if ( r_usePhong.GetBool()) {
+      programs[0] = &interactionPhongShadowMapShader;
+      programs[1] = &interactionPhongShadowMapSkinnedShader;
+    }
+    else {
+      programs[0] = &interactionShadowMapShader;
+      programs[1] = &interactionShadowMapSkinnedShader;
+    }
+  }
+  else if ( r_usePhong.GetBool()) {
+    programs[0] = &interactionPhongShader;
+    programs[1] = &interactionPhongSkinnedShader;
   }
   else {
-    GL_UseProgram(&interactionShader);
+    programs[0] = &interactionShader;
+    programs[1] = &interactionSkinnedShader;
+  }
+
+  // the uniforms of the light are set on both
+  for ( int i = ( skinnedShadersLoaded ? 1 : 0 ); i >= 0; i-- ) {
+    GL_UseProgram(programs[i]);
+
+    if ( r_usePhong.GetBool()) {
+      // Set the specular exponent now (NB: it could be cached instead)
+      const float f = r_specularExponent.GetFloat();
+      GL_Uniform1fv(offsetof(shaderProgram_t, specularExponent), &f);
+    }
+
+    if ( shadowMapped ) {
+      // the atlas placement of the light, see RB_GLSL_RenderShadowMaps
+      const float atlasScale = 1.0f / vLight->shadowMapAtlasSize;
+      float tiles[6][4];
+      memset(tiles, 0, sizeof(tiles));
+      for ( int face = 0; face < vLight->numShadowMapFaces; face++ ) {
+        tiles[face][0] = vLight->shadowMapOffsets[shadowMapSet][face][0] * atlasScale;
+        tiles[face][1] = vLight->shadowMapOffsets[shadowMapSet][face][1] * atlasScale;
+        tiles[face][2] = vLight->shadowMapSize * atlasScale;
+        tiles[face][3] = 0.5f * atlasScale;
+      }
+      qglUniform4fv(backEnd.glState.currentProgram->shadowMapTiles, 6, tiles[0]);
+
+      // the window depth of the face projections is 0.5 * ( a + b / w ) + 0.5, see R_SetShadowMapProjection
+      const float a = ( vLight->shadowMapRange + SHADOW_MAP_NEAR ) / ( vLight->shadowMapRange - SHADOW_MAP_NEAR );
+      const float b = -2.0f * vLight->shadowMapRange * SHADOW_MAP_NEAR / ( vLight->shadowMapRange - SHADOW_MAP_NEAR );
+      const float parms[4] = { 0.5f * a + 0.5f, 0.5f * b, r_shadowMapBias.GetFloat(), vLight->numShadowMapFaces == 6 ? 1.0f : 0.0f };
+      GL_Uniform4fv(offsetof(shaderProgram_t, shadowMapParms), parms);
+    }
   }
 
   // Setup attributes arrays
@@ -775,10 +1057,26 @@ static void RB_GLSL_CreateDrawInteractions(const drawSurf_t* surf, const viewLig
   for ( ; surf; surf = surf->nextOnLight ) {
     // perform setup here that will not change over multiple interaction passes
 
+    if ( RB_GLSL_SelectSkinning(surf->geo, programs[0], programs[1])) {
+      backEnd.currentSpace = NULL;
+    }
+
     if ( surf->space != backEnd.currentSpace ) {
       float mvp[16];
       RB_ComputeMVP(surf, mvp);
       GL_UniformMatrix4fv(offsetof(shaderProgram_t, modelViewProjectionMatrix), mvp);
+
+      // point lights only need the rotation to world space, the face is picked per fragment
+      if ( shadowMapped ) {
+        if ( vLight->numShadowMapFaces == 6 ) {
+          GL_UniformMatrix4fv(offsetof(shaderProgram_t, shadowMapMatrix), surf->space->modelMatrix);
+        }
+        else {
+          float shadowMatrix[16];
+          myGlMultMatrix(surf->space->modelMatrix, vLight->shadowMapMatrices[0], shadowMatrix);
+          GL_UniformMatrix4fv(offsetof(shaderProgram_t, shadowMapMatrix), shadowMatrix);
+        }
+      }
     }
 
     // Hack Depth Range if necessary
@@ -818,6 +1116,8 @@ static void RB_GLSL_CreateDrawInteractions(const drawSurf_t* surf, const viewLig
 
   backEnd.currentSpace = NULL;
 
+  RB_GLSL_EndSkinning();
+
   // Restore attributes arrays
   // Vertex attribute is always enabled
   // Color attribute is always enabled
@@ -927,16 +1227,24 @@ static void RB_T_GLSL_Shadow(const drawSurf_t* surf, const viewLight_t* vLight)
 /*
 ======================
 RB_RenderDrawSurfChainWithFunction
+
+If a skinned program is given, it replaces the bound program for the skinned surfaces
 ======================
 */
 void RB_GLSL_RenderDrawSurfChainWithFunction(const drawSurf_t* drawSurfs,
-                                             void (* triFunc_)(const drawSurf_t*, const viewLight_t*), const viewLight_t* vLight) {
+                                             void (* triFunc_)(const drawSurf_t*, const viewLight_t*), const viewLight_t* vLight,
+                                             shaderProgram_t* skinnedProgram = NULL) {
   const drawSurf_t* drawSurf;
+  shaderProgram_t* program = backEnd.glState.currentProgram;
 
   backEnd.currentSpace = NULL;
 
   for ( drawSurf = drawSurfs; drawSurf; drawSurf = drawSurf->nextOnLight ) {
 
+    if ( skinnedProgram && RB_GLSL_SelectSkinning(drawSurf->geo, program, skinnedProgram)) {
+      backEnd.currentSpace = NULL;
+    }
+
     // Change the MVP matrix if needed
     if ( drawSurf->space != backEnd.currentSpace ) {
       float mvp[16];
@@ -978,6 +1286,11 @@ void RB_GLSL_RenderDrawSurfChainWithFunction(const drawSurf_t* drawSurfs,
   }
 
   backEnd.currentSpace = NULL;
+
+  if ( skinnedProgram ) {
+    GL_UseProgram(program);
+    RB_GLSL_EndSkinning();
+  }
 }
 
 /*
@@ -1054,6 +1367,200 @@ void RB_GLSL_StencilShadowPass(const drawSurf_t* drawSurfs, const viewLight_t* v
   GL_EnableVertexAttribArray(ATTR_TEXCOORD);
 }
 
+/*
+==================
+RB_GLSL_CreateShadowMapAtlas
+
+(re)creates the atlas render target, a depth texture that the interaction
+shaders sample with hardware comparison and bilinear filtering
+==================
+*/
+static bool RB_GLSL_CreateShadowMapAtlas(int size) {
+  if ( shadowMapAtlasSize == size && shadowMapFramebuffer && qglIsFramebuffer(shadowMapFramebuffer)) {
+    return true;
+  }
+
+  if ( shadowMapFramebuffer ) {
+    qglDeleteFramebuffers(1, &shadowMapFramebuffer);
+    qglDeleteTextures(1, &shadowMapTexture);
+    shadowMapFramebuffer = shadowMapTexture = 0;
+    shadowMapAtlasSize = 0;
+  }
+
+  GL_SelectTexture(0);
+  qglGenTextures(1, &shadowMapTexture);
+  qglBindTexture(GL_TEXTURE_2D, shadowMapTexture);
+  qglTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+  GLint viewFramebuffer;
+  qglGetIntegerv(GL_FRAMEBUFFER_BINDING, &viewFramebuffer);
+
+  // depth only, there is no color target to write
+  qglGenFramebuffers(1, &shadowMapFramebuffer);
+  qglBindFramebuffer(GL_FRAMEBUFFER, shadowMapFramebuffer);
+  qglFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMapTexture, 0);
+
+  const GLenum status = qglCheckFramebufferStatus(GL_FRAMEBUFFER);
+  qglBindFramebuffer(GL_FRAMEBUFFER, viewFramebuffer);
+
+  if ( status != GL_FRAMEBUFFER_COMPLETE ) {
+    common->Warning("RB_GLSL_CreateShadowMapAtlas: %ix%i atlas incomplete (0x%x), disabling shadow maps", size, size, status);
+    r_useShadowMapping.SetBool(false);
+    return false;
+  }
+
+  shadowMapAtlasSize = size;
+  return true;
+}
+
+/*
+==================
+RB_GLSL_DrawShadowMapCasters
+==================
+*/
+static void RB_GLSL_DrawShadowMapCasters(const drawSurf_t* surf, const float faceMatrix[16]) {
+  backEnd.currentSpace = NULL;
+
+  for ( ; surf; surf = surf->nextOnLight ) {
+    if ( RB_GLSL_SelectSkinning(surf->geo, &shadowMapShader, &shadowMapSkinnedShader)) {
+      backEnd.currentSpace = NULL;
+    }
+
+    if ( surf->space != backEnd.currentSpace ) {
+      float mvp[16];
+      myGlMultMatrix(surf->space->modelMatrix, faceMatrix, mvp);
+      GL_UniformMatrix4fv(offsetof(shaderProgram_t, modelViewProjectionMatrix), mvp);
+      backEnd.currentSpace = surf->space;
+    }
+
+    // the casters are the original surfaces, not shadow volumes
+    idDrawVert* ac = (idDrawVert*) vertexCache.Position(surf->geo->ambientCache);
+    GL_VertexAttribPointer(offsetof(shaderProgram_t, attr_Vertex), 3, GL_FLOAT, false, sizeof(idDrawVert),
+                           ac->xyz.ToFloatPtr());
+
+    RB_DrawElementsWithCounters(surf->geo);
+  }
+
+  backEnd.currentSpace = NULL;
+}
+
+/*
+==================
+RB_GLSL_RenderShadowMaps
+
+Renders the casters of every light R_AllocShadowMaps placed in the atlas,
+before anything else of the view so its framebuffer is only left once
+==================
+*/
+void RB_GLSL_RenderShadowMaps(void) {
+  const viewLight_t* vLight;
+  int atlasSize = 0;
+
+  shadowMapsRendered = false;
+
+  if ( !backEnd.viewDef->viewEntitys ) {
+    return;
+  }
+
+  for ( vLight = backEnd.viewDef->viewLights; vLight; vLight = vLight->next ) {
+    if ( vLight->shadowMapSize ) {
+      atlasSize = vLight->shadowMapAtlasSize;
+      break;
+    }
+  }
+
+  if ( !atlasSize || !RB_GLSL_CreateShadowMapAtlas(atlasSize)) {
+    return;
+  }
+
+  //////////////////
+  // Setup GL state
+  //////////////////
+
+  GLint viewFramebuffer;
+  qglGetIntegerv(GL_FRAMEBUFFER_BINDING, &viewFramebuffer);
+
+  qglBindFramebuffer(GL_FRAMEBUFFER, shadowMapFramebuffer);
+  qglViewport(0, 0, atlasSize, atlasSize);
+  qglScissor(0, 0, atlasSize, atlasSize);
+  qglEnable(GL_DEPTH_TEST);
+  qglDisable(GL_STENCIL_TEST);
+
+  // only depth, cleared to the far plane
+  GL_State(GLS_DEPTHFUNC_LESS | GLS_COLORMASK | GLS_ALPHAMASK);
+  qglClear(GL_DEPTH_BUFFER_BIT);
+
+  // slope scaled offset against acne, the interaction shaders add the constant bias
+  qglPolygonOffset(r_shadowMapSlopeBias.GetFloat(), 0.0f);
+  qglEnable(GL_POLYGON_OFFSET_FILL);
+
+  GL_UseProgram(&shadowMapShader);
+
+  // Setup attributes arrays
+  // Vertex attribute is always enabled
+  // Disable Color attribute (as it is enabled by default)
+  // Disable TexCoord attribute (as it is enabled by default)
+  GL_DisableVertexAttribArray(ATTR_COLOR);
+  GL_DisableVertexAttribArray(ATTR_TEXCOORD);
+
+  // both sides cast, like the shadow volumes
+  GL_Cull(CT_TWO_SIDED);
+
+  ///////////////////////
+  // For each light loop
+  ///////////////////////
+
+  for ( vLight = backEnd.viewDef->viewLights; vLight; vLight = vLight->next ) {
+    if ( !vLight->shadowMapSize ) {
+      continue;
+    }
+
+    for ( int set = 0; set < vLight->numShadowMapSets; set++ ) {
+      for ( int face = 0; face < vLight->numShadowMapFaces; face++ ) {
+        qglViewport(vLight->shadowMapOffsets[set][face][0], vLight->shadowMapOffsets[set][face][1],
+                    vLight->shadowMapSize, vLight->shadowMapSize);
+        qglScissor(vLight->shadowMapOffsets[set][face][0], vLight->shadowMapOffsets[set][face][1],
+                   vLight->shadowMapSize, vLight->shadowMapSize);
+
+        RB_GLSL_DrawShadowMapCasters(vLight->globalShadows, vLight->shadowMapMatrices[face]);
+        if ( set == SHADOW_MAP_ALL_CASTERS ) {
+          RB_GLSL_DrawShadowMapCasters(vLight->localShadows, vLight->shadowMapMatrices[face]);
+        }
+      }
+    }
+  }
+
+  ////////////////////
+  // GL state restore
+  ////////////////////
+
+  GL_Cull(CT_FRONT_SIDED);
+
+  qglDisable(GL_POLYGON_OFFSET_FILL);
+
+  RB_GLSL_EndSkinning();
+
+  // Restore attributes arrays
+  // Vertex attribute is always enabled
+  // Re-enable Color attribute (as it is enabled by default)
+  // Re-enable TexCoord attribute (as it is enabled by default)
+  GL_EnableVertexAttribArray(ATTR_COLOR);
+  GL_EnableVertexAttribArray(ATTR_TEXCOORD);
+
+  qglEnable(GL_STENCIL_TEST);
+
+  // RB_BeginDrawingView sets the view viewport and scissor back
+  qglBindFramebuffer(GL_FRAMEBUFFER, viewFramebuffer);
+
+  shadowMapsRendered = true;
+}
+
 /*
 ==================
 RB_GLSL_DrawInteractions
@@ -1093,6 +1600,34 @@ void RB_GLSL_DrawInteractions(void) {
     // Setup GL state
     //////////////////
 
+    // shadow mapped lights don't touch the stencil buffer, and go unshadowed
+    // if the atlas ran out of room
+    if ( vLight->castsShadowMap ) {
+      const bool shadowMapped = vLight->shadowMapSize && shadowMapsRendered;
+      int localSet = -1;
+      int globalSet = -1;
+
+      qglStencilFunc(GL_ALWAYS, 128, 255);
+
+      if ( shadowMapped ) {
+        GL_SelectTexture(5);
+        qglBindTexture(GL_TEXTURE_2D, shadowMapTexture);
+        GL_SelectTexture(0);
+
+        // the NOSELFSHADOW surfaces only get the global shadows, as with the stencil passes
+        localSet = vLight->numShadowMapSets > 1 ? SHADOW_MAP_GLOBAL_CASTERS : SHADOW_MAP_ALL_CASTERS;
+        globalSet = SHADOW_MAP_ALL_CASTERS;
+      }
+
+      RB_GLSL_CreateDrawInteractions(vLight->localInteractions, vLight, GLS_DEPTHFUNC_EQUAL, localSet);
+      RB_GLSL_CreateDrawInteractions(vLight->globalInteractions, vLight, GLS_DEPTHFUNC_EQUAL, globalSet);
+
+      if ( !r_skipTranslucent.GetBool()) {
+        RB_GLSL_CreateDrawInteractions(vLight->translucentInteractions, vLight, GLS_DEPTHFUNC_LESS);
+      }
+      continue;
+    }
+
     // clear the stencil buffer if needed
     if ( vLight->globalShadows || vLight->localShadows ) {
 
@@ -1229,7 +1764,12 @@ void RB_GLSL_FogPass(const drawSurf_t* drawSurfs, const drawSurf_t* drawSurfs2,
   lightColor[2] = regs[stage->color.registers[2]];
   lightColor[3] = regs[stage->color.registers[3]];
 
-  // FogColor
+  // FogColor, on the skinned version too
+  if ( skinnedShadersLoaded ) {
+    GL_UseProgram(&fogSkinnedShader);
+    GL_Uniform4fv(offsetof(shaderProgram_t, fogColor), lightColor);
+    GL_UseProgram(&fogShader);
+  }
   GL_Uniform4fv(offsetof(shaderProgram_t, fogColor), lightColor);
 
   // calculate the falloff planes
@@ -1270,8 +1810,8 @@ void RB_GLSL_FogPass(const drawSurf_t* drawSurfs, const drawSurf_t* drawSurfs2,
 
   // draw it
   GL_State(GLS_DEPTHMASK | GLS_SRCBLEND_SRC_ALPHA | GLS_DSTBLEND_ONE_MINUS_SRC_ALPHA | GLS_DEPTHFUNC_EQUAL);
-  RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs, RB_T_GLSL_BasicFog, vLight);
-  RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs2, RB_T_GLSL_BasicFog, vLight);
+  RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs, RB_T_GLSL_BasicFog, vLight, &fogSkinnedShader);
+  RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs2, RB_T_GLSL_BasicFog, vLight, &fogSkinnedShader);
 
   // the light frustum bounding planes aren't in the depth buffer, so use depthfunc_less instead
   // of depthfunc_equal
@@ -1547,8 +2087,12 @@ void RB_GLSL_FillDepthBuffer(drawSurf_t** drawSurfs, int numDrawSurfs) {
 
   // If clip planes are enabled in the view, use he "Clip" version of zfill shader
   // and enable the second texture for mirror plane clipping if needed
+  shaderProgram_t* program = &zfillShader;
+  shaderProgram_t* skinnedProgram = &zfillSkinnedShader;
   if ( backEnd.viewDef->numClipPlanes ) {
     // Use he zfillClip shader
+    program = &zfillClipShader;
+    skinnedProgram = &zfillClipSkinnedShader;
     GL_UseProgram(&zfillClipShader);
 
     // Bind the Texture 1 to alphaNotchImage
@@ -1601,6 +2145,11 @@ void RB_GLSL_FillDepthBuffer(drawSurf_t** drawSurfs, int numDrawSurfs) {
     // GL shader setup for the current surface
     ///////////////////////////////////////////
 
+    // The skinned surfaces use the skinned version of the shader
+    if ( RB_GLSL_SelectSkinning(drawSurf->geo, program, skinnedProgram)) {
+      backEnd.currentSpace = NULL;
+    }
+
     // Change the MVP matrix if needed
     if ( drawSurf->space != backEnd.currentSpace ) {
       float mvp[16];
@@ -1652,6 +2201,8 @@ void RB_GLSL_FillDepthBuffer(drawSurf_t** drawSurfs, int numDrawSurfs) {
   // Restore current space to NULL
   backEnd.currentSpace = NULL;
 
+  RB_GLSL_EndSkinning();
+
   // Restore attributes arrays
   // Vertex attribute is always enabled
   // TexCoord attribute is always enabled
@@ -2306,27 +2857,32 @@ void RB_GLSL_BlendLight(const drawSurf_t *drawSurfs, const drawSurf_t *drawSurfs
 
     // Shader Uniforms
 
-    // Setup the texture matrix
-    if ( stage->texture.hasMatrix ) {
-      float matrix[16];
-      RB_GetShaderTextureMatrix(regs, &stage->texture, matrix);
-      GL_UniformMatrix4fv(offsetof(shaderProgram_t, textureMatrix), matrix);
-    }
-
     // Setup the Fog Color
     float lightColor[4];
     lightColor[0] = regs[stage->color.registers[0]];
     lightColor[1] = regs[stage->color.registers[1]];
     lightColor[2] = regs[stage->color.registers[2]];
     lightColor[3] = regs[stage->color.registers[3]];
-    GL_Uniform4fv(offsetof(shaderProgram_t, fogColor), lightColor);
+
+    // Setup the texture matrix, on the skinned version too
+    float matrix[16];
+    if ( stage->texture.hasMatrix ) {
+      RB_GetShaderTextureMatrix(regs, &stage->texture, matrix);
+    }
+    for ( int j = ( skinnedShadersLoaded ? 1 : 0 ); j >= 0; j-- ) {
+      GL_UseProgram(j ? &blendLightSkinnedShader : &blendLightShader);
+      if ( stage->texture.hasMatrix ) {
+        GL_UniformMatrix4fv(offsetof(shaderProgram_t, textureMatrix), matrix);
+      }
+      GL_Uniform4fv(offsetof(shaderProgram_t, fogColor), lightColor);
+    }
 
     ////////////////////
     // Do the Real Work
     ////////////////////
 
-    RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs, RB_T_GLSL_BlendLight, vLight);
-    RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs2, RB_T_GLSL_BlendLight, vLight);
+    RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs, RB_T_GLSL_BlendLight, vLight, &blendLightSkinnedShader);
+    RB_GLSL_RenderDrawSurfChainWithFunction(drawSurfs2, RB_T_GLSL_BlendLight, vLight, &blendLightSkinnedShader);
 
     ////////////////////
     // GL state restore
@@ -2334,7 +2890,10 @@ void RB_GLSL_BlendLight(const drawSurf_t *drawSurfs, const drawSurf_t *drawSurfs
 
     // Restore texture matrix to identity
     if (stage->texture.hasMatrix) {
-      GL_UniformMatrix4fv(offsetof(shaderProgram_t, textureMatrix), mat4_identity.ToFloatPtr());
+      for ( int j = ( skinnedShadersLoaded ? 1 : 0 ); j >= 0; j-- ) {
+        GL_UseProgram(j ? &blendLightSkinnedShader : &blendLightShader);
+        GL_UniformMatrix4fv(offsetof(shaderProgram_t, textureMatrix), mat4_identity.ToFloatPtr());
+      }
     }
   }
 }
@@ -2426,4 +2985,7 @@ void RB_GLSL_PrepareShaders(void) {
   GL_DisableVertexAttribArray(ATTR_NORMAL);
   GL_DisableVertexAttribArray(ATTR_TANGENT);
   GL_DisableVertexAttribArray(ATTR_BITANGENT);
+  GL_DisableVertexAttribArray(ATTR_JOINTINDICES);
+  GL_DisableVertexAttribArray(ATTR_JOINTWEIGHTS);
+  skinningArraysEnabled = false;
 }
\ No newline at end of file
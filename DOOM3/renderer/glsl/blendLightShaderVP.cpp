@@ -35,23 +35,30 @@ varying vec2 var_TexFogEnter;
 
 void main(void)
 {
-  gl_Position = u_modelViewProjectionMatrix * attr_Vertex;
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+#else
+  highp vec4 vertex = attr_Vertex;
+#endif
+
+  gl_Position = u_modelViewProjectionMatrix * vertex;
 
   // What will be computed:
   //
   // vec4 tc;
-  // tc.x = dot( u_fogMatrix[0], attr_Vertex );
-  // tc.y = dot( u_fogMatrix[1], attr_Vertex );
+  // tc.x = dot( u_fogMatrix[0], vertex );
+  // tc.y = dot( u_fogMatrix[1], vertex );
   // tc.z = 0.0;
-  // tc.w = dot( u_fogMatrix[2], attr_Vertex );
+  // tc.w = dot( u_fogMatrix[2], vertex );
   // var_TexFog.xy = tc.xy / tc.w;
   //
-  // var_TexFogEnter.x = dot( u_fogMatrix[3], attr_Vertex );
+  // var_TexFogEnter.x = dot( u_fogMatrix[3], vertex );
   // var_TexFogEnter.y = 0.5;
 
   // Optimized version:
   //
-  var_TexFog = vec2(dot( u_fogMatrix[0], attr_Vertex ), dot( u_fogMatrix[1], attr_Vertex )) / dot( u_fogMatrix[2], attr_Vertex );
-  var_TexFogEnter = vec2( dot( u_fogMatrix[3], attr_Vertex ), 0.5 );
+  var_TexFog = vec2(dot( u_fogMatrix[0], vertex ), dot( u_fogMatrix[1], vertex )) / dot( u_fogMatrix[2], vertex );
+  var_TexFogEnter = vec2( dot( u_fogMatrix[3], vertex ), 0.5 );
 }
 )";
@@ -35,17 +35,24 @@ varying vec2 var_TexFogEnter;    // output FogEnter TexCoord
   
 void main(void)
 {
-  gl_Position = u_modelViewProjectionMatrix * attr_Vertex;
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+#else
+  highp vec4 vertex = attr_Vertex;
+#endif
+
+  gl_Position = u_modelViewProjectionMatrix * vertex;
 
   // What will be computed:
   //
-  // var_TexFog.x      = dot(u_fogMatrix[0], attr_Vertex);
-  // var_TexFog.y      = dot(u_fogMatrix[1], attr_Vertex);
-  // var_TexFogEnter.x = dot(u_fogMatrix[2], attr_Vertex);
-  // var_TexFogEnter.y = dot(u_fogMatrix[3], attr_Vertex);
+  // var_TexFog.x      = dot(u_fogMatrix[0], vertex);
+  // var_TexFog.y      = dot(u_fogMatrix[1], vertex);
+  // var_TexFogEnter.x = dot(u_fogMatrix[2], vertex);
+  // var_TexFogEnter.y = dot(u_fogMatrix[3], vertex);
 
   // Optimized version:
-  var_TexFog      = vec2(dot(u_fogMatrix[0], attr_Vertex),dot(u_fogMatrix[1], attr_Vertex));
-  var_TexFogEnter = vec2(dot(u_fogMatrix[2], attr_Vertex),dot(u_fogMatrix[3], attr_Vertex));
+  var_TexFog      = vec2(dot(u_fogMatrix[0], vertex),dot(u_fogMatrix[1], vertex));
+  var_TexFogEnter = vec2(dot(u_fogMatrix[2], vertex),dot(u_fogMatrix[3], vertex));
 }
 )";
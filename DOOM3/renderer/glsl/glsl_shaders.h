@@ -25,6 +25,11 @@ extern const char* const interactionShaderFP;
   // phong
 extern const char* const interactionPhongShaderVP;
 extern const char* const interactionPhongShaderFP;
+  // shadow mapped (gouraud and phong)
+extern const char* const interactionShadowMapShaderVP;
+extern const char* const interactionShadowMapShaderFP;
+extern const char* const interactionPhongShadowMapShaderVP;
+extern const char* const interactionPhongShadowMapShaderFP;
 // Fog
 extern const char* const fogShaderVP;
 extern const char* const blendLightShaderVP;
@@ -48,5 +53,9 @@ extern const char* const cubeMapShaderFP;
 // Shadows
 extern const char* const stencilShadowShaderVP;
 extern const char* const stencilShadowShaderFP;
+extern const char* const shadowMapShaderVP;
+extern const char* const shadowMapShaderFP;
+// Skinning, inserted in the vertex programs of the skinned versions
+extern const char* const skinningShaderVP;
 
 #endif //D3WASM_GLSL_SHADERS_H
@@ -55,7 +55,20 @@ varying vec3 var_V;
   
 void main(void)
 {
-  mat3 M = mat3(attr_Tangent, attr_Bitangent, attr_Normal);
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+  vec3 tangent = SkinVector(attr_Tangent);
+  vec3 bitangent = SkinVector(attr_Bitangent);
+  vec3 normal = SkinVector(attr_Normal);
+#else
+  highp vec4 vertex = attr_Vertex;
+  vec3 tangent = attr_Tangent;
+  vec3 bitangent = attr_Bitangent;
+  vec3 normal = attr_Normal;
+#endif
+
+  mat3 M = mat3(tangent, bitangent, normal);
   
   var_TexNormal.x = dot(u_bumpMatrixS, attr_TexCoord);
   var_TexNormal.y = dot(u_bumpMatrixT, attr_TexCoord);
@@ -66,13 +79,13 @@ void main(void)
   var_TexSpecular.x = dot(u_specularMatrixS, attr_TexCoord);
   var_TexSpecular.y = dot(u_specularMatrixT, attr_TexCoord);
   
-  var_TexLight.x = dot(u_lightProjection[0], attr_Vertex);
-  var_TexLight.y = dot(u_lightProjection[1], attr_Vertex);
-  var_TexLight.z = dot(u_lightProjection[2], attr_Vertex);
-  var_TexLight.w = dot(u_lightProjection[3], attr_Vertex);
+  var_TexLight.x = dot(u_lightProjection[0], vertex);
+  var_TexLight.y = dot(u_lightProjection[1], vertex);
+  var_TexLight.z = dot(u_lightProjection[2], vertex);
+  var_TexLight.w = dot(u_lightProjection[3], vertex);
   
-  vec3 L = u_lightOrigin.xyz - attr_Vertex.xyz;
-  vec3 V = u_viewOrigin.xyz - attr_Vertex.xyz;
+  vec3 L = u_lightOrigin.xyz - vertex.xyz;
+  vec3 V = u_viewOrigin.xyz - vertex.xyz;
   
   var_L = L * M;
   var_V = V * M;
@@ -83,6 +96,6 @@ void main(void)
     var_Color = (attr_Color * u_colorModulate) + vec4(u_colorAdd);
   }
   
-  gl_Position = u_modelViewProjectionMatrix * attr_Vertex;
+  gl_Position = u_modelViewProjectionMatrix * vertex;
 }
 )";
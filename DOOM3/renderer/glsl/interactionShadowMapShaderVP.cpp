@@ -0,0 +1,112 @@
+/*
+ * This file is part of the D3wasm project (http://www.continuation-labs.com/projects/d3wasm)
+ * Copyright (c) 2019 Gabriel Cuvillier.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "glsl_shaders.h"
+
+const char * const interactionShadowMapShaderVP = R"(
+#version 300 es
+precision highp float;
+  
+// In
+in highp vec4 attr_Vertex;
+in lowp vec4 attr_Color;
+in vec4 attr_TexCoord;
+in vec3 attr_Tangent;
+in vec3 attr_Bitangent;
+in vec3 attr_Normal;
+
+// Uniforms
+uniform highp mat4 u_modelViewProjectionMatrix;
+uniform mat4 u_lightProjection;
+uniform lowp float u_colorModulate;
+uniform lowp float u_colorAdd;
+uniform vec4 u_lightOrigin;
+uniform vec4 u_viewOrigin;
+uniform vec4 u_bumpMatrixS;
+uniform vec4 u_bumpMatrixT;
+uniform vec4 u_diffuseMatrixS;
+uniform vec4 u_diffuseMatrixT;
+uniform vec4 u_specularMatrixS;
+uniform vec4 u_specularMatrixT;
+uniform mat4 u_shadowMapMatrix;
+uniform vec4 u_shadowMapParms;
+
+// Out
+// gl_Position
+out vec2 var_TexDiffuse;
+out vec2 var_TexNormal;
+out vec2 var_TexSpecular;
+out vec4 var_TexLight;
+out lowp vec4 var_Color;
+out vec4 var_TexShadow;
+out vec3 var_L;
+out vec3 var_H;
+  
+void main(void)
+{
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+  vec3 tangent = SkinVector(attr_Tangent);
+  vec3 bitangent = SkinVector(attr_Bitangent);
+  vec3 normal = SkinVector(attr_Normal);
+#else
+  highp vec4 vertex = attr_Vertex;
+  vec3 tangent = attr_Tangent;
+  vec3 bitangent = attr_Bitangent;
+  vec3 normal = attr_Normal;
+#endif
+
+  mat3 M = mat3(tangent, bitangent, normal);
+  
+  var_TexNormal.x = dot(u_bumpMatrixS, attr_TexCoord);
+  var_TexNormal.y = dot(u_bumpMatrixT, attr_TexCoord);
+  
+  var_TexDiffuse.x = dot(u_diffuseMatrixS, attr_TexCoord);
+  var_TexDiffuse.y = dot(u_diffuseMatrixT, attr_TexCoord);
+  
+  var_TexSpecular.x = dot(u_specularMatrixS, attr_TexCoord);
+  var_TexSpecular.y = dot(u_specularMatrixT, attr_TexCoord);
+  
+  var_TexLight.x = dot(u_lightProjection[0], vertex);
+  var_TexLight.y = dot(u_lightProjection[1], vertex);
+  var_TexLight.z = dot(u_lightProjection[2], vertex);
+  var_TexLight.w = dot(u_lightProjection[3], vertex);
+  
+  vec3 L = u_lightOrigin.xyz - vertex.xyz;
+  vec3 V = u_viewOrigin.xyz - vertex.xyz;
+  vec3 H = normalize(L) + normalize(V);
+  
+  var_L = L * M;
+  var_H = H * M;
+
+  if (u_colorModulate == 0.0) {
+    var_Color = vec4(u_colorAdd);
+  } else {
+    var_Color = (attr_Color * u_colorModulate) + vec4(u_colorAdd);
+  }
+  
+  // projected lights: tile clip coordinates, point lights: light to vertex vector in world space
+  if (u_shadowMapParms.w > 0.5) {
+    var_TexShadow = u_shadowMapMatrix * vec4(vertex.xyz - u_lightOrigin.xyz, 0.0);
+  } else {
+    var_TexShadow = u_shadowMapMatrix * vertex;
+  }
+
+  gl_Position = u_modelViewProjectionMatrix * vertex;
+}
+)";
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the D3wasm project (http://www.continuation-labs.com/projects/d3wasm)
+ * Copyright (c) 2019 Gabriel Cuvillier.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "glsl_shaders.h"
+
+// Inserted after the #version line of the vertex programs that have a skinned version
+const char * const skinningShaderVP = R"(
+#define SKINNING
+
+// In
+#if __VERSION__ >= 300
+in highp vec4 attr_JointIndices;
+in highp vec4 attr_JointWeights;
+#else
+attribute highp vec4 attr_JointIndices;
+attribute highp vec4 attr_JointWeights;
+#endif
+
+// Uniforms
+uniform highp vec4 u_joints[192];   // MAX_GPU_SKINNING_JOINTS rows of 3x4 joint matrices
+
+highp vec4 skinRows[3];
+
+// blends the joint matrices of the vertex
+void SkinJoints(void)
+{
+  ivec4 j = ivec4(attr_JointIndices) * 3;
+  highp vec4 w = attr_JointWeights;
+
+  skinRows[0] = u_joints[j.x] * w.x + u_joints[j.y] * w.y + u_joints[j.z] * w.z + u_joints[j.w] * w.w;
+  skinRows[1] = u_joints[j.x + 1] * w.x + u_joints[j.y + 1] * w.y + u_joints[j.z + 1] * w.z + u_joints[j.w + 1] * w.w;
+  skinRows[2] = u_joints[j.x + 2] * w.x + u_joints[j.y + 2] * w.y + u_joints[j.z + 2] * w.z + u_joints[j.w + 2] * w.w;
+}
+
+highp vec4 SkinVertex(highp vec4 v)
+{
+  return vec4(dot(skinRows[0], v), dot(skinRows[1], v), dot(skinRows[2], v), 1.0);
+}
+
+// blending the joints shortens the vectors a little
+vec3 SkinVector(vec3 v)
+{
+  return normalize(vec3(dot(skinRows[0].xyz, v), dot(skinRows[1].xyz, v), dot(skinRows[2].xyz, v)));
+}
+)";
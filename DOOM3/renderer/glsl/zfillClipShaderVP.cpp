@@ -37,10 +37,17 @@ varying vec2 var_TexClip;
         
 void main(void)
 {
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+#else
+  highp vec4 vertex = attr_Vertex;
+#endif
+
   var_TexDiffuse = (u_textureMatrix * attr_TexCoord).xy;  // Homogeneous coordinates of textureMatrix supposed to be 1
 
-  var_TexClip = vec2( dot( u_clipPlane, attr_Vertex), 0.5 );
+  var_TexClip = vec2( dot( u_clipPlane, vertex), 0.5 );
 
-  gl_Position = u_modelViewProjectionMatrix * attr_Vertex;
+  gl_Position = u_modelViewProjectionMatrix * vertex;
 }
 )";
@@ -35,8 +35,15 @@ varying vec2 var_TexDiffuse;
         
 void main(void)
 {
+#ifdef SKINNING
+  SkinJoints();
+  highp vec4 vertex = SkinVertex(attr_Vertex);
+#else
+  highp vec4 vertex = attr_Vertex;
+#endif
+
   var_TexDiffuse = (u_textureMatrix * attr_TexCoord).xy;  // Homogeneous coordinates of textureMatrix supposed to be 1
 
-  gl_Position = u_modelViewProjectionMatrix * attr_Vertex;
+  gl_Position = u_modelViewProjectionMatrix * vertex;
 }
 )";
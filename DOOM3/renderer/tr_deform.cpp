@@ -1064,6 +1064,13 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 	g.origin.Zero();
 	g.axis = mat3_identity;
 
+	// the particles have their own origins on the surface
+	particleBatch_t	batch;
+	bool			useBatches = r_useParticleBatches.GetBool();
+
+	batch.numParticles = 0;
+	batch.localOrigins = true;
+
 	for ( int currentTri = 0; currentTri < ( ( useArea ) ? 1 : numSourceTris ); currentTri++ ) {
 
 		for ( int stageNum = 0 ; stageNum < particleSystem->stages.Num() ; stageNum++ ) {
@@ -1099,6 +1106,8 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 
 			tri->numVerts = 0;
 
+			unsigned int start = Sys_Microseconds();
+
 			idRandom	steppingRandom, steppingRandom2;
 
 			int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
@@ -1187,6 +1196,20 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 
 				//-----------------------
 
+				tr.pc.c_particles++;
+
+				if ( useBatches ) {
+					batch.index[batch.numParticles] = index;
+					batch.frac[batch.numParticles] = g.frac;
+					batch.random[batch.numParticles] = g.random;
+					batch.origin[batch.numParticles] = g.origin;
+					batch.axis[batch.numParticles] = g.axis;
+					if ( ++batch.numParticles == MAX_PARTICLE_BATCH ) {
+						tri->numVerts += stage->CreateParticleBatch( &g, &batch, tri->verts + tri->numVerts );
+					}
+					continue;
+				}
+
 				// this is needed so aimed particles can calculate origins at different times
 				g.originalRandom = g.random;
 
@@ -1197,6 +1220,13 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 				tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
 			}
 
+			if ( batch.numParticles > 0 ) {
+				tri->numVerts += stage->CreateParticleBatch( &g, &batch, tri->verts + tri->numVerts );
+			}
+
+			tr.pc.c_particleStages++;
+			tr.pc.c_particleUsec += Sys_Microseconds() - start;
+
 			if ( tri->numVerts > 0 ) {
 				// build the index list
 				int	indexes = 0;
@@ -0,0 +1,426 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+#include "sys/platform.h"
+
+#include "renderer/tr_local.h"
+
+/*
+
+Gui texture atlas
+
+Every gui image and font page is its own implicit material, so idGuiModel has
+to start a new surface whenever a gui switches between them, and a hud or an
+in-world screen ends up as dozens of draws.  The images of those materials
+that are small enough are copied into a few big atlas pages the first time
+they are drawn, and idGuiModel merges the neighboring surfaces that are on the
+same page into one surface drawn with the page material.  The page material
+modulates by the vertex colors, so the color of each merged surface is moved
+into its verts.
+
+The pages are filled at the end of every level load from the gui materials
+whose images the level uses, nothing is read from disk while the guis are
+drawn.  The images are packed on shelves, each one with a border of replicated
+edge texels so the bilinear filter and the first few mip levels act like
+clamping, the pages don't use the mip levels past those.  Images that don't fit, or gui materials that show up only later,
+are simply drawn on their own.
+
+*/
+
+const int GUI_ATLAS_PAGE_SIZE		= 1024;
+const int GUI_ATLAS_MAX_PAGES		= 4;
+const int GUI_ATLAS_MAX_IMAGE_SIZE	= 256;	// bigger images are drawn on their own
+const int GUI_ATLAS_BORDER			= 4;
+
+// core in OpenGL ES 3.0
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL			0x813D
+#endif
+
+typedef enum {
+	GAS_UNKNOWN,
+	GAS_REJECTED,
+	GAS_ADDED
+} guiAtlasState_t;
+
+typedef struct {
+	guiAtlasState_t		state;
+	int					page;
+	const idImage *		image;				// the stage image that was copied, to catch reloaded materials
+	guiAtlasTile_t		tile;
+} guiAtlasEntry_t;
+
+typedef struct {
+	idImage *			image;
+	const idMaterial *	material;
+	int					shelfX, shelfY, shelfHeight;
+	bool				mipsDirty;
+	idList<int>			materials;			// decl indexes of the materials added to this page
+} guiAtlasPage_t;
+
+static guiAtlasPage_t			atlasPages[GUI_ATLAS_MAX_PAGES];
+static int						numAtlasPages;
+static idList<guiAtlasEntry_t>	atlasEntries;		// indexed by material decl index
+
+/*
+=================
+R_EmptyGuiAtlasPage
+=================
+*/
+static void R_EmptyGuiAtlasPage( guiAtlasPage_t *page ) {
+	int pageNum = page - atlasPages;
+
+	for ( int i = 0; i < page->materials.Num(); i++ ) {
+		guiAtlasEntry_t *entry = &atlasEntries[page->materials[i]];
+		if ( entry->state == GAS_ADDED && entry->page == pageNum ) {
+			entry->state = GAS_UNKNOWN;
+		}
+	}
+	page->materials.Clear();
+	page->shelfX = 0;
+	page->shelfY = 0;
+	page->shelfHeight = 0;
+	page->mipsDirty = false;
+}
+
+/*
+=================
+R_GuiAtlasPageImage
+
+Also runs when the images are reloaded, which loses the tiles of the page
+=================
+*/
+static void R_GuiAtlasPageImage( idImage *image ) {
+	for ( int i = 0; i < numAtlasPages; i++ ) {
+		if ( atlasPages[i].image == image ) {
+			R_EmptyGuiAtlasPage( &atlasPages[i] );
+		}
+	}
+
+	byte *data = (byte *)R_StaticAlloc( GUI_ATLAS_PAGE_SIZE * GUI_ATLAS_PAGE_SIZE * 4 );
+	memset( data, 0, GUI_ATLAS_PAGE_SIZE * GUI_ATLAS_PAGE_SIZE * 4 );
+
+	image->GenerateImage( data, GUI_ATLAS_PAGE_SIZE, GUI_ATLAS_PAGE_SIZE, TF_DEFAULT, false, TR_CLAMP, TD_HIGH_QUALITY );
+
+	// the border shrinks to a single texel by this level, the ones
+	// below would filter in the neighboring tiles
+	image->Bind();
+	qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, idMath::ILog2( GUI_ATLAS_BORDER ) );
+
+	R_StaticFree( data );
+}
+
+/*
+=================
+R_AllocGuiAtlasPage
+=================
+*/
+static guiAtlasPage_t *R_AllocGuiAtlasPage( void ) {
+	if ( numAtlasPages == GUI_ATLAS_MAX_PAGES ) {
+		return NULL;
+	}
+
+	guiAtlasPage_t *page = &atlasPages[numAtlasPages];
+	idStr name = va( "_guiAtlas%i", numAtlasPages );
+
+	page->image = globalImages->ImageFromFunction( name, R_GuiAtlasPageImage );
+	R_EmptyGuiAtlasPage( page );
+
+	// replace the implicit text, the page draws the color of each gui surface from the vertex colors
+	idMaterial *material = const_cast<idMaterial *>( declManager->FindMaterial( name ) );
+	material->SetText( va( "material %s { { blend blend vertexColor map %s clamp } }", name.c_str(), name.c_str() ) );
+	material->Invalidate();
+	material->EnsureNotPurged();
+	material->SetSort( SS_GUI );
+	page->material = material;
+
+	numAtlasPages++;
+
+	return page;
+}
+
+/*
+=================
+R_AllocGuiAtlasRect
+
+Shelf packing, a rect that doesn't fit next to the others on the current
+shelf starts a new one below it
+=================
+*/
+static bool R_AllocGuiAtlasRect( guiAtlasPage_t *page, int width, int height, int &x, int &y ) {
+	int shelfX = page->shelfX;
+	int shelfY = page->shelfY;
+	int shelfHeight = page->shelfHeight;
+
+	if ( shelfX + width > GUI_ATLAS_PAGE_SIZE ) {
+		shelfY += shelfHeight;
+		shelfX = 0;
+		shelfHeight = 0;
+	}
+	if ( shelfY + height > GUI_ATLAS_PAGE_SIZE ) {
+		return false;
+	}
+
+	x = shelfX;
+	y = shelfY;
+	page->shelfX = shelfX + width;
+	page->shelfY = shelfY;
+	page->shelfHeight = Max( shelfHeight, height );
+
+	return true;
+}
+
+/*
+=================
+R_MaterialFitsGuiAtlas
+
+Only the implicit materials of plain images, which is what guis and fonts
+use for almost everything, the stage must look just like SetDefaultText made it
+=================
+*/
+static bool R_MaterialFitsGuiAtlas( const idMaterial *material ) {
+	if ( !material->IsImplicit() || material->GetNumStages() != 1 || material->Deform() != DFRM_NONE ) {
+		return false;
+	}
+
+	const shaderStage_t *stage = material->GetStage( 0 );
+	if ( ( stage->drawStateBits & ( GLS_SRCBLEND_BITS | GLS_DSTBLEND_BITS ) ) != ( GLS_SRCBLEND_SRC_ALPHA | GLS_DSTBLEND_ONE_MINUS_SRC_ALPHA ) ) {
+		return false;
+	}
+	for ( int i = 0; i < 4; i++ ) {
+		if ( stage->color.registers[i] != EXP_REG_PARM0 + i ) {
+			return false;
+		}
+	}
+	if ( stage->vertexColor != SVC_IGNORE || stage->hasAlphaTest || stage->newStage || stage->privatePolygonOffset ) {
+		return false;
+	}
+
+	const textureStage_t *texture = &stage->texture;
+	if ( texture->cinematic || texture->dynamic != DI_STATIC || texture->texgen != TG_EXPLICIT || texture->hasMatrix ) {
+		return false;
+	}
+	if ( !texture->image || texture->image->generatorFunction || texture->image->cubeFiles != CF_2D ) {
+		return false;
+	}
+
+	return true;
+}
+
+/*
+=================
+R_AddGuiAtlasTile
+
+Reads the image again and copies it into the first page with room for it,
+only while a level loads
+=================
+*/
+static bool R_AddGuiAtlasTile( const idMaterial *material, guiAtlasEntry_t *entry ) {
+	const idImage	*image = material->GetStage( 0 )->texture.image;
+	byte			*pic;
+	int				width, height;
+	ID_TIME_T		timestamp;
+
+	R_LoadImageProgram( image->imgName, &pic, &width, &height, &timestamp );
+	if ( !pic ) {
+		return false;
+	}
+	if ( width > GUI_ATLAS_MAX_IMAGE_SIZE || height > GUI_ATLAS_MAX_IMAGE_SIZE ) {
+		R_StaticFree( pic );
+		return false;
+	}
+
+	int tileWidth = width + GUI_ATLAS_BORDER * 2;
+	int tileHeight = height + GUI_ATLAS_BORDER * 2;
+	guiAtlasPage_t *page = NULL;
+	int x, y;
+
+	for ( int i = 0; i <= numAtlasPages && !page; i++ ) {
+		guiAtlasPage_t *check = ( i < numAtlasPages ) ? &atlasPages[i] : R_AllocGuiAtlasPage();
+		if ( !check ) {
+			break;
+		}
+		// generating the page empties it
+		if ( check->image->texnum == (GLuint)idImage::TEXTURE_NOT_LOADED ) {
+			check->image->Bind();
+		}
+		// image_forceDownSize can shrink the pages
+		if ( check->image->uploadWidth != GUI_ATLAS_PAGE_SIZE || check->image->uploadHeight != GUI_ATLAS_PAGE_SIZE ) {
+			break;
+		}
+		if ( R_AllocGuiAtlasRect( check, tileWidth, tileHeight, x, y ) ) {
+			page = check;
+		}
+	}
+	if ( !page ) {
+		R_StaticFree( pic );
+		return false;
+	}
+
+	// replicate the edges into the border
+	byte *tile = (byte *)R_StaticAlloc( tileWidth * tileHeight * 4 );
+	for ( int ty = 0; ty < tileHeight; ty++ ) {
+		int sy = idMath::ClampInt( 0, height - 1, ty - GUI_ATLAS_BORDER );
+		for ( int tx = 0; tx < tileWidth; tx++ ) {
+			int sx = idMath::ClampInt( 0, width - 1, tx - GUI_ATLAS_BORDER );
+			*(int *)&tile[( ty * tileWidth + tx ) * 4] = *(const int *)&pic[( sy * width + sx ) * 4];
+		}
+	}
+
+	page->image->UploadSubImage( tile, x, y, tileWidth, tileHeight );
+	page->mipsDirty = true;
+	page->materials.Append( material->Index() );
+
+	R_StaticFree( tile );
+	R_StaticFree( pic );
+
+	entry->state = GAS_ADDED;
+	entry->page = page - atlasPages;
+	entry->image = image;
+	entry->tile.pageMaterial = page->material;
+	entry->tile.scale.x = (float)width / GUI_ATLAS_PAGE_SIZE;
+	entry->tile.scale.y = (float)height / GUI_ATLAS_PAGE_SIZE;
+	entry->tile.bias.x = (float)( x + GUI_ATLAS_BORDER ) / GUI_ATLAS_PAGE_SIZE;
+	entry->tile.bias.y = (float)( y + GUI_ATLAS_BORDER ) / GUI_ATLAS_PAGE_SIZE;
+
+	tr.pc.c_guiAtlasTiles++;
+
+	return true;
+}
+
+/*
+=================
+R_GuiAtlasTile
+
+The returned tile is only valid until the next level load
+=================
+*/
+const guiAtlasTile_t *R_GuiAtlasTile( const idMaterial *material ) {
+	int index = material->Index();
+
+	if ( index >= atlasEntries.Num() ) {
+		return NULL;
+	}
+
+	guiAtlasEntry_t *entry = &atlasEntries[index];
+
+	if ( entry->state != GAS_ADDED ) {
+		return NULL;
+	}
+	if ( material->GetNumStages() != 1 || material->GetStage( 0 )->texture.image != entry->image ) {
+		// the material was reloaded with something else
+		entry->state = GAS_REJECTED;
+		return NULL;
+	}
+
+	return &entry->tile;
+}
+
+/*
+=================
+R_FillGuiAtlas
+
+Copies the images of the parsed gui materials that the level uses into the
+pages, the guis of the menus and the hud were all loaded by now
+=================
+*/
+void R_FillGuiAtlas( void ) {
+	if ( !r_useGuiAtlas.GetBool() ) {
+		return;
+	}
+
+	int numMaterials = declManager->GetNumDecls( DECL_MATERIAL );
+
+	if ( numMaterials > atlasEntries.Num() ) {
+		int oldNum = atlasEntries.Num();
+		atlasEntries.SetGranularity( 256 );
+		atlasEntries.SetNum( numMaterials, false );
+		for ( int i = oldNum; i < atlasEntries.Num(); i++ ) {
+			atlasEntries[i].state = GAS_UNKNOWN;
+		}
+	}
+
+	for ( int i = 0; i < numMaterials; i++ ) {
+		const idMaterial *material = declManager->MaterialByIndex( i, false );
+		guiAtlasEntry_t *entry = &atlasEntries[i];
+
+		if ( entry->state == GAS_ADDED ) {
+			continue;
+		}
+		entry->state = GAS_REJECTED;
+
+		if ( material->GetSort() != SS_GUI || !R_MaterialFitsGuiAtlas( material ) ) {
+			continue;
+		}
+		const idImage *image = material->GetStage( 0 )->texture.image;
+		if ( !image->levelLoadReferenced && !image->referencedOutsideLevelLoad ) {
+			continue;
+		}
+
+		R_AddGuiAtlasTile( material, entry );
+	}
+
+	for ( int i = 0; i < numAtlasPages; i++ ) {
+		if ( atlasPages[i].mipsDirty ) {
+			atlasPages[i].image->GenerateMipmaps();
+			atlasPages[i].mipsDirty = false;
+		}
+	}
+}
+
+/*
+=================
+R_ClearGuiAtlas
+
+The pages keep their textures, the next level fills them again
+=================
+*/
+void R_ClearGuiAtlas( void ) {
+	for ( int i = 0; i < numAtlasPages; i++ ) {
+		R_EmptyGuiAtlasPage( &atlasPages[i] );
+	}
+	atlasEntries.Clear();
+}
+
+/*
+=================
+R_ShutdownGuiAtlas
+
+The page images are freed with the rest of the images
+=================
+*/
+void R_ShutdownGuiAtlas( void ) {
+	R_ClearGuiAtlas();
+
+	for ( int i = 0; i < numAtlasPages; i++ ) {
+		atlasPages[i].image = NULL;
+		atlasPages[i].material = NULL;
+	}
+	numAtlasPages = 0;
+}
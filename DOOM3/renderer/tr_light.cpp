@@ -66,7 +66,19 @@ bool R_CreateAmbientCache(srfTriangles_t* tri, bool needsLighting) {
     }
 
     // Build the ambient cache
-    vertexCache.Alloc(tri->verts, tri->numVerts * sizeof(tri->verts[0]), &tri->ambientCache, false);
+    if ( tri->skinning ) {
+      // the joint weights follow the vertexes, see RB_GLSL_SelectSkinning
+      int vertSize = tri->numVerts * sizeof(tri->verts[0]);
+      int weightSize = tri->numVerts * sizeof(tri->skinning->weights[0]);
+      byte* data = (byte*) R_StaticAlloc(vertSize + weightSize);
+      memcpy(data, tri->verts, vertSize);
+      memcpy(data + vertSize, tri->skinning->weights, weightSize);
+      vertexCache.Alloc(data, vertSize + weightSize, &tri->ambientCache, false);
+      R_StaticFree(data);
+    }
+    else {
+      vertexCache.Alloc(tri->verts, tri->numVerts * sizeof(tri->verts[0]), &tri->ambientCache, false);
+    }
 
     // Check for errors
     if ( !tri->ambientCache ) {
@@ -379,6 +391,7 @@ viewLight_t* R_SetLightDefViewLight(idRenderLightLocal* light) {
   vLight->falloffImage = light->falloffImage;
   vLight->lightShader = light->lightShader;
   vLight->shaderRegisters = NULL;    // allocated and evaluated in R_AddLightSurfaces
+  vLight->castsShadowMap = R_LightCastsShadowMap(light);
 
   // link the view light
   vLight->next = tr.viewDef->viewLights;
@@ -389,6 +402,54 @@ viewLight_t* R_SetLightDefViewLight(idRenderLightLocal* light) {
   return vLight;
 }
 
+
+/*
+=================
+R_SkipEntityForLight
+
+If the entity isn't viewed, the light may not need it as a shadow caster in this view
+=================
+*/
+static bool R_SkipEntityForLight(const idRenderLightLocal* ldef, const idRenderEntityLocal* edef) {
+  if ( !tr.viewDef || edef->viewCount == tr.viewCount ) {
+    return false;
+  }
+  // if the light doesn't cast shadows, skip
+  if ( !ldef->lightShader->LightCastsShadows()) {
+    return true;
+  }
+  // if we are suppressing its shadow in this view, skip
+  if ( !r_skipSuppress.GetBool()) {
+    if ( edef->parms.suppressShadowInViewID &&
+         edef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
+      return true;
+    }
+    if ( edef->parms.suppressShadowInLightID && edef->parms.suppressShadowInLightID == ldef->parms.lightId ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+=================
+R_LightAreasChanged
+
+Returns true if an entity was added to any of the light's areas since it was last swept
+=================
+*/
+static bool R_LightAreasChanged(const idRenderLightLocal* ldef) {
+  if ( ldef->interactionSweepCount < 0 ) {
+    return true;
+  }
+  for ( const areaReference_t* lref = ldef->references; lref; lref = lref->ownerNext ) {
+    if ( lref->area->entityRefChangeCount > ldef->interactionSweepCount ) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /*
 =================
 idRenderWorldLocal::CreateLightDefInteractions
@@ -407,7 +468,12 @@ even if their surfaces aren't visible, because they may need to cast shadows.
 
 Interactions are usually removed when a entityDef or lightDef is modified, unless the change
 is known to not effect them, so there is no danger of getting a stale interaction, we just need to
-check that needed ones are created.
+check that needed ones are created.  A moved def keeps its interactions with the defs it still
+shares an area with, see R_UpdateLightDefInteractions and R_UpdateEntityDefInteractions.
+
+Interactions are created for every entity in the light's areas, even the ones that don't need a
+viewEntity in this view.  The areas then only have to be swept again when an entity was added
+to one of them, otherwise walking the light's own interaction list is enough.
 
 An interaction can be at several levels:
 
@@ -425,6 +491,19 @@ void idRenderWorldLocal::CreateLightDefInteractions(idRenderLightLocal* ldef) {
   portalArea_t* area;
   idInteraction* inter;
 
+  if ( !R_LightAreasChanged(ldef)) {
+    // all the entities in the light's areas already have interactions, empty ones
+    // are linked at the end of the list
+    for ( inter = ldef->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = inter->lightNext ) {
+      if ( !R_SkipEntityForLight(ldef, inter->entityDef)) {
+        // if this entity wasn't in view already, the scissor rect will be empty,
+        // so it will only be used for shadow casting
+        R_SetEntityDefViewEntity(inter->entityDef);
+      }
+    }
+    return;
+  }
+
   for ( lref = ldef->references; lref; lref = lref->ownerNext ) {
     area = lref->area;
 
@@ -436,24 +515,6 @@ void idRenderWorldLocal::CreateLightDefInteractions(idRenderLightLocal* ldef) {
       // but we don't want to instantiate dynamic models yet, so we can't check that on
       // most things
 
-      // if the entity isn't viewed
-      if ( tr.viewDef && edef->viewCount != tr.viewCount ) {
-        // if the light doesn't cast shadows, skip
-        if ( !ldef->lightShader->LightCastsShadows()) {
-          continue;
-        }
-        // if we are suppressing its shadow in this view, skip
-        if ( !r_skipSuppress.GetBool()) {
-          if ( edef->parms.suppressShadowInViewID &&
-               edef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
-            continue;
-          }
-          if ( edef->parms.suppressShadowInLightID && edef->parms.suppressShadowInLightID == ldef->parms.lightId ) {
-            continue;
-          }
-        }
-      }
-
       // some big outdoor meshes are flagged to not create any dynamic interactions
       // when the level designer knows that nearby moving lights shouldn't actually hit them
       if ( edef->parms.noDynamicInteractions && edef->world->generateAllInteractionsCalled ) {
@@ -462,19 +523,9 @@ void idRenderWorldLocal::CreateLightDefInteractions(idRenderLightLocal* ldef) {
 
       // if any of the edef's interaction match this light, we don't
       // need to consider it.
-      if ( r_useInteractionTable.GetBool() && this->interactionTable ) {
-        // allocating these tables may take several megs on big maps, but it saves 3% to 5% of
-        // the CPU time.  The table is updated at interaction::AllocAndLink() and interaction::UnlinkAndFree()
-        int index = ldef->index * this->interactionTableWidth + edef->index;
-        inter = this->interactionTable[index];
-        if ( inter ) {
-          // if this entity wasn't in view already, the scissor rect will be empty,
-          // so it will only be used for shadow casting
-          if ( !inter->IsEmpty()) {
-            R_SetEntityDefViewEntity(edef);
-          }
-          continue;
-        }
+      if ( r_useInteractionTable.GetBool()) {
+        // the table is updated at interaction::AllocAndLink() and interaction::UnlinkAndFree()
+        inter = this->interactionTable.Find(ldef, edef);
       }
       else {
         // scan the doubly linked lists, which may have several dozen entries
@@ -487,48 +538,46 @@ void idRenderWorldLocal::CreateLightDefInteractions(idRenderLightLocal* ldef) {
             break;
           }
         }
-
-        // if we already have an interaction, we don't need to do anything
-        if ( inter != NULL ) {
-          // if this entity wasn't in view already, the scissor rect will be empty,
-          // so it will only be used for shadow casting
-          if ( !inter->IsEmpty()) {
-            R_SetEntityDefViewEntity(edef);
-          }
-          continue;
-        }
       }
 
-      //
-      // create a new interaction, but don't do any work other than bbox to frustum culling
-      //
-      idInteraction* inter = idInteraction::AllocAndLink(edef, ldef);
+      if ( inter == NULL ) {
+        //
+        // create a new interaction, but don't do any work other than bbox to frustum culling
+        //
+        inter = idInteraction::AllocAndLink(edef, ldef);
 
-      // do a check of the entity reference bounds against the light frustum,
-      // trying to avoid creating a viewEntity if it hasn't been already
-      float modelMatrix[16];
-      float* m;
+        // do a check of the entity reference bounds against the light frustum,
+        // trying to avoid creating a viewEntity if it hasn't been already
+        float modelMatrix[16];
+        float* m;
 
-      if ( edef->viewCount == tr.viewCount ) {
-        m = edef->viewEntity->modelMatrix;
-      }
-      else {
-        R_AxisToModelMatrix(edef->parms.axis, edef->parms.origin, modelMatrix);
-        m = modelMatrix;
+        if ( edef->viewCount == tr.viewCount ) {
+          m = edef->viewEntity->modelMatrix;
+        }
+        else {
+          R_AxisToModelMatrix(edef->parms.axis, edef->parms.origin, modelMatrix);
+          m = modelMatrix;
+        }
+
+        if ( R_CullLocalBox(edef->referenceBounds, m, 6, ldef->frustum)) {
+          inter->MakeEmpty();
+          continue;
+        }
+
+        // we will do a more precise per-surface check when we are checking the entity
       }
 
-      if ( R_CullLocalBox(edef->referenceBounds, m, 6, ldef->frustum)) {
-        inter->MakeEmpty();
+      if ( inter->IsEmpty() || R_SkipEntityForLight(ldef, edef)) {
         continue;
       }
 
-      // we will do a more precise per-surface check when we are checking the entity
-
       // if this entity wasn't in view already, the scissor rect will be empty,
       // so it will only be used for shadow casting
       R_SetEntityDefViewEntity(edef);
     }
   }
+
+  ldef->interactionSweepCount = this->entityRefChangeCount;
 }
 
 //===============================================================================================================
@@ -854,6 +903,13 @@ void R_AddLightSurfaces(void) {
       }
     }
 
+    // everything the light can reach is hidden behind the world
+    if ( R_CullLightByOcclusion(vLight)) {
+      *ptr = vLight->next;
+      light->viewCount = -1;
+      continue;
+    }
+
 #if 0
     // this never happens, because CullLightByPortals() does a more precise job
     if ( vLight->scissorRect.IsEmpty() ) {
@@ -898,7 +954,8 @@ void R_AddLightSurfaces(void) {
     }
 
     // add the prelight shadows for the static world geometry
-    if ( light->parms.prelightModel && r_useOptimizedShadows.GetBool()) {
+    // (shadow maps draw the world surfaces themselves)
+    if ( light->parms.prelightModel && r_useOptimizedShadows.GetBool() && !vLight->castsShadowMap ) {
 
       if ( !light->parms.prelightModel->NumSurfaces()) {
         common->Error("no surfs in prelight model '%s'", light->parms.prelightModel->Name());
@@ -980,6 +1037,69 @@ bool R_IssueEntityDefCallback(idRenderEntityLocal* def) {
   return update;
 }
 
+/*
+===================
+R_FinishEntityDefDynamicModel
+
+Adds the overlays to a new snapshot of the dynamic model, which needs the
+final vertexes of the model surfaces
+===================
+*/
+static void R_FinishEntityDefDynamicModel(idRenderEntityLocal* def) {
+  // add any overlays to the snapshot of the dynamic model
+  if ( def->overlay && !r_skipOverlays.GetBool()) {
+    def->overlay->AddOverlaySurfacesToModel(def->cachedDynamicModel);
+  }
+  else {
+    idRenderModelOverlay::RemoveOverlaySurfacesFromModel(def->cachedDynamicModel);
+  }
+
+  if ( r_checkBounds.GetBool()) {
+    idBounds b = def->cachedDynamicModel->Bounds();
+    if ( b[0][0] < def->referenceBounds[0][0] - CHECK_BOUNDS_EPSILON ||
+         b[0][1] < def->referenceBounds[0][1] - CHECK_BOUNDS_EPSILON ||
+         b[0][2] < def->referenceBounds[0][2] - CHECK_BOUNDS_EPSILON ||
+         b[1][0] > def->referenceBounds[1][0] + CHECK_BOUNDS_EPSILON ||
+         b[1][1] > def->referenceBounds[1][1] + CHECK_BOUNDS_EPSILON ||
+         b[1][2] > def->referenceBounds[1][2] + CHECK_BOUNDS_EPSILON ) {
+      common->Printf("entity %i dynamic model exceeded reference bounds\n", def->index);
+    }
+  }
+}
+
+// entities whose snapshots wait for tr.modelJobs to finish
+static idList<idRenderEntityLocal*> modelJobEntities;
+
+/*
+===================
+R_EntityDefSkinsOnGPU
+
+The vertex programs can only skin the md5 models whose vertexes aren't
+read on the CPU, which rules out overlays and stencil shadow volumes
+===================
+*/
+static bool R_EntityDefSkinsOnGPU(const idRenderEntityLocal* def) {
+  if ( !r_useGPUSkinning.GetBool() || !r_useShadowMapping.GetBool()) {
+    return false;
+  }
+
+  if ( def->overlay && !r_skipOverlays.GetBool()) {
+    return false;
+  }
+
+  // parallel lights keep their shadow volumes
+  if ( !def->parms.noShadow ) {
+    for ( idInteraction* inter = def->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = inter->entityNext ) {
+      const idRenderLightLocal* light = inter->lightDef;
+      if ( !light->parms.noShadows && light->lightShader->LightCastsShadows() && !R_LightCastsShadowMap(light)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 /*
 ===================
 R_EntityDefDynamicModel
@@ -987,10 +1107,12 @@ R_EntityDefDynamicModel
 Issues a deferred entity callback if necessary.
 If the model isn't dynamic, it returns the original.
 Returns the cached dynamic model if present, otherwise creates
-it and any necessary overlays
+it and any necessary overlays.
+If cpuVertexes is set, a snapshot skinned by the vertex programs
+is created again with its final vertexes
 ===================
 */
-idRenderModel* R_EntityDefDynamicModel(idRenderEntityLocal* def) {
+idRenderModel* R_EntityDefDynamicModel(idRenderEntityLocal* def, bool cpuVertexes) {
   bool callbackUpdate;
 
   // allow deferred entities to construct themselves
@@ -1010,6 +1132,7 @@ idRenderModel* R_EntityDefDynamicModel(idRenderEntityLocal* def) {
   if ( model->IsDynamicModel() == DM_STATIC ) {
     def->dynamicModel = NULL;
     def->dynamicModelFrameCount = 0;
+    def->dynamicModelHash = 0;
     return model;
   }
 
@@ -1019,37 +1142,33 @@ idRenderModel* R_EntityDefDynamicModel(idRenderEntityLocal* def) {
     R_ClearEntityDefDynamicModel(def);
   }
 
+  // the surfaces already drawn keep the old snapshot until the end of the frame
+  if ( cpuVertexes && def->dynamicModel && def->dynamicModelOnGPU ) {
+    R_ClearEntityDefDynamicModel(def);
+  }
+
   // if we don't have a snapshot of the dynamic model, generate it now
   if ( !def->dynamicModel ) {
 
     // instantiate the snapshot of the dynamic model, possibly reusing memory from the cached snapshot
+    tr.skinOnGPU = !cpuVertexes && model->NumJoints() > 0 && R_EntityDefSkinsOnGPU(def);
     def->cachedDynamicModel = model->InstantiateDynamicModel(&def->parms, tr.viewDef, def->cachedDynamicModel);
+    def->dynamicModelOnGPU = tr.skinOnGPU;
+    tr.skinOnGPU = false;
 
     if ( def->cachedDynamicModel ) {
-
-      // add any overlays to the snapshot of the dynamic model
-      if ( def->overlay && !r_skipOverlays.GetBool()) {
-        def->overlay->AddOverlaySurfacesToModel(def->cachedDynamicModel);
+      if ( tr.modelJobs ) {
+        // the vertexes may still be created on the job threads
+        modelJobEntities.Append(def);
       }
       else {
-        idRenderModelOverlay::RemoveOverlaySurfacesFromModel(def->cachedDynamicModel);
-      }
-
-      if ( r_checkBounds.GetBool()) {
-        idBounds b = def->cachedDynamicModel->Bounds();
-        if ( b[0][0] < def->referenceBounds[0][0] - CHECK_BOUNDS_EPSILON ||
-             b[0][1] < def->referenceBounds[0][1] - CHECK_BOUNDS_EPSILON ||
-             b[0][2] < def->referenceBounds[0][2] - CHECK_BOUNDS_EPSILON ||
-             b[1][0] > def->referenceBounds[1][0] + CHECK_BOUNDS_EPSILON ||
-             b[1][1] > def->referenceBounds[1][1] + CHECK_BOUNDS_EPSILON ||
-             b[1][2] > def->referenceBounds[1][2] + CHECK_BOUNDS_EPSILON ) {
-          common->Printf("entity %i dynamic model exceeded reference bounds\n", def->index);
-        }
+        R_FinishEntityDefDynamicModel(def);
       }
     }
 
     def->dynamicModel = def->cachedDynamicModel;
     def->dynamicModelFrameCount = tr.frameCount;
+    def->dynamicModelHash = R_DynamicModelHash(def);
   }
 
   // set model depth hack value
@@ -1350,6 +1469,85 @@ idScreenRect R_CalcEntityScissorRectangle(viewEntity_t* vEntity) {
   return R_ScreenRectFromViewFrustumBounds(bounds);
 }
 
+/*
+===================
+R_InstantiateViewEntityModels
+
+Instantiates the dynamic models of the visible md5 and particle entities up
+front, so the vertexes of all of them are skinned or created in parallel on
+the job threads.  Entities that are only seen by their shadows are still
+instantiated on demand.  The skinning stays on the CPU when the shadow volumes
+or overlays read the skinned vertexes, otherwise the vertex programs do it with
+shadow mapping, see R_EntityDefSkinsOnGPU.
+===================
+*/
+static void R_InstantiateViewEntityModels(void) {
+  static idJobList modelJobs;
+  viewEntity_t* vEntity;
+
+  if ( !r_useSkinningJobs.GetBool() && !r_useParticleJobs.GetBool()) {
+    return;
+  }
+
+  tr.modelJobs = &modelJobs;
+
+  for ( vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next ) {
+    idRenderEntityLocal* def = vEntity->entityDef;
+    idRenderModel* model = def->parms.hModel;
+
+    if ( vEntity->scissorRect.IsEmpty()) {
+      continue;
+    }
+    if ( model == NULL ) {
+      continue;
+    }
+    if ( model->NumJoints() > 0 ) {
+      if ( !r_useSkinningJobs.GetBool()) {
+        continue;
+      }
+    }
+    else if ( model->IsDynamicModel() != DM_CONTINUOUS || !r_useParticleJobs.GetBool()) {
+      continue;
+    }
+    if ( tr.viewDef->isXraySubview ? def->parms.xrayIndex == 1 : def->parms.xrayIndex == 2 ) {
+      continue;
+    }
+
+    game->SelectTimeGroup(def->parms.timeGroup);
+
+    if ( def->parms.timeGroup ) {
+      float oldFloatTime = tr.viewDef->floatTime;
+      int oldTime = tr.viewDef->renderView.time;
+
+      tr.viewDef->floatTime = game->GetTimeGroupTime(def->parms.timeGroup) * 0.001;
+      tr.viewDef->renderView.time = game->GetTimeGroupTime(def->parms.timeGroup);
+
+      R_EntityDefDynamicModel(def);
+
+      tr.viewDef->floatTime = oldFloatTime;
+      tr.viewDef->renderView.time = oldTime;
+    }
+    else {
+      R_EntityDefDynamicModel(def);
+    }
+  }
+
+  tr.modelJobs = NULL;
+
+  if ( modelJobs.NumJobs() > 0 ) {
+    modelJobs.Submit();
+    modelJobs.Wait();
+    modelJobs.Clear();
+  }
+
+  R_FinishParticleJobs();
+
+  for ( int i = 0; i < modelJobEntities.Num(); i++ ) {
+    R_FinishEntityDefDynamicModel(modelJobEntities[i]);
+  }
+  modelJobEntities.SetNum(0, false);
+}
+
 /*
 ===================
 R_AddModelSurfaces
@@ -1370,8 +1568,7 @@ void R_AddModelSurfaces(void) {
   tr.viewDef->numDrawSurfs = 0;
   tr.viewDef->maxDrawSurfs = 0;  // will be set to INITIAL_DRAWSURFS on R_AddDrawSurf
 
-  // go through each entity that is either visible to the view, or to
-  // any light that intersects the view (for shadows)
+  // find the visible entities first
   for ( vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next ) {
 
     if ( r_useEntityScissors.GetBool()) {
@@ -1385,6 +1582,19 @@ void R_AddModelSurfaces(void) {
       }
     }
 
+    // an entity hidden behind the world only casts shadows
+    if ( !vEntity->scissorRect.IsEmpty() && R_CullEntityByOcclusion(vEntity)) {
+      vEntity->scissorRect.Clear();
+    }
+  }
+
+  // skin the visible md5 models and create their particles in parallel
+  R_InstantiateViewEntityModels();
+
+  // go through each entity that is either visible to the view, or to
+  // any light that intersects the view (for shadows)
+  for ( vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next ) {
+
     float oldFloatTime = 0.0f;
     int oldTime = 0;
 
@@ -1524,3 +1734,265 @@ void R_RemoveUnecessaryViewLights(void) {
     }
   }
 }
+
+/*
+===========================================================================================
+
+SHADOW MAP ATLAS
+
+===========================================================================================
+*/
+
+/*
+=====================
+R_LightCastsShadowMap
+=====================
+*/
+bool R_LightCastsShadowMap(const idRenderLightLocal* light) {
+  // lights without shadows have no casters, like on the stencil path
+  if ( light->parms.noShadows || !light->lightShader->LightCastsShadows()) {
+    return false;
+  }
+
+  // parallel lights have no origin to project from, they keep their shadow volumes
+  return r_useShadowMapping.GetBool() && !light->parms.parallel;
+}
+
+/*
+=====================
+R_ShadowMapPowerOfTwo
+
+rounds down, unlike idMath::FloorPowerOfTwo it keeps exact powers of two
+=====================
+*/
+static int R_ShadowMapPowerOfTwo(int x) {
+  return idMath::CeilPowerOfTwo(x + 1) >> 1;
+}
+
+/*
+=====================
+R_SetShadowMapProjection
+
+Builds a column major world to clip matrix from the planes giving the
+clip x, y and w, w being the linear distance along the face axis
+=====================
+*/
+static void R_SetShadowMapProjection(float matrix[16], const idVec4& right, const idVec4& up, const idVec4& forward,
+                                     float range) {
+  const float a = ( range + SHADOW_MAP_NEAR ) / ( range - SHADOW_MAP_NEAR );
+  const float b = -2.0f * range * SHADOW_MAP_NEAR / ( range - SHADOW_MAP_NEAR );
+
+  for ( int i = 0; i < 4; i++ ) {
+    matrix[i * 4 + 0] = right[i];
+    matrix[i * 4 + 1] = up[i];
+    matrix[i * 4 + 2] = a * forward[i];
+    matrix[i * 4 + 3] = forward[i];
+  }
+  matrix[3 * 4 + 2] += b;
+}
+
+/*
+=====================
+R_SetShadowMapFaces
+
+Point lights get six 90 degree faces in +X -X +Y -Y +Z -Z order, the face
+uses the two other axes in xyz order for its s and t, as the interaction
+shaders expect. Projected lights use the light projection itself.
+=====================
+*/
+static bool R_SetShadowMapFaces(viewLight_t* vLight) {
+  const idRenderLightLocal* light = vLight->lightDef;
+  const srfTriangles_t* frustumTris = light->frustumTris;
+
+  if ( !frustumTris ) {
+    return false;
+  }
+
+  if ( light->parms.pointLight ) {
+    const idVec3& origin = vLight->globalLightOrigin;
+    float range = 0.0f;
+
+    for ( int i = 0; i < 8; i++ ) {
+      const idVec3 corner(frustumTris->bounds[( i >> 0 ) & 1][0], frustumTris->bounds[( i >> 1 ) & 1][1],
+                          frustumTris->bounds[( i >> 2 ) & 1][2]);
+      range = Max(range, ( corner - origin ).LengthFast());
+    }
+    if ( range <= SHADOW_MAP_NEAR ) {
+      return false;
+    }
+
+    for ( int face = 0; face < 6; face++ ) {
+      const int axis = face >> 1;
+      const int s = axis == 0 ? 1 : 0;
+      const int t = axis == 2 ? 1 : 2;
+      idVec4 forward, right, up;
+
+      forward.Zero();
+      right.Zero();
+      up.Zero();
+      forward[axis] = ( face & 1 ) ? -1.0f : 1.0f;
+      forward[3] = -forward[axis] * origin[axis];
+      right[s] = 1.0f;
+      right[3] = -origin[s];
+      up[t] = 1.0f;
+      up[3] = -origin[t];
+
+      R_SetShadowMapProjection(vLight->shadowMapMatrices[face], right, up, forward, range);
+    }
+
+    vLight->numShadowMapFaces = 6;
+    vLight->shadowMapRange = range;
+  }
+  else {
+    // lightProject[2] is a unit length plane through the light origin
+    const idVec4& q = vLight->lightProject[2].ToVec4();
+    float range = 0.0f;
+
+    for ( int i = 0; i < frustumTris->numVerts; i++ ) {
+      range = Max(range, vLight->lightProject[2].Distance(frustumTris->verts[i].xyz));
+    }
+    if ( range <= SHADOW_MAP_NEAR ) {
+      return false;
+    }
+
+    R_SetShadowMapProjection(vLight->shadowMapMatrices[0], 2.0f * vLight->lightProject[0].ToVec4() - q,
+                             2.0f * vLight->lightProject[1].ToVec4() - q, q, range);
+
+    vLight->numShadowMapFaces = 1;
+    vLight->shadowMapRange = range;
+  }
+
+  return true;
+}
+
+/*
+=====================
+R_SortShadowMapLights
+=====================
+*/
+static int R_SortShadowMapLights(const void* a, const void* b) {
+  return ( *(const viewLight_t* const*) b )->shadowMapSize - ( *(const viewLight_t* const*) a )->shadowMapSize;
+}
+
+/*
+=====================
+R_ShadowMapCompact
+
+the even bits of a morton index
+=====================
+*/
+static int R_ShadowMapCompact(int v) {
+  v &= 0x55555555;
+  v = ( v ^ ( v >> 1 )) & 0x33333333;
+  v = ( v ^ ( v >> 2 )) & 0x0f0f0f0f;
+  v = ( v ^ ( v >> 4 )) & 0x00ff00ff;
+  v = ( v ^ ( v >> 8 )) & 0x0000ffff;
+  return v;
+}
+
+/*
+=====================
+R_AllocShadowMaps
+
+Gives every shadow mapped light of the view a tile size from its screen
+coverage, shrinks all the tiles until they fit in the atlas, and packs them.
+Lights with both NOSELFSHADOW casters and receivers get a second set of
+tiles without those casters.
+All sizes are powers of two, so placing them biggest first along a morton
+curve of the smallest tile size leaves no holes.
+=====================
+*/
+void R_AllocShadowMaps(void) {
+  viewLight_t* vLight;
+  int numLights = 0;
+
+  if ( !r_useShadowMapping.GetBool() || !r_shadows.GetBool()) {
+    return;
+  }
+
+  for ( vLight = tr.viewDef->viewLights; vLight; vLight = vLight->next ) {
+    if ( vLight->castsShadowMap && ( vLight->globalShadows || vLight->localShadows )) {
+      numLights++;
+    }
+  }
+  if ( !numLights ) {
+    return;
+  }
+
+  const int atlasSize = Min(R_ShadowMapPowerOfTwo(r_shadowMapAtlasSize.GetInteger()), glConfig.maxTextureSize);
+  const int minSize = Min(R_ShadowMapPowerOfTwo(r_shadowMapMinSize.GetInteger()), atlasSize);
+  const int maxSize = Max(Min(R_ShadowMapPowerOfTwo(r_shadowMapSize.GetInteger()), atlasSize), minSize);
+
+  const idScreenRect& viewport = tr.viewDef->viewport;
+  const float viewWidth = viewport.x2 + 1 - viewport.x1;
+  const float viewHeight = viewport.y2 + 1 - viewport.y1;
+
+  viewLight_t** lights = (viewLight_t**) R_FrameAlloc(numLights * sizeof(lights[0]));
+  int totalArea = 0;
+
+  numLights = 0;
+  for ( vLight = tr.viewDef->viewLights; vLight; vLight = vLight->next ) {
+    if ( !vLight->castsShadowMap || ( !vLight->globalShadows && !vLight->localShadows )) {
+      continue;
+    }
+    if ( !R_SetShadowMapFaces(vLight)) {
+      continue;
+    }
+
+    // resolution from the screen coverage of the light
+    const float coverage = Max(( vLight->scissorRect.x2 + 1 - vLight->scissorRect.x1 ) / viewWidth,
+                               ( vLight->scissorRect.y2 + 1 - vLight->scissorRect.y1 ) / viewHeight);
+    const int size = idMath::CeilPowerOfTwo(idMath::Ftoi(maxSize * idMath::ClampFloat(0.0f, 1.0f, coverage)));
+
+    vLight->shadowMapSize = idMath::ClampInt(minSize, maxSize, size);
+    vLight->shadowMapAtlasSize = atlasSize;
+    vLight->numShadowMapSets = ( vLight->localShadows && vLight->localInteractions ) ? 2 : 1;
+    totalArea += vLight->numShadowMapSets * vLight->numShadowMapFaces * vLight->shadowMapSize * vLight->shadowMapSize;
+
+    lights[numLights++] = vLight;
+  }
+
+  // too many or too big lights, lower everyone's resolution
+  while ( totalArea > atlasSize * atlasSize ) {
+    bool shrunk = false;
+
+    totalArea = 0;
+    for ( int i = 0; i < numLights; i++ ) {
+      if ( lights[i]->shadowMapSize > minSize ) {
+        lights[i]->shadowMapSize >>= 1;
+        shrunk = true;
+      }
+      totalArea += lights[i]->numShadowMapSets * lights[i]->numShadowMapFaces * lights[i]->shadowMapSize *
+                   lights[i]->shadowMapSize;
+    }
+
+    if ( !shrunk ) {
+      break;
+    }
+  }
+
+  qsort(lights, numLights, sizeof(lights[0]), R_SortShadowMapLights);
+
+  const int numCells = ( atlasSize / minSize ) * ( atlasSize / minSize );
+  int cell = 0;
+
+  for ( int i = 0; i < numLights; i++ ) {
+    vLight = lights[i];
+
+    const int tileCells = ( vLight->shadowMapSize / minSize ) * ( vLight->shadowMapSize / minSize );
+
+    if ( cell + vLight->numShadowMapSets * vLight->numShadowMapFaces * tileCells > numCells ) {
+      // still no room at the smallest size, the light is drawn unshadowed
+      vLight->shadowMapSize = 0;
+      continue;
+    }
+
+    for ( int set = 0; set < vLight->numShadowMapSets; set++ ) {
+      for ( int face = 0; face < vLight->numShadowMapFaces; face++ ) {
+        vLight->shadowMapOffsets[set][face][0] = R_ShadowMapCompact(cell) * minSize;
+        vLight->shadowMapOffsets[set][face][1] = R_ShadowMapCompact(cell >> 1) * minSize;
+        cell += tileCells;
+      }
+    }
+  }
+}
@@ -583,6 +583,7 @@ void R_CreateLightDefFogPortals( idRenderLightLocal *ldef ) {
 				dp->fogLight = ldef;
 				dp->nextFoggedPortal = ldef->foggedPortals;
 				ldef->foggedPortals = dp;
+				ldef->world->portalStateCount++;
 			}
 		}
 	}
@@ -593,20 +594,34 @@ void R_CreateLightDefFogPortals( idRenderLightLocal *ldef ) {
 R_FreeLightDefDerivedData
 
 Frees all references and lit surfaces from the light
+
+If keepInteractions is set the interactions are only reset, and
+R_UpdateLightDefInteractions frees the ones that no longer apply
+once the light has its new references
 ====================
 */
-void R_FreeLightDefDerivedData( idRenderLightLocal *ldef ) {
+void R_FreeLightDefDerivedData( idRenderLightLocal *ldef, bool keepInteractions ) {
 	areaReference_t	*lref, *nextRef;
+	idInteraction	*nextInter;
 
 	// rmove any portal fog references
 	for ( doublePortal_t *dp = ldef->foggedPortals ; dp ; dp = dp->nextFoggedPortal ) {
 		dp->fogLight = NULL;
+		ldef->world->portalStateCount++;
 	}
 
 	// free all the interactions
-	while ( ldef->firstInteraction != NULL ) {
-		ldef->firstInteraction->UnlinkAndFree();
+	if ( keepInteractions ) {
+		for ( idInteraction *inter = ldef->firstInteraction; inter != NULL; inter = nextInter ) {
+			nextInter = inter->lightNext;
+			inter->Reset();
+		}
+	} else {
+		while ( ldef->firstInteraction != NULL ) {
+			ldef->firstInteraction->UnlinkAndFree();
+		}
 	}
+	ldef->interactionSweepCount = -1;
 
 	// free all the references to the light
 	for ( lref = ldef->references ; lref ; lref = nextRef ) {
@@ -630,11 +645,16 @@ R_FreeEntityDefDerivedData
 
 Used by both RE_FreeEntityDef and RE_UpdateEntityDef
 Does not actually free the entityDef.
+
+If keepInteractions is set the interactions are only reset, and
+R_UpdateEntityDefInteractions frees the ones that no longer apply
+once the entity has its new references
 ===================
 */
-void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel ) {
+void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel, bool keepInteractions ) {
 	int i;
 	areaReference_t	*ref, *next;
+	idInteraction	*nextInter;
 
 	// demo playback needs to free the joints, while normal play
 	// leaves them in the control of the game
@@ -656,8 +676,15 @@ void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool
 	}
 
 	// free all the interactions
-	while ( def->firstInteraction != NULL ) {
-		def->firstInteraction->UnlinkAndFree();
+	if ( keepInteractions ) {
+		for ( idInteraction *inter = def->firstInteraction; inter != NULL; inter = nextInter ) {
+			nextInter = inter->entityNext;
+			inter->Reset();
+		}
+	} else {
+		while ( def->firstInteraction != NULL ) {
+			def->firstInteraction->UnlinkAndFree();
+		}
 	}
 
 	// clear the dynamic model if present
@@ -682,6 +709,9 @@ void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool
 		// unlink from the area
 		ref->areaNext->areaPrev = ref->areaPrev;
 		ref->areaPrev->areaNext = ref->areaNext;
+		if ( def->moveCount ) {
+			ref->area->entityMoveCount = def->moveCount;
+		}
 
 		// put it back on the free list for reuse
 		def->world->areaReferenceAllocator.Free( ref );
@@ -689,6 +719,111 @@ void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool
 	def->entityRefs = NULL;
 }
 
+/*
+===================
+R_ReferencesMarkedArea
+
+Returns true if any of the references is in an area set in areas
+===================
+*/
+static bool R_ReferencesMarkedArea( const areaReference_t *refs, const byte *areas ) {
+	for ( const areaReference_t *ref = refs ; ref ; ref = ref->ownerNext ) {
+		if ( areas[ ref->area->areaNum ] ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+===================
+R_UpdateLightDefInteractions
+
+Called after a moved light has its new references. The interactions kept by
+R_FreeLightDefDerivedData are freed if the entity no longer shares an area with
+the light, or made empty if its bounds are outside the new light frustum.
+Entities flagged noDynamicInteractions lose theirs once GenerateAllInteractions
+was called, as they would if the interactions had been made again.
+Entities that came into the light's areas get their interactions from the next
+idRenderWorldLocal::CreateLightDefInteractions.
+===================
+*/
+void R_UpdateLightDefInteractions( idRenderLightLocal *ldef ) {
+	idInteraction	*inter, *next;
+	byte			*lightAreas;
+
+	if ( ldef->firstInteraction == NULL ) {
+		return;
+	}
+
+	lightAreas = (byte *)_alloca( ldef->world->numPortalAreas + 1 );
+	memset( lightAreas, 0, ldef->world->numPortalAreas + 1 );
+	for ( areaReference_t *lref = ldef->references ; lref ; lref = lref->ownerNext ) {
+		lightAreas[ lref->area->areaNum ] = 1;
+	}
+
+	// empty interactions are relinked at the end of the list, where
+	// they will be visited again and left alone
+	for ( inter = ldef->firstInteraction ; inter ; inter = next ) {
+		next = inter->lightNext;
+
+		idRenderEntityLocal *edef = inter->entityDef;
+		if ( !R_ReferencesMarkedArea( edef->entityRefs, lightAreas ) ) {
+			inter->UnlinkAndFree();
+			continue;
+		}
+		// CreateLightDefInteractions wouldn't have made it for a moving light either
+		if ( edef->parms.noDynamicInteractions && edef->world->generateAllInteractionsCalled ) {
+			inter->UnlinkAndFree();
+			continue;
+		}
+		if ( !inter->IsEmpty() && R_CullLocalBox( edef->referenceBounds, edef->modelMatrix, 6, ldef->frustum ) ) {
+			inter->MakeEmpty();
+		}
+	}
+}
+
+/*
+===================
+R_UpdateEntityDefInteractions
+
+Called after a moved entity has its new references, the same as
+R_UpdateLightDefInteractions for the lights it kept interactions with
+===================
+*/
+void R_UpdateEntityDefInteractions( idRenderEntityLocal *def ) {
+	idInteraction	*inter, *next;
+	byte			*entityAreas;
+
+	if ( def->firstInteraction == NULL ) {
+		return;
+	}
+
+	entityAreas = (byte *)_alloca( def->world->numPortalAreas + 1 );
+	memset( entityAreas, 0, def->world->numPortalAreas + 1 );
+	for ( areaReference_t *ref = def->entityRefs ; ref ; ref = ref->ownerNext ) {
+		entityAreas[ ref->area->areaNum ] = 1;
+	}
+
+	for ( inter = def->firstInteraction ; inter ; inter = next ) {
+		next = inter->entityNext;
+
+		idRenderLightLocal *ldef = inter->lightDef;
+		if ( !R_ReferencesMarkedArea( ldef->references, entityAreas ) ) {
+			inter->UnlinkAndFree();
+			continue;
+		}
+		// the same goes for a moving entity
+		if ( def->parms.noDynamicInteractions && def->world->generateAllInteractionsCalled ) {
+			inter->UnlinkAndFree();
+			continue;
+		}
+		if ( !inter->IsEmpty() && R_CullLocalBox( def->referenceBounds, def->modelMatrix, 6, ldef->frustum ) ) {
+			inter->MakeEmpty();
+		}
+	}
+}
+
 /*
 ==================
 R_ClearEntityDefDynamicModel
@@ -766,7 +901,7 @@ void R_FreeDerivedData( void ) {
 			if ( !def ) {
 				continue;
 			}
-			R_FreeEntityDefDerivedData( def, false, false );
+			R_FreeEntityDefDerivedData( def, false, false, false );
 		}
 
 		for ( i = 0; i < rw->lightDefs.Num(); i++ ) {
@@ -774,7 +909,7 @@ void R_FreeDerivedData( void ) {
 			if ( !light ) {
 				continue;
 			}
-			R_FreeLightDefDerivedData( light );
+			R_FreeLightDefDerivedData( light, false );
 		}
 	}
 }
@@ -800,7 +935,7 @@ void R_CheckForEntityDefsUsingModel( idRenderModel *model ) {
 			if ( def->parms.hModel == model ) {
 				//assert( 0 );
 				// this should never happen but Radiant messes it up all the time so just free the derived data
-				R_FreeEntityDefDerivedData( def, false, false );
+				R_FreeEntityDefDerivedData( def, false, false, false );
 			}
 		}
 	}
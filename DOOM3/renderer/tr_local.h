@@ -231,6 +231,8 @@ public:
 	areaReference_t *		references;				// each area the light is present in will have a lightRef
 	idInteraction *			firstInteraction;		// doubly linked list
 	idInteraction *			lastInteraction;
+	int						interactionSweepCount;	// world entityRefChangeCount when all the entities in the light's
+													// areas were last given interactions, -1 if they must be swept again
 
 	struct doublePortal_s *	foggedPortals;
 };
@@ -266,6 +268,9 @@ public:
 	int						dynamicModelFrameCount;	// continuously animating dynamic models will recreate
 													// dynamicModel if this doesn't == tr.viewCount
 	idRenderModel *			cachedDynamicModel;
+	unsigned int			dynamicModelHash;		// pose of the dynamic model snapshot for the shadow cache,
+													// 0 if the snapshot can't be compared between updates
+	bool					dynamicModelOnGPU;		// the vertex programs skin the snapshot, its vertexes keep the bind pose
 
 	idBounds				referenceBounds;		// the local bounds used to place entityRefs, either from parms or a model
 
@@ -285,6 +290,7 @@ public:
 	idRenderModelOverlay *	overlay;				// blood overlays on animated models
 
 	areaReference_t *		entityRefs;				// chain of all references
+	int						moveCount;				// world entityMoveCount while UpdateEntityDef moves it, 0 otherwise
 	idInteraction *			firstInteraction;		// doubly linked list
 	idInteraction *			lastInteraction;
 
@@ -334,8 +340,29 @@ typedef struct viewLight_s {
 	const struct drawSurf_s	*localShadows;				// don't shadow local Surfaces
 	const struct drawSurf_s	*globalInteractions;		// get shadows from everything
 	const struct drawSurf_s	*translucentInteractions;	// get shadows from everything
+
+	// with r_useShadowMapping the shadow lists hold the caster surfaces themselves
+	// instead of shadow volumes, and R_AllocShadowMaps places the light in the atlas
+	bool					castsShadowMap;
+	int						shadowMapSize;				// tile size in texels, 0 if the atlas had no room left
+	int						numShadowMapFaces;			// 6 for point lights, 1 for projected lights
+	int						numShadowMapSets;			// 2 if the NOSELFSHADOW surfaces need a map without their own casters
+	int						shadowMapAtlasSize;
+	int						shadowMapOffsets[2][6][2];	// tile corners in the atlas, in texels, for each set and face
+	float					shadowMapRange;				// far plane distance of the face projections
+	float					shadowMapMatrices[6][16];	// world space to tile clip space for each face
 } viewLight_t;
 
+// the shadow map tile sets of a light, like the stencil path the localInteractions
+// are only shadowed by the globalShadows
+typedef enum {
+	SHADOW_MAP_ALL_CASTERS,		// globalShadows and localShadows
+	SHADOW_MAP_GLOBAL_CASTERS	// globalShadows only
+} shadowMapSet_t;
+
+// near plane distance of the shadow map face projections
+const float SHADOW_MAP_NEAR = 1.0f;
+
 
 // a viewEntity is created whenever a idRenderEntityLocal is considered for inclusion
 // in the current view, but it may still turn out to be culled.
@@ -576,6 +603,7 @@ typedef struct {
 	int		c_createInteractions;	// number of calls to idInteraction::CreateInteraction
 	int		c_createLightTris;
 	int		c_createShadowVolumes;
+	int		c_shadowCacheHits, c_shadowCacheMisses;	// R_CreateCachedShadowVolume
 	int		c_generateMd5;
 	int		c_entityDefCallbacks;
 	int		c_alloc, c_free;	// counts for R_StaticAllc/R_StaticFree
@@ -589,6 +617,20 @@ typedef struct {
 	int		c_tangentIndexes;	// R_DeriveTangents()
 	int		c_entityUpdates, c_lightUpdates, c_entityReferences, c_lightReferences;
 	int		c_guiSurfs;
+	int		c_guiModelSurfs;	// idGuiModel surfaces emitted
+	int		c_guiModelDraws;	// draw surfaces left of them after the atlas batching
+	int		c_guiAtlasTiles;	// images added to the gui atlas
+	int		c_portalFloodAreas;	// FloodViewThroughArea_r
+	int		c_portalClips;		// portal windings clipped by FloodViewThroughArea_r
+	int		c_portalFloodCacheHits, c_portalFloodCacheMisses;	// FlowViewThroughPortals
+	int		c_portalFloodUsec;	// time in FlowViewThroughPortals
+	int		c_occluderTris;		// R_BuildOcclusionBuffer
+	int		c_occlusionTests, c_occludedEntities, c_occludedLights;
+	int		c_occlusionUsec;	// time in R_BuildOcclusionBuffer
+	int		c_skinnedTangentVerts;	// compared by r_skinnedTangents 2
+	float	skinnedTangentError, skinnedTangentMaxError;	// in degrees
+	int		c_particleStages, c_particles;	// stages and live particles created
+	int		c_particleUsec;		// time creating particles, added up over all threads
 	int		frontEndMsec;		// sum of time in all RE_RenderScene's in a frame
 } performanceCounters_t;
 
@@ -746,6 +788,9 @@ public:
 
 	viewDef_t *				viewDef;
 
+	idJobList *				modelJobs;			// dynamic models queue their vertex work here while set
+	bool					skinOnGPU;			// md5 models leave the skinning to the vertex programs while set
+
 	performanceCounters_t	pc;					// performance counters
 
 	drawSurfsCommand_t		lockSurfacesCmd;	// use this when r_lockSurfaces = 1
@@ -798,8 +843,10 @@ extern idCVar r_specularExponent;
 extern idCVar r_useLightPortalFlow;		// 1 = do a more precise area reference determination
 extern idCVar r_useShadowSurfaceScissor;// 1 = scissor shadows by the scissor rect of the interaction surfaces
 extern idCVar r_useConstantMaterials;	// 1 = use pre-calculated material registers if possible
-extern idCVar r_useInteractionTable;	// create a full entityDefs * lightDefs table to make finding interactions faster
+extern idCVar r_useInteractionTable;	// use the sparse lightDef / entityDef table instead of the entityDef interaction lists to find interactions
 extern idCVar r_useNodeCommonChildren;	// stop pushing reference bounds early when possible
+extern idCVar r_usePortalFloodCache;	// reuse the portal flood of a view that didn't leave its area or move
+extern idCVar r_portalFloodCacheDist;	// distance the view origin can move and still reuse a portal flood
 extern idCVar r_useSilRemap;			// 1 = consider verts with the same XYZ, but different ST the same for shadows
 extern idCVar r_useCulling;				// 0 = none, 1 = sphere, 2 = sphere + box
 extern idCVar r_useLightCulling;		// 0 = none, 1 = box, 2 = exact clip of polyhedron faces
@@ -807,6 +854,8 @@ extern idCVar r_useLightScissors;		// 1 = use custom scissor rectangle for each
 extern idCVar r_useClippedLightScissors;// 0 = full screen when near clipped, 1 = exact when near clipped, 2 = exact always
 extern idCVar r_useEntityCulling;		// 0 = none, 1 = box
 extern idCVar r_useEntityScissors;		// 1 = use custom scissor rectangle for each entity
+extern idCVar r_useOcclusionCulling;	// 1 = cull entities and lights hidden behind the world with a software depth buffer
+extern idCVar r_occluderMinArea;		// smallest occluder triangle rasterized, in occlusion buffer pixels
 extern idCVar r_useInteractionCulling;	// 1 = cull interactions
 extern idCVar r_useInteractionScissors;	// 1 = use a custom scissor rectangle for each interaction
 extern idCVar r_useFrustumFarDistance;	// if != 0 force the view frustum far distance to this distance
@@ -818,6 +867,11 @@ extern idCVar r_useOptimizedShadows;	// 1 = use the dmap generated static shadow
 extern idCVar r_useShadowProjectedCull;	// 1 = discard triangles outside light volume before shadowing
 extern idCVar r_useDeferredTangents;	// 1 = don't always calc tangents after deform
 extern idCVar r_useCachedDynamicModels;	// 1 = cache snapshots of dynamic models
+extern idCVar r_useSkinningJobs;		// 1 = skin the md5 models of the visible entities on the job threads
+extern idCVar r_skinnedTangents;		// 0 = derive md5 tangents from the triangles, 1 = skin bind pose tangents, 2 = compare both
+extern idCVar r_useParticleJobs;		// 1 = create the particles of the visible particle systems on the job threads
+extern idCVar r_useParticleBatches;		// 1 = create particles in batches instead of one at a time
+extern idCVar r_useGuiAtlas;			// 1 = draw small gui images and font pages from a texture atlas in batches
 extern idCVar r_useInfiniteFarZ;		// 1 = use the no-far-clip-plane trick
 extern idCVar r_useScissor;				// 1 = scissor clip as portals and lights are processed
 extern idCVar r_usePortals;				// 1 = use portals to perform area culling, otherwise draw everything
@@ -882,6 +936,10 @@ extern idCVar r_showInteractionFrustums;// show a frustum for each interaction
 extern idCVar r_showInteractionScissors;// show screen rectangle which contains the interaction frustum
 extern idCVar r_showMemory;				// print frame memory utilization
 extern idCVar r_showCull;				// report sphere and box culling stats
+extern idCVar r_showPortalFlood;		// report portal flood areas, clips, cache hits and time
+extern idCVar r_showOcclusion;			// report occluder triangles, occlusion tests and culled entities and lights
+extern idCVar r_showParticles;			// report particle stages, particles and time
+extern idCVar r_showGuiSurfaces;		// report gui surfaces, the draws they were batched into and atlas additions
 extern idCVar r_showInteractions;		// report interaction generation activity
 extern idCVar r_showSurfaces;			// report surface/light/shadow counts
 extern idCVar r_showPrimitives;			// report vertex/index/draw counts
@@ -906,6 +964,15 @@ extern idCVar r_jitter;					// randomly subpixel jitter the projection matrix
 extern idCVar r_lightSourceRadius;		// for soft-shadow sampling
 extern idCVar r_lockSurfaces;
 extern idCVar r_orderIndexes;			// perform index reorganization to optimize vertex use
+extern idCVar r_binaryMD5;				// load md5 meshes and anims from binary files
+extern idCVar r_useShadowCache;			// reuse shadow volumes of animated entities that didn't change pose
+extern idCVar r_useShadowMapping;		// use shadow maps instead of stencil shadow volumes
+extern idCVar r_useGPUSkinning;			// skin md5 models in the vertex programs when shadow mapping
+extern idCVar r_shadowMapAtlasSize;		// size of the shadow map atlas texture
+extern idCVar r_shadowMapSize;			// largest tile size given to a single light
+extern idCVar r_shadowMapMinSize;		// smallest tile size given to a single light
+extern idCVar r_shadowMapBias;			// depth bias in world units for shadow map comparisons
+extern idCVar r_shadowMapSlopeBias;		// polygon offset factor for the shadow map casters
 
 extern idCVar r_debugLineDepthTest;		// perform depth test on debug lines
 extern idCVar r_debugLineWidth;			// width of debug lines
@@ -1077,7 +1144,10 @@ void R_ListRenderLightDefs_f( const idCmdArgs &args );
 void R_ListRenderEntityDefs_f( const idCmdArgs &args );
 
 bool R_IssueEntityDefCallback( idRenderEntityLocal *def );
-idRenderModel *R_EntityDefDynamicModel( idRenderEntityLocal *def );
+idRenderModel *R_EntityDefDynamicModel( idRenderEntityLocal *def, bool cpuVertexes = false );
+
+// Model_prt.cpp
+void R_FinishParticleJobs( void );
 
 viewEntity_t *R_SetEntityDefViewEntity( idRenderEntityLocal *def );
 viewLight_t *R_SetLightDefViewLight( idRenderLightLocal *def );
@@ -1111,6 +1181,8 @@ void R_SetLightProject( idPlane lightProject[4], const idVec3 origin, const idVe
 void R_AddLightSurfaces( void );
 void R_AddModelSurfaces( void );
 void R_RemoveUnecessaryViewLights( void );
+bool R_LightCastsShadowMap( const idRenderLightLocal *light );
+void R_AllocShadowMaps( void );
 
 void R_FreeDerivedData( void );
 void R_ReCreateWorldReferences( void );
@@ -1119,11 +1191,13 @@ void R_CreateEntityRefs( idRenderEntityLocal *def );
 void R_CreateLightRefs( idRenderLightLocal *light );
 
 void R_DeriveLightData( idRenderLightLocal *light );
-void R_FreeLightDefDerivedData( idRenderLightLocal *light );
+void R_FreeLightDefDerivedData( idRenderLightLocal *light, bool keepInteractions );
+void R_UpdateLightDefInteractions( idRenderLightLocal *light );
 void R_CheckForEntityDefsUsingModel( idRenderModel *model );
 
 void R_ClearEntityDefDynamicModel( idRenderEntityLocal *def );
-void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel );
+void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel, bool keepInteractions );
+void R_UpdateEntityDefInteractions( idRenderEntityLocal *def );
 void R_FreeEntityDefCachedDynamicModel( idRenderEntityLocal *def );
 void R_FreeEntityDefDecals( idRenderEntityLocal *def );
 void R_FreeEntityDefOverlay( idRenderEntityLocal *def );
@@ -1144,6 +1218,19 @@ srfTriangles_t *R_PolytopeSurface( int numPlanes, const idPlane *planes, idWindi
 /*
 ============================================================
 
+OCCLUSION
+
+============================================================
+*/
+
+void R_BuildOcclusionBuffer( void );
+bool R_CullLocalBoxByOcclusion( const idBounds &bounds, const float modelViewMatrix[16], const idScreenRect &scissor );
+bool R_CullEntityByOcclusion( const viewEntity_t *vEntity );
+bool R_CullLightByOcclusion( const viewLight_t *vLight );
+
+/*
+============================================================
+
 RENDER BACKEND
  NB: Not touching to GLSL shader stuff. This is using classic OGL calls only.
 
@@ -1206,6 +1293,12 @@ typedef struct shaderProgram_s {
 
 	GLint		clipPlane;
 
+	GLint		shadowMapMatrix;
+	GLint		shadowMapParms;
+	GLint		shadowMapTiles;
+
+	GLint		joints;
+
 	/* gl_... */
 	GLint		attr_TexCoord;
 	GLint		attr_Tangent;
@@ -1213,6 +1306,8 @@ typedef struct shaderProgram_s {
 	GLint		attr_Normal;
 	GLint		attr_Vertex;
 	GLint		attr_Color;
+	GLint		attr_JointIndices;
+	GLint		attr_JointWeights;
 
 	GLint		u_fragmentMap[MAX_FRAGMENT_IMAGES];
   GLint		u_fragmentCubeMap[MAX_FRAGMENT_IMAGES];
@@ -1222,6 +1317,7 @@ void R_ReloadGLSLPrograms_f(const idCmdArgs &args);
 
 void RB_GLSL_PrepareShaders(void);
 void RB_GLSL_FillDepthBuffer(drawSurf_t **drawSurfs, int numDrawSurfs);
+void RB_GLSL_RenderShadowMaps(void);
 void RB_GLSL_DrawInteractions(void);
 int  RB_GLSL_DrawShaderPasses(drawSurf_t **drawSurfs, int numDrawSurfs);
 void RB_GLSL_FogAllLights(void);
@@ -1247,6 +1343,14 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 									 const srfTriangles_t *tri, const idRenderLightLocal *light,
 									 shadowGen_t optimize, srfCullInfo_t &cullInfo );
 
+// reuses the shadow volume of an animated entity surface if neither its pose nor the light changed
+srfTriangles_t *R_CreateCachedShadowVolume( const idRenderEntityLocal *ent,
+									 const srfTriangles_t *tri, const idRenderLightLocal *light,
+									 shadowGen_t optimize, srfCullInfo_t &cullInfo, int surfaceNum );
+unsigned int	R_DynamicModelHash( const idRenderEntityLocal *ent );
+void			R_PurgeShadowCache( const idRenderEntityLocal *ent, const idRenderLightLocal *light );
+void			R_BenchShadowCull_f( const idCmdArgs &args );
+
 /*
 ============================================================
 
@@ -1351,6 +1455,8 @@ typedef struct deformInfo_s {
 deformInfo_t *		R_BuildDeformInfo( int numVerts, const idDrawVert *verts, int numIndexes, const int *indexes, bool useUnsmoothedTangents );
 void				R_FreeDeformInfo( deformInfo_t *deformInfo );
 int					R_DeformInfoMemoryUsed( deformInfo_t *deformInfo );
+void				R_WriteDeformInfo( idFile *file, const deformInfo_t *deformInfo );
+deformInfo_t *		R_ReadDeformInfo( idFile *file );
 
 /*
 ============================================================
@@ -1409,6 +1515,27 @@ void R_RenderGuiSurf( idUserInterface *gui, drawSurf_t *drawSurf );
 /*
 =============================================================
 
+TR_GUIATLAS
+
+=============================================================
+*/
+
+// where an image of a gui material lives in the atlas,
+// the page material draws it with vertex colors
+typedef struct {
+	const idMaterial *	pageMaterial;
+	idVec2				scale;			// material st to page st
+	idVec2				bias;
+} guiAtlasTile_t;
+
+const guiAtlasTile_t *R_GuiAtlasTile( const idMaterial *material );	// NULL if the material can't be drawn from the atlas
+void R_FillGuiAtlas( void );		// adds the gui images of the level, called when a level is done loading
+void R_ClearGuiAtlas( void );		// empties all pages, called when a level is loaded
+void R_ShutdownGuiAtlas( void );
+
+/*
+=============================================================
+
 TR_ORDERINDEXES
 
 =============================================================
@@ -298,9 +298,10 @@ R_StaticAlloc
 void *R_StaticAlloc( int bytes ) {
 	void	*buf;
 
-	tr.pc.c_alloc++;
+	// image loads call this from the job threads
+	Sys_InterlockedAdd( tr.pc.c_alloc, 1 );
 
-	tr.staticAllocCount += bytes;
+	Sys_InterlockedAdd( tr.staticAllocCount, bytes );
 
 	buf = Mem_Alloc( bytes );
 
@@ -330,7 +331,7 @@ R_StaticFree
 =================
 */
 void R_StaticFree( void *data ) {
-	tr.pc.c_free++;
+	Sys_InterlockedAdd( tr.pc.c_free, 1 );
 	Mem_Free( data );
 }
 
@@ -1123,6 +1124,10 @@ void R_RenderView( viewDef_t *parms ) {
 	// constrain the view frustum to the view lights and entities
 	R_ConstrainViewFrustum();
 
+	// rasterize the world surfaces of the visible areas, so entities and lights
+	// hidden behind them can be skipped
+	R_BuildOcclusionBuffer();
+
 	// make sure that interactions exist for all light / entity combinations
 	// that are visible
 	// add any pre-generated light shadows, and calculate the light shader values
@@ -1135,6 +1140,9 @@ void R_RenderView( viewDef_t *parms ) {
 	// any viewLight that didn't have visible surfaces can have it's shadows removed
 	R_RemoveUnecessaryViewLights();
 
+	// place the shadow mapped lights in the shadow map atlas
+	R_AllocShadowMaps();
+
 	// sort all the ambient surfaces for translucency ordering
 	R_SortDrawSurfs();
 
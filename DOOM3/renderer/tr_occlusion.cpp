@@ -0,0 +1,461 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Doom 3 GPL Source Code ("Doom 3 Source Code").
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+#include "sys/platform.h"
+
+#include "renderer/tr_local.h"
+
+/*
+
+Software occlusion culling
+
+Portal visibility lets through everything in the visible areas, even when it is
+behind a wall of that area.  Before the light and model surfaces are added, the
+opaque world surfaces of the visible areas are rasterized into a small depth
+buffer on the cpu, and the bounds of entities and lights are tested against it.
+An entity that is hidden only loses its ambient and lit surfaces, it can still
+cast shadows into the view.  A hidden light is removed from the view entirely,
+because everything it can light is hidden as well.
+
+The buffer holds 1/w, so bigger values are nearer and a cleared buffer is at
+infinity.  Each written pixel holds the farthest depth of the occluder over the
+whole pixel, and the tiles hold the farthest depth of their pixels, so a test
+only has to look at the pixels of a tile that isn't completely in front.
+
+Occluders cover the pixels whose centers they contain, like the gpu does, which
+keeps the world surfaces watertight.  Tests grow their rectangle by a pixel to
+make up for the pixels an occluder only partly covers.
+
+*/
+
+const int OCCLUSION_WIDTH		= 256;
+const int OCCLUSION_HEIGHT		= 128;
+const int OCCLUSION_TILE_SIZE	= 8;
+const int OCCLUSION_TILES_X		= OCCLUSION_WIDTH / OCCLUSION_TILE_SIZE;
+const int OCCLUSION_TILES_Y		= OCCLUSION_HEIGHT / OCCLUSION_TILE_SIZE;
+
+typedef struct {
+	int				viewCount;			// the buffer is only valid for the view it was built in
+	float			zNear;
+	float			localToClip[16];
+	idList<idVec4>	clipVerts;			// of the surface being rasterized
+	float			depth[OCCLUSION_HEIGHT][OCCLUSION_WIDTH];
+	float			tileDepth[OCCLUSION_TILES_Y][OCCLUSION_TILES_X];
+} occlusionBuffer_t;
+
+static occlusionBuffer_t	occlusion;
+
+/*
+=================
+R_TransformLocalToClip
+=================
+*/
+static ID_INLINE void R_TransformLocalToClip( const idVec3 &v, const float m[16], idVec4 &clip ) {
+	clip.x = v.x * m[0*4+0] + v.y * m[1*4+0] + v.z * m[2*4+0] + m[3*4+0];
+	clip.y = v.x * m[0*4+1] + v.y * m[1*4+1] + v.z * m[2*4+1] + m[3*4+1];
+	clip.z = v.x * m[0*4+2] + v.y * m[1*4+2] + v.z * m[2*4+2] + m[3*4+2];
+	clip.w = v.x * m[0*4+3] + v.y * m[1*4+3] + v.z * m[2*4+3] + m[3*4+3];
+}
+
+/*
+=================
+R_ClipToOcclusion
+
+Returns the buffer pixel coordinates in x and y, and 1/w in z
+=================
+*/
+static ID_INLINE void R_ClipToOcclusion( const idVec4 &clip, idVec3 &out ) {
+	float invW = 1.0f / clip.w;
+
+	out.x = ( clip.x * invW * 0.5f + 0.5f ) * OCCLUSION_WIDTH;
+	out.y = ( clip.y * invW * 0.5f + 0.5f ) * OCCLUSION_HEIGHT;
+	out.z = invW;
+}
+
+/*
+=================
+R_RasterizeOccluderTriangle
+
+Sets up the edge functions and the depth plane, the pixels of the bounds are
+tested against the edges and written by SIMDProcessor->RasterizeOccluder.
+=================
+*/
+static void R_RasterizeOccluderTriangle( const idVec3 &a, const idVec3 &b, const idVec3 &c ) {
+	const idVec3	*v[3];
+	idVec3			edges[3], zPlane;
+	float			area, invArea, dzdx, dzdy, zMin, zMax;
+	int				x0, x1, y0, y1, i;
+
+	// counter clockwise in buffer space
+	area = ( b.x - a.x ) * ( c.y - a.y ) - ( c.x - a.x ) * ( b.y - a.y );
+	v[0] = &a;
+	if ( area < 0.0f ) {
+		v[1] = &c;
+		v[2] = &b;
+		area = -area;
+	} else {
+		v[1] = &b;
+		v[2] = &c;
+	}
+
+	// skip the slivers that would cost more to set up than they cover
+	if ( area < r_occluderMinArea.GetFloat() * 2.0f ) {
+		return;
+	}
+
+	x0 = idMath::Ftoi( idMath::Ceil( Min3( a.x, b.x, c.x ) - 0.5f ) );
+	x1 = idMath::Ftoi( idMath::Floor( Max3( a.x, b.x, c.x ) - 0.5f ) );
+	y0 = idMath::Ftoi( idMath::Ceil( Min3( a.y, b.y, c.y ) - 0.5f ) );
+	y1 = idMath::Ftoi( idMath::Floor( Max3( a.y, b.y, c.y ) - 0.5f ) );
+	if ( x0 < 0 ) {
+		x0 = 0;
+	}
+	if ( x1 > OCCLUSION_WIDTH - 1 ) {
+		x1 = OCCLUSION_WIDTH - 1;
+	}
+	if ( y0 < 0 ) {
+		y0 = 0;
+	}
+	if ( y1 > OCCLUSION_HEIGHT - 1 ) {
+		y1 = OCCLUSION_HEIGHT - 1;
+	}
+	if ( x0 > x1 || y0 > y1 ) {
+		return;
+	}
+
+	tr.pc.c_occluderTris++;
+
+	// each edge function is ( q - p ) x ( pixel - p ) >= 0 inside
+	for ( i = 0 ; i < 3 ; i++ ) {
+		const idVec3 &p = *v[i];
+		const idVec3 &q = *v[(i+1)%3];
+		float	dx = q.x - p.x;
+		float	dy = q.y - p.y;
+
+		edges[i].Set( -dy, dx, dy * p.x - dx * p.y );
+	}
+
+	// 1/w is linear in screen space
+	invArea = 1.0f / area;
+	dzdx = ( ( v[1]->z - v[0]->z ) * ( v[2]->y - v[0]->y ) - ( v[2]->z - v[0]->z ) * ( v[1]->y - v[0]->y ) ) * invArea;
+	dzdy = ( ( v[2]->z - v[0]->z ) * ( v[1]->x - v[0]->x ) - ( v[1]->z - v[0]->z ) * ( v[2]->x - v[0]->x ) ) * invArea;
+
+	// move the plane back to the farthest corner of each pixel, and never
+	// let it get in front of or behind the triangle off its edges
+	zPlane.Set( dzdx, dzdy, v[0]->z - dzdx * v[0]->x - dzdy * v[0]->y - 0.5f * ( idMath::Fabs( dzdx ) + idMath::Fabs( dzdy ) ) );
+	zMin = Min3( a.z, b.z, c.z );
+	zMax = Max3( a.z, b.z, c.z );
+
+	SIMDProcessor->RasterizeOccluder( occlusion.depth[0], OCCLUSION_WIDTH, x0, y0, x1, y1, edges, zPlane, zMin, zMax );
+}
+
+/*
+=================
+R_RasterizeOccluderPolygon
+
+Clips to the near plane and fans the polygon into triangles
+=================
+*/
+static void R_RasterizeOccluderPolygon( const idVec4 &a, const idVec4 &b, const idVec4 &c ) {
+	const idVec4	*in[3] = { &a, &b, &c };
+	idVec4			clipped[4];
+	idVec3			screen[4];
+	int				numClipped, i;
+
+	// trivially reject triangles outside a side of the view
+	if ( ( a.x > a.w && b.x > b.w && c.x > c.w ) || ( a.x < -a.w && b.x < -b.w && c.x < -c.w ) ||
+		( a.y > a.w && b.y > b.w && c.y > c.w ) || ( a.y < -a.w && b.y < -b.w && c.y < -c.w ) ) {
+		return;
+	}
+
+	numClipped = 0;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		const idVec4 &p = *in[i];
+		const idVec4 &q = *in[(i+1)%3];
+		bool pIn = p.w >= occlusion.zNear;
+		bool qIn = q.w >= occlusion.zNear;
+
+		if ( pIn ) {
+			clipped[numClipped++] = p;
+		}
+		if ( pIn != qIn ) {
+			float f = ( occlusion.zNear - p.w ) / ( q.w - p.w );
+			clipped[numClipped++] = p + f * ( q - p );
+		}
+	}
+	if ( numClipped < 3 ) {
+		return;
+	}
+
+	for ( i = 0 ; i < numClipped ; i++ ) {
+		R_ClipToOcclusion( clipped[i], screen[i] );
+	}
+	R_RasterizeOccluderTriangle( screen[0], screen[1], screen[2] );
+	if ( numClipped == 4 ) {
+		R_RasterizeOccluderTriangle( screen[0], screen[2], screen[3] );
+	}
+}
+
+/*
+=================
+R_RasterizeOccluderSurface
+=================
+*/
+static void R_RasterizeOccluderSurface( const srfTriangles_t *tri, cullType_t cullType, const idVec3 &localViewOrigin ) {
+	int		i;
+
+	occlusion.clipVerts.SetNum( tri->numVerts, false );
+	idVec4 *clip = occlusion.clipVerts.Ptr();
+	for ( i = 0 ; i < tri->numVerts ; i++ ) {
+		R_TransformLocalToClip( tri->verts[i].xyz, occlusion.localToClip, clip[i] );
+	}
+
+	for ( i = 0 ; i < tri->numIndexes ; i += 3 ) {
+		const glIndex_t *indexes = tri->indexes + i;
+
+		// back faces don't hide anything
+		if ( cullType != CT_TWO_SIDED ) {
+			const idVec3 &v1 = tri->verts[indexes[0]].xyz;
+			const idVec3 d1 = tri->verts[indexes[1]].xyz - v1;
+			const idVec3 d2 = tri->verts[indexes[2]].xyz - v1;
+			bool front = ( d2.Cross( d1 ) * ( localViewOrigin - v1 ) ) > 0.0f;
+			if ( front != ( cullType == CT_FRONT_SIDED ) ) {
+				continue;
+			}
+		}
+
+		R_RasterizeOccluderPolygon( clip[indexes[0]], clip[indexes[1]], clip[indexes[2]] );
+	}
+}
+
+/*
+=================
+R_BuildOcclusionBuffer
+
+Rasterizes the opaque world surfaces of the visible areas.  Called after the
+view entities have been found, before any light or model surfaces are added.
+=================
+*/
+void R_BuildOcclusionBuffer( void ) {
+	viewEntity_t	*vEntity;
+	idVec3			localViewOrigin;
+	int				start, x, y, i, j;
+
+	occlusion.viewCount = -1;
+
+	if ( !r_useOcclusionCulling.GetBool() ) {
+		return;
+	}
+
+	// subviews clip away the world on the near side of the mirror or portal,
+	// which would still be rasterized here
+	if ( tr.viewDef->isSubview ) {
+		return;
+	}
+
+	start = Sys_Microseconds();
+
+	occlusion.zNear = r_znear.GetFloat();
+	memset( occlusion.depth, 0, sizeof( occlusion.depth ) );
+
+	for ( vEntity = tr.viewDef->viewEntitys ; vEntity ; vEntity = vEntity->next ) {
+		idRenderModel *model = vEntity->entityDef->parms.hModel;
+
+		if ( vEntity->scissorRect.IsEmpty() ) {
+			continue;
+		}
+		if ( model == NULL || !model->IsStaticWorldModel() ) {
+			continue;
+		}
+
+		myGlMultMatrix( vEntity->modelViewMatrix, tr.viewDef->projectionMatrix, occlusion.localToClip );
+		R_GlobalPointToLocal( vEntity->modelMatrix, tr.viewDef->renderView.vieworg, localViewOrigin );
+
+		for ( i = 0 ; i < model->NumSurfaces() ; i++ ) {
+			const modelSurface_t *surf = model->Surface( i );
+			const idMaterial *shader = surf->shader;
+			const srfTriangles_t *tri = surf->geometry;
+
+			if ( shader == NULL || !shader->IsDrawn() || shader->Coverage() != MC_OPAQUE ) {
+				continue;
+			}
+			if ( shader->Deform() != DFRM_NONE || shader->GetSort() != SS_OPAQUE ) {
+				continue;
+			}
+			if ( tri == NULL || tri->verts == NULL || tri->indexes == NULL ) {
+				continue;
+			}
+
+			R_RasterizeOccluderSurface( tri, shader->GetCullType(), localViewOrigin );
+		}
+	}
+
+	// keep the farthest depth of every tile
+	for ( y = 0 ; y < OCCLUSION_TILES_Y ; y++ ) {
+		for ( x = 0 ; x < OCCLUSION_TILES_X ; x++ ) {
+			float tileDepth = idMath::INFINITY;
+			for ( i = 0 ; i < OCCLUSION_TILE_SIZE ; i++ ) {
+				const float *row = &occlusion.depth[y * OCCLUSION_TILE_SIZE + i][x * OCCLUSION_TILE_SIZE];
+				for ( j = 0 ; j < OCCLUSION_TILE_SIZE ; j++ ) {
+					tileDepth = ( row[j] < tileDepth ) ? row[j] : tileDepth;
+				}
+			}
+			occlusion.tileDepth[y][x] = tileDepth;
+		}
+	}
+
+	occlusion.viewCount = tr.viewCount;
+
+	tr.pc.c_occlusionUsec += Sys_Microseconds() - start;
+}
+
+/*
+=================
+R_CullLocalBoxByOcclusion
+
+Returns true if the box can't be seen through the part of the view inside the
+scissor rect.
+=================
+*/
+bool R_CullLocalBoxByOcclusion( const idBounds &bounds, const float modelViewMatrix[16], const idScreenRect &scissor ) {
+	float	localToClip[16];
+	idVec4	clip;
+	idVec3	screen, corner;
+	idBounds screenBounds;
+	float	nearest, scaleX, scaleY;
+	int		x0, x1, y0, y1, tx, ty, x, y, i;
+
+	if ( occlusion.viewCount != tr.viewCount ) {
+		return false;
+	}
+
+	tr.pc.c_occlusionTests++;
+
+	// project the corners, anything reaching in front of the near plane may be visible
+	myGlMultMatrix( modelViewMatrix, tr.viewDef->projectionMatrix, localToClip );
+	screenBounds.Clear();
+	nearest = 0.0f;
+	for ( i = 0 ; i < 8 ; i++ ) {
+		corner[0] = bounds[i & 1][0];
+		corner[1] = bounds[( i >> 1 ) & 1][1];
+		corner[2] = bounds[( i >> 2 ) & 1][2];
+		R_TransformLocalToClip( corner, localToClip, clip );
+		if ( clip.w < occlusion.zNear ) {
+			return false;
+		}
+		R_ClipToOcclusion( clip, screen );
+		screenBounds.AddPoint( screen );
+		if ( screen.z > nearest ) {
+			nearest = screen.z;
+		}
+	}
+
+	// nothing outside the scissor rect gets drawn
+	scaleX = (float)OCCLUSION_WIDTH / ( tr.viewDef->viewport.x2 - tr.viewDef->viewport.x1 );
+	scaleY = (float)OCCLUSION_HEIGHT / ( tr.viewDef->viewport.y2 - tr.viewDef->viewport.y1 );
+	x0 = Max( idMath::Ftoi( idMath::Floor( screenBounds[0].x ) ), idMath::Ftoi( idMath::Floor( scissor.x1 * scaleX ) ) ) - 1;
+	x1 = Min( idMath::Ftoi( idMath::Floor( screenBounds[1].x ) ), idMath::Ftoi( idMath::Floor( ( scissor.x2 + 1 ) * scaleX ) ) ) + 1;
+	y0 = Max( idMath::Ftoi( idMath::Floor( screenBounds[0].y ) ), idMath::Ftoi( idMath::Floor( scissor.y1 * scaleY ) ) ) - 1;
+	y1 = Min( idMath::Ftoi( idMath::Floor( screenBounds[1].y ) ), idMath::Ftoi( idMath::Floor( ( scissor.y2 + 1 ) * scaleY ) ) ) + 1;
+	x0 = Max( x0, 0 );
+	y0 = Max( y0, 0 );
+	x1 = Min( x1, OCCLUSION_WIDTH - 1 );
+	y1 = Min( y1, OCCLUSION_HEIGHT - 1 );
+	if ( x0 > x1 || y0 > y1 ) {
+		return false;
+	}
+
+	for ( ty = y0 / OCCLUSION_TILE_SIZE ; ty <= y1 / OCCLUSION_TILE_SIZE ; ty++ ) {
+		for ( tx = x0 / OCCLUSION_TILE_SIZE ; tx <= x1 / OCCLUSION_TILE_SIZE ; tx++ ) {
+			// the whole tile is in front
+			if ( occlusion.tileDepth[ty][tx] > nearest ) {
+				continue;
+			}
+
+			int px0 = Max( x0, tx * OCCLUSION_TILE_SIZE );
+			int px1 = Min( x1, tx * OCCLUSION_TILE_SIZE + OCCLUSION_TILE_SIZE - 1 );
+			int py0 = Max( y0, ty * OCCLUSION_TILE_SIZE );
+			int py1 = Min( y1, ty * OCCLUSION_TILE_SIZE + OCCLUSION_TILE_SIZE - 1 );
+			for ( y = py0 ; y <= py1 ; y++ ) {
+				for ( x = px0 ; x <= px1 ; x++ ) {
+					if ( occlusion.depth[y][x] <= nearest ) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+=================
+R_CullEntityByOcclusion
+=================
+*/
+bool R_CullEntityByOcclusion( const viewEntity_t *vEntity ) {
+	const idRenderEntityLocal *def = vEntity->entityDef;
+
+	// the world is what occludes, and depth hacked models are drawn in front of it
+	if ( def->parms.hModel && def->parms.hModel->IsStaticWorldModel() ) {
+		return false;
+	}
+	// modelDepthHack is only resolved when the dynamic model is created, after this
+	if ( vEntity->weaponDepthHack || ( def->parms.hModel && def->parms.hModel->DepthHack() != 0.0f ) ) {
+		return false;
+	}
+
+	if ( !R_CullLocalBoxByOcclusion( def->referenceBounds, vEntity->modelViewMatrix, vEntity->scissorRect ) ) {
+		return false;
+	}
+
+	tr.pc.c_occludedEntities++;
+	return true;
+}
+
+/*
+=================
+R_CullLightByOcclusion
+=================
+*/
+bool R_CullLightByOcclusion( const viewLight_t *vLight ) {
+	const idRenderLightLocal *light = vLight->lightDef;
+
+	if ( light->frustumTris == NULL ) {
+		return false;
+	}
+
+	if ( !R_CullLocalBoxByOcclusion( light->frustumTris->bounds, tr.viewDef->worldSpace.modelViewMatrix, vLight->scissorRect ) ) {
+		return false;
+	}
+
+	tr.pc.c_occludedLights++;
+	return true;
+}
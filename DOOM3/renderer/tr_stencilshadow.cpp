@@ -27,8 +27,11 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include "sys/platform.h"
+#include "idlib/hashing/CRC32.h"
+#include "idlib/geometry/JointTransform.h"
 
 #include "renderer/tr_local.h"
+#include "renderer/RenderWorld_local.h"
 
 // tr_stencilShadow.c -- creaton of stencil shadow volumes
 
@@ -636,30 +639,50 @@ Add quads from the front points to the projected points
 for each silhouette edge in the light
 =================
 */
+
+// we need to choose the correct way of triangulating the silhouette quad
+// consistantly between any two points, no matter which order they are specified.
+// If this wasn't done, slight rasterization cracks would show in the shadow
+// volume when two sil edges were exactly coincident.
+// Indexed by faceCastsShadow[p2] * 2 + PointsOrdered( v1, v2 ), the
+// entries select v1, v1+1, v2 or v2+1.
+static const int silQuadIndexes[4][6] = {
+	{ 0, 2, 3, 0, 3, 1 },
+	{ 0, 2, 1, 2, 3, 1 },
+	{ 0, 3, 2, 0, 1, 3 },
+	{ 0, 1, 2, 2, 1, 3 }
+};
+
 static void R_AddSilEdges( const srfTriangles_t *tri, unsigned short *pointCull, const idPlane frustum[6] ) {
 	int		v1, v2;
-	int		i;
-	silEdge_t	*sil;
+	int		i, j;
+	const silEdge_t	*sil;
 	int		numPlanes;
+	int		*silEdgeNums;
+	int		numSils;
+	int		quadVerts[4];
 
 	numPlanes = tri->numIndexes / 3;
 
-	// add sil edges for any true silhouette boundaries on the surface
 	for ( i = 0 ; i < tri->numSilEdges ; i++ ) {
 		sil = tri->silEdges + i;
 		if ( sil->p1 < 0 || sil->p1 > numPlanes || sil->p2 < 0 || sil->p2 > numPlanes ) {
 			common->Error( "Bad sil planes" );
 		}
+	}
 
-		// an edge will be a silhouette edge if the face on one side
-		// casts a shadow, but the face on the other side doesn't.
-		// "casts a shadow" means that it has some surface in the projection,
-		// not just that it has the correct facing direction
-		// This will cause edges that are exactly on the frustum plane
-		// to be considered sil edges if the face inside casts a shadow.
-		if ( !( faceCastsShadow[ sil->p1 ] ^ faceCastsShadow[ sil->p2 ] ) ) {
-			continue;
-		}
+	// an edge will be a silhouette edge if the face on one side
+	// casts a shadow, but the face on the other side doesn't.
+	// "casts a shadow" means that it has some surface in the projection,
+	// not just that it has the correct facing direction
+	// This will cause edges that are exactly on the frustum plane
+	// to be considered sil edges if the face inside casts a shadow.
+	silEdgeNums = (int *)_alloca16( tri->numSilEdges * sizeof( silEdgeNums[0] ) );
+	numSils = SIMDProcessor->ShadowSilEdges( silEdgeNums, faceCastsShadow, tri->silEdges, tri->numSilEdges );
+
+	// add sil edges for any true silhouette boundaries on the surface
+	for ( i = 0 ; i < numSils ; i++ ) {
+		sil = tri->silEdges + silEdgeNums[i];
 
 		// if the edge is completely off the negative side of
 		// a frustum plane, don't add it at all.  This can still
@@ -698,60 +721,28 @@ static void R_AddSilEdges( const srfTriangles_t *tri, unsigned short *pointCull,
 			return;
 		}
 
-		// we need to choose the correct way of triangulating the silhouette quad
-		// consistantly between any two points, no matter which order they are specified.
-		// If this wasn't done, slight rasterization cracks would show in the shadow
-		// volume when two sil edges were exactly coincident
-		if ( faceCastsShadow[ sil->p2 ] ) {
-			if ( PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ) {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-			} else {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-			}
-		} else {
-			if ( PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ) {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-			} else {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-			}
+		quadVerts[0] = v1;
+		quadVerts[1] = v1 + 1;
+		quadVerts[2] = v2;
+		quadVerts[3] = v2 + 1;
+
+		const int *quad = silQuadIndexes[ faceCastsShadow[ sil->p2 ] * 2 + PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ];
+		for ( j = 0 ; j < 6 ; j++ ) {
+			shadowIndexes[numShadowIndexes++] = quadVerts[ quad[j] ];
 		}
 	}
 }
 
 /*
 ================
-R_CalcPointCull
+R_CalcPointCullFrontBits
 
-Also inits the remap[] array to all -1
+Returns the high order pointCull bits of the planes the whole surface is in front of
 ================
 */
-static void R_CalcPointCull( const srfTriangles_t *tri, const idPlane frustum[6], unsigned short *pointCull ) {
+static int R_CalcPointCullFrontBits( const srfTriangles_t *tri, const idPlane frustum[6] ) {
 	int i;
 	int frontBits;
-	float *planeSide;
-	byte *side1, *side2;
-
-	SIMDProcessor->Memset( remap, -1, tri->numVerts * sizeof( remap[0] ) );
 
 	for ( frontBits = 0, i = 0; i < 6; i++ ) {
 		// get front bits for the whole surface
@@ -759,36 +750,21 @@ static void R_CalcPointCull( const srfTriangles_t *tri, const idPlane frustum[6]
 			frontBits |= 1<<(i+6);
 		}
 	}
+	return frontBits;
+}
 
-	// initialize point cull
-	for ( i = 0; i < tri->numVerts; i++ ) {
-		pointCull[i] = frontBits;
-	}
-
-	// if the surface is not completely inside the light frustum
-	if ( frontBits == ( ( ( 1 << 6 ) - 1 ) ) << 6 ) {
-		return;
-	}
-
-	planeSide = (float *) _alloca16( tri->numVerts * sizeof( float ) );
-	side1 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
-	side2 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
-	SIMDProcessor->Memset( side1, 0, tri->numVerts * sizeof( byte ) );
-	SIMDProcessor->Memset( side2, 0, tri->numVerts * sizeof( byte ) );
-
-	for ( i = 0; i < 6; i++ ) {
+/*
+================
+R_CalcPointCull
 
-		if ( frontBits & (1<<(i+6)) ) {
-			continue;
-		}
+Also inits the remap[] array to all -1
+================
+*/
+static void R_CalcPointCull( const srfTriangles_t *tri, const idPlane frustum[6], unsigned short *pointCull ) {
+	SIMDProcessor->Memset( remap, -1, tri->numVerts * sizeof( remap[0] ) );
 
-		SIMDProcessor->Dot( planeSide, frustum[i], tri->verts, tri->numVerts );
-		SIMDProcessor->CmpLT( side1, i, planeSide, LIGHT_CLIP_EPSILON, tri->numVerts );
-		SIMDProcessor->CmpGT( side2, i, planeSide, -LIGHT_CLIP_EPSILON, tri->numVerts );
-	}
-	for ( i = 0; i < tri->numVerts; i++ ) {
-		pointCull[i] |= side1[i] | (side2[i] << 6);
-	}
+	// planes the whole surface is in front of are not tested per vertex
+	SIMDProcessor->ShadowPointCull( pointCull, frustum, R_CalcPointCullFrontBits( tri, frustum ), LIGHT_CLIP_EPSILON, tri->verts, tri->numVerts );
 }
 
 /*
@@ -1325,3 +1301,387 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 
 	return newTri;
 }
+
+/*
+=====================================================================================
+
+Shadow volume cache
+
+Animated entities free their interactions every time the game updates them, and
+their dynamic model snapshot is regenerated every frame, so every shadow of an
+idle monster would be rebuilt each frame even when nothing moved.  The cache
+remembers the last shadow volume for each entity / light / surface along with the
+pose it was made from and hands out a copy while the pose and the light match.
+
+=====================================================================================
+*/
+
+#define SHADOW_CACHE_SIZE		256			// must be a power of two
+
+typedef struct {
+	const idRenderEntityLocal *	entityDef;
+	const idRenderLightLocal *	lightDef;
+	int							surfaceNum;
+	unsigned int				modelHash;			// entityDef->dynamicModelHash when it was created
+	int							lightModified;		// lightDef->lastModifiedFrameNum when it was created
+	idVec3						lightOrigin;
+	shadowGen_t					shadowGen;
+	int							numVerts;			// of the source surface
+	int							numIndexes;
+	srfTriangles_t *			shadowTris;			// NULL if the surface didn't cast a shadow
+} shadowCacheEntry_t;
+
+static shadowCacheEntry_t	shadowCache[SHADOW_CACHE_SIZE];
+
+/*
+=================
+R_DynamicModelHash
+
+Hashes everything the vertexes of an animated entity's dynamic model are built from.
+Only entities with joints are cached, everything else returns 0.
+=================
+*/
+unsigned int R_DynamicModelHash( const idRenderEntityLocal *ent ) {
+	unsigned int crc;
+
+	if ( !ent->parms.joints || ent->parms.numJoints <= 0 ) {
+		return 0;
+	}
+
+	CRC32_InitChecksum( crc );
+	CRC32_UpdateChecksum( crc, &ent->parms.hModel, sizeof( ent->parms.hModel ) );
+	CRC32_UpdateChecksum( crc, ent->modelMatrix, sizeof( ent->modelMatrix ) );
+	CRC32_UpdateChecksum( crc, &ent->parms.shaderParms[ SHADERPARM_MD5_SKINSCALE ], sizeof( float ) );
+	CRC32_UpdateChecksum( crc, ent->parms.joints, ent->parms.numJoints * sizeof( ent->parms.joints[0] ) );
+	CRC32_FinishChecksum( crc );
+
+	// 0 is reserved for entities that can't be cached
+	return crc ? crc : 1;
+}
+
+/*
+=================
+R_CopyShadowTris
+=================
+*/
+static srfTriangles_t *R_CopyShadowTris( const srfTriangles_t *tri ) {
+	srfTriangles_t	*newTri;
+
+	newTri = R_AllocStaticTriSurf();
+	newTri->bounds = tri->bounds;
+	newTri->numVerts = tri->numVerts;
+	newTri->numIndexes = tri->numIndexes;
+	newTri->numShadowIndexesNoCaps = tri->numShadowIndexesNoCaps;
+	newTri->numShadowIndexesNoFrontCaps = tri->numShadowIndexesNoFrontCaps;
+	newTri->shadowCapPlaneBits = tri->shadowCapPlaneBits;
+
+	R_AllocStaticTriSurfIndexes( newTri, tri->numIndexes );
+	SIMDProcessor->Memcpy( newTri->indexes, tri->indexes, tri->numIndexes * sizeof( newTri->indexes[0] ) );
+
+	// turbo shadows take their vertexes from the ambient surface
+	if ( tri->shadowVertexes ) {
+		R_AllocStaticTriSurfShadowVerts( newTri, tri->numVerts );
+		SIMDProcessor->Memcpy( newTri->shadowVertexes, tri->shadowVertexes, tri->numVerts * sizeof( newTri->shadowVertexes[0] ) );
+	}
+
+	return newTri;
+}
+
+/*
+=================
+R_ClearShadowCacheEntry
+=================
+*/
+static void R_ClearShadowCacheEntry( shadowCacheEntry_t *entry ) {
+	if ( entry->shadowTris ) {
+		R_FreeStaticTriSurf( entry->shadowTris );
+	}
+	memset( entry, 0, sizeof( *entry ) );
+}
+
+/*
+=================
+R_CreateCachedShadowVolume
+=================
+*/
+srfTriangles_t *R_CreateCachedShadowVolume( const idRenderEntityLocal *ent,
+									 const srfTriangles_t *tri, const idRenderLightLocal *light,
+									 shadowGen_t optimize, srfCullInfo_t &cullInfo, int surfaceNum ) {
+	shadowCacheEntry_t	*entry;
+	srfTriangles_t		*newTri;
+
+	if ( !r_useShadowCache.GetBool() || !ent->dynamicModelHash || !r_shadows.GetBool() ) {
+		return R_CreateShadowVolume( ent, tri, light, optimize, cullInfo );
+	}
+
+	entry = &shadowCache[ ( ent->index * 31 + light->index * 7 + surfaceNum ) & ( SHADOW_CACHE_SIZE - 1 ) ];
+
+	if ( entry->entityDef == ent && entry->lightDef == light && entry->surfaceNum == surfaceNum &&
+			entry->modelHash == ent->dynamicModelHash && entry->lightModified == light->lastModifiedFrameNum &&
+				entry->lightOrigin == light->globalLightOrigin && entry->shadowGen == optimize &&
+					entry->numVerts == tri->numVerts && entry->numIndexes == tri->numIndexes ) {
+		tr.pc.c_shadowCacheHits++;
+		return entry->shadowTris ? R_CopyShadowTris( entry->shadowTris ) : NULL;
+	}
+
+	tr.pc.c_shadowCacheMisses++;
+
+	newTri = R_CreateShadowVolume( ent, tri, light, optimize, cullInfo );
+
+	R_ClearShadowCacheEntry( entry );
+	entry->entityDef = ent;
+	entry->lightDef = light;
+	entry->surfaceNum = surfaceNum;
+	entry->modelHash = ent->dynamicModelHash;
+	entry->lightModified = light->lastModifiedFrameNum;
+	entry->lightOrigin = light->globalLightOrigin;
+	entry->shadowGen = optimize;
+	entry->numVerts = tri->numVerts;
+	entry->numIndexes = tri->numIndexes;
+	entry->shadowTris = newTri ? R_CopyShadowTris( newTri ) : NULL;
+
+	return newTri;
+}
+
+/*
+=================
+R_PurgeShadowCache
+
+Frees the cached shadows of an entity or a light before it is deleted, or all of them if both are NULL.
+=================
+*/
+void R_PurgeShadowCache( const idRenderEntityLocal *ent, const idRenderLightLocal *light ) {
+	for ( int i = 0 ; i < SHADOW_CACHE_SIZE ; i++ ) {
+		shadowCacheEntry_t *entry = &shadowCache[i];
+		if ( !entry->entityDef ) {
+			continue;
+		}
+		if ( ( !ent && !light ) || entry->entityDef == ent || entry->lightDef == light ) {
+			R_ClearShadowCacheEntry( entry );
+		}
+	}
+}
+
+/*
+==============================================================================
+
+SHADOW CULL BENCHMARK
+
+==============================================================================
+*/
+
+typedef struct {
+	int				numSurfaces;
+	int				numVerts;
+	int				numSilEdges;
+	int				numMismatches;
+	unsigned int	scalarCullUsec;
+	unsigned int	simdCullUsec;
+	unsigned int	scalarSilUsec;
+	unsigned int	simdSilUsec;
+} shadowCullBench_t;
+
+/*
+=================
+R_ScalarPointCull
+
+The per plane Dot / CmpLT / CmpGT passes that ShadowPointCull replaced
+=================
+*/
+static void R_ScalarPointCull( const srfTriangles_t *tri, const idPlane frustum[6], unsigned short *pointCull ) {
+	int i;
+	int frontBits;
+	float *planeSide;
+	byte *side1, *side2;
+
+	frontBits = R_CalcPointCullFrontBits( tri, frustum );
+
+	for ( i = 0; i < tri->numVerts; i++ ) {
+		pointCull[i] = frontBits;
+	}
+
+	if ( frontBits == ( ( ( 1 << 6 ) - 1 ) ) << 6 ) {
+		return;
+	}
+
+	planeSide = (float *) _alloca16( tri->numVerts * sizeof( float ) );
+	side1 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
+	side2 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
+	SIMDProcessor->Memset( side1, 0, tri->numVerts * sizeof( byte ) );
+	SIMDProcessor->Memset( side2, 0, tri->numVerts * sizeof( byte ) );
+
+	for ( i = 0; i < 6; i++ ) {
+		if ( frontBits & (1<<(i+6)) ) {
+			continue;
+		}
+		SIMDProcessor->Dot( planeSide, frustum[i], tri->verts, tri->numVerts );
+		SIMDProcessor->CmpLT( side1, i, planeSide, LIGHT_CLIP_EPSILON, tri->numVerts );
+		SIMDProcessor->CmpGT( side2, i, planeSide, -LIGHT_CLIP_EPSILON, tri->numVerts );
+	}
+	for ( i = 0; i < tri->numVerts; i++ ) {
+		pointCull[i] |= side1[i] | (side2[i] << 6);
+	}
+}
+
+/*
+=================
+R_ScalarSilEdges
+
+The per edge branch that ShadowSilEdges replaced
+=================
+*/
+static int R_ScalarSilEdges( int *silEdgeNums, const byte *faceCasts, const srfTriangles_t *tri ) {
+	int num = 0;
+
+	for ( int i = 0 ; i < tri->numSilEdges ; i++ ) {
+		const silEdge_t *sil = tri->silEdges + i;
+		if ( !( faceCasts[ sil->p1 ] ^ faceCasts[ sil->p2 ] ) ) {
+			continue;
+		}
+		silEdgeNums[num++] = i;
+	}
+	return num;
+}
+
+/*
+=================
+R_BenchShadowCullSurface
+=================
+*/
+static void R_BenchShadowCullSurface( const srfTriangles_t *tri, const idPlane frustum[6], const idVec3 &lightOrigin,
+										int passes, shadowCullBench_t &bench ) {
+	int				i, j;
+	unsigned int	start;
+	int				numTris = tri->numIndexes / 3;
+	int				numSils1 = 0, numSils2 = 0;
+
+	unsigned short *pointCull = (unsigned short *)_alloca16( tri->numVerts * sizeof( pointCull[0] ) );
+	unsigned short *simdPointCull = (unsigned short *)_alloca16( tri->numVerts * sizeof( simdPointCull[0] ) );
+	int *silEdgeNums1 = (int *)_alloca16( tri->numSilEdges * sizeof( silEdgeNums1[0] ) );
+	int *silEdgeNums2 = (int *)_alloca16( tri->numSilEdges * sizeof( silEdgeNums2[0] ) );
+	idPlane *facePlanes = (idPlane *)_alloca16( numTris * sizeof( facePlanes[0] ) );
+	float *facing = (float *)_alloca16( numTris * sizeof( facing[0] ) );
+	byte *faceCasts = (byte *)_alloca16( numTris + 1 );
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < passes ; i++ ) {
+		R_ScalarPointCull( tri, frustum, pointCull );
+	}
+	bench.scalarCullUsec += Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < passes ; i++ ) {
+		SIMDProcessor->ShadowPointCull( simdPointCull, frustum, R_CalcPointCullFrontBits( tri, frustum ), LIGHT_CLIP_EPSILON, tri->verts, tri->numVerts );
+	}
+	bench.simdCullUsec += Sys_Microseconds() - start;
+
+	for ( i = 0 ; i < tri->numVerts ; i++ ) {
+		if ( pointCull[i] != simdPointCull[i] ) {
+			bench.numMismatches++;
+			break;
+		}
+	}
+
+	// faces that face away from the light and are not culled cast shadows, like R_CreateShadowVolumeInFrustum
+	SIMDProcessor->DeriveTriPlanes( facePlanes, tri->verts, tri->numVerts, tri->indexes, tri->numIndexes );
+	SIMDProcessor->Dot( facing, lightOrigin, facePlanes, numTris );
+	for ( i = 0 ; i < numTris ; i++ ) {
+		faceCasts[i] = ( facing[i] < 0.0f && !TRIANGLE_CULLED( tri->silIndexes[i*3+0], tri->silIndexes[i*3+1], tri->silIndexes[i*3+2] ) );
+	}
+	faceCasts[numTris] = 0;
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < passes ; i++ ) {
+		numSils1 = R_ScalarSilEdges( silEdgeNums1, faceCasts, tri );
+	}
+	bench.scalarSilUsec += Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < passes ; i++ ) {
+		numSils2 = SIMDProcessor->ShadowSilEdges( silEdgeNums2, faceCasts, tri->silEdges, tri->numSilEdges );
+	}
+	bench.simdSilUsec += Sys_Microseconds() - start;
+
+	for ( j = 0 ; j < numSils1 ; j++ ) {
+		if ( silEdgeNums1[j] != silEdgeNums2[j] ) {
+			break;
+		}
+	}
+	if ( j < numSils1 || numSils1 != numSils2 ) {
+		bench.numMismatches++;
+	}
+
+	bench.numSurfaces++;
+	bench.numVerts += tri->numVerts;
+	bench.numSilEdges += tri->numSilEdges;
+}
+
+/*
+=================
+R_BenchShadowCull_f
+
+Times the shadow volume point cull and silhouette edge search on every
+static surface of the current map that is inside a shadow casting light
+=================
+*/
+void R_BenchShadowCull_f( const idCmdArgs &args ) {
+	shadowCullBench_t	bench;
+	idPlane				localFrustum[6];
+	idVec3				localLightOrigin;
+	int					passes;
+
+	if ( !tr.primaryWorld ) {
+		common->Printf( "no map loaded\n" );
+		return;
+	}
+
+	passes = ( args.Argc() > 1 ) ? atoi( args.Argv( 1 ) ) : 10;
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+
+	memset( &bench, 0, sizeof( bench ) );
+
+	for ( int i = 0 ; i < tr.primaryWorld->lightDefs.Num() ; i++ ) {
+		const idRenderLightLocal *light = tr.primaryWorld->lightDefs[i];
+		if ( !light || light->parms.noShadows ) {
+			continue;
+		}
+
+		for ( int j = 0 ; j < tr.primaryWorld->entityDefs.Num() ; j++ ) {
+			const idRenderEntityLocal *def = tr.primaryWorld->entityDefs[j];
+			if ( !def || def->parms.noShadow || !def->parms.hModel || def->parms.hModel->IsDynamicModel() != DM_STATIC ) {
+				continue;
+			}
+			if ( R_CullLocalBox( def->referenceBounds, def->modelMatrix, 6, light->frustum ) ) {
+				continue;
+			}
+
+			for ( int k = 0 ; k < 6 ; k++ ) {
+				R_GlobalPlaneToLocal( def->modelMatrix, light->frustum[k], localFrustum[k] );
+			}
+			R_GlobalPointToLocal( def->modelMatrix, light->globalLightOrigin, localLightOrigin );
+
+			const idRenderModel *model = def->parms.hModel;
+			for ( int k = 0 ; k < model->NumSurfaces() ; k++ ) {
+				const modelSurface_t *surf = model->Surface( k );
+				const srfTriangles_t *tri = surf->geometry;
+				if ( !tri || !tri->silEdges || !tri->silIndexes || ( surf->shader && !surf->shader->SurfaceCastsShadow() ) ) {
+					continue;
+				}
+				if ( R_CullLocalBox( tri->bounds, def->modelMatrix, 6, light->frustum ) ) {
+					continue;
+				}
+				R_BenchShadowCullSurface( tri, localFrustum, localLightOrigin, passes, bench );
+			}
+		}
+	}
+
+	common->Printf( "%i surfaces, %i verts, %i sil edges, %i passes, %s\n", bench.numSurfaces, bench.numVerts,
+					bench.numSilEdges, passes, SIMDProcessor->GetName() );
+	common->Printf( "point cull: scalar %u usec, simd %u usec\n", bench.scalarCullUsec, bench.simdCullUsec );
+	common->Printf( "sil edges:  scalar %u usec, simd %u usec\n", bench.scalarSilUsec, bench.simdSilUsec );
+	if ( bench.numMismatches ) {
+		common->Printf( S_COLOR_RED "%i surfaces gave different results\n", bench.numMismatches );
+	}
+}
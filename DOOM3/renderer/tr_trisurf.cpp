@@ -186,6 +186,9 @@ R_ShutdownTriSurfData
 ===============
 */
 void R_ShutdownTriSurfData( void ) {
+	// the cached shadow volumes come from the allocators
+	R_PurgeShadowCache( NULL, NULL );
+
 	R_StaticFree( silEdges );
 	silEdgeHash.Free();
 	srfTrianglesAllocator.Shutdown();
@@ -420,6 +423,11 @@ void R_ReallyFreeStaticTriSurf( srfTriangles_t *tri ) {
 		triShadowVertexAllocator.Free( tri->shadowVertexes );
 	}
 
+	// R_CreateLightTris references the skinning of the ambient surface
+	if ( tri->skinning != NULL && tri->ambientSurface == NULL ) {
+		R_StaticFree( tri->skinning );
+	}
+
 #ifdef _DEBUG
 	memset( tri, 0, sizeof( srfTriangles_t ) );
 #endif
@@ -2244,6 +2252,120 @@ void R_FreeDeformInfo( deformInfo_t *deformInfo ) {
 	R_StaticFree( deformInfo );
 }
 
+/*
+===================
+R_WriteDeformInfo
+
+Writes the arrays in their runtime layout so R_ReadDeformInfo can read them straight back.
+===================
+*/
+void R_WriteDeformInfo( idFile *file, const deformInfo_t *deformInfo ) {
+	file->WriteInt( deformInfo->numSourceVerts );
+	file->WriteInt( deformInfo->numOutputVerts );
+	file->WriteInt( deformInfo->numIndexes );
+	file->WriteInt( deformInfo->numSilEdges );
+	file->WriteInt( deformInfo->numMirroredVerts );
+	file->WriteInt( deformInfo->numDupVerts );
+	file->WriteBool( deformInfo->indexes != NULL );
+	file->WriteBool( deformInfo->silIndexes != NULL );
+	file->WriteBool( deformInfo->silEdges != NULL );
+	file->WriteBool( deformInfo->mirroredVerts != NULL );
+	file->WriteBool( deformInfo->dupVerts != NULL );
+	file->WriteBool( deformInfo->dominantTris != NULL );
+
+	if ( deformInfo->indexes != NULL ) {
+		file->Write( deformInfo->indexes, deformInfo->numIndexes * sizeof( deformInfo->indexes[0] ) );
+	}
+	if ( deformInfo->silIndexes != NULL ) {
+		file->Write( deformInfo->silIndexes, deformInfo->numIndexes * sizeof( deformInfo->silIndexes[0] ) );
+	}
+	if ( deformInfo->silEdges != NULL ) {
+		file->Write( deformInfo->silEdges, deformInfo->numSilEdges * sizeof( deformInfo->silEdges[0] ) );
+	}
+	if ( deformInfo->mirroredVerts != NULL ) {
+		file->Write( deformInfo->mirroredVerts, deformInfo->numMirroredVerts * sizeof( deformInfo->mirroredVerts[0] ) );
+	}
+	if ( deformInfo->dupVerts != NULL ) {
+		file->Write( deformInfo->dupVerts, deformInfo->numDupVerts * 2 * sizeof( deformInfo->dupVerts[0] ) );
+	}
+	if ( deformInfo->dominantTris != NULL ) {
+		file->Write( deformInfo->dominantTris, deformInfo->numOutputVerts * sizeof( deformInfo->dominantTris[0] ) );
+	}
+}
+
+/*
+===================
+R_ReadDeformInfo
+
+Returns NULL if the file doesn't hold a complete deform info.
+===================
+*/
+deformInfo_t *R_ReadDeformInfo( idFile *file ) {
+	deformInfo_t	*deform;
+	bool			hasIndexes, hasSilIndexes, hasSilEdges, hasMirroredVerts, hasDupVerts, hasDominantTris;
+	int				size;
+
+	deform = (deformInfo_t *)R_ClearedStaticAlloc( sizeof( *deform ) );
+
+	file->ReadInt( deform->numSourceVerts );
+	file->ReadInt( deform->numOutputVerts );
+	file->ReadInt( deform->numIndexes );
+	file->ReadInt( deform->numSilEdges );
+	file->ReadInt( deform->numMirroredVerts );
+	file->ReadInt( deform->numDupVerts );
+	file->ReadBool( hasIndexes );
+	file->ReadBool( hasSilIndexes );
+	file->ReadBool( hasSilEdges );
+	file->ReadBool( hasMirroredVerts );
+	file->ReadBool( hasDupVerts );
+	file->ReadBool( hasDominantTris );
+
+	if ( deform->numSourceVerts < 0 || deform->numOutputVerts < 0 || deform->numIndexes < 0 ||
+			deform->numSilEdges < 0 || deform->numMirroredVerts < 0 || deform->numDupVerts < 0 ) {
+		R_StaticFree( deform );
+		return NULL;
+	}
+
+	size = 0;
+	size += hasIndexes ? deform->numIndexes * sizeof( deform->indexes[0] ) : 0;
+	size += hasSilIndexes ? deform->numIndexes * sizeof( deform->silIndexes[0] ) : 0;
+	size += hasSilEdges ? deform->numSilEdges * sizeof( deform->silEdges[0] ) : 0;
+	size += hasMirroredVerts ? deform->numMirroredVerts * sizeof( deform->mirroredVerts[0] ) : 0;
+	size += hasDupVerts ? deform->numDupVerts * 2 * sizeof( deform->dupVerts[0] ) : 0;
+	size += hasDominantTris ? deform->numOutputVerts * sizeof( deform->dominantTris[0] ) : 0;
+	if ( size > file->Length() - file->Tell() ) {
+		R_StaticFree( deform );
+		return NULL;
+	}
+
+	if ( hasIndexes ) {
+		deform->indexes = triIndexAllocator.Alloc( deform->numIndexes );
+		file->Read( deform->indexes, deform->numIndexes * sizeof( deform->indexes[0] ) );
+	}
+	if ( hasSilIndexes ) {
+		deform->silIndexes = triSilIndexAllocator.Alloc( deform->numIndexes );
+		file->Read( deform->silIndexes, deform->numIndexes * sizeof( deform->silIndexes[0] ) );
+	}
+	if ( hasSilEdges ) {
+		deform->silEdges = triSilEdgeAllocator.Alloc( deform->numSilEdges );
+		file->Read( deform->silEdges, deform->numSilEdges * sizeof( deform->silEdges[0] ) );
+	}
+	if ( hasMirroredVerts ) {
+		deform->mirroredVerts = triMirroredVertAllocator.Alloc( deform->numMirroredVerts );
+		file->Read( deform->mirroredVerts, deform->numMirroredVerts * sizeof( deform->mirroredVerts[0] ) );
+	}
+	if ( hasDupVerts ) {
+		deform->dupVerts = triDupVertAllocator.Alloc( deform->numDupVerts * 2 );
+		file->Read( deform->dupVerts, deform->numDupVerts * 2 * sizeof( deform->dupVerts[0] ) );
+	}
+	if ( hasDominantTris ) {
+		deform->dominantTris = triDominantTrisAllocator.Alloc( deform->numOutputVerts );
+		file->Read( deform->dominantTris, deform->numOutputVerts * sizeof( deform->dominantTris[0] ) );
+	}
+
+	return deform;
+}
+
 /*
 ===================
 R_DeformInfoMemoryUsed
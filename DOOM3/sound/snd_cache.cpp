@@ -39,6 +39,207 @@ static idDynamicBlockAlloc<byte, 1<<20, 1<<10>	soundCacheAllocator;
 static idDynamicAlloc<byte, 1<<20, 1<<10>		soundCacheAllocator;
 #endif
 
+/*
+==========================================================================
+
+IMA ADPCM resident format
+
+Samples are split into independent blocks so FetchFromCache can start
+decoding at any block boundary. The decoder works from a precomputed
+delta table instead of rebuilding the delta from the step bits for
+every code. The codes depend on the previous output so there is nothing
+to vectorize inside a channel.
+
+==========================================================================
+*/
+
+static const int adpcmStepTable[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int adpcmIndexTable[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static int		adpcmDeltaTable[89][16];
+static byte		adpcmNextIndexTable[89][16];
+
+// FetchFromCache decodes into this window, it is only called by the sample
+// decoder which holds CRITICAL_SECTION_ONE while it consumes the data
+static short	adpcmFetchBuffer[SCACHE_SIZE / sizeof( short ) + 2 * ADPCM_BLOCK_SAMPLES];
+
+/*
+===================
+ADPCM_InitTables
+===================
+*/
+static void ADPCM_InitTables( void ) {
+	for ( int i = 0; i < 89; i++ ) {
+		int step = adpcmStepTable[i];
+		for ( int code = 0; code < 16; code++ ) {
+			int delta = step >> 3;
+			if ( code & 4 ) {
+				delta += step;
+			}
+			if ( code & 2 ) {
+				delta += step >> 1;
+			}
+			if ( code & 1 ) {
+				delta += step >> 2;
+			}
+			adpcmDeltaTable[i][code] = ( code & 8 ) ? -delta : delta;
+			adpcmNextIndexTable[i][code] = idMath::ClampInt( 0, 88, i + adpcmIndexTable[code] );
+		}
+	}
+}
+
+/*
+===================
+ADPCM_BlockSize
+===================
+*/
+static ID_INLINE int ADPCM_BlockSize( int numChannels ) {
+	return numChannels * ADPCM_BLOCK_HEADER + ADPCM_BLOCK_SAMPLES / 2;
+}
+
+/*
+===================
+ADPCM_EncodeBlock
+
+Encodes numSamples interleaved samples, the rest of the block is padded with silence.
+===================
+*/
+static void ADPCM_EncodeBlock( const short *src, int numSamples, int numChannels, byte *dest ) {
+	int predictor[2], index[2];
+
+	for ( int c = 0; c < numChannels; c++ ) {
+		predictor[c] = ( c < numSamples ) ? src[c] : 0;
+		// start with a step size that fits the first delta so the block doesn't need to ramp up
+		int firstDelta = ( c + numChannels < numSamples ) ? abs( src[c + numChannels] - src[c] ) : 0;
+		index[c] = 0;
+		while ( index[c] < 88 && adpcmStepTable[index[c]] < firstDelta ) {
+			index[c]++;
+		}
+		dest[0] = predictor[c] & 0xff;
+		dest[1] = ( predictor[c] >> 8 ) & 0xff;
+		dest[2] = index[c];
+		dest[3] = 0;
+		dest += ADPCM_BLOCK_HEADER;
+	}
+
+	memset( dest, 0, ADPCM_BLOCK_SAMPLES / 2 );
+
+	for ( int i = 0; i < ADPCM_BLOCK_SAMPLES; i++ ) {
+		int c = i & ( numChannels - 1 );
+		int sample = ( i < numSamples ) ? src[i] : 0;
+		int step = adpcmStepTable[index[c]];
+		int diff = sample - predictor[c];
+		int code = 0;
+
+		if ( diff < 0 ) {
+			code = 8;
+			diff = -diff;
+		}
+		if ( diff >= step ) {
+			code |= 4;
+			diff -= step;
+		}
+		step >>= 1;
+		if ( diff >= step ) {
+			code |= 2;
+			diff -= step;
+		}
+		step >>= 1;
+		if ( diff >= step ) {
+			code |= 1;
+		}
+
+		// track the decoder state exactly so errors don't accumulate
+		predictor[c] = idMath::ClampInt( -32768, 32767, predictor[c] + adpcmDeltaTable[index[c]][code] );
+		index[c] = adpcmNextIndexTable[index[c]][code];
+
+		dest[i >> 1] |= code << ( ( i & 1 ) << 2 );
+	}
+}
+
+/*
+===================
+ADPCM_DecodeBlock
+===================
+*/
+static void ADPCM_DecodeBlock( const byte *src, int numChannels, short *dest ) {
+	int predictor[2], index[2];
+
+	for ( int c = 0; c < numChannels; c++ ) {
+		predictor[c] = (short)( src[0] | ( src[1] << 8 ) );
+		index[c] = src[2];
+		src += ADPCM_BLOCK_HEADER;
+	}
+
+	if ( numChannels == 1 ) {
+		int p = predictor[0], x = index[0];
+		for ( int i = 0; i < ADPCM_BLOCK_SAMPLES / 2; i++ ) {
+			int lo = src[i] & 15;
+			int hi = src[i] >> 4;
+			p = idMath::ClampInt( -32768, 32767, p + adpcmDeltaTable[x][lo] );
+			x = adpcmNextIndexTable[x][lo];
+			dest[i*2+0] = p;
+			p = idMath::ClampInt( -32768, 32767, p + adpcmDeltaTable[x][hi] );
+			x = adpcmNextIndexTable[x][hi];
+			dest[i*2+1] = p;
+		}
+	} else {
+		// each byte holds one left and one right code
+		int p0 = predictor[0], x0 = index[0];
+		int p1 = predictor[1], x1 = index[1];
+		for ( int i = 0; i < ADPCM_BLOCK_SAMPLES / 2; i++ ) {
+			int lo = src[i] & 15;
+			int hi = src[i] >> 4;
+			p0 = idMath::ClampInt( -32768, 32767, p0 + adpcmDeltaTable[x0][lo] );
+			x0 = adpcmNextIndexTable[x0][lo];
+			p1 = idMath::ClampInt( -32768, 32767, p1 + adpcmDeltaTable[x1][hi] );
+			x1 = adpcmNextIndexTable[x1][hi];
+			dest[i*2+0] = p0;
+			dest[i*2+1] = p1;
+		}
+	}
+}
+
+// a run of blocks of one sample that is compressed on a job thread
+typedef struct {
+	const short *	pcm;
+	int				numSamples;
+	int				numChannels;
+	byte *			dest;
+} adpcmJob_t;
+
+const int ADPCM_BLOCKS_PER_JOB = 256;
+const int SAMPLE_READ_AHEAD = 16;			// pending samples whose files are prefetched ahead of the one being loaded
+
+/*
+============
+ADPCM_EncodeJob
+============
+*/
+static void ADPCM_EncodeJob( void *data ) {
+	adpcmJob_t *job = (adpcmJob_t *)data;
+	int blockSize = ADPCM_BlockSize( job->numChannels );
+
+	for ( int i = 0; i * ADPCM_BLOCK_SAMPLES < job->numSamples; i++ ) {
+		int numSamples = Min( ADPCM_BLOCK_SAMPLES, job->numSamples - i * ADPCM_BLOCK_SAMPLES );
+		ADPCM_EncodeBlock( job->pcm + i * ADPCM_BLOCK_SAMPLES, numSamples, job->numChannels, job->dest + i * blockSize );
+	}
+}
+
 /*
 ===================
 idSoundCache::idSoundCache()
@@ -50,6 +251,7 @@ idSoundCache::idSoundCache() {
 	listCache.AssureSize( 1024, NULL );
 	listCache.SetGranularity( 256 );
 	insideLevelLoad = false;
+	ADPCM_InitTables();
 }
 
 /*
@@ -83,7 +285,7 @@ idSoundCache::FindSound
 Adds a sound object to the cache and returns a handle for it.
 ===================
 */
-idSoundSample *idSoundCache::FindSound( const idStr& filename, bool loadOnDemandOnly ) {
+idSoundSample *idSoundCache::FindSound( const idStr& filename, bool loadOnDemandOnly, bool compressResident ) {
 	idStr fname;
 
 	fname = filename;
@@ -97,8 +299,10 @@ idSoundSample *idSoundCache::FindSound( const idStr& filename, bool loadOnDemand
 		idSoundSample *def = listCache[i];
 		if ( def && def->name == fname ) {
 			def->levelLoadReferenced = true;
+			// a sample that is already resident as PCM keeps that format until it is reloaded
+			def->compressResident |= compressResident;
 			if ( def->purged && !loadOnDemandOnly ) {
-				def->Load();
+				LoadSample( def );
 			}
 			return def;
 		}
@@ -117,16 +321,33 @@ idSoundSample *idSoundCache::FindSound( const idStr& filename, bool loadOnDemand
 	def->name = fname;
 	def->levelLoadReferenced = true;
 	def->onDemand = loadOnDemandOnly;
+	def->compressResident = compressResident;
 	def->purged = true;
 
 	if ( !loadOnDemandOnly ) {
 		// this may make it a default sound if it can't be loaded
-		def->Load();
+		LoadSample( def );
 	}
 
 	return def;
 }
 
+/*
+===================
+idSoundCache::LoadSample
+
+During a level load the sample is only queued, a sound started before the end
+of the load still loads it on demand.
+===================
+*/
+void idSoundCache::LoadSample( idSoundSample *sample ) {
+	if ( insideLevelLoad ) {
+		pendingLoads.AddUnique( sample );
+		return;
+	}
+	sample->Load();
+}
+
 /*
 ===================
 idSoundCache::ReloadSounds
@@ -185,8 +406,13 @@ void idSoundCache::EndLevelLoad() {
 	int	useCount, purgeCount;
 	common->Printf( "----- idSoundCache::EndLevelLoad -----\n" );
 
+	// still inside the level load so the ADPCM encoding is deferred as well
+	LoadPendingSamples();
+
 	insideLevelLoad = false;
 
+	CompressPendingSamples();
+
 	// purge the ones we don't need
 	useCount = 0;
 	purgeCount = 0;
@@ -213,13 +439,136 @@ void idSoundCache::EndLevelLoad() {
 	common->Printf( "%5ik purged\n", purgeCount / 1024 );
 }
 
+/*
+====================
+idSoundCache::LoadPendingSamples
+
+Reads the samples queued during the level load. The files of the next few samples
+are prefetched, so they are inflated on the job threads while the current one is
+read and converted.
+====================
+*/
+void idSoundCache::LoadPendingSamples( void ) {
+	int i, prefetched, numLoaded;
+
+	if ( !pendingLoads.Num() ) {
+		return;
+	}
+
+	int start = Sys_Milliseconds();
+
+	numLoaded = 0;
+	prefetched = 0;
+	for ( i = 0; i < pendingLoads.Num(); i++ ) {
+		for ( ; prefetched < pendingLoads.Num() && prefetched <= i + SAMPLE_READ_AHEAD; prefetched++ ) {
+			idSoundSample *ahead = pendingLoads[prefetched];
+			if ( !ahead->purged ) {
+				continue;
+			}
+			// idWaveFile::Open reads the .ogg version when there is one
+			idStr oggName = ahead->name;
+			oggName.SetFileExtension( ".ogg" );
+			fileSystem->PrefetchFile( oggName );
+			fileSystem->PrefetchFile( ahead->name );
+		}
+
+		idSoundSample *sample = pendingLoads[i];
+		if ( !sample->purged ) {
+			// started during the load and loaded on demand
+			continue;
+		}
+		// this may make it a default sound if it can't be loaded
+		sample->Load();
+		numLoaded++;
+	}
+	pendingLoads.Clear();
+
+	common->Printf( "%5i samples loaded in %i msec\n", numLoaded, Sys_Milliseconds() - start );
+}
+
+/*
+====================
+idSoundCache::CompressPendingSamples
+
+The ADPCM encoding of all samples loaded during the level load is spread over
+the job threads. Buffers are allocated and freed here, the jobs only encode.
+====================
+*/
+void idSoundCache::CompressPendingSamples( void ) {
+	idList<byte *>		compressed;
+	idList<adpcmJob_t>	jobs;
+	idJobList			jobList;
+	int					i, j, numJobs;
+
+	if ( !pendingADPCM.Num() ) {
+		return;
+	}
+
+	// the job list holds pointers into the job array, so size it up front
+	numJobs = 0;
+	for ( i = 0; i < pendingADPCM.Num(); i++ ) {
+		idSoundSample *sample = pendingADPCM[i];
+		int numBlocks = ( sample->objectSize + ADPCM_BLOCK_SAMPLES - 1 ) / ADPCM_BLOCK_SAMPLES;
+		numJobs += ( numBlocks + ADPCM_BLOCKS_PER_JOB - 1 ) / ADPCM_BLOCKS_PER_JOB;
+	}
+	jobs.SetNum( numJobs );
+	compressed.SetNum( pendingADPCM.Num() );
+
+	int start = Sys_Milliseconds();
+
+	numJobs = 0;
+	for ( i = 0; i < pendingADPCM.Num(); i++ ) {
+		idSoundSample *sample = pendingADPCM[i];
+
+		compressed[i] = NULL;
+		if ( !sample->WantsADPCM() ) {
+			// reloaded or purged since it was deferred
+			continue;
+		}
+
+		int numBlocks = ( sample->objectSize + ADPCM_BLOCK_SAMPLES - 1 ) / ADPCM_BLOCK_SAMPLES;
+		int blockSize = ADPCM_BlockSize( sample->objectInfo.nChannels );
+		compressed[i] = soundCacheAllocator.Alloc( numBlocks * blockSize );
+
+		for ( j = 0; j < numBlocks; j += ADPCM_BLOCKS_PER_JOB ) {
+			adpcmJob_t &job = jobs[numJobs++];
+			job.pcm = (const short *)sample->nonCacheData + j * ADPCM_BLOCK_SAMPLES;
+			job.numSamples = Min( ADPCM_BLOCKS_PER_JOB * ADPCM_BLOCK_SAMPLES, sample->objectSize - j * ADPCM_BLOCK_SAMPLES );
+			job.numChannels = sample->objectInfo.nChannels;
+			job.dest = compressed[i] + j * blockSize;
+			jobList.AddJob( ADPCM_EncodeJob, &job );
+		}
+	}
+
+	jobList.Wait();
+
+	// samples that are already playing are decoded by the mixer thread
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
+	for ( i = 0; i < pendingADPCM.Num(); i++ ) {
+		idSoundSample *sample = pendingADPCM[i];
+		if ( !compressed[i] ) {
+			continue;
+		}
+		int numBlocks = ( sample->objectSize + ADPCM_BLOCK_SAMPLES - 1 ) / ADPCM_BLOCK_SAMPLES;
+		soundCacheAllocator.Free( sample->nonCacheData );
+		sample->nonCacheData = compressed[i];
+		sample->objectMemSize = numBlocks * ADPCM_BlockSize( sample->objectInfo.nChannels );
+		sample->residentADPCM = true;
+	}
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
+
+	common->Printf( "%5i samples compressed to ADPCM in %i msec (%i jobs)\n", pendingADPCM.Num(), Sys_Milliseconds() - start, numJobs );
+
+	pendingADPCM.Clear();
+}
+
 /*
 ===================
 idSoundCache::PrintMemInfo
 ===================
 */
 void idSoundCache::PrintMemInfo( MemInfo_t *mi ) {
-	int i, j, num = 0, total = 0;
+	int i, j, num = 0, total = 0, saved = 0;
 	int *sortIndex;
 	idFile *f;
 
@@ -262,12 +611,18 @@ void idSoundCache::PrintMemInfo( MemInfo_t *mi ) {
 		}
 
 		total += sample->objectMemSize;
-		f->Printf( "%s %s\n", idStr::FormatNumber( sample->objectMemSize ).c_str(), sample->name.c_str() );
+		if ( sample->residentADPCM ) {
+			saved += sample->PCMMemSize() - sample->objectMemSize;
+			f->Printf( "%s %s (adpcm, %s as pcm)\n", idStr::FormatNumber( sample->objectMemSize ).c_str(), sample->name.c_str(), idStr::FormatNumber( sample->PCMMemSize() ).c_str() );
+		} else {
+			f->Printf( "%s %s\n", idStr::FormatNumber( sample->objectMemSize ).c_str(), sample->name.c_str() );
+		}
 	}
 
 	mi->soundAssetsTotal = total;
 
 	f->Printf( "\nTotal sound bytes allocated: %s\n", idStr::FormatNumber( total ).c_str() );
+	f->Printf( "Sound bytes saved by ADPCM: %s\n", idStr::FormatNumber( saved ).c_str() );
 	fileSystem->CloseFile( f );
 	delete[] sortIndex;
 }
@@ -291,6 +646,8 @@ idSoundSample::idSoundSample() {
 	objectSize = 0;
 	objectMemSize = 0;
 	nonCacheData = NULL;
+	compressResident = false;
+	residentADPCM = false;
 	amplitudeData = NULL;
 	openalBuffer = 0;
 	hardwareBuffer = false;
@@ -343,6 +700,7 @@ void idSoundSample::MakeDefault( void ) {
 
 	objectSize = MIXBUFFER_SAMPLES * 2;
 	objectMemSize = objectSize * sizeof( short );
+	residentADPCM = false;
 
 	nonCacheData = (byte *)soundCacheAllocator.Alloc( objectMemSize );
 
@@ -406,6 +764,70 @@ void idSoundSample::CheckForDownSample( void ) {
 	objectInfo.nSamplesPerSec >>= 1;
 }
 
+/*
+===================
+idSoundSample::CheckForADPCM
+
+The hardware buffer has already been filled from the PCM data at this point,
+only the copy kept around for streaming and shakes is compressed.
+===================
+*/
+void idSoundSample::CheckForADPCM( void ) {
+	if ( !WantsADPCM() ) {
+		return;
+	}
+
+	if ( soundSystemLocal.soundCache->IsLevelLoad() ) {
+		soundSystemLocal.soundCache->DeferADPCM( this );
+		return;
+	}
+
+	int numBlocks = ( objectSize + ADPCM_BLOCK_SAMPLES - 1 ) / ADPCM_BLOCK_SAMPLES;
+	int blockSize = ADPCM_BlockSize( objectInfo.nChannels );
+	byte *compressed = soundCacheAllocator.Alloc( numBlocks * blockSize );
+
+	const short *pcm = (const short *)nonCacheData;
+	for ( int i = 0; i < numBlocks; i++ ) {
+		int numSamples = Min( ADPCM_BLOCK_SAMPLES, objectSize - i * ADPCM_BLOCK_SAMPLES );
+		ADPCM_EncodeBlock( pcm + i * ADPCM_BLOCK_SAMPLES, numSamples, objectInfo.nChannels, compressed + i * blockSize );
+	}
+
+	// the mixer thread may be decoding this sample
+	Sys_EnterCriticalSection( CRITICAL_SECTION_ONE );
+	soundCacheAllocator.Free( nonCacheData );
+	nonCacheData = compressed;
+	objectMemSize = numBlocks * blockSize;
+	residentADPCM = true;
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_ONE );
+}
+
+/*
+===================
+idSoundSample::WantsADPCM
+===================
+*/
+bool idSoundSample::WantsADPCM( void ) const {
+	if ( !compressResident || !idSoundSystemLocal::s_useADPCM.GetBool() ) {
+		return false;
+	}
+	if ( objectInfo.wFormatTag != WAVE_FORMAT_TAG_PCM || residentADPCM || !nonCacheData || purged ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+===================
+idSoundSample::PCMMemSize
+===================
+*/
+int idSoundSample::PCMMemSize( void ) const {
+	if ( objectInfo.wFormatTag == WAVE_FORMAT_TAG_OGG ) {
+		return objectMemSize;
+	}
+	return objectSize * sizeof( short );
+}
+
 /*
 ===================
 idSoundSample::GetNewTimeStamp
@@ -434,6 +856,7 @@ void idSoundSample::Load( void ) {
 	defaultSound = false;
 	purged = false;
 	hardwareBuffer = false;
+	residentADPCM = false;
 
 	timestamp = GetNewTimeStamp();
 
@@ -562,6 +985,9 @@ void idSoundSample::Load( void ) {
 		}
 	}
 
+	// optionally keep the resident copy as ADPCM
+	CheckForADPCM();
+
 	fh.Close();
 }
 
@@ -591,6 +1017,7 @@ void idSoundSample::PurgeSoundSample() {
 		soundCacheAllocator.Free( nonCacheData );
 		nonCacheData = NULL;
 	}
+	residentADPCM = false;
 }
 
 /*
@@ -626,7 +1053,9 @@ void idSoundSample::Reload( bool force ) {
 ===================
 idSoundSample::FetchFromCache
 
-Returns true on success.
+Returns true on success. ADPCM samples are decoded into a shared window
+starting at the enclosing block, position is the offset of the requested
+data inside that window.
 ===================
 */
 bool idSoundSample::FetchFromCache( int offset, const byte **output, int *position, int *size, const bool allowIO ) {
@@ -636,6 +1065,28 @@ bool idSoundSample::FetchFromCache( int offset, const byte **output, int *positi
 		return false;
 	}
 
+	if ( residentADPCM ) {
+		int available = Min( objectSize * (int)sizeof( short ) - offset, SCACHE_SIZE );
+		int firstBlock = ( offset / sizeof( short ) ) / ADPCM_BLOCK_SAMPLES;
+		int lastBlock = ( ( offset + available ) / sizeof( short ) + ADPCM_BLOCK_SAMPLES - 1 ) / ADPCM_BLOCK_SAMPLES;
+		int blockSize = ADPCM_BlockSize( objectInfo.nChannels );
+		int skip = offset - firstBlock * ADPCM_BLOCK_SAMPLES * sizeof( short );
+
+		if ( output ) {
+			for ( int i = firstBlock; i < lastBlock; i++ ) {
+				ADPCM_DecodeBlock( nonCacheData + i * blockSize, objectInfo.nChannels, adpcmFetchBuffer + ( i - firstBlock ) * ADPCM_BLOCK_SAMPLES );
+			}
+			*output = (const byte *)adpcmFetchBuffer;
+		}
+		if ( position ) {
+			*position = skip;
+		}
+		if ( size ) {
+			*size = skip + available;
+		}
+		return true;
+	}
+
 	if ( output ) {
 		*output = nonCacheData + offset;
 	}
@@ -684,7 +684,7 @@ int idSoundEmitterLocal::StartSound( const idSoundShader *shader, const s_channe
 	// this is the sample time it will be first mixed
 	int start44kHz;
 
-	if ( soundWorld->fpa[0] ) {
+	if ( soundWorld->IsWritingToFile() ) {
 		// if we are recording an AVI demo, don't use hardware time
 		start44kHz = soundWorld->lastAVI44kHz + MIXBUFFER_SAMPLES;
 	} else {
@@ -806,7 +806,7 @@ int idSoundEmitterLocal::StartSound( const idSoundShader *shader, const s_channe
 		int		end = Sys_Milliseconds();
 		session->TimeHitch( end - start );
 		// recalculate start44kHz, because loading may have taken a fair amount of time
-		if ( !soundWorld->fpa[0] ) {
+		if ( !soundWorld->IsWritingToFile() ) {
 			start44kHz = soundSystemLocal.GetCurrent44kHzTime() + MIXBUFFER_SAMPLES;
 		}
 	}
@@ -984,7 +984,7 @@ void idSoundEmitterLocal::FadeSound( const s_channelType channel, float to, floa
 
 	int	start44kHz;
 
-	if ( soundWorld->fpa[0] ) {
+	if ( soundWorld->IsWritingToFile() ) {
 		// if we are recording an AVI demo, don't use hardware time
 		start44kHz = soundWorld->lastAVI44kHz + MIXBUFFER_SAMPLES;
 	} else {
@@ -72,6 +72,8 @@ const float SND_EPSILON				= 1.0f / 32768.0f;	// if volume is below this, it wil
 
 const int ROOM_SLICES_IN_BUFFER		= 10;
 
+const int WAVE_MIX_HISTOGRAM_SIZE	= 10;				// mix block times from < 50 usec doubling up to >= 12.8 msec
+
 class idAudioBuffer;
 class idWaveFile;
 class idSoundCache;
@@ -553,6 +555,10 @@ public:
 	virtual void			AVIOpen( const char *path, const char *name );
 	virtual void			AVIClose( void );
 
+	// offline mix to a wave file
+	virtual void			StartWritingWave( const char *fileName );
+	virtual void			StopWritingWave( void );
+
 	// SaveGame Support
 	virtual void			WriteToSaveGame( idFile *savefile );
 	virtual void			ReadFromSaveGame( idFile *savefile );
@@ -583,6 +589,9 @@ public:
 												int current44kHz, int numSpeakers, float *finalMixBuffer );
 	void					MixLoop( int current44kHz, int numSpeakers, float *finalMixBuffer );
 	void					AVIUpdate( void );
+	void					WaveUpdate( void );
+	void					WriteWaveHeader( int numSamples );
+	bool					IsWritingToFile( void ) const { return fpa[0] != NULL || fpWave != NULL; }
 	void					ResolveOrigin( const int stackDepth, const soundPortalTrace_t *prevStack, const int soundArea, const float dist, const idVec3& soundOrigin, idSoundEmitterLocal *def );
 	float					FindAmplitude( idSoundEmitterLocal *sound, const int localTime, const idVec3 *listenerPosition, const s_channelType channel, bool shakesOnly );
 
@@ -615,6 +624,14 @@ public:
 	idStr					aviDemoPath;
 	idStr					aviDemoName;
 
+	// offline wave mixing, also advances lastAVI44kHz
+	idFile *				fpWave;
+	int						waveNumSpeakers;
+	int						waveMixBlocks;
+	unsigned int			waveMixTime;		// microseconds spent in MixLoop
+	unsigned int			waveMixMaxTime;
+	int						waveMixHistogram[WAVE_MIX_HISTOGRAM_SIZE];
+
 	idSoundEmitterLocal *	localSound;		// just for playShaderDirectly()
 
 	bool					slowmoActive;
@@ -783,6 +800,7 @@ public:
 	static idCVar			s_realTimeDecoding;
 	static idCVar			s_useEAXReverb;
 	static idCVar			s_decompressionLimit;
+	static idCVar			s_useADPCM;
 
 	static idCVar			s_slowAttenuate;
 
@@ -810,6 +828,11 @@ extern	idSoundSystemLocal	soundSystemLocal;
 
 const int SCACHE_SIZE = MIXBUFFER_SAMPLES*20;	// 1/2 of a second (aroundabout)
 
+// resident IMA ADPCM blocks, each block holds a predictor/step index header per
+// channel followed by ADPCM_BLOCK_SAMPLES interleaved 4 bit codes
+const int ADPCM_BLOCK_SAMPLES = 512;
+const int ADPCM_BLOCK_HEADER = 4;
+
 class idSoundSample {
 public:
 							idSoundSample();
@@ -822,6 +845,8 @@ public:
 	int						objectSize;					// size of waveform in samples, excludes the header
 	int						objectMemSize;				// object size in memory
 	byte *					nonCacheData;				// if it's not cached
+	bool					compressResident;			// a sound shader asked for ADPCM residency
+	bool					residentADPCM;				// nonCacheData holds IMA ADPCM blocks instead of PCM
 	byte *					amplitudeData;				// precomputed min,max amplitude pairs
 	ALuint					openalBuffer;				// openal buffer
 	bool					hardwareBuffer;
@@ -837,6 +862,9 @@ public:
 	void					Reload( bool force );		// reloads if timestamp has changed, or always if force
 	void					PurgeSoundSample();			// frees all data
 	void					CheckForDownSample();		// down sample if required
+	void					CheckForADPCM();			// compress resident PCM if requested
+	bool					WantsADPCM() const;
+	int						PCMMemSize() const;			// size the resident data would have as 16 bit PCM
 	bool					FetchFromCache( int offset, const byte **output, int *position, int *size, const bool allowIO );
 };
 
@@ -879,7 +907,7 @@ public:
 							idSoundCache();
 							~idSoundCache();
 
-	idSoundSample *			FindSound( const idStr &fname, bool loadOnDemandOnly );
+	idSoundSample *			FindSound( const idStr &fname, bool loadOnDemandOnly, bool compressResident = false );
 
 	const int				GetNumObjects( void ) { return listCache.Num(); }
 	const idSoundSample *	GetObject( const int index ) const;
@@ -888,12 +916,22 @@ public:
 
 	void					BeginLevelLoad();
 	void					EndLevelLoad();
+	bool					IsLevelLoad( void ) const { return insideLevelLoad; }
+
+							// samples loaded during a level load are compressed together at the end
+	void					DeferADPCM( idSoundSample *sample ) { pendingADPCM.AddUnique( sample ); }
 
 	void					PrintMemInfo( MemInfo_t *mi );
 
 private:
 	bool					insideLevelLoad;
 	idList<idSoundSample*>	listCache;
+	idList<idSoundSample*>	pendingADPCM;
+	idList<idSoundSample*>	pendingLoads;		// samples found during the level load, read at the end of it
+
+	void					LoadSample( idSoundSample *sample );
+	void					LoadPendingSamples( void );
+	void					CompressPendingSamples( void );
 };
 
 #endif /* !__SND_LOCAL_H__ */
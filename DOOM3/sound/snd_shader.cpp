@@ -40,6 +40,7 @@ void idSoundShader::Init( void ) {
 	desc = "<no description>";
 	errorDuringParse = false;
 	onDemand = false;
+	compressResident = false;
 	numEntries = 0;
 	numLeadins = 0;
 	leadinVolume = 0;
@@ -80,6 +81,7 @@ idSoundShader::idSoundShader::FreeData
 void idSoundShader::FreeData() {
 	numEntries = 0;
 	numLeadins = 0;
+	pendingSamples.Clear();
 }
 
 /*
@@ -265,7 +267,11 @@ bool idSoundShader::ParseShader( idLexer &src ) {
 			if ( !src.ExpectAnyToken( &token ) ) {
 				return false;
 			}
-			altSound = declManager->FindSound( token.c_str() );
+			if ( ParsingOnJob() ) {
+				altSound = static_cast<const idSoundShader *>( declManager->FindDeclWithoutParsing( DECL_SOUND, token.c_str() ) );
+			} else {
+				altSound = declManager->FindSound( token.c_str() );
+			}
 		}
 		// ordered
 		else if ( !token.Icmp( "ordered" ) ) {
@@ -320,6 +326,10 @@ bool idSoundShader::ParseShader( idLexer &src ) {
 			// no longer loading sounds on demand
 			//onDemand = true;
 		}
+		// like onDemand, this only affects the wave files that follow it
+		else if ( !token.Icmp( "adpcm" ) ) {
+			compressResident = true;
+		}
 
 		// the wave files
 		else if ( !token.Icmp( "leadin" ) ) {
@@ -329,30 +339,14 @@ bool idSoundShader::ParseShader( idLexer &src ) {
 				return false;
 			}
 			if ( soundSystemLocal.soundCache && numLeadins < maxSamples ) {
-				leadins[ numLeadins ] = soundSystemLocal.soundCache->FindSound( token.c_str(), onDemand );
+				leadins[ numLeadins ] = ParseSample( token.c_str(), numLeadins, true );
 				numLeadins++;
 			}
 		} else if ( token.Find( ".wav", false ) != -1 || token.Find( ".ogg", false ) != -1 ) {
 			// add to the wav list
 			if ( soundSystemLocal.soundCache && numEntries < maxSamples ) {
 				token.BackSlashesToSlashes();
-				idStr lang = cvarSystem->GetCVarString( "sys_lang" );
-				if ( lang.Icmp( "english" ) != 0 && token.Find( "sound/vo/", false ) >= 0 ) {
-					idStr work = token;
-					work.ToLower();
-					work.StripLeading( "sound/vo/" );
-					work = va( "sound/vo/%s/%s", lang.c_str(), work.c_str() );
-					if ( fileSystem->ReadFile( work, NULL, NULL ) > 0 ) {
-						token = work;
-					} else {
-						// also try to find it with the .ogg extension
-						work.SetFileExtension( ".ogg" );
-						if ( fileSystem->ReadFile( work, NULL, NULL ) > 0 ) {
-							token = work;
-						}
-					}
-				}
-				entries[ numEntries ] = soundSystemLocal.soundCache->FindSound( token.c_str(), onDemand );
+				entries[ numEntries ] = ParseSample( token.c_str(), numEntries, false );
 				numEntries++;
 			}
 		} else {
@@ -361,13 +355,90 @@ bool idSoundShader::ParseShader( idLexer &src ) {
 		}
 	}
 
-	if ( parms.shakes > 0.0f ) {
+	if ( parms.shakes > 0.0f && !ParsingOnJob() ) {
 		CheckShakesAndOgg();
 	}
 
 	return true;
 }
 
+/*
+===============
+idSoundShader::ParseSample
+
+the sound cache belongs to the main thread, a parse on a job thread keeps the
+name and ResolveReferences() finds the sample
+===============
+*/
+idSoundSample *idSoundShader::ParseSample( const char *name, int index, bool leadin ) {
+	if ( ParsingOnJob() ) {
+		pendingSample_t &sample = pendingSamples.Alloc();
+		sample.name = name;
+		sample.index = index;
+		sample.leadin = leadin;
+		sample.compressResident = compressResident;
+		return NULL;
+	}
+	return FindSample( name, leadin, compressResident );
+}
+
+/*
+===============
+idSoundShader::FindSample
+
+the voice overs of other languages replace the english ones if they exist
+===============
+*/
+idSoundSample *idSoundShader::FindSample( const char *name, bool leadin, bool compressResident ) const {
+	idStr sampleName = name;
+
+	if ( !leadin ) {
+		idStr lang = cvarSystem->GetCVarString( "sys_lang" );
+		if ( lang.Icmp( "english" ) != 0 && sampleName.Find( "sound/vo/", false ) >= 0 ) {
+			idStr work = sampleName;
+			work.ToLower();
+			work.StripLeading( "sound/vo/" );
+			work = va( "sound/vo/%s/%s", lang.c_str(), work.c_str() );
+			if ( fileSystem->ReadFile( work, NULL, NULL ) > 0 ) {
+				sampleName = work;
+			} else {
+				// also try to find it with the .ogg extension
+				work.SetFileExtension( ".ogg" );
+				if ( fileSystem->ReadFile( work, NULL, NULL ) > 0 ) {
+					sampleName = work;
+				}
+			}
+		}
+	}
+
+	return soundSystemLocal.soundCache->FindSound( sampleName.c_str(), onDemand, compressResident );
+}
+
+/*
+===============
+idSoundShader::ResolveReferences
+===============
+*/
+void idSoundShader::ResolveReferences( void ) {
+	for ( int i = 0; i < pendingSamples.Num(); i++ ) {
+		const pendingSample_t &sample = pendingSamples[i];
+		if ( sample.leadin ) {
+			leadins[ sample.index ] = FindSample( sample.name, true, sample.compressResident );
+		} else {
+			entries[ sample.index ] = FindSample( sample.name, false, sample.compressResident );
+		}
+	}
+	pendingSamples.Clear();
+
+	if ( altSound ) {
+		altSound = declManager->FindSound( altSound->GetName() );
+	}
+
+	if ( parms.shakes > 0.0f ) {
+		CheckShakesAndOgg();
+	}
+}
+
 /*
 ===============
 idSoundShader::CheckShakesAndOgg
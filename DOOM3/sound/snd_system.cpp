@@ -69,6 +69,7 @@ idCVar idSoundSystemLocal::s_reverbFeedback( "s_reverbFeedback", "0.333", CVAR_S
 idCVar idSoundSystemLocal::s_enviroSuitVolumeScale( "s_enviroSuitVolumeScale", "0.9", CVAR_SOUND | CVAR_FLOAT, "" );
 idCVar idSoundSystemLocal::s_skipHelltimeFX( "s_skipHelltimeFX", "0", CVAR_SOUND | CVAR_BOOL, "" );
 idCVar idSoundSystemLocal::s_decompressionLimit( "s_decompressionLimit", "6", CVAR_SOUND | CVAR_INTEGER | CVAR_ARCHIVE, "specifies maximum uncompressed sample length in seconds" );
+idCVar idSoundSystemLocal::s_useADPCM( "s_useADPCM", "1", CVAR_SOUND | CVAR_BOOL | CVAR_ARCHIVE, "keep samples of sound shaders marked 'adpcm' in memory as 4:1 IMA ADPCM" );
 #ifdef IOS
 idCVar idSoundSystemLocal::s_useEAXReverb( "s_useEAXReverb", "0", CVAR_SOUND | CVAR_BOOL | CVAR_ROM, "EFX not available in this build" );
 #else
@@ -133,7 +134,7 @@ void ListSounds_f( const idCmdArgs &args ) {
 		const waveformatex_t &info = sample->objectInfo;
 
 		const char *stereo = ( info.nChannels == 2 ? "ST" : "  " );
-		const char *format = ( info.wFormatTag == WAVE_FORMAT_TAG_OGG ) ? "OGG" : "WAV";
+		const char *format = ( info.wFormatTag == WAVE_FORMAT_TAG_OGG ) ? "OGG" : sample->residentADPCM ? "ADPC" : "WAV";
 		const char *defaulted = ( sample->defaultSound ? "(DEFAULTED)" : sample->purged ? "(PURGED)" : "" );
 
 		common->Printf( "%s %dkHz %6dms %5dkB %4s %s%s\n", stereo, sample->objectInfo.nSamplesPerSec / 1000,
@@ -581,8 +582,8 @@ int idSoundSystemLocal::AsyncMix( int soundTime, float *mixBuffer ) {
 	inTime = Sys_Milliseconds();
 	numSpeakers = s_numberOfSpeakers.GetInteger();
 
-	// let the active sound world mix all the channels in unless muted or avi demo recording
-	if ( !muted && currentSoundWorld && !currentSoundWorld->fpa[0] ) {
+	// let the active sound world mix all the channels in unless muted or avi demo / wave recording
+	if ( !muted && currentSoundWorld && !currentSoundWorld->IsWritingToFile() ) {
 		currentSoundWorld->MixLoop( soundTime, numSpeakers, mixBuffer );
 	}
 
@@ -653,8 +654,8 @@ int idSoundSystemLocal::AsyncUpdate( int inTime ) {
 	// enable audio hardware caching
 	alcSuspendContext( openalContext );
 
-	// let the active sound world mix all the channels in unless muted or avi demo recording
-	if ( !muted && currentSoundWorld && !currentSoundWorld->fpa[0] ) {
+	// let the active sound world mix all the channels in unless muted or avi demo / wave recording
+	if ( !muted && currentSoundWorld && !currentSoundWorld->IsWritingToFile() ) {
 		currentSoundWorld->MixLoop( newSoundTime, numSpeakers, finalMixBuffer );
 	}
 
@@ -702,8 +703,8 @@ int idSoundSystemLocal::AsyncUpdateWrite( int inTime ) {
 	// enable audio hardware caching
 	alcSuspendContext( openalContext );
 
-	// let the active sound world mix all the channels in unless muted or avi demo recording
-	if ( !muted && currentSoundWorld && !currentSoundWorld->fpa[0] ) {
+	// let the active sound world mix all the channels in unless muted or avi demo / wave recording
+	if ( !muted && currentSoundWorld && !currentSoundWorld->IsWritingToFile() ) {
 		currentSoundWorld->MixLoop( sampleTime, numSpeakers, finalMixBuffer );
 	}
 
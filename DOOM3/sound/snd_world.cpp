@@ -102,6 +102,13 @@ void idSoundWorldLocal::Init( idRenderWorld *renderWorld ) {
 	aviDemoPath = "";
 	aviDemoName = "";
 
+	fpWave = NULL;
+	waveNumSpeakers = 2;
+	waveMixBlocks = 0;
+	waveMixTime = 0;
+	waveMixMaxTime = 0;
+	memset( waveMixHistogram, 0, sizeof( waveMixHistogram ) );
+
 	localSound = NULL;
 
 	slowmoActive		= false;
@@ -141,6 +148,7 @@ void idSoundWorldLocal::Shutdown() {
 	}
 
 	AVIClose();
+	StopWritingWave();
 
 #ifndef IOS
 	if (idSoundSystemLocal::useEFXReverb) {
@@ -177,6 +185,7 @@ void idSoundWorldLocal::ClearAllSoundEmitters() {
 	Sys_EnterCriticalSection();
 
 	AVIClose();
+	StopWritingWave();
 
 	for ( i = 0; i < emitters.Num(); i++ ) {
 		idSoundEmitterLocal *sound = emitters[i];
@@ -746,6 +755,164 @@ void idSoundWorldLocal::AVIClose( void ) {
 	soundSystemLocal.SetMute( false );
 }
 
+/*
+===================
+idSoundWorldLocal::StartWritingWave
+
+	this is called by the main thread
+===================
+*/
+void idSoundWorldLocal::StartWritingWave( const char *fileName ) {
+	if ( fpa[0] || fpWave ) {
+		common->Warning( "idSoundWorldLocal::StartWritingWave: already writing sound output" );
+		return;
+	}
+
+	fpWave = fileSystem->OpenFileWrite( fileName );
+	if ( !fpWave ) {
+		common->Warning( "Couldn't write %s", fileName );
+		return;
+	}
+
+	waveNumSpeakers = idSoundSystemLocal::s_numberOfSpeakers.GetInteger();
+	waveMixBlocks = 0;
+	waveMixTime = 0;
+	waveMixMaxTime = 0;
+	memset( waveMixHistogram, 0, sizeof( waveMixHistogram ) );
+
+	lastAVI44kHz = game44kHz - game44kHz % MIXBUFFER_SAMPLES;
+
+	// the sizes are filled in when the file is closed
+	WriteWaveHeader( 0 );
+
+	soundSystemLocal.SetMute( true );
+}
+
+/*
+===================
+idSoundWorldLocal::WriteWaveHeader
+===================
+*/
+void idSoundWorldLocal::WriteWaveHeader( int numSamples ) {
+	mminfo_t		info;
+	pcmwaveformat_t format;
+	int				dataSize = numSamples * waveNumSpeakers * sizeof( short );
+
+	info.ckid = fourcc_riff;
+	info.fccType = mmioFOURCC( 'W', 'A', 'V', 'E' );
+	info.cksize = dataSize + 4 + 8 + 16 + 8;
+	info.dwDataOffset = 12;
+
+	fpWave->Write( &info, 12 );
+
+	info.ckid = mmioFOURCC( 'f', 'm', 't', ' ' );
+	info.cksize = 16;
+
+	fpWave->Write( &info, 8 );
+
+	format.wBitsPerSample = 16;
+	format.wf.nAvgBytesPerSec = 44100 * waveNumSpeakers * sizeof( short );
+	format.wf.nChannels = waveNumSpeakers;
+	format.wf.nSamplesPerSec = 44100;
+	format.wf.wFormatTag = WAVE_FORMAT_TAG_PCM;
+	format.wf.nBlockAlign = waveNumSpeakers * sizeof( short );
+
+	fpWave->Write( &format, 16 );
+
+	info.ckid = mmioFOURCC( 'd', 'a', 't', 'a' );
+	info.cksize = dataSize;
+
+	fpWave->Write( &info, 8 );
+}
+
+/*
+===================
+idSoundWorldLocal::WaveUpdate
+
+this is called by the main thread
+mixes and writes all blocks up to the current game time, demos played back as
+fast as possible can advance the game time by several blocks per frame
+===================
+*/
+void idSoundWorldLocal::WaveUpdate() {
+	float	mix[MIXBUFFER_SAMPLES*6+16];
+	float	*mix_p = (float *)((( intptr_t)mix + 15 ) & ~15);	// SIMD align
+	short	out_p[MIXBUFFER_SAMPLES*6];
+	int		numValues = MIXBUFFER_SAMPLES * waveNumSpeakers;
+
+	while ( game44kHz - lastAVI44kHz >= MIXBUFFER_SAMPLES ) {
+		SIMDProcessor->Memset( mix_p, 0, numValues * sizeof( float ) );
+
+		unsigned int start = Sys_Microseconds();
+		MixLoop( lastAVI44kHz, waveNumSpeakers, mix_p );
+		unsigned int usec = Sys_Microseconds() - start;
+
+		waveMixBlocks++;
+		waveMixTime += usec;
+		if ( usec > waveMixMaxTime ) {
+			waveMixMaxTime = usec;
+		}
+		int bucket = 0;
+		while ( bucket < WAVE_MIX_HISTOGRAM_SIZE - 1 && usec >= ( 50u << bucket ) ) {
+			bucket++;
+		}
+		waveMixHistogram[bucket]++;
+
+		for ( int i = 0; i < numValues; i++ ) {
+			float s = mix_p[i];
+			if ( s < -32768.0f ) {
+				out_p[i] = -32768;
+			} else if ( s > 32767.0f ) {
+				out_p[i] = 32767;
+			} else {
+				out_p[i] = idMath::FtoiFast( s );
+			}
+		}
+		fpWave->Write( out_p, numValues * sizeof( short ) );
+
+		lastAVI44kHz += MIXBUFFER_SAMPLES;
+	}
+}
+
+/*
+===================
+idSoundWorldLocal::StopWritingWave
+===================
+*/
+void idSoundWorldLocal::StopWritingWave( void ) {
+	if ( !fpWave ) {
+		return;
+	}
+
+	// make sure the final block is written
+	game44kHz += MIXBUFFER_SAMPLES;
+	WaveUpdate();
+	game44kHz -= MIXBUFFER_SAMPLES;
+
+	fpWave->Seek( 0, FS_SEEK_SET );
+	WriteWaveHeader( waveMixBlocks * MIXBUFFER_SAMPLES );
+
+	common->Printf( "wrote %s\n", fpWave->GetName() );
+	fileSystem->CloseFile( fpWave );
+	fpWave = NULL;
+
+	float audioMsec = waveMixBlocks * MIXBUFFER_SAMPLES * 1000.0f / 44100.0f;
+	float mixMsec = waveMixTime * 0.001f;
+	common->Printf( "%i blocks, %.1f seconds of sound mixed in %.1f msec (%.1fx realtime)\n",
+					waveMixBlocks, audioMsec * 0.001f, mixMsec, mixMsec > 0.0f ? audioMsec / mixMsec : 0.0f );
+	common->Printf( "%i usec average, %i usec max per %i sample block\n",
+					waveMixBlocks ? waveMixTime / waveMixBlocks : 0, waveMixMaxTime, MIXBUFFER_SAMPLES );
+	for ( int i = 0; i < WAVE_MIX_HISTOGRAM_SIZE; i++ ) {
+		if ( i < WAVE_MIX_HISTOGRAM_SIZE - 1 ) {
+			common->Printf( "  < %6i usec: %i\n", 50 << i, waveMixHistogram[i] );
+		} else {
+			common->Printf( "  >= %5i usec: %i\n", 50 << ( i - 1 ), waveMixHistogram[i] );
+		}
+	}
+
+	soundSystemLocal.SetMute( false );
+}
+
 //==============================================================================
 
 
@@ -1001,8 +1168,8 @@ void idSoundWorldLocal::ForegroundUpdate( int current44kHzTime ) {
 
 	Sys_EnterCriticalSection();
 
-	// if we are recording an AVI demo, don't use hardware time
-	if ( fpa[0] ) {
+	// if we are recording an AVI demo or a wave file, don't use hardware time
+	if ( IsWritingToFile() ) {
 		current44kHzTime = lastAVI44kHz;
 	}
 
@@ -1094,6 +1261,8 @@ void idSoundWorldLocal::ForegroundUpdate( int current44kHzTime ) {
 	//
 	if ( fpa[0] ) {
 		AVIUpdate();
+	} else if ( fpWave ) {
+		WaveUpdate();
 	}
 }
 
@@ -1763,8 +1932,9 @@ void idSoundWorldLocal::AddChannelContribution( idSoundEmitterLocal *sound, idSo
 
 	//
 	// allocate and initialize hardware source
+	// when writing to a file everything goes through the software mixer below
 	//
-	if ( sound->removeStatus < REMOVE_STATUS_SAMPLEFINISHED ) {
+	if ( sound->removeStatus < REMOVE_STATUS_SAMPLEFINISHED && !IsWritingToFile() ) {
 		if ( !alIsSource( chan->openalSource ) ) {
 			chan->openalSource = soundSystemLocal.AllocOpenALSource( chan, !chan->leadinSample->hardwareBuffer || !chan->soundShader->entries[0]->hardwareBuffer || looping, chan->leadinSample->objectInfo.nChannels == 2 );
 		}
@@ -2148,7 +2318,7 @@ void	idSoundWorldLocal::FadeSoundClasses( const int soundClass, const float to,
 
 	int	start44kHz;
 
-	if ( fpa[0] ) {
+	if ( IsWritingToFile() ) {
 		// if we are recording an AVI demo, don't use hardware time
 		start44kHz = lastAVI44kHz + MIXBUFFER_SAMPLES;
 	} else {
@@ -89,6 +89,7 @@ public:
 	virtual bool			SetDefaultText( void );
 	virtual const char *	DefaultDefinition( void ) const;
 	virtual bool			Parse( const char *text, const int textLength );
+	virtual void			ResolveReferences( void );
 	virtual void			FreeData( void );
 	virtual void			List( void ) const;
 
@@ -121,6 +122,7 @@ private:
 	soundShaderParms_t		parms;						// can be overriden on a per-channel basis
 
 	bool					onDemand;					// only load when played, and free when finished
+	bool					compressResident;			// keep samples in memory as ADPCM
 	int						speakerMask;
 	const idSoundShader *	altSound;
 	idStr					desc;						// description
@@ -132,9 +134,21 @@ private:
 	idSoundSample *	entries[SOUND_MAX_LIST_WAVS];
 	int						numEntries;
 
+	// a sample that a parse on a job thread left for ResolveReferences()
+	typedef struct {
+		idStr				name;
+		int					index;
+		bool				leadin;
+		bool				compressResident;
+	} pendingSample_t;
+
+	idList<pendingSample_t>	pendingSamples;
+
 private:
 	void					Init( void );
 	bool					ParseShader( idLexer &src );
+	idSoundSample *			ParseSample( const char *name, int index, bool leadin );
+	idSoundSample *			FindSample( const char *name, bool leadin, bool compressResident ) const;
 };
 
 /*
@@ -253,6 +267,12 @@ public:
 	virtual void			AVIOpen( const char *path, const char *name ) = 0;
 	virtual void			AVIClose( void ) = 0;
 
+	// Mixes in the foreground like AVIOpen, but at normal game time and into a single
+	// interleaved .wav file, so the sound of a demo can be rendered faster than realtime
+	// without a sound device. StopWritingWave reports how long each mix block took.
+	virtual void			StartWritingWave( const char *fileName ) = 0;
+	virtual void			StopWritingWave( void ) = 0;
+
 	// SaveGame / demo Support
 	virtual void			WriteToSaveGame( idFile *savefile ) = 0;
 	virtual void			ReadFromSaveGame( idFile *savefile ) = 0;
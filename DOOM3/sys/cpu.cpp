@@ -219,6 +219,9 @@ int Sys_GetProcessorId( void ) {
 	if (SDL_HasAltiVec())
 		flags |= CPUID_ALTIVEC;
 
+	if (SDL_HasNEON())
+		flags |= CPUID_NEON;
+
 	return flags;
 }
 
@@ -309,6 +309,35 @@ ID_TIME_T Sys_FileTimeStamp(FILE * fp) {
 	return st.st_mtime;
 }
 
+const void *Sys_MapFile( const char *path, int *length ) {
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open( path, O_RDONLY );
+	if ( fd == -1 ) {
+		return NULL;
+	}
+	if ( fstat( fd, &st ) == -1 || st.st_size <= 0 || st.st_size > INT_MAX ) {
+		close( fd );
+		return NULL;
+	}
+	data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	// the mapping stays valid after the descriptor is closed
+	close( fd );
+	if ( data == MAP_FAILED ) {
+		return NULL;
+	}
+	*length = (int)st.st_size;
+	return data;
+}
+
+void Sys_UnmapFile( const void *data, int length ) {
+	if ( data ) {
+		munmap( (void *)data, length );
+	}
+}
+
 char *Sys_GetClipboardData(void) {
 	Sys_Printf( "TODO: Sys_GetClipboardData\n" );
 	return NULL;
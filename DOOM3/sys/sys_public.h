@@ -41,6 +41,7 @@ typedef enum {
 	CPUID_SSE2							= 0x00080,	// Streaming SIMD Extensions 2
 	CPUID_SSE3							= 0x00100,	// Streaming SIMD Extentions 3 aka Prescott's New Instructions
 	CPUID_ALTIVEC						= 0x00200,	// AltiVec
+	CPUID_NEON							= 0x00400,	// ARM Advanced SIMD
 } cpuidSimd_t;
 
 typedef enum {
@@ -119,6 +120,9 @@ void			Sys_Sleep( int msec );
 // any game related timing information should come from event timestamps
 unsigned int	Sys_Milliseconds( void );
 
+// high resolution profiling timer, only the difference between two calls is meaningful
+unsigned int	Sys_Microseconds( void );
+
 // returns a selection of the CPUID_* flags
 int				Sys_GetProcessorId( void );
 
@@ -191,6 +195,9 @@ void			Sys_ShowConsole( int visLevel, bool quitOnClose );
 
 void			Sys_Mkdir( const char *path );
 ID_TIME_T			Sys_FileTimeStamp( FILE *fp );
+// maps a whole file read only, returns NULL if the file can't be mapped
+const void *	Sys_MapFile( const char *path, int *length );
+void			Sys_UnmapFile( const void *data, int length );
 // NOTE: do we need to guarantee the same output on all platforms?
 const char *	Sys_TimeStampToStr( ID_TIME_T timeStamp );
 
@@ -307,17 +314,20 @@ void				Sys_DestroyThread( xthreadInfo& info ); // sets threadHandle back to 0
 // find the name of the calling thread
 // if index != NULL, set the index in threads array (use -1 for "main" thread)
 const char *		Sys_GetThreadName( int *index = 0 );
+// true on the thread that called Sys_InitThreads
+bool				Sys_IsMainThread( void );
 
 extern void Sys_InitThreads();
 extern void Sys_ShutdownThreads();
 
-const int MAX_CRITICAL_SECTIONS		= 5;
+const int MAX_CRITICAL_SECTIONS		= 6;
 
 enum {
 	CRITICAL_SECTION_ZERO = 0,
 	CRITICAL_SECTION_ONE,
 	CRITICAL_SECTION_TWO,
 	CRITICAL_SECTION_THREE,
+	CRITICAL_SECTION_HEAP,		// Mem_Alloc and the string allocator while job threads are running
 	CRITICAL_SECTION_SYS
 };
 
@@ -336,6 +346,67 @@ enum {
 void				Sys_WaitForEvent( int index = TRIGGER_EVENT_ZERO );
 void				Sys_TriggerEvent( int index = TRIGGER_EVENT_ZERO );
 
+/*
+==============================================================
+
+	Parallel jobs
+
+	Jobs must only do CPU work on data that was set up by the caller.
+	The file system, the console, the decl manager and the renderer
+	are not thread safe, so a job must not print, open files or touch
+	any of the engine systems. Memory may be allocated with Mem_Alloc,
+	idStr and R_StaticAlloc, all other allocators are off limits.
+
+==============================================================
+*/
+
+const int MAX_JOB_THREADS			= 4;
+
+typedef void (*xjob_t)( void *data );
+
+// numThreads < 0 picks a count from the number of cores, 0 runs all jobs on the waiting thread
+void				Sys_StartJobThreads( int numThreads );
+void				Sys_ShutdownJobThreads( void );
+int					Sys_NumJobThreads( void );
+// adds i to value as one atomic operation and returns the new value
+int					Sys_InterlockedAdd( int &value, int i );
+
+class idJobList {
+public:
+					idJobList( void );
+					~idJobList( void );
+
+	void			AddJob( xjob_t function, void *data );
+					// hands the jobs over to the job threads
+	void			Submit( void );
+					// runs jobs on the calling thread until all jobs of the list are done
+	void			Wait( void );
+	bool			IsDone( void ) const;
+	int				NumJobs( void ) const { return numJobs; }
+					// removes all jobs, the list must not be running
+	void			Clear( void );
+
+private:
+	typedef struct {
+		xjob_t		function;
+		void *		data;
+	} job_t;
+
+	job_t *			jobs;
+	int				numJobs;
+	int				maxJobs;
+	int				nextJob;			// next job to be picked up
+	int				doneJobs;			// number of jobs finished
+	bool			submitted;
+	bool			threaded;			// handed to the job threads, the heap is locked until Wait
+	idJobList *		nextList;			// next list in the job queue
+
+	bool			RunNextJob( void );
+	static int		JobThread( void *parm );
+
+	friend void		Sys_StartJobThreads( int numThreads );
+};
+
 /*
 ==============================================================
 
@@ -27,11 +27,13 @@ If you have questions concerning this license or the applicable additional terms
 */
 
 #include <SDL_version.h>
+#include <SDL_cpuinfo.h>
 #include <SDL_mutex.h>
 #include <SDL_thread.h>
 #include <SDL_timer.h>
 
 #include "sys/platform.h"
+#include "idlib/Heap.h"
 #include "framework/Common.h"
 
 #include "sys/sys_public.h"
@@ -44,6 +46,17 @@ static bool			waiting[MAX_TRIGGER_EVENTS] = { };
 static xthreadInfo	*thread[MAX_THREADS] = { };
 static size_t		thread_count = 0;
 
+static SDL_mutex	*jobMutex = NULL;
+static SDL_cond		*jobCond = NULL;		// signaled when jobs are submitted
+static SDL_cond		*jobDoneCond = NULL;	// signaled when a job list finishes
+static idJobList	*jobQueue = NULL;
+static xthreadInfo	jobThreads[MAX_JOB_THREADS];
+static int			numJobThreads = 0;
+static bool			jobThreadsExit = false;
+static int			numThreadedLists = 0;	// lists handed to the job threads and not waited on yet
+
+static unsigned int	mainThreadId = 0;
+
 /*
 ==============
 Sys_Sleep
@@ -62,12 +75,27 @@ unsigned int Sys_Milliseconds() {
 	return SDL_GetTicks();
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+unsigned int Sys_Microseconds() {
+	static Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 ticks = SDL_GetPerformanceCounter();
+
+	// split up so the multiplication doesn't overflow
+	return (unsigned int)( ( ticks / frequency ) * 1000000 + ( ticks % frequency ) * 1000000 / frequency );
+}
+
 /*
 ==================
 Sys_InitThreads
 ==================
 */
 void Sys_InitThreads() {
+	mainThreadId = SDL_ThreadID();
+
 	// critical sections
 	for (int i = 0; i < MAX_CRITICAL_SECTIONS; i++) {
 		mutex[i] = SDL_CreateMutex();
@@ -96,6 +124,19 @@ void Sys_InitThreads() {
 		thread[i] = NULL;
 
 	thread_count = 0;
+
+	// jobs
+	jobMutex = SDL_CreateMutex();
+	jobCond = SDL_CreateCond();
+	jobDoneCond = SDL_CreateCond();
+
+	if (!jobMutex || !jobCond || !jobDoneCond) {
+		Sys_Printf("ERROR: SDL_CreateMutex failed\n");
+		return;
+	}
+
+	jobQueue = NULL;
+	numJobThreads = 0;
 }
 
 /*
@@ -104,6 +145,15 @@ Sys_ShutdownThreads
 ==================
 */
 void Sys_ShutdownThreads() {
+	Sys_ShutdownJobThreads();
+
+	SDL_DestroyCond(jobDoneCond);
+	SDL_DestroyCond(jobCond);
+	SDL_DestroyMutex(jobMutex);
+	jobDoneCond = NULL;
+	jobCond = NULL;
+	jobMutex = NULL;
+
 	// threads
 	for (int i = 0; i < MAX_THREADS; i++) {
 		if (!thread[i])
@@ -314,3 +364,293 @@ const char *Sys_GetThreadName(int *index) {
 
 	return "main";
 }
+
+/*
+==================
+Sys_IsMainThread
+==================
+*/
+bool Sys_IsMainThread(void) {
+	return SDL_ThreadID() == mainThreadId;
+}
+
+/*
+======================================================
+parallel jobs
+
+all job bookkeeping is protected by jobMutex. a job list that is submitted
+is linked into jobQueue until its last job was picked up, the thread that
+waits on a list helps running its jobs, so lists also complete when there
+are no job threads at all. the heap is only locked from the submit of the
+first list the job threads can pick up until the last of them was waited on
+======================================================
+*/
+
+/*
+==================
+Sys_StartJobThreads
+==================
+*/
+void Sys_StartJobThreads(int numThreads) {
+	assert(numJobThreads == 0);
+
+#ifdef NOMT
+	numThreads = 0;
+#else
+	if (numThreads < 0) {
+		// leave a core for the main thread
+		numThreads = SDL_GetCPUCount() - 1;
+	}
+#endif
+	numThreads = Min(numThreads, MAX_JOB_THREADS);
+
+	if (numThreads <= 0) {
+		common->Printf("running jobs on the main thread\n");
+		return;
+	}
+
+	jobThreadsExit = false;
+	for (int i = 0; i < numThreads; i++) {
+		Sys_CreateThread(idJobList::JobThread, NULL, jobThreads[i], "job");
+		numJobThreads++;
+	}
+
+	common->Printf("%d job threads\n", numJobThreads);
+}
+
+/*
+==================
+Sys_ShutdownJobThreads
+==================
+*/
+void Sys_ShutdownJobThreads(void) {
+	if (numJobThreads == 0)
+		return;
+
+	SDL_LockMutex(jobMutex);
+	jobThreadsExit = true;
+	SDL_CondBroadcast(jobCond);
+	SDL_UnlockMutex(jobMutex);
+
+	for (int i = 0; i < numJobThreads; i++)
+		Sys_DestroyThread(jobThreads[i]);
+
+	numJobThreads = 0;
+}
+
+/*
+==================
+Sys_NumJobThreads
+==================
+*/
+int Sys_NumJobThreads(void) {
+	return numJobThreads;
+}
+
+/*
+==================
+Sys_InterlockedAdd
+==================
+*/
+int Sys_InterlockedAdd(int &value, int i) {
+	return __sync_add_and_fetch(&value, i);
+}
+
+/*
+==================
+idJobList::idJobList
+==================
+*/
+idJobList::idJobList(void) {
+	jobs = NULL;
+	numJobs = 0;
+	maxJobs = 0;
+	nextJob = 0;
+	doneJobs = 0;
+	submitted = false;
+	threaded = false;
+	nextList = NULL;
+}
+
+/*
+==================
+idJobList::~idJobList
+==================
+*/
+idJobList::~idJobList(void) {
+	if (submitted)
+		Wait();
+
+	Mem_Free(jobs);
+}
+
+/*
+==================
+idJobList::AddJob
+==================
+*/
+void idJobList::AddJob(xjob_t function, void *data) {
+	assert(!submitted);
+
+	if (numJobs == maxJobs) {
+		maxJobs = maxJobs ? maxJobs * 2 : 64;
+		job_t *newJobs = (job_t *)Mem_Alloc(maxJobs * sizeof(job_t));
+		if (jobs) {
+			memcpy(newJobs, jobs, numJobs * sizeof(job_t));
+			Mem_Free(jobs);
+		}
+		jobs = newJobs;
+	}
+
+	jobs[numJobs].function = function;
+	jobs[numJobs].data = data;
+	numJobs++;
+}
+
+/*
+==================
+idJobList::Submit
+==================
+*/
+void idJobList::Submit(void) {
+	assert(!submitted);
+
+	SDL_LockMutex(jobMutex);
+
+	submitted = true;
+	nextJob = 0;
+	doneJobs = 0;
+
+	if (numJobs > 0 && numJobThreads > 0) {
+		// the allocators can be called from more than one thread until the list was waited on
+		threaded = true;
+		if (numThreadedLists++ == 0)
+			Mem_EnableThreadSafety(true);
+
+		// append so lists are started in the order they were submitted
+		idJobList **link = &jobQueue;
+		while (*link)
+			link = &(*link)->nextList;
+
+		nextList = NULL;
+		*link = this;
+
+		SDL_CondBroadcast(jobCond);
+	}
+
+	SDL_UnlockMutex(jobMutex);
+}
+
+/*
+==================
+idJobList::RunNextJob
+
+jobMutex must be locked, it is released while the job runs
+==================
+*/
+bool idJobList::RunNextJob(void) {
+	if (nextJob >= numJobs)
+		return false;
+
+	int index = nextJob++;
+
+	if (nextJob == numJobs) {
+		// all jobs are picked up, take the list out of the queue
+		for (idJobList **link = &jobQueue; *link; link = &(*link)->nextList) {
+			if (*link == this) {
+				*link = nextList;
+				break;
+			}
+		}
+		nextList = NULL;
+	}
+
+	SDL_UnlockMutex(jobMutex);
+
+	jobs[index].function(jobs[index].data);
+
+	SDL_LockMutex(jobMutex);
+
+	doneJobs++;
+	if (doneJobs == numJobs)
+		SDL_CondBroadcast(jobDoneCond);
+
+	return true;
+}
+
+/*
+==================
+idJobList::Wait
+==================
+*/
+void idJobList::Wait(void) {
+	if (!submitted)
+		Submit();
+
+	SDL_LockMutex(jobMutex);
+
+	while (doneJobs < numJobs) {
+		if (!RunNextJob())
+			SDL_CondWait(jobDoneCond, jobMutex);
+	}
+
+	submitted = false;
+
+	// the job threads are out of the jobs of this list, so if no other list is
+	// running nobody but the calling thread uses the allocators
+	if (threaded) {
+		threaded = false;
+		if (--numThreadedLists == 0)
+			Mem_EnableThreadSafety(false);
+	}
+
+	SDL_UnlockMutex(jobMutex);
+}
+
+/*
+==================
+idJobList::IsDone
+==================
+*/
+bool idJobList::IsDone(void) const {
+	SDL_LockMutex(jobMutex);
+	bool done = (doneJobs == numJobs);
+	SDL_UnlockMutex(jobMutex);
+
+	return done;
+}
+
+/*
+==================
+idJobList::Clear
+==================
+*/
+void idJobList::Clear(void) {
+	assert(!submitted);
+
+	numJobs = 0;
+	nextJob = 0;
+	doneJobs = 0;
+}
+
+/*
+==================
+idJobList::JobThread
+==================
+*/
+int idJobList::JobThread(void *parm) {
+	SDL_LockMutex(jobMutex);
+
+	while (!jobThreadsExit) {
+		if (!jobQueue) {
+			SDL_CondWait(jobCond, jobMutex);
+			continue;
+		}
+
+		jobQueue->RunNextJob();
+	}
+
+	SDL_UnlockMutex(jobMutex);
+
+	return 0;
+}
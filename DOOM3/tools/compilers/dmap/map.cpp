@@ -641,7 +641,7 @@ void FreeDMapFile( void ) {
 
 	// free the map lights
 	for ( i = 0; i < dmapGlobals.mapLights.Num(); i++ ) {
-		R_FreeLightDefDerivedData( &dmapGlobals.mapLights[i]->def );
+		R_FreeLightDefDerivedData( &dmapGlobals.mapLights[i]->def, false );
 	}
 	dmapGlobals.mapLights.DeleteContents( true );
 }